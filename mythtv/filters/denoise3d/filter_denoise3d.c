@@ -41,6 +41,7 @@ typedef struct ThisFilter
     int pitches[3];
     int mm_flags;
     int line_size;
+    int line_stride;
     int prev_size;
     uint8_t *line;
     uint8_t *prev;
@@ -304,14 +305,16 @@ static int alloc_prev(ThisFilter *filter, int size)
 
 static int imax(int a, int b) { return (a > b) ? a : b; }
 
-static int init_buf(ThisFilter *filter, VideoFrame *frame)
+static int init_buf(ThisFilter *filter, VideoFrame *frame, int slices)
 {
     if (!alloc_prev(filter, frame->size))
         return 0;
 
+    /* Each slice keeps its own vertical filter state */
     int sz = imax(imax(frame->pitches[0], frame->pitches[1]), frame->pitches[2]);
-    if (!alloc_line(filter, sz))
+    if (!alloc_line(filter, sz * slices))
         return 0;
+    filter->line_stride = sz;
 
     if ((filter->prev_size  != frame->size)       ||
         (filter->offsets[0] != frame->offsets[0]) ||
@@ -329,44 +332,72 @@ static int init_buf(ThisFilter *filter, VideoFrame *frame)
     return 1;
 }
 
-static int denoise3DFilter(VideoFilter *f, VideoFrame *frame, int field)
+static int denoise3DPrepare(VideoFilter *f, VideoFrame *frame, int field,
+                            int total_slices)
 {
     (void)field;
     ThisFilter *filter = (ThisFilter*) f;
-    TF_VARS;
 
-    if (!init_buf(filter, frame))
+    if (!init_buf(filter, frame, total_slices))
         return -1;
 
-    TF_START;
+    return 0;
+}
+
+static int denoise3DSlice(VideoFilter *f, VideoFrame *frame, int field,
+                          int this_slice, int total_slices)
+{
+    (void)field;
+    ThisFilter *filter = (ThisFilter*) f;
+
+    if (!filter->prev || !filter->line)
+        return -1;
+
+    /* The low-pass filter runs both along and down each plane, so a plane
+     * can't be cut up without changing the picture.  Slices take whole
+     * planes instead, which keeps the output identical to a single thread. */
+    if (this_slice >= 3)
+        return 0;
+
+    uint8_t *line = filter->line + filter->line_stride * this_slice;
 
 #ifdef MMX
     if (filter->mm_flags & AV_CPU_FLAG_MMX)
         emms();
 #endif
 
-    (filter->filtfunc)(frame->buf   + frame->offsets[0],
-                       filter->prev + frame->offsets[0],
-                       filter->line,  frame->pitches[0], frame->height,
-                       filter->coefs[0] + 256,
-                       filter->coefs[1] + 256);
-
-    (filter->filtfunc)(frame->buf   + frame->offsets[1],
-                       filter->prev + frame->offsets[1],
-                       filter->line,  frame->pitches[1], frame->height >> 1,
-                       filter->coefs[2] + 256,
-                       filter->coefs[3] + 256);
-
-    (filter->filtfunc)(frame->buf   + frame->offsets[2],
-                       filter->prev + frame->offsets[2],
-                       filter->line,  frame->pitches[2], frame->height >> 1,
-                       filter->coefs[2] + 256,
-                       filter->coefs[3] + 256);
+    for (int plane = this_slice; plane < 3; plane += total_slices)
+    {
+        int height = plane ? frame->height >> 1 : frame->height;
+        int coef   = plane ? 2 : 0;
+
+        (filter->filtfunc)(frame->buf   + frame->offsets[plane],
+                           filter->prev + frame->offsets[plane],
+                           line, frame->pitches[plane], height,
+                           filter->coefs[coef]     + 256,
+                           filter->coefs[coef + 1] + 256);
+    }
+
 #ifdef MMX
     if (filter->mm_flags & AV_CPU_FLAG_MMX)
         emms();
 #endif
 
+    return 0;
+}
+
+static int denoise3DFilter(VideoFilter *f, VideoFrame *frame, int field)
+{
+    ThisFilter *filter = (ThisFilter*) f;
+    TF_VARS;
+
+    if (!init_buf(filter, frame, 1))
+        return -1;
+
+    TF_START;
+
+    denoise3DSlice(f, frame, field, 0, 1);
+
     TF_END(filter, "Denoise3D: ");
     return 0;
 }
@@ -476,7 +507,9 @@ const FilterInfo filter_table[] =
         .descript=   (char*)
         "removes noise with a spatial and temporal low-pass filter",
         .formats=    FmtList,
-        .libname=    NULL
+        .libname=    NULL,
+        .filter_prepare= &denoise3DPrepare,
+        .filter_slice=   &denoise3DSlice
     },
     FILT_NULL
 };
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstdlib>
@@ -26,7 +27,8 @@ using namespace std;
 AudioOutputNULL::AudioOutputNULL(const AudioSettings &settings) :
     AudioOutputBase(settings),
     pcm_output_buffer_mutex(QMutex::NonRecursive),
-    current_buffer_size(0)
+    current_buffer_size(0),
+    m_playout_written(0)
 {
     memset(pcm_output_buffer, 0, sizeof(char) * NULLAUDIO_OUTPUT_BUFFER_SIZE);
     InitSettings(settings);
@@ -41,16 +43,36 @@ AudioOutputNULL::~AudioOutputNULL()
 
 bool AudioOutputNULL::OpenDevice()
 {
-    LOG(VB_GENERAL, LOG_INFO, "Opening NULL audio device, will fail.");
+    LOG(VB_GENERAL, LOG_INFO, "Opening NULL audio device.");
 
     fragment_size = NULLAUDIO_OUTPUT_BUFFER_SIZE / 2;
     soundcard_buffer_size = NULLAUDIO_OUTPUT_BUFFER_SIZE;
 
-    return false;
+    QMutexLocker locker(&m_playout_lock);
+    m_playout_clock.stop();
+    m_playout_written = 0;
+
+    return true;
 }
 
 void AudioOutputNULL::CloseDevice()
 {
+    QMutexLocker locker(&m_playout_lock);
+    m_playout_clock.stop();
+    m_playout_written = 0;
+}
+
+/**
+ * Bytes written to the virtual sound card that it has not played yet.
+ * Must be called with m_playout_lock held.
+ */
+int64_t AudioOutputNULL::PlayoutPending(void) const
+{
+    int64_t rate = (int64_t)samplerate * output_bytes_per_frame;
+    if (!m_playout_clock.isRunning() || rate <= 0)
+        return 0;
+    int64_t played = m_playout_clock.elapsed() * rate / 1000;
+    return max(m_playout_written - played, (int64_t)0);
 }
 
 AudioOutputSettings* AudioOutputNULL::GetOutputSettings(bool /*digital*/)
@@ -93,7 +115,30 @@ void AudioOutputNULL::WriteAudio(unsigned char* aubuf, int size)
         memcpy(pcm_output_buffer + current_buffer_size, aubuf, size);
         current_buffer_size += size;
         pcm_output_buffer_mutex.unlock();
+        return;
     }
+
+    // Consume the data at the nominal sample rate, blocking while the
+    // virtual sound card buffer is full, just as a real device would.
+    int64_t rate = (int64_t)samplerate * output_bytes_per_frame;
+    if (rate <= 0)
+        return;
+
+    m_playout_lock.lock();
+    int64_t pending = PlayoutPending();
+    if (!m_playout_clock.isRunning() || pending == 0)
+    {
+        // First write, or we underran: restart playout from now
+        m_playout_clock.start();
+        m_playout_written = 0;
+        pending = 0;
+    }
+    m_playout_written += size;
+    pending += size;
+    m_playout_lock.unlock();
+
+    if (pending > soundcard_buffer_size)
+        usleep((pending - soundcard_buffer_size) * 1000000 / rate);
 }
 
 int AudioOutputNULL::readOutputData(unsigned char *read_buffer, int max_length)
@@ -122,6 +167,12 @@ void AudioOutputNULL::Reset()
             current_buffer_size = 0;
         pcm_output_buffer_mutex.unlock();
     }
+    else
+    {
+        QMutexLocker locker(&m_playout_lock);
+        m_playout_clock.stop();
+        m_playout_written = 0;
+    }
     AudioOutputBase::Reset();
 }
 
@@ -132,5 +183,6 @@ int AudioOutputNULL::GetBufferedOnSoundcard(void) const
         return current_buffer_size;
     }
 
-    return 0;
+    QMutexLocker locker(&m_playout_lock);
+    return (int)PlayoutPending();
 }
@@ -2,6 +2,7 @@
 #define AUDIOOUTPUTNULL
 
 #include "audiooutputbase.h"
+#include "mythtimer.h"
 
 #define NULLAUDIO_OUTPUT_BUFFER_SIZE 32768
 
@@ -16,6 +17,10 @@
     it will maintain a small buffer and will not let anymore audio data be
     decoded until something pulls the data off (via readOutputData()). 
 
+    Otherwise it behaves like a sound card that consumes samples at the
+    configured rate, so that the audio clock advances in real time and
+    A/V sync can be exercised without any audio hardware.
+
 */
 
 class AudioOutputNULL : public AudioOutputBase
@@ -48,6 +53,12 @@ class AudioOutputNULL : public AudioOutputBase
     QMutex        pcm_output_buffer_mutex;
     unsigned char pcm_output_buffer[NULLAUDIO_OUTPUT_BUFFER_SIZE];
     int           current_buffer_size;
+
+    // Virtual sound card used when the data is not buffered for a reader
+    mutable QMutex m_playout_lock;
+    MythTimer      m_playout_clock;
+    int64_t        m_playout_written;
+    int64_t PlayoutPending(void) const;
 };
 
 #endif
@@ -1663,6 +1663,10 @@ bool MythContext::Init(const bool gui,
     }
     gCoreContext->ActivateSettingsCache(true);
 
+    // 0, the default, leaves the number of pooled DB connections unlimited
+    GetMythDB()->GetDBManager()->SetMaxConnections(
+        gCoreContext->GetNumSetting("DBMaxConnections", 0));
+
     return true;
 }
 
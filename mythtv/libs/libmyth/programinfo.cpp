@@ -6030,113 +6030,17 @@ bool LoadFromOldRecorded(ProgramList &destination, const QString &sql,
     return true;
 }
 
-/** \fn ProgramInfo::LoadFromRecorded(void)
- *  \brief Load a ProgramList from the recorded table.
- *  \param destination     ProgramList to fill
- *  \param possiblyInProgressRecordingsOnly  return only in-progress
- *                                           recordings or empty list
- *  \param inUseMap        in-use programs map
- *  \param isJobRunning    job map
- *  \param recMap          recording map
- *  \param sort            sort order, negative for descending, 0 for
- *                         unsorted, positive for ascending
- *  \param sortBy          comma separated list of fields to sort by
- *  \return true if it succeeds, false if it fails.
- *  \sa QueryInUseMap(void)
- *      QueryJobsRunning(int)
- *      Scheduler::GetRecording()
- */
-bool LoadFromRecorded(
+// Adds the recordings selected by query, a ProgramInfo::kFromRecordedQuery
+static void load_from_recorded_query(
     ProgramList &destination,
-    bool possiblyInProgressRecordingsOnly,
+    MSqlQuery &query,
     const QMap<QString,uint32_t> &inUseMap,
     const QMap<QString,bool> &isJobRunning,
-    const QMap<QString, ProgramInfo*> &recMap,
-    int sort,
-    const QString &sortBy)
+    const QMap<QString, ProgramInfo*> &recMap)
 {
-    destination.clear();
-
-    QString     fs_db_name = "";
     QDateTime   rectime    = MythDate::current().addSecs(
         -gCoreContext->GetNumSetting("RecordOverTime"));
 
-    // ----------------------------------------------------------------------
-
-    QString thequery = ProgramInfo::kFromRecordedQuery;
-    if (possiblyInProgressRecordingsOnly)
-        thequery += "WHERE r.endtime >= NOW() AND r.starttime <= NOW() ";
-
-    if (sortBy.isEmpty())
-    {
-        if (sort)
-            thequery += "ORDER BY r.starttime ";
-        if (sort < 0)
-            thequery += "DESC ";
-    }
-    else
-    {
-        QStringList sortByFields;
-        sortByFields << "starttime" <<  "title" <<  "subtitle" << "season" << "episode" << "category"
-                     <<  "watched" << "stars" << "originalairdate" << "recgroup" << "storagegroup"
-                     <<  "channum" << "callsign" << "name";
-
-        // sanity check the fields are one of the above fields
-        QString sSortBy;
-        QStringList fields = sortBy.split(",");
-        for (int x = 0; x < fields.size(); x++)
-        {
-            bool ascending = true;
-            QString field = fields.at(x).simplified().toLower();
-
-            if (field.endsWith("desc"))
-            {
-                ascending = false;
-                field = field.remove("desc");
-            }
-
-            if (field.endsWith("asc"))
-            {
-                ascending = true;
-                field = field.remove("asc");
-            }
-
-            field = field.simplified();
-
-            if (field == "channelname")
-                field = "name";
-
-            if (sortByFields.contains(field))
-            {
-                QString table;
-                if (field == "channum" || field == "callsign" || field == "name")
-                    table = "c";
-                else
-                    table = "r";
-
-                if (sSortBy.isEmpty())
-                    sSortBy = QString("%1.%2 %3").arg(table).arg(field).arg(ascending ? "ASC" : "DESC");
-                else
-                    sSortBy += QString(",%1.%2 %3").arg(table).arg(field).arg(ascending ? "ASC" : "DESC");
-            }
-            else
-            {
-                LOG(VB_GENERAL, LOG_WARNING, QString("ProgramInfo::LoadFromRecorded() got an unknown sort field '%1' - ignoring").arg(fields.at(x)));
-            }
-        }
-
-        thequery += "ORDER BY " + sSortBy;
-    }
-
-    MSqlQuery query(MSqlQuery::InitCon());
-    query.prepare(thequery);
-
-    if (!query.exec())
-    {
-        MythDB::DBError("ProgramList::FromRecorded", query);
-        return true;
-    }
-
     while (query.next())
     {
         const uint chanid = query.value(6).toUInt();
@@ -6276,6 +6180,152 @@ bool LoadFromRecorded(
         if (save_not_commflagged)
             destination.back()->SaveCommFlagged(COMM_FLAG_NOT_FLAGGED);
     }
+}
+
+/** \fn ProgramInfo::LoadFromRecorded(void)
+ *  \brief Load a ProgramList from the recorded table.
+ *  \param destination     ProgramList to fill
+ *  \param possiblyInProgressRecordingsOnly  return only in-progress
+ *                                           recordings or empty list
+ *  \param inUseMap        in-use programs map
+ *  \param isJobRunning    job map
+ *  \param recMap          recording map
+ *  \param sort            sort order, negative for descending, 0 for
+ *                         unsorted, positive for ascending
+ *  \param sortBy          comma separated list of fields to sort by
+ *  \return true if it succeeds, false if it fails.
+ *  \sa QueryInUseMap(void)
+ *      QueryJobsRunning(int)
+ *      Scheduler::GetRecording()
+ */
+bool LoadFromRecorded(
+    ProgramList &destination,
+    bool possiblyInProgressRecordingsOnly,
+    const QMap<QString,uint32_t> &inUseMap,
+    const QMap<QString,bool> &isJobRunning,
+    const QMap<QString, ProgramInfo*> &recMap,
+    int sort,
+    const QString &sortBy)
+{
+    destination.clear();
+
+    QString thequery = ProgramInfo::kFromRecordedQuery;
+    if (possiblyInProgressRecordingsOnly)
+        thequery += "WHERE r.endtime >= NOW() AND r.starttime <= NOW() ";
+
+    if (sortBy.isEmpty())
+    {
+        if (sort)
+            thequery += "ORDER BY r.starttime ";
+        if (sort < 0)
+            thequery += "DESC ";
+    }
+    else
+    {
+        QStringList sortByFields;
+        sortByFields << "starttime" <<  "title" <<  "subtitle" << "season" << "episode" << "category"
+                     <<  "watched" << "stars" << "originalairdate" << "recgroup" << "storagegroup"
+                     <<  "channum" << "callsign" << "name";
+
+        // sanity check the fields are one of the above fields
+        QString sSortBy;
+        QStringList fields = sortBy.split(",");
+        for (int x = 0; x < fields.size(); x++)
+        {
+            bool ascending = true;
+            QString field = fields.at(x).simplified().toLower();
+
+            if (field.endsWith("desc"))
+            {
+                ascending = false;
+                field = field.remove("desc");
+            }
+
+            if (field.endsWith("asc"))
+            {
+                ascending = true;
+                field = field.remove("asc");
+            }
+
+            field = field.simplified();
+
+            if (field == "channelname")
+                field = "name";
+
+            if (sortByFields.contains(field))
+            {
+                QString table;
+                if (field == "channum" || field == "callsign" || field == "name")
+                    table = "c";
+                else
+                    table = "r";
+
+                if (sSortBy.isEmpty())
+                    sSortBy = QString("%1.%2 %3").arg(table).arg(field).arg(ascending ? "ASC" : "DESC");
+                else
+                    sSortBy += QString(",%1.%2 %3").arg(table).arg(field).arg(ascending ? "ASC" : "DESC");
+            }
+            else
+            {
+                LOG(VB_GENERAL, LOG_WARNING, QString("ProgramInfo::LoadFromRecorded() got an unknown sort field '%1' - ignoring").arg(fields.at(x)));
+            }
+        }
+
+        thequery += "ORDER BY " + sSortBy;
+    }
+
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare(thequery);
+
+    if (!query.exec())
+    {
+        MythDB::DBError("ProgramList::FromRecorded", query);
+        return false;
+    }
+
+    load_from_recorded_query(destination, query, inUseMap, isJobRunning,
+                             recMap);
+
+    return true;
+}
+
+/** \brief Load the recordings with the given ids from the recorded table.
+ *  \param destination     ProgramList to fill
+ *  \param recordedids     recordings to load, those that don't exist
+ *                         are left out
+ *  \param inUseMap        in-use programs map
+ *  \param isJobRunning    job map
+ *  \param recMap          recording map
+ *  \return true if it succeeds, false if it fails.
+ */
+bool LoadFromRecorded(
+    ProgramList &destination,
+    const QList<uint> &recordedids,
+    const QMap<QString,uint32_t> &inUseMap,
+    const QMap<QString,bool> &isJobRunning,
+    const QMap<QString, ProgramInfo*> &recMap)
+{
+    destination.clear();
+
+    if (recordedids.isEmpty())
+        return true;
+
+    QStringList ids;
+    foreach (uint recordedid, recordedids)
+        ids << QString::number(recordedid);
+
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare(ProgramInfo::kFromRecordedQuery +
+                  QString("WHERE r.recordedid IN (%1) ").arg(ids.join(",")));
+
+    if (!query.exec())
+    {
+        MythDB::DBError("ProgramList::FromRecorded", query);
+        return false;
+    }
+
+    load_from_recorded_query(destination, query, inUseMap, isJobRunning,
+                             recMap);
 
     return true;
 }
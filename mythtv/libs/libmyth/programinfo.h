@@ -565,6 +565,7 @@ class MPUBLIC ProgramInfo
     virtual void SetRecordingID(uint _recordedid) { recordedid = _recordedid; }
     void SetRecordingStatus(RecStatus::Type status) { recstatus = status; }
     void SetRecordingRuleType(RecordingType type) { rectype   = type;   }
+    void SetProgramFlags(uint32_t flags)          { programflags = flags; }
     void SetPositionMapDBReplacement(PMapDBReplacement *pmap)
         { positionMapDBReplacement = pmap; }
 
@@ -871,6 +872,13 @@ MPUBLIC bool LoadFromRecorded(
     int                 sort = 0,
     const QString      &sortBy = "");
 
+MPUBLIC bool LoadFromRecorded(
+    ProgramList        &destination,
+    const QList<uint>  &recordedids,
+    const QMap<QString,uint32_t> &inUseMap,
+    const QMap<QString,bool> &isJobRunning,
+    const QMap<QString, ProgramInfo*> &recMap);
+
 
 template<typename TYPE>
 bool LoadFromScheduler(
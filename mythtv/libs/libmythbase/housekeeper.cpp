@@ -39,24 +39,58 @@
  *  to see if any are ready to be run. If any are ready, they are copied
  *  to the queue, and the run thread is woken up.
  *
- *  The run thread sequentially steps through all tasks in the queue and
- *  then goes back to sleep. If one run thread is still active by the time
- *  the timer triggers a new pass, the existing thread will be discarded,
- *  and a new thread will be started to process remaining tasks in the queue.
- *  The old thread will terminate itself once finished with its current task,
- *  rather than following through with the next item in the queue, or going
- *  into wait. This allows the manager to deal with both time-sensitive
- *  tasks and long duration tasks, without any special knowledge of behavior.
+ *  Queued tasks are run by a small pool of run threads, which is grown as
+ *  long as runnable tasks are waiting and every thread is busy. A long
+ *  task therefore only holds up the thread it runs in, and time-sensitive
+ *  tasks carry on in the others. Tasks may declare the tasks they must run
+ *  after, and an exclusion group of tasks that must not run at the same
+ *  time, e.g. those that load the database. A run thread takes the first
+ *  queued task that neither of these holds back.
+ *
+ *  Tasks queued by the timer pass are started after a random delay of up
+ *  to half a minute, and the pass itself is not exactly a minute apart,
+ *  so backends in a cluster do not all check and start global tasks at
+ *  the same moment. A global task that another backend starts during the
+ *  delay is dropped from the queue.
+ *
+ *  The duration of the last few runs of each task is kept, for the status
+ *  reports returned by HouseKeeper::GetTaskStatus().
  */
 
 
+#include <cstdlib>
+#include <random>
+
 #include <QMutexLocker>
 
 #include "mythevent.h"
 #include "mythdbcon.h"
+#include "mythtimer.h"
 #include "housekeeper.h"
 #include "mythcorecontext.h"
 
+/// Most run threads the HouseKeeper starts
+static const int kMaxThreads = 3;
+/// Milliseconds between passes to check for tasks to run
+static const int kCheckInterval = 60000;
+/// Most milliseconds a pass is moved either side of kCheckInterval
+static const int kCheckJitter = 5000;
+/// Most seconds a task queued by a pass is held before it may run
+static const int kMaxStartDelay = 30;
+/// Runs of each task that statistics are kept for
+static const int kRunHistory = 10;
+
+/// Returns a random number from 0 to max. rand() is never seeded, so it
+/// would give every backend started together the same delays.
+static int random_upto(int max)
+{
+    static QMutex s_lock;
+    static std::mt19937 s_gen(std::random_device{}());
+
+    QMutexLocker locker(&s_lock);
+    return std::uniform_int_distribution<int>(0, max)(s_gen);
+}
+
 /** \class HouseKeeperTask
  *  \ingroup housekeeper
  *  \brief Definition for a single task to be run by the HouseKeeper
@@ -74,6 +108,11 @@
  *  Child classes can also implement a Terminate() method, which is to be used
  *  to stop in-progress tasks when the application is shutting down.
  *
+ *  A child class can call AddDependency() with the tag of another task that,
+ *  if both are waiting to run, must finish first. Dependencies must not be
+ *  circular. SetExclusionGroup() names a group of tasks of which only one
+ *  runs at a time.
+ *
  *  The HouseKeeperScope attribute passed to the class in the constructor
  *  controls in what scope the task should operate. <b>kHKGlobal</b> means the
  *  task should only operate once globally. If another housekeeper in another
@@ -96,7 +135,7 @@
 HouseKeeperTask::HouseKeeperTask(const QString &dbTag, HouseKeeperScope scope,
                                  HouseKeeperStartup startup):
     ReferenceCounter(dbTag), m_dbTag(dbTag), m_confirm(false), m_scope(scope),
-    m_startup(startup), m_running(false),
+    m_startup(startup), m_running(0),
 #if QT_VERSION < QT_VERSION_CHECK(5,8,0)
     m_lastRun(MythDate::fromTime_t(0)),
     m_lastSuccess(MythDate::fromTime_t(0)),
@@ -113,7 +152,7 @@ bool HouseKeeperTask::CheckRun(QDateTime now)
 {
     LOG(VB_GENERAL, LOG_DEBUG, QString("Checking to run %1").arg(GetTag()));
     bool check = false;
-    if (!m_confirm && !m_running && (check = DoCheckRun(now)))
+    if (!m_confirm && !m_running.loadAcquire() && (check = DoCheckRun(now)))
         // if m_confirm is already set, the task is already in the queue
         // and should not be queued a second time
         m_confirm = true;
@@ -140,7 +179,7 @@ bool HouseKeeperTask::Run(void)
 {
     LOG(VB_GENERAL, LOG_INFO, QString("Running HouseKeeperTask '%1'.")
                                 .arg(m_dbTag));
-    if (m_running)
+    if (!m_running.testAndSetOrdered(0, 1))
     {
         // something else is already running me, bail out
         LOG(VB_GENERAL, LOG_WARNING, QString("HouseKeeperTask '%1' already "
@@ -148,19 +187,50 @@ bool HouseKeeperTask::Run(void)
         return false;
     }
 
-    m_running = true;
+    {
+        QMutexLocker locker(&m_statusLock);
+        m_runStarted = MythDate::current();
+    }
+
+    MythTimer timer(MythTimer::kStartRunning);
     bool res = DoRun();
-    m_running = false;
+    int elapsed = timer.elapsed();
+
+    {
+        QMutexLocker locker(&m_statusLock);
+        m_runTimes.append(elapsed);
+        while (m_runTimes.size() > kRunHistory)
+            m_runTimes.removeFirst();
+    }
+    m_running.storeRelease(0);
+
     if (!res)
-        LOG(VB_GENERAL, LOG_INFO, QString("HouseKeeperTask '%1' Failed.")
-                                .arg(m_dbTag));
+        LOG(VB_GENERAL, LOG_INFO, QString("HouseKeeperTask '%1' Failed "
+                "after %2 seconds.").arg(m_dbTag).arg(elapsed * 0.001));
     else
         LOG(VB_GENERAL, LOG_INFO,
-                QString("HouseKeeperTask '%1' Finished Successfully.")
-                    .arg(m_dbTag));
+                QString("HouseKeeperTask '%1' Finished Successfully "
+                        "in %2 seconds.").arg(m_dbTag).arg(elapsed * 0.001));
     return res;
 }
 
+/** \fn HouseKeeperTask::GetStatus(void)
+ *  \brief Returns the last run times and durations of the task. The
+ *         queued flag is left for the HouseKeeper to fill in.
+ */
+HouseKeeperTaskStatus HouseKeeperTask::GetStatus(void)
+{
+    QMutexLocker locker(&m_statusLock);
+    HouseKeeperTaskStatus status;
+    status.tag         = m_dbTag;
+    status.running     = m_running.loadAcquire();
+    status.started     = m_runStarted;
+    status.lastRun     = m_lastRun;
+    status.lastSuccess = m_lastSuccess;
+    status.runTimes    = m_runTimes;
+    return status;
+}
+
 QDateTime HouseKeeperTask::QueryLastRun(void)
 {
     QueryLast();
@@ -219,9 +289,12 @@ void HouseKeeperTask::QueryLast(void)
 
 QDateTime HouseKeeperTask::UpdateLastRun(QDateTime last, bool successful)
 {
-    m_lastRun = last;
-    if (successful)
-        m_lastSuccess = last;
+    {
+        QMutexLocker locker(&m_statusLock);
+        m_lastRun = last;
+        if (successful)
+            m_lastSuccess = last;
+    }
     m_confirm = false;
 
     if (m_scope != kHKInst)
@@ -296,9 +369,12 @@ QDateTime HouseKeeperTask::UpdateLastRun(QDateTime last, bool successful)
 
 void HouseKeeperTask::SetLastRun(QDateTime last, bool successful)
 {
-    m_lastRun = last;
-    if (successful)
-        m_lastSuccess = last;
+    {
+        QMutexLocker locker(&m_statusLock);
+        m_lastRun = last;
+        if (successful)
+            m_lastSuccess = last;
+    }
 
     m_lastUpdate = MythDate::current();
 }
@@ -390,11 +466,11 @@ bool PeriodicHouseKeeperTask::DoCheckRun(QDateTime now)
     // calculate current probability to achieve overall probability
     // this should be nearly one
     float prob2 = prob/m_currentProb;
-    // so rand() should have to return nearly RAND_MAX to get a positive
+    // so random_upto() should have to return nearly RAND_MAX to get a positive
     // remember, this is computing the probability that up to this point, one
     //      of these tests has returned positive, so each individual test has
     //      a necessarily low probability
-    bool res = (rand() > (int)(prob2 * RAND_MAX));
+    bool res = (random_upto(RAND_MAX) > (int)(prob2 * RAND_MAX));
     m_currentProb = prob;
 //  if (res)
 //      LOG(VB_GENERAL, LOG_DEBUG, QString("%1 will run: this=%2; total=%3")
@@ -501,55 +577,32 @@ bool DailyHouseKeeperTask::InWindow(QDateTime now)
  *  \ingroup housekeeper
  *  \brief Thread used to perform queued HouseKeeper tasks.
  *
- *  This class is a long-running thread that pulls tasks out of the
- *  HouseKeeper queue and runs them sequentially. It performs one last check
- *  of the task to make sure something else in the same scope has not
- *  pre-empted it, before running the task.
+ *  This class is a long-running thread that takes runnable tasks out of the
+ *  HouseKeeper queue and runs them, waiting in between until one is ready.
+ *  It performs one last check of the task to make sure something else in
+ *  the same scope has not pre-empted it, before running the task.
  *
  */
 void HouseKeepingThread::run(void)
 {
     RunProlog();
-    m_waitMutex.lock();
     HouseKeeperTask *task = nullptr;
 
-    while (m_keepRunning)
+    while ((task = m_parent->GetQueuedTask(this)))
     {
-        m_idle = false;
-
-        while ((task = m_parent->GetQueuedTask()))
+        // something else may have caused the lastrun time to
+        // change since this was requested to run. if so, abort.
+        if (task->ConfirmRun())
         {
-            // pull task from housekeeper and process it
-            ReferenceLocker rlock(task);
-
-            if (!task->ConfirmRun())
-            {
-                // something else has caused the lastrun time to
-                // change since this was requested to run. abort.
-                task = nullptr;
-                continue;
-            }
-
             task->UpdateLastRun(false);
             if (task->Run())
                 task->UpdateLastRun(task->GetLastRun(), true);
-            task = nullptr;
-
-            if (!m_keepRunning)
-                // thread has been discarded, don't try to start another task
-                break;
         }
 
-        m_idle = true;
-
-        if (!m_keepRunning)
-            // short out rather than potentially hitting another sleep cycle
-            break;
-
-        m_waitCondition.wait(&m_waitMutex);
+        m_parent->TaskFinished(task);
+        task->DecrRef();
     }
 
-    m_waitMutex.unlock();
     RunEpilog();
 }
 
@@ -569,11 +622,11 @@ void HouseKeepingThread::run(void)
  *  Tasks cannot be removed from the housekeeper once added.
  *
  */
-HouseKeeper::HouseKeeper(void) : m_timer(nullptr)
+HouseKeeper::HouseKeeper(void) : m_timer(nullptr), m_idleThreads(0)
 {
     m_timer = new QTimer(this);
     connect(m_timer, SIGNAL(timeout()), this, SLOT(Run()));
-    m_timer->setInterval(60000);
+    m_timer->setInterval(kCheckInterval);
     m_timer->setSingleShot(false);
 }
 
@@ -594,6 +647,7 @@ HouseKeeper::~HouseKeeper(void)
         QMutexLocker queueLock(&m_queueLock);
         while (!m_taskQueue.isEmpty())
             m_taskQueue.takeFirst()->DecrRef();
+        m_notBefore.clear();
     }
 
     {
@@ -608,9 +662,13 @@ HouseKeeper::~HouseKeeper(void)
     if (!m_threadList.isEmpty())
     {
         QMutexLocker threadLock(&m_threadLock);
-        // tell primary thread to self-terminate and wake it
-        m_threadList.first()->Discard();
-        m_threadList.first()->Wake();
+        {
+            // tell the threads to self-terminate and wake them
+            QMutexLocker queueLock(&m_queueLock);
+            foreach (HouseKeepingThread *thread, m_threadList)
+                thread->Discard();
+            m_queueWait.wakeAll();
+        }
         // wait for any remaining threads to self-terminate and close
         while (!m_threadList.isEmpty())
         {
@@ -651,19 +709,119 @@ void HouseKeeper::RegisterTask(HouseKeeperTask *task)
     }
 }
 
-HouseKeeperTask* HouseKeeper::GetQueuedTask(void)
+/** \fn HouseKeeper::GetQueuedTask(HouseKeepingThread*)
+ *  \brief Waits for a queued task that is ready to run, and takes it out
+ *         of the queue.
+ *
+ *  A task is ready once its start delay has passed, no task it depends on
+ *  is queued or running, and no other task of its exclusion group is
+ *  running. Returns nullptr once \p thread has been discarded.
+ */
+HouseKeeperTask* HouseKeeper::GetQueuedTask(HouseKeepingThread *thread)
 {
     QMutexLocker queueLock(&m_queueLock);
-    HouseKeeperTask *task = nullptr;
 
-    if (!m_taskQueue.isEmpty())
+    while (!thread->isDiscarded())
+    {
+        QDateTime now = MythDate::current();
+        qint64 wait = -1;
+
+        for (int i = 0; i < m_taskQueue.size(); ++i)
+        {
+            HouseKeeperTask *task = m_taskQueue[i];
+            if (!IsRunnable(task))
+                continue;
+
+            qint64 delay = now.msecsTo(m_notBefore.value(task, now));
+            if (delay > 0)
+            {
+                if (wait < 0 || delay < wait)
+                    wait = delay;
+                continue;
+            }
+
+            m_taskQueue.removeAt(i);
+            m_notBefore.remove(task);
+            m_runningTasks.append(task);
+            m_idleThreads--;
+            return task;
+        }
+
+        // sleep until the next start delay passes, or a task is queued
+        // or finishes
+        if (wait < 0)
+            m_queueWait.wait(&m_queueLock);
+        else
+            m_queueWait.wait(&m_queueLock, wait + 1);
+    }
+
+    // returning nullptr tells the thread to terminate
+    m_idleThreads--;
+    return nullptr;
+}
+
+/// Marks a task taken by GetQueuedTask() as no longer running, which may
+/// let the tasks that wait on it start.
+void HouseKeeper::TaskFinished(HouseKeeperTask *task)
+{
+    QMutexLocker queueLock(&m_queueLock);
+    m_runningTasks.removeAll(task);
+    m_idleThreads++;
+    m_queueWait.wakeAll();
+}
+
+// Whether no dependency or exclusion group holds back a queued task.
+// The caller must hold m_queueLock.
+bool HouseKeeper::IsRunnable(HouseKeeperTask *task)
+{
+    QStringList dependencies = task->GetDependencies();
+    QString group = task->GetExclusionGroup();
+
+    foreach (HouseKeeperTask *other, m_runningTasks)
     {
-        task = m_taskQueue.dequeue();
+        if (dependencies.contains(other->GetTag()) ||
+            (!group.isEmpty() && other->GetExclusionGroup() == group))
+            return false;
     }
 
-    // returning nullptr tells the thread that the queue is empty and
-    // to go into standby
-    return task;
+    foreach (HouseKeeperTask *other, m_taskQueue)
+    {
+        if (dependencies.contains(other->GetTag()))
+            return false;
+    }
+
+    return true;
+}
+
+// Adds a task to the queue, to be started no sooner than delay seconds
+// from now. The caller must hold m_queueLock.
+void HouseKeeper::Enqueue(HouseKeeperTask *task, int delay)
+{
+    LOG(VB_GENERAL, LOG_INFO,
+        QString("Queueing HouseKeeperTask '%1'.").arg(task->GetTag()));
+    task->IncrRef();
+    m_taskQueue.enqueue(task);
+    if (delay > 0)
+        m_notBefore[task] = MythDate::current().addSecs(delay);
+}
+
+/** \fn HouseKeeper::GetTaskStatus(void)
+ *  \brief Returns the state and recent run times of every registered task.
+ */
+QList<HouseKeeperTaskStatus> HouseKeeper::GetTaskStatus(void)
+{
+    QList<HouseKeeperTaskStatus> list;
+
+    QMutexLocker mapLock(&m_mapLock);
+    QMutexLocker queueLock(&m_queueLock);
+    foreach (HouseKeeperTask *task, m_taskMap)
+    {
+        HouseKeeperTaskStatus status = task->GetStatus();
+        status.queued = m_taskQueue.contains(task);
+        list.append(status);
+    }
+
+    return list;
 }
 
 void HouseKeeper::Start(void)
@@ -711,11 +869,8 @@ void HouseKeeper::Start(void)
         else if ((*it)->CheckStartup())
         {
             // queue any tasks marked for startup
-            LOG(VB_GENERAL, LOG_INFO,
-                QString("Queueing HouseKeeperTask '%1'.").arg(it.key()));
             QMutexLocker queueLock(&m_queueLock);
-            (*it)->IncrRef();
-            m_taskQueue.enqueue(*it);
+            Enqueue(*it, 0);
         }
     }
 
@@ -736,94 +891,51 @@ void HouseKeeper::Run(void)
         if ((*it)->CheckRun(now))
         {
             // check if any tasks are ready to run, and add to queue
-            LOG(VB_GENERAL, LOG_INFO,
-                QString("Queueing HouseKeeperTask '%1'.").arg(it.key()));
             QMutexLocker queueLock(&m_queueLock);
-            (*it)->IncrRef();
-            m_taskQueue.enqueue(*it);
+            Enqueue(*it, random_upto(kMaxStartDelay));
         }
     }
 
     if (!m_taskQueue.isEmpty())
         StartThread();
 
-    if (m_threadList.size() > 1)
-    {
-        // spent threads exist in the thread list
-        // check to see if any have finished up their task and terminated
-        QMutexLocker threadLock(&m_threadLock);
-        int count1 = m_threadList.size();
-
-        auto it = m_threadList.begin();
-        ++it; // skip the primary thread
-        while (it != m_threadList.end())
-        {
-            if ((*it)->isRunning())
-                ++it;
-            else
-            {
-                delete *it;
-                it = m_threadList.erase(it);
-            }
-        }
-
-        int count2 = m_threadList.size();
-        if (count1 > count2)
-            LOG(VB_GENERAL, LOG_DEBUG,
-                QString("Discarded HouseKeepingThreads have completed and "
-                        "been deleted. Current count %1 -> %2.")
-                            .arg(count1).arg(count2));
-    }
+    // keep passes on different backends from lining up
+    m_timer->setInterval(kCheckInterval - kCheckJitter +
+                         random_upto(2 * kCheckJitter));
 }
 
-/** \brief Wake the primary run thread, or create a new one
- *
- *  The HouseKeeper maintains one primary thread, but allows for multiple to
- *  allow task processing to continue should one long-running thread stall.
+/** \brief Wake the run threads, and start more if needed
  *
  *  The HouseKeeper scans to queue tasks once a minute. If any tasks are in
- *  the queue at the end of the scan, this method will be run. If the primary
- *  thread is still in use from the previous scan, it will be marked for
- *  destruction and a replacement thread will be started to pick up the
- *  remainder of the queue. The in-progress thread will terminate itself once
- *  its current task has finished, and will be eventually cleaned up by this
- *  method.
+ *  the queue at the end of the scan, this method will be run. If there are
+ *  more runnable tasks in the queue than idle threads, new threads are
+ *  started, up to kMaxThreads, so a long running task does not hold up the
+ *  rest. Threads are kept until the HouseKeeper is destroyed.
  */
 void HouseKeeper::StartThread(void)
 {
     QMutexLocker threadLock(&m_threadLock);
+    QMutexLocker queueLock(&m_queueLock);
 
-    if (m_threadList.isEmpty())
+    int runnable = 0;
+    foreach (HouseKeeperTask *task, m_taskQueue)
     {
-        // we're running for the first time
-        // start up a new thread
-        LOG(VB_GENERAL, LOG_DEBUG, "Running initial HouseKeepingThread.");
-        HouseKeepingThread *thread = new HouseKeepingThread(this);
-        m_threadList.append(thread);
-        thread->start();
+        if (IsRunnable(task))
+            runnable++;
     }
 
-    else if (!m_threadList.first()->isIdle())
+    while (m_idleThreads < runnable && m_threadList.size() < kMaxThreads)
     {
-        // the old thread is still off processing something
-        // discard it and start a new one because we have more stuff
-        // that wants to run
         LOG(VB_GENERAL, LOG_DEBUG,
-            QString("Current HouseKeepingThread is delayed on task, "
-                    "spawning replacement. Current count %1.")
-                            .arg(m_threadList.size()));
-        m_threadList.first()->Discard();
+            QString("Starting HouseKeepingThread. Current count %1.")
+                .arg(m_threadList.size()));
         HouseKeepingThread *thread = new HouseKeepingThread(this);
-        m_threadList.prepend(thread);
+        m_threadList.append(thread);
+        m_idleThreads++;
         thread->start();
     }
 
-    else
-    {
-        // the old thread is idle, so just wake it for processing
-        LOG(VB_GENERAL, LOG_DEBUG, "Waking HouseKeepingThread.");
-        m_threadList.first()->Wake();
-    }
+    m_queueWait.wakeAll();
 }
 
 void HouseKeeper::customEvent(QEvent *e)
@@ -850,10 +962,29 @@ void HouseKeeper::customEvent(QEvent *e)
                 if ((m_taskMap[tag]->GetScope() == kHKGlobal) ||
                         ((m_taskMap[tag]->GetScope() == kHKLocal) &&
                          (gCoreContext->GetHostName() == hostname)))
+                {
                     // task being run in the same scope as us.
                     // update the run time so we don't attempt to run
                     //      it ourselves
-                    m_taskMap[tag]->SetLastRun(last, successful);
+                    HouseKeeperTask *task = m_taskMap[tag];
+                    task->SetLastRun(last, successful);
+
+                    // another backend started it while ours waited out
+                    // its start delay
+                    QMutexLocker queueLock(&m_queueLock);
+                    if (hostname != gCoreContext->GetHostName() &&
+                        m_taskQueue.removeOne(task))
+                    {
+                        LOG(VB_GENERAL, LOG_INFO,
+                            QString("HouseKeeperTask '%1' started on %2. "
+                                    "Dropping it from the queue.")
+                                .arg(tag).arg(hostname));
+                        m_notBefore.remove(task);
+                        task->CancelRun();
+                        task->DecrRef();
+                        m_queueWait.wakeAll();
+                    }
+                }
             }
         }
     }
@@ -2,6 +2,7 @@
 #define HOUSEKEEPER_H_
 
 #include <QWaitCondition>
+#include <QAtomicInt>
 #include <QDateTime>
 #include <QString>
 #include <QEvent>
@@ -11,6 +12,7 @@
 #include <QList>
 #include <QMap>
 #include <QPair>
+#include <QStringList>
 
 #include "mthread.h"
 #include "mythdate.h"
@@ -36,6 +38,18 @@ enum HouseKeeperStartup {
     kHKRunImmediateOnStartup    ///< task is run during HouseKeeper startup
 };
 
+/// Snapshot of the state of a HouseKeeperTask, for status reports
+struct HouseKeeperTaskStatus
+{
+    QString     tag;
+    bool        queued  {false};
+    bool        running {false};
+    QDateTime   started;        ///< start of the current or last run
+    QDateTime   lastRun;
+    QDateTime   lastSuccess;
+    QList<int>  runTimes;       ///< milliseconds, oldest run first
+};
+
 class MBASE_PUBLIC HouseKeeperTask : public ReferenceCounter
 {
   public:
@@ -46,12 +60,15 @@ class MBASE_PUBLIC HouseKeeperTask : public ReferenceCounter
     bool            CheckRun(QDateTime now);
     bool            Run(void);
     bool            ConfirmRun(void)                { return m_confirm;     }
-    bool            IsRunning(void)                 { return m_running;     }
+    bool            IsRunning(void)                 { return m_running.loadAcquire(); }
 
     bool            CheckImmediate(void);
     bool            CheckStartup(void);
 
     QString         GetTag(void)                    { return m_dbTag;       }
+    QStringList     GetDependencies(void)           { return m_dependencies; }
+    QString         GetExclusionGroup(void)         { return m_exclusionGroup; }
+    HouseKeeperTaskStatus GetStatus(void);
     QDateTime       GetLastRun(void)                { return m_lastRun;     }
     QDateTime       GetLastSuccess(void)            { return m_lastSuccess; }
     HouseKeeperScope    GetScope(void)              { return m_scope;       }
@@ -67,18 +84,34 @@ class MBASE_PUBLIC HouseKeeperTask : public ReferenceCounter
 
     virtual void    Terminate(void)                 {}
 
+  protected:
+    void            AddDependency(const QString &tag)
+                                            { m_dependencies.append(tag); }
+    void            SetExclusionGroup(const QString &group)
+                                            { m_exclusionGroup = group;   }
+
   private:
+    friend class HouseKeeper;
+    void            CancelRun(void)                 { m_confirm = false;    }
     void            QueryLast(void);
 
     QString             m_dbTag;
+    QStringList         m_dependencies;
+    QString             m_exclusionGroup;
     bool                m_confirm;
     HouseKeeperScope    m_scope;
     HouseKeeperStartup  m_startup;
-    bool                m_running;
+    QAtomicInt          m_running;
 
     QDateTime   m_lastRun;
     QDateTime   m_lastSuccess;
     QDateTime   m_lastUpdate;
+
+    /// Protects m_lastRun, m_lastSuccess and the run statistics, which
+    /// are read by status reports in other threads
+    QMutex      m_statusLock;
+    QDateTime   m_runStarted;
+    QList<int>  m_runTimes;
 };
 
 class MBASE_PUBLIC PeriodicHouseKeeperTask : public HouseKeeperTask
@@ -127,22 +160,17 @@ class HouseKeepingThread : public MThread
 {
   public:
     explicit HouseKeepingThread(HouseKeeper *p) :
-        MThread("HouseKeeping"), m_idle(true), m_keepRunning(true),
-        m_parent(p) {}
+        MThread("HouseKeeping"), m_keepRunning(true), m_parent(p) {}
    ~HouseKeepingThread() = default;
     void run(void) override; // MThread
     void Discard(void)                  { m_keepRunning = false;        }
-    bool isIdle(void)                   { return m_idle;                }
-    void Wake(void)                     { m_waitCondition.wakeAll();    }
+    bool isDiscarded(void)              { return !m_keepRunning;        }
 
     void Terminate(void);
 
   private:
-    bool                m_idle;
     bool                m_keepRunning;
     HouseKeeper        *m_parent;
-    QMutex              m_waitMutex;
-    QWaitCondition      m_waitCondition;
 };
 
 class MBASE_PUBLIC HouseKeeper : public QObject
@@ -156,7 +184,9 @@ class MBASE_PUBLIC HouseKeeper : public QObject
     void RegisterTask(HouseKeeperTask *task);
     void Start(void);
     void StartThread(void);
-    HouseKeeperTask* GetQueuedTask(void);
+    HouseKeeperTask* GetQueuedTask(HouseKeepingThread *thread);
+    void TaskFinished(HouseKeeperTask *task);
+    QList<HouseKeeperTaskStatus> GetTaskStatus(void);
 
     void customEvent(QEvent *e) override; // QObject
 
@@ -164,9 +194,16 @@ class MBASE_PUBLIC HouseKeeper : public QObject
     void Run(void);
 
   private:
+    void Enqueue(HouseKeeperTask *task, int delay);
+    bool IsRunnable(HouseKeeperTask *task);
+
     QTimer                         *m_timer;
 
     QQueue<HouseKeeperTask*>        m_taskQueue;
+    QMap<HouseKeeperTask*, QDateTime> m_notBefore;
+    QList<HouseKeeperTask*>         m_runningTasks;
+    int                             m_idleThreads;
+    QWaitCondition                  m_queueWait;
     QMutex                          m_queueLock;
 
     QMap<QString, HouseKeeperTask*> m_taskMap;
@@ -1,9 +1,10 @@
+#include <QAtomicPointer>
 #include <QAtomicInt>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QWaitCondition>
+#include <QThreadStorage>
 #include <QList>
-#include <QQueue>
 #include <QHash>
 #include <QCoreApplication>
 #include <QFileInfo>
@@ -56,16 +57,19 @@ extern "C" {
 #include <mach/mach.h>
 #endif
 
-// QJson
-#include "qjsonwrapper/Json.h"
-
 #ifdef Q_OS_ANDROID
 #include <android/log.h>
 #endif
 
+/// Items logged since the logging thread last took the queue, newest first.
+/// LOG() pushes onto it without taking a lock.
+static QAtomicPointer<LoggingItem> logQueueHead;
+/// Set while the logging thread handles a batch it has taken off the queue
+static QAtomicInt              logQueueBusy;
+/// Protects the waits on the two conditions below, not the queue itself
 static QMutex                  logQueueMutex;
-static QQueue<LoggingItem *>   logQueue;
-static QRegExp                 logRegExp = QRegExp("[%]{1,2}");
+static QWaitCondition          logQueueNotEmpty;
+static QWaitCondition          logQueueEmpty;
 
 static LoggerThread           *logThread = nullptr;
 static QMutex                  logThreadMutex;
@@ -142,7 +146,7 @@ LoggingItem::LoggingItem() :
         m_pid(-1), m_tid(-1), m_threadId(-1), m_usec(0), m_line(0),
         m_type(kMessage), m_level(LOG_INFO), m_facility(0), m_epoch(0),
         m_file(nullptr), m_function(nullptr), m_threadName(nullptr), m_appName(nullptr),
-        m_table(nullptr), m_logFile(nullptr)
+        m_table(nullptr), m_logFile(nullptr), m_next(nullptr)
 {
     m_message[0]='\0';
     m_message[LOGLINE_MAX]='\0';
@@ -154,7 +158,8 @@ LoggingItem::LoggingItem(const char *_file, const char *_function,
         m_threadId((uint64_t)(QThread::currentThreadId())),
         m_line(_line), m_type(_type), m_level(_level), m_facility(0),
         m_file(strdup(_file)), m_function(strdup(_function)),
-        m_threadName(nullptr), m_appName(nullptr), m_table(nullptr), m_logFile(nullptr)
+        m_threadName(nullptr), m_appName(nullptr), m_table(nullptr), m_logFile(nullptr),
+        m_next(nullptr)
 {
     loggingGetTimeStamp(&m_epoch, &m_usec);
 
@@ -178,16 +183,6 @@ LoggingItem::~LoggingItem()
     free(m_logFile);
 }
 
-QByteArray LoggingItem::toByteArray(void)
-{
-    QVariantMap variant = QJsonWrapper::qobject2qvariant(this);
-    QByteArray json = QJsonWrapper::toJson(variant);
-
-    //cout << json.constData() << endl;
-
-    return json;
-}
-
 /// \brief Get the name of the thread that produced the LoggingItem
 /// \return C-string of the thread name
 char *LoggingItem::getThreadName(void)
@@ -221,6 +216,15 @@ int64_t LoggingItem::getThreadTid(void)
 ///        shown in gdb.
 void LoggingItem::setThreadTid(void)
 {
+    // Kept per thread as well, so only a thread's first message takes the
+    // lock below
+    static QThreadStorage<int64_t> threadTid;
+    if (threadTid.hasLocalData())
+    {
+        m_tid = threadTid.localData();
+        return;
+    }
+
     QMutexLocker locker(&logThreadTidMutex);
 
     m_tid = logThreadTidHash.value(m_threadId, -1);
@@ -242,6 +246,7 @@ void LoggingItem::setThreadTid(void)
 #endif
         logThreadTidHash[m_threadId] = m_tid;
     }
+    threadTid.setLocalData(m_tid);
 }
 
 /// \brief LoggerThread constructor.  Enables debugging of thread registration
@@ -250,8 +255,6 @@ void LoggingItem::setThreadTid(void)
 LoggerThread::LoggerThread(QString filename, bool progress, bool quiet,
                            QString table, int facility) :
     MThread("Logger"),
-    m_waitNotEmpty(new QWaitCondition()),
-    m_waitEmpty(new QWaitCondition()),
     m_aborted(false), m_filename(filename), m_progress(progress),
     m_quiet(quiet), m_appname(QCoreApplication::applicationName()),
     m_tablename(table), m_facility(facility), m_pid(getpid())
@@ -278,9 +281,39 @@ LoggerThread::~LoggerThread()
     stop();
     wait();
     logForwardStop();
+}
+
+/// \brief Adds an item to the log queue.  This does not take a lock unless
+///        the queue was empty, when the logging thread may be waiting for it.
+void logQueuePush(LoggingItem *item)
+{
+    LoggingItem *head;
+    do
+    {
+        head = logQueueHead.loadAcquire();
+        item->m_next = head;
+    } while (!logQueueHead.testAndSetRelease(head, item));
+
+    if (!head)
+    {
+        // The logging thread checks the queue with the mutex held before
+        // it waits, so this wake up can not fall between the two
+        QMutexLocker qLock(&logQueueMutex);
+        logQueueNotEmpty.wakeAll();
+    }
+}
+
+/// \brief Takes every item from the log queue.
+/// \return The items, oldest first
+LoggingList logQueueTake(void)
+{
+    LoggingList items;
 
-    delete m_waitNotEmpty;
-    delete m_waitEmpty;
+    LoggingItem *item = logQueueHead.fetchAndStoreAcquire(nullptr);
+    for (; item; item = item->m_next)
+        items.prepend(item);
+
+    return items;
 }
 
 /// \brief Run the logging thread.  This thread reads from the logging queue,
@@ -297,35 +330,25 @@ void LoggerThread::run(void)
 
     bool dieNow = false;
 
-    QMutexLocker qLock(&logQueueMutex);
-
-    while (!m_aborted || !logQueue.isEmpty())
+    while (!m_aborted || logQueueHead.loadAcquire())
     {
-        qLock.unlock();
         qApp->processEvents(QEventLoop::AllEvents, 10);
         qApp->sendPostedEvents(nullptr, QEvent::DeferredDelete);
 
-        qLock.relock();
-        if (logQueue.isEmpty())
-        {
-            m_waitEmpty->wakeAll();
-            m_waitNotEmpty->wait(qLock.mutex(), 100);
+        logQueueBusy.storeRelease(1);
+        LoggingList items = logQueueTake();
+        if (!items.isEmpty())
+            handleItems(items);
+        logQueueBusy.storeRelease(0);
+        if (!items.isEmpty())
             continue;
-        }
 
-        LoggingItem *item = logQueue.dequeue();
-        qLock.unlock();
-
-        fillItem(item);
-        handleItem(item);
-        logConsole(item);
-        item->DecrRef();
-
-        qLock.relock();
+        QMutexLocker qLock(&logQueueMutex);
+        logQueueEmpty.wakeAll();
+        if (!m_aborted && !logQueueHead.loadAcquire())
+            logQueueNotEmpty.wait(qLock.mutex(), 100);
     }
 
-    qLock.unlock();
-
     // This must be before the timer stop below or we deadlock when the timer
     // thread tries to deregister, and we wait for it.
     logThreadFinished = true;
@@ -339,6 +362,31 @@ void LoggerThread::run(void)
     }
 }
 
+/// \brief  Handles a batch of LoggingItems taken from the queue, writing
+///         them to the console and passing the messages among them to the
+///         loggers in one go.  The items are released.
+/// \param  items   The LoggingItems to be handled, oldest first
+void LoggerThread::handleItems(const LoggingList &items)
+{
+    LoggingList messages;
+
+    foreach (LoggingItem *item, items)
+    {
+        fillItem(item);
+        handleItem(item);
+        logConsole(item);
+
+        if (item->m_message[0] != '\0')
+            messages.append(item);
+        else
+            item->DecrRef();
+    }
+
+    // The log forwarding thread releases the messages
+    if (!messages.isEmpty())
+        logForwardMessages(messages);
+}
+
 /// \brief  Handles each LoggingItem.  There is a special case for
 ///         thread registration and deregistration which are also included in
 ///         the logging queue to keep the thread names in sync with the log
@@ -348,7 +396,11 @@ void LoggerThread::handleItem(LoggingItem *item)
 {
     if (item->m_type & kRegistering)
     {
-        item->m_tid = item->getThreadTid();
+        {
+            // A thread pool thread registers again after deregistering
+            QMutexLocker locker(&logThreadTidMutex);
+            logThreadTidHash[item->m_threadId] = item->m_tid;
+        }
 
         QMutexLocker locker(&logThreadMutex);
         if (logThreadHash.contains(item->m_threadId))
@@ -397,21 +449,6 @@ void LoggerThread::handleItem(LoggingItem *item)
             free(threadName);
         }
     }
-
-    if (item->m_message[0] != '\0')
-    {
-        /// TODO: This converts the LoggingItem to json for sending to
-        /// the log server.  Now that the log server is gone, it just
-        /// passed the json to the logForwardThread, where it will
-        /// eventually be converted back to a LoggingItem.  It should
-        /// be possible to eliminate the double conversion now that
-        /// the log server is gone and all logging happens in one
-        /// process.
-        QList<QByteArray> list;
-        list.append(QByteArray());
-        list.append(item->toByteArray());
-        logForwardMessage(list);
-    }
 }
 
 /// \brief Process a log message, writing to the console
@@ -515,24 +552,32 @@ void LoggerThread::stop(void)
     flush(1000);
     m_aborted = true;
     logQueueMutex.unlock();
-    m_waitNotEmpty->wakeAll();
+    logQueueNotEmpty.wakeAll();
 }
 
-/// \brief  Wait for the queue to be flushed (up to a timeout)
+/// \brief  Wait for the queue to be flushed (up to a timeout).  The caller
+///         must hold logQueueMutex.
+///
+///         The queue is flushed once the logging thread has written every
+///         item in it to the console and handed the messages to the
+///         loggers.  The loggers write them from the log forwarding thread,
+///         so they may not be in the logfile or database yet.
 /// \param  timeoutMS   The number of ms to wait for the queue to flush
-/// \return true if the queue is empty, false otherwise
+/// \return true if the queue is flushed, false otherwise
 bool LoggerThread::flush(int timeoutMS)
 {
     QTime t;
     t.start();
-    while (!m_aborted && !logQueue.isEmpty() && t.elapsed() < timeoutMS)
+    while (!m_aborted &&
+           (logQueueHead.loadAcquire() || logQueueBusy.loadAcquire()) &&
+           t.elapsed() < timeoutMS)
     {
-        m_waitNotEmpty->wakeAll();
+        logQueueNotEmpty.wakeAll();
         int left = timeoutMS - t.elapsed();
         if (left > 0)
-            m_waitEmpty->wait(&logQueueMutex, left);
+            logQueueEmpty.wait(&logQueueMutex, left);
     }
-    return logQueue.isEmpty();
+    return !logQueueHead.loadAcquire() && !logQueueBusy.loadAcquire();
 }
 
 void LoggerThread::fillItem(LoggingItem *item)
@@ -566,17 +611,6 @@ LoggingItem *LoggingItem::create(const char *_file,
     return item;
 }
 
-LoggingItem *LoggingItem::create(QByteArray &buf)
-{
-    // Deserialize buffer
-    QVariant variant = QJsonWrapper::parseJson(buf);
-
-    LoggingItem *item = new LoggingItem;
-    QJsonWrapper::qvariant2qobject(variant.toMap(), item);
-
-    return item;
-}
-
 
 /// \brief  Format and send a log message into the queue.  This is called from
 ///         the LOG() macro.  The intention is minimal blocking of the caller.
@@ -603,45 +637,41 @@ void LogPrintLine( uint64_t mask, LogLevel_t level, const char *file, int line,
     if (!item)
         return;
 
-    char *formatcopy = nullptr;
-    if( fromQString && strchr(format, '%') )
+    if (fromQString)
     {
-        QString string(format);
-        format = strdup(string.replace(logRegExp, "%%").toLocal8Bit()
-                              .constData());
-        formatcopy = (char *)format;
+        // The message is already formatted, copy it as printf would
+        // print it, with "%%" as "%"
+        char *dest = item->m_message;
+        char *end  = item->m_message + LOGLINE_MAX - 1;
+        for (const char *src = format; *src && dest < end; ++src)
+        {
+            if (src[0] == '%' && src[1] == '%')
+                ++src;
+            *dest++ = *src;
+        }
+        *dest = '\0';
+    }
+    else
+    {
+        va_start(arguments, format);
+        vsnprintf(item->m_message, LOGLINE_MAX, format, arguments);
+        va_end(arguments);
     }
-
-    va_start(arguments, format);
-    vsnprintf(item->m_message, LOGLINE_MAX, format, arguments);
-    va_end(arguments);
-
-    if (formatcopy)
-        free(formatcopy);
-
-    QMutexLocker qLock(&logQueueMutex);
 
 #if defined( _MSC_VER ) && defined( _DEBUG )
         OutputDebugStringA( item->m_message );
         OutputDebugStringA( "\n" );
 #endif
 
-    logQueue.enqueue(item);
+    logQueuePush(item);
 
     if (logThread && logThreadFinished && !logThread->isRunning())
     {
-        while (!logQueue.isEmpty())
-        {
-            item = logQueue.dequeue();
-            qLock.unlock();
-            logThread->handleItem(item);
-            logThread->logConsole(item);
-            item->DecrRef();
-            qLock.relock();
-        }
+        logThread->handleItems(logQueueTake());
     }
     else if (logThread && !logThreadFinished && (type & kFlush))
     {
+        QMutexLocker qLock(&logQueueMutex);
         logThread->flush();
     }
 }
@@ -776,15 +806,13 @@ void loggingRegisterThread(const QString &name)
     if (logThreadFinished)
         return;
 
-    QMutexLocker qLock(&logQueueMutex);
-
     LoggingItem *item = LoggingItem::create(__FILE__, __FUNCTION__,
                                             __LINE__, LOG_DEBUG,
                                             kRegistering);
     if (item)
     {
         item->setThreadName((char *)name.toLocal8Bit().constData());
-        logQueue.enqueue(item);
+        logQueuePush(item);
     }
 }
 
@@ -795,13 +823,11 @@ void loggingDeregisterThread(void)
     if (logThreadFinished)
         return;
 
-    QMutexLocker qLock(&logQueueMutex);
-
     LoggingItem *item = LoggingItem::create(__FILE__, __FUNCTION__, __LINE__,
                                             LOG_DEBUG,
                                             kDeregistering);
     if (item)
-        logQueue.enqueue(item);
+        logQueuePush(item);
 }
 
 
@@ -3,7 +3,7 @@
 
 #include <QMutexLocker>
 #include <QMutex>
-#include <QQueue>
+#include <QList>
 #include <QTime>
 #include <QPointer>
 
@@ -32,12 +32,12 @@ class QString;
 class MSqlQuery;
 class LoggingItem;
 
+typedef QList<LoggingItem *> LoggingList;
+
 void loggingRegisterThread(const QString &name);
 void loggingDeregisterThread(void);
 void loggingGetTimeStamp(qlonglong *epoch, uint *usec);
 
-class QWaitCondition;
-
 typedef enum {
     kMessage       = 0x01,
     kRegistering   = 0x02,
@@ -82,6 +82,8 @@ class LoggingItem: public QObject, public ReferenceCounter
     friend class LoggerThread;
     friend void LogPrintLine(uint64_t, LogLevel_t, const char *, int,
                              const char *, int, const char *, ... );
+    friend void logQueuePush(LoggingItem *item);
+    friend LoggingList logQueueTake(void);
 
   public:
     char *getThreadName(void);
@@ -89,8 +91,6 @@ class LoggingItem: public QObject, public ReferenceCounter
     void setThreadTid(void);
     static LoggingItem *create(const char *, const char *, int, LogLevel_t,
                                LoggingType);
-    static LoggingItem *create(QByteArray &buf);
-    QByteArray toByteArray(void);
 
     int                 pid() const         { return m_pid; };
     qlonglong           tid() const         { return m_tid; };
@@ -155,6 +155,7 @@ class LoggingItem: public QObject, public ReferenceCounter
     char               *m_table;
     char               *m_logFile;
     char                m_message[LOGLINE_MAX+1];
+    LoggingItem        *m_next;     ///< next older item in the log queue
 
   private:
     LoggingItem();
@@ -178,15 +179,11 @@ class LoggerThread : public QObject, public MThread
     void run(void) override; // MThread
     void stop(void);
     bool flush(int timeoutMS = 200000);
-    void handleItem(LoggingItem *item);
+    void handleItems(const LoggingList &items);
     void fillItem(LoggingItem *item);
   private:
-    QWaitCondition *m_waitNotEmpty; ///< Condition variable for waiting
-                                    ///  for the queue to not be empty
-                                    ///  Protected by logQueueMutex
-    QWaitCondition *m_waitEmpty;    ///< Condition variable for waiting
-                                    ///  for the queue to be empty
-                                    ///  Protected by logQueueMutex
+    void handleItem(LoggingItem *item);
+
     bool m_aborted;                 ///< Flag to abort the thread.
                                     ///  Protected by logQueueMutex
     QString m_filename; ///< Filename of debug logfile
@@ -34,12 +34,16 @@ using namespace std;
 #endif
 #endif
 #include <cstdarg>
+#include <cerrno>
 #include <cstring>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <fcntl.h>
 #include <cstdio>
 #include <unistd.h>
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
 #if HAVE_GETTIMEOFDAY
 #include <sys/time.h>
 #endif
@@ -81,12 +85,17 @@ static QMutex                       logRevClientMapMutex;
 static RevClientMap                 logRevClientMap;
 
 static QMutex                       logMsgListMutex;
-static LogMessageList               logMsgList;
+static LoggingList                  logMsgList;
 static QWaitCondition               logMsgListNotEmpty;
 
 #define TIMESTAMP_MAX 30
 #define MAX_STRING_LENGTH (LOGLINE_MAX+120)
 
+/// Most messages FileLogger writes with one system call
+static const int kWriteBatch = 64;
+/// Most messages DBLoggerThread inserts with one statement
+static const int kInsertBatch = 100;
+
 /// \brief LoggerBase class constructor.  Adds the new logger instance to the
 ///        loggerMap.
 /// \param string a C-string of the handle for this instance (NULL if unused)
@@ -117,11 +126,22 @@ LoggerBase::~LoggerBase()
         free(m_handle);
 }
 
+/// \brief Process a batch of log messages.  Loggers that can write several
+///        messages at once override this, the default handles them one at
+///        a time.
+/// \param items LoggingItems containing the log messages, oldest first
+void LoggerBase::logmsgs(const LoggingList &items)
+{
+    foreach (LoggingItem *item, items)
+        logmsg(item);
+}
+
 
 /// \brief FileLogger constructor
 /// \param filename Filename of the logfile.
 FileLogger::FileLogger(const char *filename) :
-        LoggerBase(filename), m_opened(false), m_fd(-1)
+        LoggerBase(filename), m_opened(false), m_fd(-1),
+        m_lines(new char[kWriteBatch * MAX_STRING_LENGTH])
 {
     m_fd = open(filename, O_WRONLY|O_CREAT|O_APPEND, 0664);
     m_opened = (m_fd != -1);
@@ -141,6 +161,8 @@ FileLogger::~FileLogger()
         m_fd = -1;
         m_opened = false;
     }
+
+    delete [] m_lines;
 }
 
 FileLogger *FileLogger::create(QString filename, QMutex *mutex)
@@ -179,13 +201,89 @@ void FileLogger::reopen(void)
 /// \param item LoggingItem containing the log message to process
 bool FileLogger::logmsg(LoggingItem *item)
 {
-    char                line[MAX_STRING_LENGTH];
-    char                usPart[9];
-    char                timestamp[TIMESTAMP_MAX];
+    char line[MAX_STRING_LENGTH];
 
     if (!m_opened)
         return false;
 
+    int length = format(item, line);
+    if (write(m_fd, line, length) == -1)
+        return writeError();
+
+    return true;
+}
+
+#ifndef _WIN32
+/// \brief Writes lines to a file, carrying on after a short write with
+///        whatever writev() did not take
+/// \param fd The file descriptor to write to
+/// \param iov The lines to write, these are modified
+/// \param count The number of lines
+/// \return false if the write failed
+static bool writeLines(int fd, struct iovec *iov, int count)
+{
+    while (count > 0)
+    {
+        ssize_t written = writev(fd, iov, count);
+        if (written == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        while (count > 0 && (size_t)written >= iov->iov_len)
+        {
+            written -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return true;
+}
+#endif
+
+/// \brief Process a batch of log messages, writing up to kWriteBatch of
+///        them to the logfile with a single writev()
+/// \param items LoggingItems containing the log messages, oldest first
+void FileLogger::logmsgs(const LoggingList &items)
+{
+#ifdef _WIN32
+    LoggerBase::logmsgs(items);
+#else
+    struct iovec iov[kWriteBatch];
+    int count = 0;
+
+    for (int i = 0; i < items.size() && m_opened; ++i)
+    {
+        char *line = m_lines + count * MAX_STRING_LENGTH;
+        iov[count].iov_base = line;
+        iov[count].iov_len  = format(items[i], line);
+
+        if (++count == kWriteBatch || i == items.size() - 1)
+        {
+            if (!writeLines(m_fd, iov, count))
+                writeError();
+            count = 0;
+        }
+    }
+#endif
+}
+
+/// \brief Formats a log message as a line of the logfile
+/// \param item LoggingItem containing the log message to format
+/// \param line Buffer of MAX_STRING_LENGTH characters for the line
+/// \return The length of the line
+int FileLogger::format(LoggingItem *item, char *line)
+{
+    char                usPart[9];
+    char                timestamp[TIMESTAMP_MAX];
+
     time_t epoch = item->epoch();
     struct tm tm;
     localtime_r(&epoch, &tm);
@@ -205,30 +303,32 @@ bool FileLogger::logmsg(LoggingItem *item)
             shortname = (*it)->shortname;
     }
 
+    int length;
     if( item->tid() )
-        snprintf( line, MAX_STRING_LENGTH,
+        length = snprintf( line, MAX_STRING_LENGTH,
                   "%s %c [%d/%" PREFIX64 "d] %s %s:%d (%s) - %s\n",
                   timestamp, shortname, item->pid(), item->tid(),
                   item->rawThreadName(), item->rawFile(), item->line(),
                   item->rawFunction(), item->rawMessage() );
     else
-        snprintf( line, MAX_STRING_LENGTH,
+        length = snprintf( line, MAX_STRING_LENGTH,
                   "%s %c [%d] %s %s:%d (%s) - %s\n",
                   timestamp, shortname, item->pid(), item->rawThreadName(),
                   item->rawFile(), item->line(), item->rawFunction(),
                   item->rawMessage() );
 
-    int result = write(m_fd, line, strlen(line));
+    // snprintf returns the length the line would have had untruncated
+    return qBound(0, length, MAX_STRING_LENGTH - 1);
+}
 
-    if( result == -1 )
-    {
-        LOG(VB_GENERAL, LOG_ERR,
-                 QString("Closed Log output on fd %1 due to errors").arg(m_fd));
-        m_opened = false;
-        close( m_fd );
-        return false;
-    }
-    return true;
+/// \brief Stops logging to the logfile after a failed write
+bool FileLogger::writeError(void)
+{
+    LOG(VB_GENERAL, LOG_ERR,
+             QString("Closed Log output on fd %1 due to errors").arg(m_fd));
+    m_opened = false;
+    close( m_fd );
+    return false;
 }
 
 #ifndef _WIN32
@@ -364,8 +464,7 @@ DatabaseLogger::DatabaseLogger(const char *table) :
         "INSERT INTO %1 "
         "    (host, application, pid, tid, thread, filename, "
         "     line, function, msgtime, level, message) "
-        "VALUES (:HOST, :APP, :PID, :TID, :THREAD, :FILENAME, "
-        "        :LINE, :FUNCTION, :MSGTIME, :LEVEL, :MESSAGE)")
+        "VALUES ")
         .arg(m_handle);
 
     LOG(VB_GENERAL, LOG_INFO, QString("Added database logging to table %1")
@@ -458,30 +557,49 @@ bool DatabaseLogger::logmsg(LoggingItem *item)
 }
 
 
-/// \brief Actually insert a log message from the queue into the database
-/// \param query    The database insert query to use
-/// \param item     LoggingItem containing the log message to insert
-bool DatabaseLogger::logqmsg(MSqlQuery &query, LoggingItem *item)
+/// \brief Actually insert log messages from the queue into the database,
+///        with one multi-row insert
+/// \param query    The database query to use
+/// \param items    LoggingItems containing the log messages to insert
+bool DatabaseLogger::logqmsg(MSqlQuery &query, const LoggingList &items)
 {
     char        timestamp[TIMESTAMP_MAX];
 
-    time_t epoch = item->epoch();
-    struct tm tm;
-    localtime_r(&epoch, &tm);
-
-    strftime(timestamp, TIMESTAMP_MAX-8, "%Y-%m-%d %H:%M:%S",
-             (const struct tm *)&tm);
+    QString sql = m_query;
+    for (int i = 0; i < items.size(); ++i)
+    {
+        sql += QString("%1(:HOST%2, :APP%2, :PID%2, :TID%2, :THREAD%2, "
+                       ":FILENAME%2, :LINE%2, :FUNCTION%2, :MSGTIME%2, "
+                       ":LEVEL%2, :MESSAGE%2)")
+            .arg(i ? ", " : "").arg(i);
+    }
+    query.prepare(sql);
 
-    query.bindValue(":TID",         item->tid());
-    query.bindValue(":THREAD",      item->threadName());
-    query.bindValue(":FILENAME",    item->file());
-    query.bindValue(":LINE",        item->line());
-    query.bindValue(":FUNCTION",    item->function());
-    query.bindValue(":MSGTIME",     timestamp);
-    query.bindValue(":LEVEL",       item->level());
-    query.bindValue(":MESSAGE",     item->message());
-    query.bindValue(":APP",         item->appName());
-    query.bindValue(":PID",         item->pid());
+    QString host = gCoreContext->GetHostName();
+    for (int i = 0; i < items.size(); ++i)
+    {
+        LoggingItem *item = items[i];
+        QString row = QString::number(i);
+
+        time_t epoch = item->epoch();
+        struct tm tm;
+        localtime_r(&epoch, &tm);
+
+        strftime(timestamp, TIMESTAMP_MAX-8, "%Y-%m-%d %H:%M:%S",
+                 (const struct tm *)&tm);
+
+        query.bindValue(":HOST"     + row, host);
+        query.bindValue(":TID"      + row, item->tid());
+        query.bindValue(":THREAD"   + row, item->threadName());
+        query.bindValue(":FILENAME" + row, item->file());
+        query.bindValue(":LINE"     + row, item->line());
+        query.bindValue(":FUNCTION" + row, item->function());
+        query.bindValue(":MSGTIME"  + row, timestamp);
+        query.bindValue(":LEVEL"    + row, item->level());
+        query.bindValue(":MESSAGE"  + row, item->message());
+        query.bindValue(":APP"      + row, item->appName());
+        query.bindValue(":PID"      + row, item->pid());
+    }
 
     if (!query.exec())
     {
@@ -504,14 +622,6 @@ bool DatabaseLogger::logqmsg(MSqlQuery &query, LoggingItem *item)
     return true;
 }
 
-/// \brief Prepare the database query for use, and bind constant values to it.
-/// \param query    The database query to prepare
-void DatabaseLogger::prepare(MSqlQuery &query)
-{
-    query.prepare(m_query);
-    query.bindValue(":HOST", gCoreContext->GetHostName());
-}
-
 /// \brief Check if the database is ready for use
 /// \return true when database is ready, false otherwise
 bool DatabaseLogger::isDatabaseReady(void)
@@ -605,7 +715,6 @@ void DBLoggerThread::run(void)
         // shutdown occurs correctly as otherwise the connection appears still
         // in use, and we get a qWarning on shutdown.
         MSqlQuery *query = new MSqlQuery(MSqlQuery::InitCon());
-        m_logger->prepare(*query);
 
         QMutexLocker qLock(&m_queueMutex);
         while (!m_aborted || !m_queue->isEmpty())
@@ -616,28 +725,39 @@ void DBLoggerThread::run(void)
                 continue;
             }
 
-            LoggingItem *item = m_queue->dequeue();
-            if (!item)
+            // Whatever queued up during the last insert goes in the next
+            LoggingList items;
+            while (!m_queue->isEmpty() && items.size() < kInsertBatch)
+            {
+                LoggingItem *item = m_queue->dequeue();
+                if (!item)
+                    continue;
+
+                if (item->rawMessage()[0] != '\0')
+                    items.append(item);
+                else
+                    item->DecrRef();
+            }
+
+            if (items.isEmpty())
                 continue;
 
-            if (item->message()[0] != QChar('\0'))
+            qLock.unlock();
+            bool logged = m_logger->logqmsg(*query, items);
+            qLock.relock();
+
+            if (!logged)
             {
-                qLock.unlock();
-                bool logged = m_logger->logqmsg(*query, item);
-                qLock.relock();
-
-                if (!logged)
-                {
-                    m_queue->prepend(item);
-                    m_wait->wait(qLock.mutex(), 100);
-                    delete query;
-                    query = new MSqlQuery(MSqlQuery::InitCon());
-                    m_logger->prepare(*query);
-                    continue;
-                }
+                for (int i = items.size() - 1; i >= 0; --i)
+                    m_queue->prepend(items[i]);
+                m_wait->wait(qLock.mutex(), 100);
+                delete query;
+                query = new MSqlQuery(MSqlQuery::InitCon());
+                continue;
             }
 
-            item->DecrRef();
+            foreach (LoggingItem *item, items)
+                item->DecrRef();
         }
 
         delete query;
@@ -717,6 +837,7 @@ void LogForwardThread::run(void)
         qApp->processEvents(QEventLoop::AllEvents, 10);
         qApp->sendPostedEvents(nullptr, QEvent::DeferredDelete);
 
+        LoggingList items;
         {
             QMutexLocker lock(&logMsgListMutex);
             if (logMsgList.isEmpty() &&
@@ -725,26 +846,11 @@ void LogForwardThread::run(void)
                 continue;
             }
 
-            int processed = 0;
-            while (!logMsgList.isEmpty())
-            {
-                processed++;
-                LogMessage *msg = logMsgList.takeFirst();
-                lock.unlock();
-                forwardMessage(msg);
-                delete msg;
-
-                // Force a processEvents every 128 messages so a busy queue
-                // doesn't preclude timer notifications, etc.
-                if ((processed & 127) == 0)
-                {
-                    qApp->processEvents(QEventLoop::AllEvents, 10);
-                    qApp->sendPostedEvents(nullptr, QEvent::DeferredDelete);
-                }
-
-                lock.relock();
-            }
+            // Take everything queued, so each logger gets it in one batch
+            items.swap(logMsgList);
         }
+
+        forwardMessages(items);
     }
 
     LoggerList loggers;
@@ -780,43 +886,26 @@ void LogForwardThread::handleSigHup(void)
 #endif
 }
 
-void LogForwardThread::forwardMessage(LogMessage *msg)
+/// \brief Passes a batch of log messages to the loggers, and releases them
+/// \param items LoggingItems containing the log messages, oldest first
+void LogForwardThread::forwardMessages(const LoggingList &items)
 {
-#ifdef DUMP_PACKET
-    QList<QByteArray>::const_iterator it = msg->begin();
-    int i = 0;
-    for (; it != msg->end(); ++it, i++)
-    {
-        QByteArray buf = *it;
-        cout << i << ":\t" << buf.size() << endl << "\t"
-             << buf.toHex().constData() << endl << "\t"
-             << buf.constData() << endl;
-    }
-#endif
-
-    // First section is the client id
-    QByteArray clientBa = msg->first();
-    QString clientId = QString(clientBa.toHex());
-
-    QByteArray json     = msg->at(1);
-
-    if (json.size() == 0)
-    {
-        // cout << "invalid msg, no json data " << qPrintable(clientId) << endl;
+    if (items.isEmpty())
         return;
-    }
+
+    // The messages all come from this process, which is the one client
+    QString clientId;
 
     QMutexLocker lock(&logClientMapMutex);
     LoggerListItem *logItem = logClientMap.value(clientId, nullptr);
 
-    // cout << "msg  " << clientId.toLocal8Bit().constData() << endl;
     if (logItem)
     {
         loggingGetTimeStamp(&logItem->epoch, nullptr);
     }
     else
     {
-        LoggingItem *item = LoggingItem::create(json);
+        LoggingItem *item = items.first();
 
         logClientCount.ref();
         LOG(VB_FILE, LOG_DEBUG, QString("New Logging Client: ID: %1 (#%2)")
@@ -896,22 +985,17 @@ void LogForwardThread::forwardMessage(LogMessage *msg)
         loggingGetTimeStamp(&logItem->epoch, nullptr);
         logItem->list = loggers;
         logClientMap.insert(clientId, logItem);
-
-        item->DecrRef();
     }
 
-    if (logItem && logItem->list && !logItem->list->isEmpty())
+    if (logItem && logItem->list)
     {
         LoggerList::iterator it = logItem->list->begin();
-        LoggingItem *item = LoggingItem::create(json);
-        if (!item)
-            return;
         for (; it != logItem->list->end(); ++it)
-        {
-            (*it)->logmsg(item);
-        }
-        item->DecrRef();
+            (*it)->logmsgs(items);
     }
+
+    foreach (LoggingItem *item, items)
+        item->DecrRef();
 }
 
 /// \brief Stop the thread by setting the abort flag
@@ -945,13 +1029,14 @@ void logForwardStop(void)
     }
 }
 
-void logForwardMessage(const QList<QByteArray> &msg)
+/// \brief Queues log messages for the loggers.  The log forwarding thread
+///        takes over the caller's references to the items.
+void logForwardMessages(const LoggingList &items)
 {
-    LogMessage *message = new LogMessage(msg);
     QMutexLocker lock(&logMsgListMutex);
 
     bool wasEmpty = logMsgList.isEmpty();
-    logMsgList.append(message);
+    logMsgList.append(items);
 
     if (wasEmpty)
         logMsgListNotEmpty.wakeAll();
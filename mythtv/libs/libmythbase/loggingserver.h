@@ -16,12 +16,10 @@
 #include "verbosedefs.h"
 #include "mythsignalingtimer.h"
 #include "mthread.h"
-
-#define LOGLINE_MAX (2048-120)
+#include "logging.h"
 
 class QString;
 class MSqlQuery;
-class LoggingItem;
 
 /// \brief Base class for the various logging mechanisms
 class LoggerBase : public QObject
@@ -36,6 +34,8 @@ class LoggerBase : public QObject
     /// \brief Process a log message for the logger instance
     /// \param item LoggingItem containing the log message to process
     virtual bool logmsg(LoggingItem *item) = 0;
+    /// \brief Process a batch of log messages, oldest first
+    virtual void logmsgs(const LoggingList &items);
     /// \brief Reopen the log file to facilitate log rolling
     virtual void reopen(void) = 0;
     /// \brief Stop logging to the database
@@ -53,11 +53,16 @@ class FileLogger : public LoggerBase
     explicit FileLogger(const char *filename);
     ~FileLogger();
     bool logmsg(LoggingItem *item) override; // LoggerBase
+    void logmsgs(const LoggingList &items) override; // LoggerBase
     void reopen(void) override; // LoggerBase
     static FileLogger *create(QString filename, QMutex *mutex);
   private:
+    int  format(LoggingItem *item, char *line);
+    bool writeError(void);
+
     bool m_opened;      ///< true when the logfile is opened
     int  m_fd;          ///< contains the file descriptor for the logfile
+    char *m_lines;      ///< line buffers for a batch of messages
 };
 
 /// \brief Syslog-based logger (not available in Windows)
@@ -108,14 +113,14 @@ class DatabaseLogger : public LoggerBase
     void stopDatabaseAccess(void) override; // LoggerBase
     static DatabaseLogger *create(QString table, QMutex *mutex);
   protected:
-    bool logqmsg(MSqlQuery &query, LoggingItem *item);
-    void prepare(MSqlQuery &query);
+    bool logqmsg(MSqlQuery &query, const LoggingList &items);
   private:
     bool isDatabaseReady(void);
     bool tableExists(const QString &table);
 
     DBLoggerThread *m_thread;   ///< The database queue handling thread
-    QString m_query;            ///< The database query to insert log messages
+    QString m_query;            ///< The start of the query to insert log
+                                ///  messages, the rows follow
     bool m_opened;              ///< The database is opened
     bool m_loggingTableExists;  ///< The desired logging table exists
     bool m_disabled;            ///< DB logging is temporarily disabled
@@ -125,9 +130,6 @@ class DatabaseLogger : public LoggerBase
                                        ///  (in ms)
 };
 
-typedef QList<QByteArray> LogMessage;
-typedef QList<LogMessage *> LogMessageList;
-
 /// \brief The logging thread that forwards received messages to the consuming
 ///        loggers via ZeroMQ
 class LogForwardThread : public QObject, public MThread
@@ -143,7 +145,7 @@ class LogForwardThread : public QObject, public MThread
   private:
     bool m_aborted;                  ///< Flag to abort the thread.
 
-    void forwardMessage(LogMessage *msg);
+    void forwardMessages(const LoggingList &items);
   signals:
     void incomingSigHup(void);
   protected slots:
@@ -152,7 +154,7 @@ class LogForwardThread : public QObject, public MThread
 
 MBASE_PUBLIC bool logForwardStart(void);
 MBASE_PUBLIC void logForwardStop(void);
-MBASE_PUBLIC void logForwardMessage(const QList<QByteArray> &msg);
+MBASE_PUBLIC void logForwardMessages(const LoggingList &items);
 
 
 class QWaitCondition;
@@ -187,6 +187,8 @@ MythCoreContextPrivate::~MythCoreContextPrivate()
     logStop(); // need to shutdown db logger before we kill db
 #endif
 
+    GetMythDB()->GetDBManager()->StopReclaiming();
+
     MThread::Cleanup();
 
     GetMythDB()->GetDBManager()->CloseDatabases();
@@ -1,7 +1,6 @@
 #include <vector>
 using namespace std;
 
-#include <QReadWriteLock>
 #include <QTextStream>
 #include <QSqlError>
 #include <QMutex>
@@ -14,6 +13,7 @@ using namespace std;
 #include "mythlogging.h"
 #include "mythdirs.h"
 #include "mythcorecontext.h"
+#include "mythsnapshot.h"
 
 static MythDB *mythdb = nullptr;
 static QMutex dbLock;
@@ -62,12 +62,25 @@ struct SingleSetting
 
 typedef QHash<QString,QString> SettingsMap;
 
+/// The settings cache, replaced as a whole whenever it changes so that
+/// settings can be read without taking a lock
+struct SettingsCache
+{
+    /// Permanent settings in the DB and overridden settings
+    SettingsMap settings;
+    /// Overridden this session only
+    SettingsMap overrides;
+};
+
 class MythDBPrivate
 {
   public:
     MythDBPrivate();
    ~MythDBPrivate();
 
+    bool FindSetting(const QString &key, QString &value) const;
+    void CacheSetting(QString key, QString value);
+
     DatabaseParams  m_DBparams;  ///< Current database host & WOL details
     QString m_localhostname;
     MDBManager m_dbmanager;
@@ -75,12 +88,8 @@ class MythDBPrivate
     bool ignoreDatabase {false};
     bool suppressDBMessages {true};
 
-    QReadWriteLock settingsCacheLock;
     volatile bool useSettingsCache {false};
-    /// Permanent settings in the DB and overridden settings
-    SettingsMap settingsCache;
-    /// Overridden this session only
-    SettingsMap overriddenSettings;
+    MythSnapshot<SettingsCache> settingsCache;
     /// Settings which should be written to the database as soon as it becomes
     /// available
     QList<SingleSetting> delayedSettings;
@@ -94,7 +103,10 @@ static const int settings_reserve = 61;
 MythDBPrivate::MythDBPrivate()
 {
     m_localhostname.clear();
-    settingsCache.reserve(settings_reserve);
+
+    SettingsCache cache;
+    cache.settings.reserve(settings_reserve);
+    settingsCache.Set(cache);
 }
 
 MythDBPrivate::~MythDBPrivate()
@@ -102,6 +114,49 @@ MythDBPrivate::~MythDBPrivate()
     LOG(VB_DATABASE, LOG_INFO, "Destroying MythDBPrivate");
 }
 
+/// Looks up the cached or overridden value of a lower case setting key.
+bool MythDBPrivate::FindSetting(const QString &key, QString &value) const
+{
+    MythSnapshot<SettingsCache>::Reader cache(settingsCache);
+
+    SettingsMap::const_iterator it;
+    if (useSettingsCache)
+    {
+        it = cache->settings.constFind(key);
+        if (it != cache->settings.constEnd())
+        {
+            value = *it;
+            return true;
+        }
+    }
+
+    it = cache->overrides.constFind(key);
+    if (it != cache->overrides.constEnd())
+    {
+        value = *it;
+        return true;
+    }
+
+    return false;
+}
+
+/// Adds a value read from the database to the settings cache.
+void MythDBPrivate::CacheSetting(QString key, QString value)
+{
+    key.squeeze();
+    value.squeeze();
+
+    settingsCache.Modify([&](SettingsCache &cache)
+    {
+        // another thread may have inserted a value into the cache
+        // while we read the database, keep the first one
+        if (cache.settings.contains(key))
+            return false;
+        cache.settings.insert(key, value);
+        return true;
+    });
+}
+
 MythDB::MythDB()
 {
     d = new MythDBPrivate();
@@ -272,6 +327,7 @@ bool MythDB::SaveSettingOnHost(const QString &key,
                 OverrideSettingForSession(key, newValue);
             else
                 ClearOverrideSettingForSession(key);
+            NotifySettingChanged(key, host);
         }
         return true;
     }
@@ -346,9 +402,25 @@ bool MythDB::SaveSettingOnHost(const QString &key,
 
     ClearSettingsCache(host + ' ' + key);
 
+    if (success)
+        NotifySettingChanged(key, host);
+
     return success;
 }
 
+/** \brief Tells the listeners of this process that a setting was saved.
+ *
+ *  The MythEvent message is "SETTING_CHANGED", with the key and the host,
+ *  empty for a global setting, as its extra data. Listeners may read the
+ *  new value right away, the settings cache no longer holds the old one.
+ */
+void MythDB::NotifySettingChanged(const QString &key, const QString &host)
+{
+    if (gCoreContext)
+        gCoreContext->dispatch(
+            MythEvent("SETTING_CHANGED", QStringList() << key << host));
+}
+
 bool MythDB::ClearSetting(const QString &key)
 {
     return ClearSettingOnHost(key, d->m_localhostname);
@@ -364,25 +436,8 @@ QString MythDB::GetSetting(const QString &_key, const QString &defaultval)
     QString key = _key.toLower();
     QString value = defaultval;
 
-    d->settingsCacheLock.lockForRead();
-    if (d->useSettingsCache)
-    {
-        SettingsMap::const_iterator it = d->settingsCache.find(key);
-        if (it != d->settingsCache.end())
-        {
-            value = *it;
-            d->settingsCacheLock.unlock();
-            return value;
-        }
-    }
-    SettingsMap::const_iterator it = d->overriddenSettings.find(key);
-    if (it != d->overriddenSettings.end())
-    {
-        value = *it;
-        d->settingsCacheLock.unlock();
+    if (d->FindSetting(key, value))
         return value;
-    }
-    d->settingsCacheLock.unlock();
 
     if (d->ignoreDatabase || !HaveValidDatabase())
         return value;
@@ -417,16 +472,7 @@ QString MythDB::GetSetting(const QString &_key, const QString &defaultval)
     }
 
     if (d->useSettingsCache && value != kSentinelValue)
-    {
-        key.squeeze();
-        value.squeeze();
-        d->settingsCacheLock.lockForWrite();
-        // another thread may have inserted a value into the cache
-        // while we did not have the lock, check first then save
-        if (d->settingsCache.find(key) == d->settingsCache.end())
-            d->settingsCache[key] = value;
-        d->settingsCacheLock.unlock();
-    }
+        d->CacheSetting(key, value);
 
     return value;
 }
@@ -444,32 +490,14 @@ bool MythDB::GetSettings(QMap<QString,QString> &_key_value_pairs)
 
     {
         uint done_cnt = 0;
-        d->settingsCacheLock.lockForRead();
-        if (d->useSettingsCache)
-        {
-            for (; kvit != _key_value_pairs.end(); ++dit, ++kvit)
-            {
-                SettingsMap::const_iterator it = d->settingsCache.find(dit.key());
-                if (it != d->settingsCache.end())
-                {
-                    *kvit = *it;
-                    *dit = true;
-                    done_cnt++;
-                }
-            }
-        }
         for (; kvit != _key_value_pairs.end(); ++dit, ++kvit)
         {
-            SettingsMap::const_iterator it =
-                d->overriddenSettings.find(dit.key());
-            if (it != d->overriddenSettings.end())
+            if (d->FindSetting(dit.key(), *kvit))
             {
-                *kvit = *it;
                 *dit = true;
                 done_cnt++;
             }
         }
-        d->settingsCacheLock.unlock();
 
         // Avoid extra work if everything was in the caches and
         // also don't try to access the DB if ignoreDatabase is set
@@ -530,22 +558,24 @@ bool MythDB::GetSettings(QMap<QString,QString> &_key_value_pairs)
 
     if (d->useSettingsCache)
     {
-        d->settingsCacheLock.lockForWrite();
-        QMap<QString,KVIt>::const_iterator it = keymap.begin();
-        for (; it != keymap.end(); ++it)
+        d->settingsCache.Modify([&](SettingsCache &cache)
         {
-            QString key = it.key(), value = **it;
-
-            // another thread may have inserted a value into the cache
-            // while we did not have the lock, check first then save
-            if (d->settingsCache.find(key) == d->settingsCache.end())
+            QMap<QString,KVIt>::const_iterator it = keymap.begin();
+            for (; it != keymap.end(); ++it)
             {
-                key.squeeze();
-                value.squeeze();
-                d->settingsCache[key] = value;
+                QString key = it.key(), value = **it;
+
+                // another thread may have inserted a value into the cache
+                // while we read the database, keep the first one
+                if (!cache.settings.contains(key))
+                {
+                    key.squeeze();
+                    value.squeeze();
+                    cache.settings.insert(key, value);
+                }
             }
-        }
-        d->settingsCacheLock.unlock();
+            return true;
+        });
     }
 
     return true;
@@ -614,25 +644,8 @@ QString MythDB::GetSettingOnHost(const QString &_key, const QString &_host,
     QString value = defaultval;
     QString myKey = host + ' ' + key;
 
-    d->settingsCacheLock.lockForRead();
-    if (d->useSettingsCache)
-    {
-        SettingsMap::const_iterator it = d->settingsCache.find(myKey);
-        if (it != d->settingsCache.end())
-        {
-            value = *it;
-            d->settingsCacheLock.unlock();
-            return value;
-        }
-    }
-    SettingsMap::const_iterator it = d->overriddenSettings.find(myKey);
-    if (it != d->overriddenSettings.end())
-    {
-        value = *it;
-        d->settingsCacheLock.unlock();
+    if (d->FindSetting(myKey, value))
         return value;
-    }
-    d->settingsCacheLock.unlock();
 
     if (d->ignoreDatabase)
         return value;
@@ -660,14 +673,7 @@ QString MythDB::GetSettingOnHost(const QString &_key, const QString &_host,
     }
 
     if (d->useSettingsCache && value != kSentinelValue)
-    {
-        myKey.squeeze();
-        value.squeeze();
-        d->settingsCacheLock.lockForWrite();
-        if (d->settingsCache.find(myKey) == d->settingsCache.end())
-            d->settingsCache[myKey] = value;
-        d->settingsCacheLock.unlock();
-    }
+        d->CacheSetting(myKey, value);
 
     return value;
 }
@@ -797,11 +803,13 @@ void MythDB::OverrideSettingForSession(
     mk2.squeeze();
     mv.squeeze();
 
-    d->settingsCacheLock.lockForWrite();
-    d->overriddenSettings[mk] = mv;
-    d->settingsCache[mk]      = mv;
-    d->settingsCache[mk2]     = mv;
-    d->settingsCacheLock.unlock();
+    d->settingsCache.Modify([&](SettingsCache &cache)
+    {
+        cache.overrides[mk] = mv;
+        cache.settings[mk]  = mv;
+        cache.settings[mk2] = mv;
+        return true;
+    });
 }
 
 /// \brief Clears session Overrides for the given setting.
@@ -810,24 +818,16 @@ void MythDB::ClearOverrideSettingForSession(const QString &key)
     QString mk = key.toLower();
     QString mk2 = d->m_localhostname + ' ' + mk;
 
-    d->settingsCacheLock.lockForWrite();
-
-    SettingsMap::iterator oit = d->overriddenSettings.find(mk);
-    if (oit != d->overriddenSettings.end())
-        d->overriddenSettings.erase(oit);
-
-    SettingsMap::iterator sit = d->settingsCache.find(mk);
-    if (sit != d->settingsCache.end())
-        d->settingsCache.erase(sit);
-
-    sit = d->settingsCache.find(mk2);
-    if (sit != d->settingsCache.end())
-        d->settingsCache.erase(sit);
-
-    d->settingsCacheLock.unlock();
+    d->settingsCache.Modify([&](SettingsCache &cache)
+    {
+        int removed = cache.overrides.remove(mk);
+        removed += cache.settings.remove(mk);
+        removed += cache.settings.remove(mk2);
+        return removed > 0;
+    });
 }
 
-static void clear(
+static bool clear(
     SettingsMap &cache, SettingsMap &overrides, const QString &myKey)
 {
     // Do the actual clearing..
@@ -840,6 +840,7 @@ static void clear(
             LOG(VB_DATABASE, LOG_INFO,
                     QString("Clearing Settings Cache for '%1'.").arg(myKey));
             cache.erase(it);
+            return true;
         }
         else
         {
@@ -848,40 +849,44 @@ static void clear(
                     .arg(myKey));
         }
     }
+    return false;
 }
 
 void MythDB::ClearSettingsCache(const QString &_key)
 {
-    d->settingsCacheLock.lockForWrite();
-
     if (_key.isEmpty())
     {
         LOG(VB_DATABASE, LOG_INFO, "Clearing Settings Cache.");
-        d->settingsCache.clear();
-        d->settingsCache.reserve(settings_reserve);
-
-        SettingsMap::const_iterator it = d->overriddenSettings.begin();
-        for (; it != d->overriddenSettings.end(); ++it)
+        d->settingsCache.Modify([&](SettingsCache &cache)
         {
-            QString mk2 = d->m_localhostname + ' ' + it.key();
-            mk2.squeeze();
+            cache.settings.clear();
+            cache.settings.reserve(settings_reserve);
 
-            d->settingsCache[it.key()] = *it;
-            d->settingsCache[mk2] = *it;
-        }
-    }
-    else
-    {
-        QString myKey = _key.toLower();
-        clear(d->settingsCache, d->overriddenSettings, myKey);
+            SettingsMap::const_iterator it = cache.overrides.begin();
+            for (; it != cache.overrides.end(); ++it)
+            {
+                QString mk2 = d->m_localhostname + ' ' + it.key();
+                mk2.squeeze();
 
-        // To be safe always clear any local[ized] version too
-        QString mkl = myKey.section(QChar(' '), 1);
-        if (!mkl.isEmpty())
-            clear(d->settingsCache, d->overriddenSettings, mkl);
+                cache.settings[it.key()] = *it;
+                cache.settings[mk2] = *it;
+            }
+            return true;
+        });
+        return;
     }
 
-    d->settingsCacheLock.unlock();
+    QString myKey = _key.toLower();
+    // To be safe always clear any local[ized] version too
+    QString mkl = myKey.section(QChar(' '), 1);
+
+    d->settingsCache.Modify([&](SettingsCache &cache)
+    {
+        bool cleared = clear(cache.settings, cache.overrides, myKey);
+        if (!mkl.isEmpty())
+            cleared |= clear(cache.settings, cache.overrides, mkl);
+        return cleared;
+    });
 }
 
 void MythDB::ActivateSettingsCache(bool activate)
@@ -91,6 +91,8 @@ class MBASE_PUBLIC MythDB
    ~MythDB();
 
   private:
+    void NotifySettingChanged(const QString &key, const QString &host);
+
     MythDBPrivate *d;
 };
 
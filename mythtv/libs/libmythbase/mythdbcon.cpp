@@ -32,6 +32,14 @@
 #endif
 
 static const uint kPurgeTimeout = 60 * 60;
+/// Prepared statements kept per connection
+static const int kMaxCachedStatements = 32;
+/// Milliseconds a thread waits for a connection before exceeding the limit
+static const int kMaxConnectionWait = 5000;
+/// Milliseconds between looks for idle connections to close
+static const int kReclaimInterval = 60 * 1000;
+/// Milliseconds between looks while a thread is waiting for a connection
+static const int kReclaimRetry = 100;
 
 bool TestDatabase(QString dbHostName,
                   QString dbUserName,
@@ -72,7 +80,8 @@ bool TestDatabase(QString dbHostName,
     return ret;
 }
 
-MSqlDatabase::MSqlDatabase(const QString &name)
+MSqlDatabase::MSqlDatabase(const QString &name) :
+    m_nextStatementId(0), m_statementHits(0), m_statementMisses(0)
 {
     m_name = name;
 
@@ -98,6 +107,8 @@ MSqlDatabase::MSqlDatabase(const QString &name)
 
 MSqlDatabase::~MSqlDatabase()
 {
+    ClearStatements();
+
     if (m_db.isOpen())
     {
         m_db.close();
@@ -254,6 +265,8 @@ bool MSqlDatabase::KickDatabase(void)
 
 bool MSqlDatabase::Reconnect()
 {
+    // the server drops the prepared statements with the connection
+    ClearStatements();
     m_db.close();
     m_db.open();
 
@@ -275,14 +288,230 @@ void MSqlDatabase::InitSessionVars()
     m_db.exec("SET @@session.sql_mode=''");
 }
 
+/** \fn MSqlDatabase::TakeStatement(const QString&, QSqlQuery&, int&)
+ *  \brief Returns the prepared statement for \p sql, if there is one that
+ *         no other query is using, and marks it as in use.
+ *  \param[out] id Identifies the statement to ReleaseStatement().
+ */
+bool MSqlDatabase::TakeStatement(const QString &sql, QSqlQuery &query,
+                                 int &id)
+{
+    for (int i = 0; i < m_statements.size(); ++i)
+    {
+        if (m_statements[i].sql != sql)
+            continue;
+        if (m_statements[i].inUse)
+            break;
+
+        m_statements.move(i, 0);
+        m_statements[0].inUse = true;
+        query = m_statements[0].query;
+        id = m_statements[0].id;
+        m_statementHits++;
+        return true;
+    }
+
+    m_statementMisses++;
+    return false;
+}
+
+/** \fn MSqlDatabase::AddStatement(const QString&, const QSqlQuery&)
+ *  \brief Keeps a newly prepared statement, in use by the caller, in place
+ *         of the least recently used one.
+ *  \return The id for ReleaseStatement(), or 0 if it was not kept.
+ */
+int MSqlDatabase::AddStatement(const QString &sql, const QSqlQuery &query)
+{
+    for (int i = 0; i < m_statements.size(); ++i)
+    {
+        // another query on this connection is using the same SQL
+        if (m_statements[i].sql == sql)
+            return 0;
+    }
+
+    if (m_statements.size() >= kMaxCachedStatements)
+    {
+        int i = m_statements.size() - 1;
+        while (i >= 0 && m_statements[i].inUse)
+            --i;
+        if (i < 0)
+            return 0;
+        m_statements.removeAt(i);
+    }
+
+    CachedStatement statement;
+    statement.sql   = sql;
+    statement.query = query;
+    statement.id    = ++m_nextStatementId;
+    statement.inUse = true;
+    m_statements.prepend(statement);
+    return statement.id;
+}
+
+void MSqlDatabase::ReleaseStatement(int id)
+{
+    for (int i = 0; i < m_statements.size(); ++i)
+    {
+        if (m_statements[i].id == id)
+        {
+            m_statements[i].inUse = false;
+            return;
+        }
+    }
+}
+
+void MSqlDatabase::ClearStatements(void)
+{
+    m_statements.clear();
+}
+
 // -----------------------------------------------------------------------
 
 
 
-MDBManager::MDBManager()
+MDBConnectionLimit::MDBConnectionLimit(int maxWait) : m_maxWait(maxWait)
+{
+}
+
+/// Sets the number of connections that may be open, 0 for no limit.
+void MDBConnectionLimit::SetMax(int max)
+{
+    QMutexLocker locker(&m_lock);
+    m_max = qMax(max, 0);
+    m_wait.wakeAll();
+}
+
+int MDBConnectionLimit::GetMax(void) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_max;
+}
+
+bool MDBConnectionLimit::IsFull(void) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_max > 0 && m_count >= m_max;
+}
+
+/** \fn MDBConnectionLimit::Acquire(bool)
+ *  \brief Counts a connection that is about to be opened, waiting for
+ *         another to be closed first if the limit has been reached.
+ *  \param mayWait false to open the connection at once even so.
+ *  \return false if the connection is over the limit.
+ */
+bool MDBConnectionLimit::Acquire(bool mayWait)
+{
+    QMutexLocker locker(&m_lock);
+
+    if (m_max <= 0 || m_count < m_max)
+    {
+        m_count++;
+        return true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while (mayWait && m_max > 0 && m_count >= m_max)
+    {
+        qint64 left = m_maxWait - timer.elapsed();
+        if (left <= 0)
+            break;
+        m_wait.wait(&m_lock, left);
+    }
+
+    qint64 elapsed = timer.elapsed();
+    bool within = m_max <= 0 || m_count < m_max;
+    m_count++;
+
+    if (mayWait)
+    {
+        m_waitCount++;
+        m_waitTime += elapsed;
+        m_longestWait = qMax(m_longestWait, elapsed);
+        LOG(VB_DATABASE, LOG_INFO,
+            QString("Waited %1ms for a DB connection").arg(elapsed));
+    }
+
+    if (!within)
+    {
+        m_overLimit++;
+        LOG(VB_GENERAL, LOG_WARNING,
+            QString("All %1 DB connections have been in use for %2ms, "
+                    "opening another").arg(m_count - 1).arg(elapsed));
+    }
+
+    return within;
+}
+
+/// Counts connections that have been closed.
+void MDBConnectionLimit::Release(int count)
+{
+    QMutexLocker locker(&m_lock);
+    m_count -= count;
+    m_wait.wakeAll();
+}
+
+int MDBConnectionLimit::Count(void) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_count;
+}
+
+QString MDBConnectionLimit::GetStatus(void) const
+{
+    QMutexLocker locker(&m_lock);
+    return QString("%1 pooled DB connections, %2 waits for a connection "
+                   "taking %3ms (longest %4ms), %5 times over the limit")
+        .arg(m_count).arg(m_waitCount).arg(m_waitTime)
+        .arg(m_longestWait).arg(m_overLimit);
+}
+
+// -----------------------------------------------------------------------
+
+/// Closes idle pooled connections for MDBManager
+class MDBReclaimThread : public MThread
+{
+  public:
+    explicit MDBReclaimThread(MDBManager *manager) :
+        MThread("DBReclaim"), m_manager(manager) {}
+
+  protected:
+    void run(void) override
+    {
+        RunProlog();
+        m_manager->ReclaimConnections();
+        RunEpilog();
+    }
+
+  private:
+    MDBManager *m_manager;
+};
+
+/** \class MDBManager
+ *
+ *   Connections belong to the thread that opened them, as Qt requires, and
+ *   each thread keeps its idle connections for its next query. The
+ *   DBReclaim thread closes the connections that have been idle for
+ *   kPurgeTimeout, whichever thread they belong to.
+ *
+ *   The number of pooled connections is unlimited unless the
+ *   DBMaxConnections setting is set. At the limit a thread that needs a new
+ *   connection waits, see MDBConnectionLimit, while the DBReclaim thread
+ *   closes the longest idle connection of another thread for it. The UI
+ *   thread never waits, and never has its connections closed for another
+ *   thread.
+ */
+MDBManager::MDBManager() : m_connLimit(kMaxConnectionWait)
 {
     m_nextConnID = 0;
-    m_connCount = 0;
+
+    m_statementHits = 0;
+    m_statementMisses = 0;
+
+    m_reclaimThread = nullptr;
+    m_reclaimStop = false;
+    m_reclaimWanted = 0;
 
     m_schedCon = nullptr;
     m_DDCon = nullptr;
@@ -290,15 +519,18 @@ MDBManager::MDBManager()
 
 MDBManager::~MDBManager()
 {
+    StopReclaiming();
+
+    LOG(VB_DATABASE, LOG_INFO, GetPoolStatus());
     CloseDatabases();
 
-    if (m_connCount != 0 || m_schedCon || m_DDCon)
+    if (m_connLimit.Count() != 0 || m_schedCon || m_DDCon)
     {
         LOG(VB_GENERAL, LOG_CRIT,
             "MDBManager exiting with connections still open");
     }
 #if 0 /* some post logStop() debugging... */
-    cout<<"m_connCount: "<<m_connCount<<endl;
+    cout<<"m_connCount: "<<m_connLimit.Count()<<endl;
     cout<<"m_schedCon: "<<m_schedCon<<endl;
     cout<<"m_DDCon: "<<m_DDCon<<endl;
 #endif
@@ -328,10 +560,32 @@ MSqlDatabase *MDBManager::popConnection(bool reuse)
     DBList &list = m_pool[QThread::currentThread()];
     if (list.isEmpty())
     {
+        if (!m_reclaimThread && !m_reclaimStop)
+        {
+            m_reclaimThread = new MDBReclaimThread(this);
+            m_reclaimThread->start();
+        }
+
+        bool mayWait = !(gCoreContext && gCoreContext->IsUIThread());
+        bool wanted = mayWait && m_connLimit.IsFull();
+        if (wanted)
+        {
+            // have an idle connection of another thread closed for this one
+            m_reclaimWanted++;
+            m_reclaimWait.wakeAll();
+        }
+
+        m_lock.unlock();
+        m_connLimit.Acquire(mayWait);
+        m_lock.lock();
+
+        if (wanted)
+            m_reclaimWanted--;
+
         db = new MSqlDatabase("DBManager" + QString::number(m_nextConnID++));
-        ++m_connCount;
         LOG(VB_DATABASE, LOG_INFO,
-                QString("New DB connection, total: %1").arg(m_connCount));
+                QString("New DB connection, total: %1")
+                .arg(m_connLimit.Count()));
     }
     else
     {
@@ -375,6 +629,11 @@ void MDBManager::pushConnection(MSqlDatabase *db)
     {
         db->m_lastDBKick = MythDate::current();
         m_pool[QThread::currentThread()].push_front(db);
+
+        m_statementHits += db->m_statementHits;
+        m_statementMisses += db->m_statementMisses;
+        db->m_statementHits = 0;
+        db->m_statementMisses = 0;
     }
 
     m_lock.unlock();
@@ -407,7 +666,7 @@ void MDBManager::PurgeIdleConnections(bool leaveOne)
         // seconds close it.
         MSqlDatabase *entry = *it;
         it = list.erase(it);
-        --m_connCount;
+        m_connLimit.Release();
         purgedConnections++;
 
         // Qt's MySQL driver apparently keeps track of the number of
@@ -424,11 +683,13 @@ void MDBManager::PurgeIdleConnections(bool leaveOne)
             purgedConnections > 0 &&
             totalConnections == purgedConnections)
         {
+            // replaces a connection just released, so it never waits
+            m_connLimit.Acquire(false);
             newDb = new MSqlDatabase("DBManager" +
                                      QString::number(m_nextConnID++));
-            ++m_connCount;
             LOG(VB_GENERAL, LOG_INFO,
-                    QString("New DB connection, total: %1").arg(m_connCount));
+                    QString("New DB connection, total: %1")
+                    .arg(m_connLimit.Count()));
             newDb->m_lastDBKick = MythDate::current();
         }
 
@@ -447,6 +708,140 @@ void MDBManager::PurgeIdleConnections(bool leaveOne)
     }
 }
 
+/// Stops the DBReclaim thread, idle connections are then only closed by
+/// their own thread.
+void MDBManager::StopReclaiming(void)
+{
+    m_lock.lock();
+    MDBReclaimThread *reclaimThread = m_reclaimThread;
+    m_reclaimThread = nullptr;
+    m_reclaimStop = true;
+    m_reclaimWait.wakeAll();
+    m_lock.unlock();
+
+    if (reclaimThread)
+    {
+        reclaimThread->wait();
+        delete reclaimThread;
+    }
+}
+
+/// Limits the number of pooled connections, 0 for no limit.
+void MDBManager::SetMaxConnections(int max)
+{
+    m_connLimit.SetMax(max);
+    if (max > 0)
+    {
+        LOG(VB_DATABASE, LOG_INFO,
+            QString("Limiting the DB connection pool to %1 connections")
+            .arg(max));
+    }
+}
+
+// Run by the DBReclaim thread until MDBManager is destroyed.
+void MDBManager::ReclaimConnections(void)
+{
+    QMutexLocker locker(&m_lock);
+
+    while (!m_reclaimStop)
+    {
+        m_reclaimWait.wait(&m_lock, m_reclaimWanted > 0 ?
+                           kReclaimRetry : kReclaimInterval);
+        if (m_reclaimStop)
+            break;
+
+        DBList list = TakeReclaimable();
+        if (list.isEmpty())
+            continue;
+
+        locker.unlock();
+
+        // Nothing uses an idle connection, and it is no longer in the pool
+        // for its thread to take, so it can be closed from this one
+        for (DBList::iterator it = list.begin(); it != list.end(); ++it)
+        {
+            LOG(VB_DATABASE, LOG_INFO,
+                "Closing idle DB connection named '" + (*it)->m_name + "'");
+            delete (*it);
+        }
+        m_connLimit.Release(list.size());
+
+        locker.relock();
+    }
+}
+
+// Takes the connections to close out of the pool: those idle for
+// kPurgeTimeout, and one more for each thread waiting for a connection.
+// The last pooled connection is kept, see PurgeIdleConnections(), and so
+// are the UI thread's. m_lock must be held.
+MDBManager::DBList MDBManager::TakeReclaimable(void)
+{
+    QThread *uiThread = QCoreApplication::instance() ?
+        QCoreApplication::instance()->thread() : nullptr;
+    QDateTime now = MythDate::current();
+    int keep = m_connLimit.Count() - 1;
+    DBList list;
+
+    QHash<QThread*, DBList>::iterator it = m_pool.begin();
+    for (; it != m_pool.end() && keep > 0; ++it)
+    {
+        if (it.key() == uiThread)
+            continue;
+        DBList::iterator dit = it->begin();
+        while (dit != it->end() && keep > 0)
+        {
+            if ((*dit)->m_lastDBKick.secsTo(now) <= (int)kPurgeTimeout)
+            {
+                ++dit;
+                continue;
+            }
+            list.append(*dit);
+            dit = it->erase(dit);
+            keep--;
+        }
+    }
+
+    for (int i = 0; i < m_reclaimWanted && keep > 0; i++)
+    {
+        DBList *oldestList = nullptr;
+        DBList::iterator oldest;
+        for (it = m_pool.begin(); it != m_pool.end(); ++it)
+        {
+            if (it.key() == uiThread)
+                continue;
+            DBList::iterator dit = it->begin();
+            for (; dit != it->end(); ++dit)
+            {
+                if (!oldestList ||
+                    (*dit)->m_lastDBKick < (*oldest)->m_lastDBKick)
+                {
+                    oldestList = &(*it);
+                    oldest = dit;
+                }
+            }
+        }
+
+        if (!oldestList)
+            break;
+
+        list.append(*oldest);
+        oldestList->erase(oldest);
+        keep--;
+    }
+
+    return list;
+}
+
+/// Returns the connection pool and statement cache statistics.
+QString MDBManager::GetPoolStatus(void)
+{
+    QMutexLocker locker(&m_lock);
+    qint64 lookups = m_statementHits + m_statementMisses;
+    return m_connLimit.GetStatus() +
+        QString(", %1% of %2 prepares reused a statement")
+        .arg(lookups ? m_statementHits * 100 / lookups : 0).arg(lookups);
+}
+
 MSqlDatabase *MDBManager::getStaticCon(MSqlDatabase **dbcon, QString name)
 {
     if (!dbcon)
@@ -487,11 +882,13 @@ void MDBManager::CloseDatabases()
     {
         LOG(VB_DATABASE, LOG_INFO,
             "Closing DB connection named '" + (*it)->m_name + "'");
+        (*it)->ClearStatements();
         (*it)->m_db.close();
         delete (*it);
-        m_connCount--;
     }
 
+    m_connLimit.Release(list.size());
+
     m_lock.lock();
     DBList &slist = m_static_pool[QThread::currentThread()];
     while (!slist.isEmpty())
@@ -527,12 +924,15 @@ MSqlQuery::MSqlQuery(const MSqlQueryInfo &qi)
     m_isConnected = false;
     m_db = qi.db;
     m_returnConnection = qi.returnConnection;
+    m_cachedStatement = 0;
 
     m_isConnected = m_db && m_db->isOpen();
 }
 
 MSqlQuery::~MSqlQuery()
 {
+    ReleaseStatement();
+
     if (m_returnConnection)
     {
         MDBManager *dbmanager = GetMythDB()->GetDBManager();
@@ -728,6 +1128,8 @@ bool MSqlQuery::exec(const QString &query)
         return false;
     }
 
+    ReleaseStatement();
+
     // Database connection down.  Try to restart it, give up if it's still
     // down
     if (!m_db->isOpen() && !Reconnect())
@@ -824,6 +1226,9 @@ bool MSqlQuery::prepare(const QString& query)
         return false;
     }
 
+    // hand back the statement of the last prepare() before taking another
+    ReleaseStatement();
+
     m_last_prepared_query = query;
 
     if (!m_db->isOpen() && !Reconnect())
@@ -832,6 +1237,21 @@ bool MSqlQuery::prepare(const QString& query)
         return false;
     }
 
+    QSqlQuery cached;
+    if (m_db->TakeStatement(query, cached, m_cachedStatement))
+    {
+        // Share the statement, and forget the values its last user bound
+        QSqlQuery::operator=(cached);
+        setForwardOnly(true);
+        QMapIterator<QString, QVariant> b(QSqlQuery::boundValues());
+        while (b.hasNext())
+        {
+            b.next();
+            QSqlQuery::bindValue(b.key(), QVariant(), QSql::In);
+        }
+        return true;
+    }
+
     // QT docs indicate that there are significant speed ups and a reduction
     // in memory usage by enabling forward-only cursors
     //
@@ -857,9 +1277,27 @@ bool MSqlQuery::prepare(const QString& query)
             MythDB::DBErrorMessage(QSqlQuery::lastError()));
     }
 
+    if (ok)
+        m_cachedStatement = m_db->AddStatement(query, *this);
+
     return ok;
 }
 
+/// Returns the cached statement this query uses, if any, to the connection.
+void MSqlQuery::ReleaseStatement(void)
+{
+    if (!m_cachedStatement)
+        return;
+
+    // Free the result set, and stop sharing the statement so the next
+    // prepare() or exec(QString) on this query leaves it alone
+    QSqlQuery::finish();
+    QSqlQuery::operator=(QSqlQuery(QString(), m_db->db()));
+
+    m_db->ReleaseStatement(m_cachedStatement);
+    m_cachedStatement = 0;
+}
+
 bool MSqlQuery::testDBConnection()
 {
     MSqlDatabase *db = GetMythDB()->GetDBManager()->popConnection(true);
@@ -893,6 +1331,8 @@ QVariant MSqlQuery::lastInsertId()
 
 bool MSqlQuery::Reconnect(void)
 {
+    // the cached statements are gone with the old connection
+    m_cachedStatement = 0;
     if (!m_db->Reconnect())
         return false;
     if (!m_last_prepared_query.isEmpty())
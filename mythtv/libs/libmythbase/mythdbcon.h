@@ -9,6 +9,7 @@
 #include <QRegExp>
 #include <QDateTime>
 #include <QMutex>
+#include <QWaitCondition>
 #include <QList>
 
 #include "mythbaseexp.h"
@@ -42,13 +43,67 @@ class MSqlDatabase
     bool Reconnect(void);
     void InitSessionVars(void);
 
+    bool TakeStatement(const QString &sql, QSqlQuery &query, int &id);
+    int  AddStatement(const QString &sql, const QSqlQuery &query);
+    void ReleaseStatement(int id);
+    void ClearStatements(void);
+
   private:
+    /// A prepared statement kept for the next query with the same SQL
+    struct CachedStatement
+    {
+        QString   sql;
+        QSqlQuery query;
+        int       id;
+        bool      inUse;
+    };
+
     QString m_name;
     QSqlDatabase m_db;
     QDateTime m_lastDBKick;
     DatabaseParams m_dbparms;
+    QList<CachedStatement> m_statements; // most recently used first
+    int m_nextStatementId;
+    int m_statementHits;
+    int m_statementMisses;
 };
 
+/** \brief Limits the number of pooled DB connections a process opens.
+ *
+ *   A thread that needs a connection at the limit waits for one to be
+ *   closed, for up to the wait given to the constructor, then opens one
+ *   anyway, since the threads holding connections may be waiting on it.
+ *   Used by MDBManager. Do not use directly.
+ */
+class MBASE_PUBLIC MDBConnectionLimit
+{
+  public:
+    explicit MDBConnectionLimit(int maxWait);
+
+    void SetMax(int max);
+    int  GetMax(void) const;
+    bool IsFull(void) const;
+    bool Acquire(bool mayWait);
+    void Release(int count = 1);
+    int  Count(void) const;
+    QString GetStatus(void) const;
+
+  private:
+    mutable QMutex m_lock;
+    QWaitCondition m_wait;      // signalled when a connection is closed
+    const int      m_maxWait;
+    int            m_max         {0}; // 0 for no limit
+    int            m_count       {0};
+
+    // statistics, protected by m_lock
+    int            m_waitCount   {0};
+    qint64         m_waitTime    {0};
+    qint64         m_longestWait {0};
+    int            m_overLimit   {0};
+};
+
+class MDBReclaimThread;
+
 /// \brief DB connection pool, used by MSqlQuery. Do not use directly.
 class MBASE_PUBLIC MDBManager
 {
@@ -59,6 +114,9 @@ class MBASE_PUBLIC MDBManager
 
     void CloseDatabases(void);
     void PurgeIdleConnections(bool leaveOne = false);
+    void SetMaxConnections(int max);
+    void StopReclaiming(void);
+    QString GetPoolStatus(void);
 
   protected:
     MSqlDatabase *popConnection(bool reuse);
@@ -68,10 +126,14 @@ class MBASE_PUBLIC MDBManager
     MSqlDatabase *getDDCon(void);
 
   private:
+    friend class MDBReclaimThread;
+    typedef QList<MSqlDatabase*> DBList;
+
     MSqlDatabase *getStaticCon(MSqlDatabase **dbcon, QString name);
+    void ReclaimConnections(void);
+    DBList TakeReclaimable(void);
 
     QMutex m_lock;
-    typedef QList<MSqlDatabase*> DBList;
     QHash<QThread*, DBList> m_pool; // protected by m_lock
 #if REUSE_CONNECTION
     QHash<QThread*, MSqlDatabase*> m_inuse; // protected by m_lock
@@ -79,7 +141,16 @@ class MBASE_PUBLIC MDBManager
 #endif
 
     int m_nextConnID;
-    int m_connCount;
+    MDBConnectionLimit m_connLimit; // counts the pooled connections
+
+    // Statement cache statistics, protected by m_lock
+    qint64 m_statementHits;
+    qint64 m_statementMisses;
+
+    MDBReclaimThread *m_reclaimThread; // protected by m_lock
+    QWaitCondition m_reclaimWait;      // wakes m_reclaimThread
+    bool m_reclaimStop;                // protected by m_lock
+    int  m_reclaimWanted; ///< threads waiting for a connection to be closed
 
     MSqlDatabase *m_schedCon;
     MSqlDatabase *m_DDCon;
@@ -121,6 +192,11 @@ typedef QMap<QString, QVariant> MSqlBindings;
  *   Note: Due to a bug in some Qt/MySql combinations, QSqlDatabase connections
  *   will crash if closed and reopend - so we never close them and keep them in
  *   a pool.
+ *
+ *   Each connection keeps the statements it most recently prepared. When
+ *   prepare() is called with the same SQL text as one of them, and no other
+ *   query is using it, the statement is reused rather than prepared again
+ *   on the server. Values bound by its previous user are cleared.
  */
 class MBASE_PUBLIC MSqlQuery : private QSqlQuery
 {
@@ -218,10 +294,12 @@ class MBASE_PUBLIC MSqlQuery : private QSqlQuery
 
     bool seekDebug(const char *type, bool result,
                    int where, bool relative) const;
+    void ReleaseStatement(void);
 
     MSqlDatabase *m_db;
     bool m_isConnected;
     bool m_returnConnection;
+    int m_cachedStatement; // id of the cached statement in use, or 0
     QString m_last_prepared_query; // holds a copy of the last prepared query
 };
 
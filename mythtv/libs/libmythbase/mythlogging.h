@@ -21,8 +21,9 @@ extern "C" {
 // Helper for checking verbose mask & level outside of LOG macro
 #define VERBOSE_LEVEL_NONE        (verboseMask == 0)
 #ifdef __cplusplus
+// Component levels are rare, so test for them before any map lookup
 #define VERBOSE_LEVEL_CHECK(_MASK_, _LEVEL_) \
-    (componentLogLevel.contains(_MASK_) ?                               \
+    ((!componentLogLevel.isEmpty() && componentLogLevel.contains(_MASK_)) ? \
      (*(componentLogLevel.find(_MASK_)) >= _LEVEL_) :                   \
      (((verboseMask & (_MASK_)) == (_MASK_)) && logLevel >= (_LEVEL_)))
 #else
@@ -0,0 +1,142 @@
+#ifndef MYTHSNAPSHOT_H_
+#define MYTHSNAPSHOT_H_
+
+#include <QAtomicPointer>
+#include <QAtomicInt>
+#include <QMutexLocker>
+#include <QMutex>
+#include <QThread>
+
+/** \class MythSnapshot
+ *  \brief An immutable value that many threads read and a few replace.
+ *
+ *   Readers never block. A Reader marks its thread as reading in one of a
+ *   few counters, chosen by thread so that readers on different cores
+ *   rarely touch the same cache line, and then simply dereferences the
+ *   current snapshot.
+ *
+ *   Writers are serialized. Modify() copies the current value, changes the
+ *   copy and publishes it with an atomic pointer swap, then waits for the
+ *   readers that may still see the old value to finish before deleting it.
+ *   Two counter generations are used for this, as in user space RCU, so a
+ *   steady stream of new readers can not hold up a writer.
+ *
+ *   This suits values that are cheap to copy, e.g. the implicitly shared
+ *   Qt containers, and that change rarely compared to how often they are
+ *   read. A thread must not call Modify() while it holds a Reader.
+ */
+template <typename T>
+class MythSnapshot
+{
+  public:
+    explicit MythSnapshot(const T &value = T()) : m_current(new T(value)) {}
+   ~MythSnapshot() { delete m_current.load(); }
+
+    class Reader
+    {
+      public:
+        explicit Reader(const MythSnapshot<T> &snapshot) :
+            m_readers(snapshot.Enter()),
+            m_value(snapshot.m_current.loadAcquire()) {}
+       ~Reader() { m_readers->fetchAndAddOrdered(-1); }
+
+        const T &operator*(void) const  { return *m_value; }
+        const T *operator->(void) const { return m_value;  }
+
+      private:
+        Q_DISABLE_COPY(Reader)
+
+        QAtomicInt *m_readers;
+        const T    *m_value;
+    };
+
+    /// Returns a copy of the current value.
+    T Get(void) const
+    {
+        Reader reader(*this);
+        return *reader;
+    }
+
+    /// Replaces the value.
+    void Set(const T &value)
+    {
+        QMutexLocker locker(&m_writeLock);
+        Publish(new T(value));
+    }
+
+    /// Calls \p modify with a copy of the current value and publishes the
+    /// result. Returns false, publishing nothing, if \p modify does.
+    template <typename F>
+    bool Modify(F modify)
+    {
+        QMutexLocker locker(&m_writeLock);
+        T *value = new T(*m_current.load());
+        if (!modify(*value))
+        {
+            delete value;
+            return false;
+        }
+        Publish(value);
+        return true;
+    }
+
+  private:
+    Q_DISABLE_COPY(MythSnapshot)
+
+    static const int kStripeBits = 4;
+    static const int kStripes = 1 << kStripeBits;
+
+    /// A reader counter padded to a cache line of its own
+    struct Stripe
+    {
+        QAtomicInt readers;
+        char       padding[64 - sizeof(QAtomicInt)];
+    };
+
+    QAtomicInt *Enter(void) const
+    {
+        // Fibonacci hashing spreads the aligned thread ids over the stripes
+        quint64 id = quint64(quintptr(QThread::currentThreadId()));
+        int stripe = int((id * Q_UINT64_C(0x9E3779B97F4A7C15)) >>
+                         (64 - kStripeBits));
+
+        QAtomicInt *readers =
+            &m_stripes[m_generation.loadAcquire()][stripe].readers;
+        readers->fetchAndAddOrdered(1);
+        return readers;
+    }
+
+    void Publish(T *value)
+    {
+        T *old = m_current.fetchAndStoreOrdered(value);
+        Synchronize();
+        delete old;
+    }
+
+    // Waits until no reader can still hold the previous value. A reader
+    // that registered in the old generation after we checked it read the
+    // new value; one that read the generation before the first flip but
+    // registered after it is caught by the second.
+    void Synchronize(void)
+    {
+        for (int phase = 0; phase < 2; ++phase)
+        {
+            int generation = m_generation.loadAcquire();
+            m_generation.fetchAndStoreOrdered(generation ^ 1);
+
+            for (int i = 0; i < kStripes; ++i)
+            {
+                QAtomicInt &readers = m_stripes[generation][i].readers;
+                while (readers.fetchAndAddOrdered(0) != 0)
+                    QThread::yieldCurrentThread();
+            }
+        }
+    }
+
+    QAtomicPointer<T> m_current;
+    QMutex            m_writeLock;
+    mutable QAtomicInt m_generation {0};
+    mutable Stripe    m_stripes[2][kStripes];
+};
+
+#endif
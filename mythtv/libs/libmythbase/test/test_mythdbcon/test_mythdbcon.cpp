@@ -0,0 +1,3 @@
+#include "test_mythdbcon.h"
+
+QTEST_APPLESS_MAIN(TestMythDBCon)
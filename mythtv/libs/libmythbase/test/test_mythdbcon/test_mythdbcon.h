@@ -0,0 +1,143 @@
+/*
+ *  Class TestMythDBCon
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <chrono> // for milliseconds
+#include <thread>
+
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+
+#include "mythdbcon.h"
+
+// Long enough that a test finishing within it didn't time out
+static const int kLongWait = 60 * 1000;
+
+class TestMythDBCon: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void UnlimitedByDefault(void)
+    {
+        MDBConnectionLimit limit(kLongWait);
+        QCOMPARE(limit.GetMax(), 0);
+
+        for (int i = 0; i < 100; i++)
+            QVERIFY(limit.Acquire(true));
+        QVERIFY(!limit.IsFull());
+        QCOMPARE(limit.Count(), 100);
+
+        limit.Release(100);
+        QCOMPARE(limit.Count(), 0);
+    }
+
+    void OpensUpToTheLimit(void)
+    {
+        MDBConnectionLimit limit(kLongWait);
+        limit.SetMax(2);
+
+        QVERIFY(limit.Acquire(true));
+        QVERIFY(!limit.IsFull());
+        QVERIFY(limit.Acquire(true));
+        QVERIFY(limit.IsFull());
+        QCOMPARE(limit.Count(), 2);
+    }
+
+    /// At the limit a connection is opened once another is closed
+    void WaitsForRelease(void)
+    {
+        MDBConnectionLimit limit(kLongWait);
+        limit.SetMax(1);
+        QVERIFY(limit.Acquire(true));
+
+        std::thread closer([&limit]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            limit.Release();
+        });
+
+        QElapsedTimer timer;
+        timer.start();
+        bool within = limit.Acquire(true);
+        qint64 elapsed = timer.elapsed();
+        closer.join();
+
+        QVERIFY(within);
+        QVERIFY(elapsed >= 40);
+        QVERIFY(elapsed < kLongWait);
+        QCOMPARE(limit.Count(), 1);
+    }
+
+    /// A connection is opened anyway once the wait is over
+    void OpensOverTheLimitAfterWaiting(void)
+    {
+        MDBConnectionLimit limit(100);
+        limit.SetMax(1);
+        QVERIFY(limit.Acquire(true));
+
+        QElapsedTimer timer;
+        timer.start();
+        QVERIFY(!limit.Acquire(true));
+        QVERIFY(timer.elapsed() >= 100);
+        QCOMPARE(limit.Count(), 2);
+
+        // both have to be closed before there's room again
+        limit.Release();
+        QVERIFY(limit.IsFull());
+        limit.Release();
+        QVERIFY(!limit.IsFull());
+    }
+
+    /// The UI thread opens a connection at once
+    void NoWaitWhenNotAllowed(void)
+    {
+        MDBConnectionLimit limit(kLongWait);
+        limit.SetMax(1);
+        QVERIFY(limit.Acquire(true));
+
+        QElapsedTimer timer;
+        timer.start();
+        QVERIFY(!limit.Acquire(false));
+        QVERIFY(timer.elapsed() < kLongWait);
+        QCOMPARE(limit.Count(), 2);
+    }
+
+    /// Removing the limit lets a waiting thread go on
+    void RemovingLimitEndsWait(void)
+    {
+        MDBConnectionLimit limit(kLongWait);
+        limit.SetMax(1);
+        QVERIFY(limit.Acquire(true));
+
+        std::thread setter([&limit]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            limit.SetMax(0);
+        });
+
+        QElapsedTimer timer;
+        timer.start();
+        bool within = limit.Acquire(true);
+        qint64 elapsed = timer.elapsed();
+        setter.join();
+
+        QVERIFY(within);
+        QVERIFY(elapsed < kLongWait);
+        QCOMPARE(limit.Count(), 2);
+    }
+};
@@ -0,0 +1,3 @@
+#include "test_mythsnapshot.h"
+
+QTEST_APPLESS_MAIN(TestMythSnapshot)
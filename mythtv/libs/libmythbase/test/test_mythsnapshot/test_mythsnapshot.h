@@ -0,0 +1,247 @@
+/*
+ *  Class TestMythSnapshot
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <atomic>
+#include <chrono> // for milliseconds
+#include <thread>
+#include <vector>
+
+#include <QtTest/QtTest>
+#include <QReadWriteLock>
+#include <QHash>
+
+#include "mythsnapshot.h"
+
+typedef QHash<QString,QString> Settings;
+
+static const int kSettings = 500;
+
+static Settings make_settings(void)
+{
+    Settings settings;
+    for (int i = 0; i < kSettings; i++)
+        settings.insert(QString("setting%1").arg(i), QString::number(i));
+    return settings;
+}
+
+/// Runs readers on all but one core and a writer that changes a setting
+/// every millisecond, while the test thread measures its own reads.
+class Churn
+{
+  public:
+    template <typename Read, typename Write>
+    Churn(Read read, Write write)
+    {
+        int readers = qMax(QThread::idealThreadCount() - 2, 1);
+        for (int i = 0; i < readers; i++)
+        {
+            m_threads.emplace_back([this, read]()
+            {
+                while (!m_stop)
+                    read(QString("setting%1").arg(qrand() % kSettings));
+            });
+        }
+        m_threads.emplace_back([this, write]()
+        {
+            for (int i = 0; !m_stop; i++)
+            {
+                write(QString("setting%1").arg(i % kSettings),
+                      QString::number(i));
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+
+   ~Churn()
+    {
+        m_stop = true;
+        for (auto &thread : m_threads)
+            thread.join();
+    }
+
+  private:
+    std::atomic<bool>        m_stop {false};
+    std::vector<std::thread> m_threads;
+};
+
+class TestMythSnapshot: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void ReadsInitialValue(void)
+    {
+        MythSnapshot<Settings> snapshot(make_settings());
+        MythSnapshot<Settings>::Reader reader(snapshot);
+        QCOMPARE(reader->size(), kSettings);
+        QCOMPARE(reader->value("setting7"), QString("7"));
+    }
+
+    void ModifyPublishes(void)
+    {
+        MythSnapshot<Settings> snapshot(make_settings());
+        QVERIFY(snapshot.Modify([](Settings &settings)
+        {
+            settings["setting7"] = "seven";
+            return true;
+        }));
+        QCOMPARE(snapshot.Get().value("setting7"), QString("seven"));
+    }
+
+    void DeclinedModifyPublishesNothing(void)
+    {
+        MythSnapshot<Settings> snapshot(make_settings());
+        QVERIFY(!snapshot.Modify([](Settings &settings)
+        {
+            settings["setting7"] = "seven";
+            return false;
+        }));
+        QCOMPARE(snapshot.Get().value("setting7"), QString("7"));
+    }
+
+    // A writer must keep the old value alive until its readers are done
+    void ReaderKeepsItsValue(void)
+    {
+        MythSnapshot<Settings> snapshot(make_settings());
+        std::atomic<bool> written {false};
+        std::thread writer;
+        // Checked after the join, a failed QVERIFY returns at once and
+        // a joinable std::thread would abort the whole test
+        bool writtenEarly;
+        int size;
+        QString value;
+        {
+            MythSnapshot<Settings>::Reader reader(snapshot);
+            writer = std::thread([&]()
+            {
+                snapshot.Set(Settings());
+                written = true;
+            });
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            writtenEarly = written;
+            size = reader->size();
+            value = reader->value("setting7");
+        }
+        writer.join();
+        QVERIFY(!writtenEarly);
+        QCOMPARE(size, kSettings);
+        QCOMPARE(value, QString("7"));
+        QVERIFY(written);
+        QVERIFY(snapshot.Get().isEmpty());
+    }
+
+    // Every value a reader sees must be complete: the two settings
+    // are always changed together
+    void ReadersSeeWholeValues(void)
+    {
+        Settings initial;
+        initial["a"] = initial["b"] = "0";
+        MythSnapshot<Settings> snapshot(initial);
+
+        std::atomic<bool> stop {false};
+        std::atomic<int>  torn {0};
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; i++)
+        {
+            readers.emplace_back([&]()
+            {
+                while (!stop)
+                {
+                    MythSnapshot<Settings>::Reader reader(snapshot);
+                    if (reader->value("a") != reader->value("b"))
+                        torn++;
+                }
+            });
+        }
+
+        for (int i = 1; i <= 2000; i++)
+        {
+            snapshot.Modify([i](Settings &settings)
+            {
+                settings["a"] = settings["b"] = QString::number(i);
+                return true;
+            });
+        }
+
+        stop = true;
+        for (auto &reader : readers)
+            reader.join();
+
+        QCOMPARE(int(torn), 0);
+        QCOMPARE(snapshot.Get().value("a"), QString("2000"));
+    }
+
+    // Concurrent setting reads under write churn, lock free
+    void SnapshotReadsUnderChurn(void)
+    {
+        MythSnapshot<Settings> snapshot(make_settings());
+        Churn churn(
+            [&](const QString &key)
+            {
+                MythSnapshot<Settings>::Reader reader(snapshot);
+                return reader->value(key);
+            },
+            [&](const QString &key, const QString &value)
+            {
+                snapshot.Modify([&](Settings &settings)
+                {
+                    settings[key] = value;
+                    return true;
+                });
+            });
+
+        QString key("setting42");
+        QBENCHMARK
+        {
+            for (int i = 0; i < 1000; i++)
+            {
+                MythSnapshot<Settings>::Reader reader(snapshot);
+                QVERIFY(!reader->value(key).isEmpty());
+            }
+        }
+    }
+
+    // The same with the read/write lock MythDB used before, for comparison
+    void LockedReadsUnderChurn(void)
+    {
+        Settings settings = make_settings();
+        QReadWriteLock lock;
+        Churn churn(
+            [&](const QString &key)
+            {
+                QReadLocker locker(&lock);
+                return settings.value(key);
+            },
+            [&](const QString &key, const QString &value)
+            {
+                QWriteLocker locker(&lock);
+                settings[key] = value;
+            });
+
+        QString key("setting42");
+        QBENCHMARK
+        {
+            for (int i = 0; i < 1000; i++)
+            {
+                QReadLocker locker(&lock);
+                QVERIFY(!settings.value(key).isEmpty());
+            }
+        }
+    }
+};
@@ -15,7 +15,7 @@ namespace DTC
 class SERVICE_PUBLIC LiveStreamInfo : public QObject
 {
     Q_OBJECT
-    Q_CLASSINFO( "version"    , "1.0" );
+    Q_CLASSINFO( "version"    , "1.1" );
 
     Q_PROPERTY( int             Id               READ Id                WRITE setId               )
     Q_PROPERTY( int             Width            READ Width             WRITE setWidth            )
@@ -40,6 +40,7 @@ class SERVICE_PUBLIC LiveStreamInfo : public QObject
     Q_PROPERTY( int             SourceWidth      READ SourceWidth       WRITE setSourceWidth      )
     Q_PROPERTY( int             SourceHeight     READ SourceHeight      WRITE setSourceHeight     )
     Q_PROPERTY( int             AudioOnlyBitrate READ AudioOnlyBitrate  WRITE setAudioOnlyBitrate )
+    Q_PROPERTY( int             Renditions       READ Renditions        WRITE setRenditions       )
 
     PROPERTYIMP    ( int        , Id               )
     PROPERTYIMP    ( int        , Width            )
@@ -64,6 +65,7 @@ class SERVICE_PUBLIC LiveStreamInfo : public QObject
     PROPERTYIMP    ( int        , SourceWidth      )
     PROPERTYIMP    ( int        , SourceHeight     )
     PROPERTYIMP    ( int        , AudioOnlyBitrate );
+    PROPERTYIMP    ( int        , Renditions       );
 
     public:
 
@@ -85,7 +87,8 @@ class SERVICE_PUBLIC LiveStreamInfo : public QObject
               m_StatusInt        ( 0      ),
               m_SourceWidth      ( 0      ),
               m_SourceHeight     ( 0      ),
-              m_AudioOnlyBitrate ( 0      )
+              m_AudioOnlyBitrate ( 0      ),
+              m_Renditions       ( 1      )
         { 
         }
 
@@ -114,6 +117,7 @@ class SERVICE_PUBLIC LiveStreamInfo : public QObject
             m_SourceWidth       = src->m_SourceWidth       ;
             m_SourceHeight      = src->m_SourceHeight      ;
             m_AudioOnlyBitrate  = src->m_AudioOnlyBitrate  ;
+            m_Renditions        = src->m_Renditions        ;
         }
 
     private:
@@ -35,6 +35,10 @@
 //    type.  Defaults to "BOTH", available values:
 //          "GET", "POST" or "BOTH"
 //
+//  * Q_CLASSINFO( "<methodName>_Cache", ...) lists the version stamps the
+//    method's result depends on, and has its responses cached by
+//    ServiceHost until one of them changes (see ServiceCache)
+//
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
@@ -48,6 +52,8 @@ class SERVICE_PUBLIC ChannelServices : public Service
     Q_CLASSINFO( "AddVideoSource_Method",            "POST" )
     Q_CLASSINFO( "UpdateVideoSource_Method",         "POST" )
     Q_CLASSINFO( "RemoveVideoSource_Method",         "POST" )
+    Q_CLASSINFO( "GetChannelInfoList_Cache",         "channel" )
+    Q_CLASSINFO( "GetVideoSourceList_Cache",         "channel" )
 
     public:
 
@@ -39,7 +39,7 @@
 class SERVICE_PUBLIC ContentServices : public Service  //, public QScriptable ???
 {
     Q_OBJECT
-    Q_CLASSINFO( "version"    , "2.0" );
+    Q_CLASSINFO( "version"    , "2.2" );
     Q_CLASSINFO( "DownloadFile_Method",            "POST" )
 
     public:
@@ -116,7 +116,8 @@ class SERVICE_PUBLIC ContentServices : public Service  //, public QScriptable ??
                                                                   int              Height,
                                                                   int              Bitrate,
                                                                   int              AudioBitrate,
-                                                                  int              SampleRate ) = 0;
+                                                                  int              SampleRate,
+                                                                  int              Renditions ) = 0;
 
         virtual DTC::LiveStreamInfo     *AddRecordingLiveStream ( int              RecordedId,
                                                                   int              ChanId,
@@ -126,7 +127,8 @@ class SERVICE_PUBLIC ContentServices : public Service  //, public QScriptable ??
                                                                   int              Height,
                                                                   int              Bitrate,
                                                                   int              AudioBitrate,
-                                                                  int              SampleRate ) = 0;
+                                                                  int              SampleRate,
+                                                                  int              Renditions ) = 0;
 
         virtual DTC::LiveStreamInfo     *AddVideoLiveStream     ( int              Id,
                                                                   int              MaxSegments,
@@ -134,13 +136,17 @@ class SERVICE_PUBLIC ContentServices : public Service  //, public QScriptable ??
                                                                   int              Height,
                                                                   int              Bitrate,
                                                                   int              AudioBitrate,
-                                                                  int              SampleRate ) = 0;
+                                                                  int              SampleRate,
+                                                                  int              Renditions ) = 0;
 
         virtual DTC::LiveStreamInfo     *GetLiveStream            ( int Id ) = 0;
         virtual DTC::LiveStreamInfoList *GetLiveStreamList        ( const QString &FileName ) = 0;
 
         virtual DTC::LiveStreamInfo     *StopLiveStream         ( int Id ) = 0;
         virtual bool                     RemoveLiveStream       ( int Id ) = 0;
+
+        virtual QFileInfo                GetLiveStreamSegment   ( int Id,
+                                                                  int Segment ) = 0;
 };
 
 #endif
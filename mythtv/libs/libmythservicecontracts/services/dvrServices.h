@@ -39,6 +39,10 @@
 //    type.  Defaults to "BOTH", available values:
 //          "GET", "POST" or "BOTH"
 //
+//  * Q_CLASSINFO( "<methodName>_Cache", ...) lists the version stamps the
+//    method's result depends on, and has its responses cached by
+//    ServiceHost until one of them changes (see ServiceCache)
+//
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
@@ -58,6 +62,11 @@ class SERVICE_PUBLIC DvrServices : public Service  //, public QScriptable ???
     Q_CLASSINFO( "EnableRecordSchedule_Method",                 "POST" )
     Q_CLASSINFO( "DisableRecordSchedule_Method",                "POST" )
     Q_CLASSINFO( "ManageJobQueue_Method",                       "POST" )
+    Q_CLASSINFO( "GetRecordedList_Cache",                       "recorded" )
+    Q_CLASSINFO( "GetRecGroupList_Cache",                       "recorded" )
+    Q_CLASSINFO( "GetTitleList_Cache",                          "recorded" )
+    Q_CLASSINFO( "GetUpcomingList_Cache",              "schedule,recorded" )
+    Q_CLASSINFO( "GetRecordScheduleList_Cache",                 "schedule" )
 
 
     public:
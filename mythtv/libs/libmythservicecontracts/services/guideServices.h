@@ -34,6 +34,10 @@
 //    type.  Defaults to "BOTH", available values:
 //          "GET", "POST" or "BOTH"
 //
+//  * Q_CLASSINFO( "<methodName>_Cache", ...) lists the version stamps the
+//    method's result depends on, and has its responses cached by
+//    ServiceHost until one of them changes (see ServiceCache)
+//
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
@@ -43,6 +47,8 @@ class SERVICE_PUBLIC GuideServices : public Service  //, public QScriptable ???
     Q_CLASSINFO( "version"    , "2.4" )
     Q_CLASSINFO( "AddToChannelGroup_Method",                     "POST" )
     Q_CLASSINFO( "RemoveFromChannelGroup_Method",                "POST" )
+    Q_CLASSINFO( "GetProgramGuide_Cache",                "schedule,channel" )
+    Q_CLASSINFO( "GetProgramList_Cache",                 "schedule,channel" )
 
     public:
 
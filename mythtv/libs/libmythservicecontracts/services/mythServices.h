@@ -38,6 +38,10 @@
 //    type.  Defaults to "BOTH", available values:
 //          "GET", "POST" or "BOTH"
 //
+//  * Q_CLASSINFO( "<methodName>_Cache", ...) lists the version stamps the
+//    method's result depends on, and has its responses cached by
+//    ServiceHost until one of them changes (see ServiceCache)
+//
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
@@ -58,6 +62,8 @@ class SERVICE_PUBLIC MythServices : public Service  //, public QScriptable ???
     Q_CLASSINFO( "ProfileDelete_Method",         "POST" )
     Q_CLASSINFO( "ManageDigestUser_Method",      "POST" )
     Q_CLASSINFO( "ManageUrlProtection_Method",   "POST" )
+    Q_CLASSINFO( "GetSetting_Cache",             "settings" )
+    Q_CLASSINFO( "GetSettingList_Cache",         "settings" )
 
     public:
 
@@ -0,0 +1,120 @@
+/*****************************************************************************
+ * hlsadaptation.h
+ * MythTV
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef HLSADAPTATION_H
+#define HLSADAPTATION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <QMap>
+
+#define PLAYBACK_HEADROOM  80   // percentage of the estimated bandwidth a
+                                // stream's bitrate may use
+
+/**
+ * Estimate of the download bandwidth
+ *
+ * Keeps two exponentially weighted moving averages of the measured throughput,
+ * each sample weighted by the duration of the segment it came from. The fast
+ * one follows the network down quickly, the slow one stops a single quick
+ * download from making us switch up, and the lower of the two is used.
+ */
+class HLSBandwidthEstimate
+{
+public:
+    void AddSample(int duration, uint64_t bandwidth)
+    {
+        double weight = std::max(duration, 1);
+        m_fast.AddSample(weight, bandwidth);
+        m_slow.AddSample(weight, bandwidth);
+    }
+
+    /* bits per second, 0 until a segment has been downloaded */
+    uint64_t Estimate(void) const
+    {
+        return (uint64_t)std::min(m_fast.Estimate(), m_slow.Estimate());
+    }
+
+private:
+    class EWMA
+    {
+    public:
+        explicit EWMA(double halflife) : m_alpha(exp(log(0.5) / halflife)) {}
+
+        void AddSample(double weight, double value)
+        {
+            double alpha    = pow(m_alpha, weight);
+            m_estimate      = value * (1.0 - alpha) + m_estimate * alpha;
+            m_totalweight  += weight;
+        }
+
+        double Estimate(void) const
+        {
+            if (m_totalweight <= 0.0)
+                return 0.0;
+            // the average starts at 0, correct for the bias it gives the
+            // first few samples
+            return m_estimate / (1.0 - pow(m_alpha, m_totalweight));
+        }
+
+    private:
+        double  m_alpha;
+        double  m_estimate    {0.0};
+        double  m_totalweight {0.0};
+    };
+
+    EWMA    m_fast {2.0};   // half-life of 2s of media
+    EWMA    m_slow {5.0};   // half-life of 5s of media
+};
+
+/**
+ * Return the stream with the highest bitrate that fits within the
+ * bandwidth, keeping some headroom, or the lowest one if none do.
+ * [bitrates] holds the bitrate of each stream to choose from, by stream
+ * number. Returns -1 if it is empty.
+ */
+inline int HLSChooseStream(const QMap<int,uint64_t> &bitrates,
+                           uint64_t bandwidth)
+{
+    int candidate = -1;
+    int lowest = -1;
+    uint64_t bw = bandwidth * PLAYBACK_HEADROOM / 100;
+    uint64_t bw_candidate = 0;
+    uint64_t bw_lowest = 0;
+
+    QMap<int,uint64_t>::const_iterator it = bitrates.constBegin();
+    for (; it != bitrates.constEnd(); ++it)
+    {
+        if ((bw >= *it) && (bw_candidate < *it))
+        {
+            bw_candidate = *it;
+            candidate = it.key(); /* possible candidate */
+        }
+        if (lowest < 0 || *it < bw_lowest)
+        {
+            bw_lowest = *it;
+            lowest = it.key();
+        }
+    }
+    return candidate >= 0 ? candidate : lowest;
+}
+
+#endif // HLSADAPTATION_H
@@ -23,6 +23,8 @@
 #include <unistd.h> // for usleep
 
 // C headers
+#include <cmath>
+#include <cstdint>
 #include <cstdio>
 
 #include <QDir>
@@ -30,6 +32,11 @@
 #include <QFileInfo>
 #include <QIODevice>
 #include <QRunnable>
+#include <QWaitCondition>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QSet>
 #include <QUrl>
 
 #include "mythcorecontext.h"
@@ -41,6 +48,8 @@
 #include "exitcodes.h"
 #include "mythlogging.h"
 #include "storagegroup.h"
+#include "recordinginfo.h"
+#include "recordingfile.h"
 #include "httplivestream.h"
 
 #define LOC QString("HLS(%1): ").arg(m_sourceFile)
@@ -48,6 +57,9 @@
 #define SLOC QString("HLS(): ")
 #define SLOC_ERR QString("HLS() Error: ")
 
+// Most renditions one transcode produces, 1080 lines down to 320
+static const uint16_t kMaxRenditions = 4;
+
 /** \class HTTPLiveStreamThread
  *  \brief QRunnable class for running mythtranscode for HTTP Live Streams
  *
@@ -89,12 +101,290 @@ class HTTPLiveStreamThread : public QRunnable
     int m_streamID;
 };
 
+/** \class HLSRemuxIndex
+ *  \brief Where the segments of a remuxed HTTP Live Stream lie in the
+ *         recording.
+ *
+ *  A remuxed stream is cut from the recording as it is, so its segments are
+ *  byte ranges of the recording that start at keyframes, found from the
+ *  recording's seek table. The PAT and PMT of the recording are put in
+ *  front of each segment, so a player can start with any one of them.
+ *
+ *  The fingerprint of the recording the index was read from is written to
+ *  the stream's playlist, so a change to the recording, e.g. by cutting or
+ *  transcoding it, is noticed even after a restart.
+ */
+class HLSRemuxIndex
+{
+  public:
+    class Segment
+    {
+      public:
+        int64_t  m_start    {0};
+        int64_t  m_end      {0};
+        uint32_t m_duration {0}; ///< milliseconds
+    };
+
+    QVector<Segment> m_segments;
+    QByteArray       m_psi;           ///< PAT and PMT packets
+    uint32_t         m_bandwidth {0}; ///< peak bits per second
+    uint32_t         m_maxDuration {0};
+    uint             m_chanid {0};
+    QDateTime        m_recstartts;
+    QString          m_fingerprint;   ///< see remux_fingerprint()
+};
+
+static const int kTSPacketSize = 188;
+
+// Comment line of a remux playlist that holds the index's fingerprint
+static const QString kFingerprintTag = "#MYTHTV-SOURCE:";
+
+// Indexes by stream id, the seek table is only read again when the
+// recording changes
+static QMutex                      s_remuxLock;
+static QHash<int, HLSRemuxIndex>   s_remuxIndexes;
+
+// Segments being cut, a viewer asking for one of these waits for it
+static QMutex                      s_cutLock;
+static QWaitCondition              s_cutWait;
+static QSet<QString>               s_cutting;
+
+/// Returns the first packet on the pid that starts a section, or the
+/// first PAT when pid is 0
+static QByteArray find_psi_packet(const QByteArray &data, int sync, int pid)
+{
+    for (int i = sync; i + kTSPacketSize <= data.size(); i += kTSPacketSize)
+    {
+        const auto *pkt = reinterpret_cast<const uint8_t*>(data.constData() + i);
+
+        if ((pkt[0] == 0x47) && (pkt[1] & 0x40) &&
+            ((((pkt[1] & 0x1f) << 8) | pkt[2]) == pid))
+        {
+            return data.mid(i, kTSPacketSize);
+        }
+    }
+
+    return QByteArray();
+}
+
+/// Returns the PMT pid of the first program in a PAT packet, or -1
+static int pmt_pid(const QByteArray &pat)
+{
+    const auto *pkt = reinterpret_cast<const uint8_t*>(pat.constData());
+
+    int offset = 4;
+    if (pkt[3] & 0x20)
+        offset += 1 + pkt[4];
+    if (offset >= kTSPacketSize)
+        return -1;
+    offset += 1 + pkt[offset]; // pointer field
+
+    if (offset + 8 > kTSPacketSize || pkt[offset] != 0x00)
+        return -1;
+
+    int sectionEnd = offset + 3 + (((pkt[offset + 1] & 0x0f) << 8) |
+                                   pkt[offset + 2]) - 4; // less the CRC
+
+    for (int i = offset + 8; i + 4 <= qMin(sectionEnd, kTSPacketSize); i += 4)
+    {
+        int program = (pkt[i] << 8) | pkt[i + 1];
+        if (program != 0) // 0 is the NIT
+            return ((pkt[i + 2] & 0x1f) << 8) | pkt[i + 3];
+    }
+
+    return -1;
+}
+
+/// Returns the PAT and PMT packets from the start of a transport stream
+static QByteArray find_psi(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    QByteArray data = file.read(4 * 1024 * 1024);
+
+    int sync = 0;
+    while ((sync < kTSPacketSize) &&
+           (sync + 2 * kTSPacketSize < data.size()) &&
+           !((data[sync] == 0x47) &&
+             (data[sync + kTSPacketSize] == 0x47) &&
+             (data[sync + 2 * kTSPacketSize] == 0x47)))
+    {
+        ++sync;
+    }
+
+    QByteArray pat = find_psi_packet(data, sync, 0);
+    if (pat.isEmpty())
+        return QByteArray();
+
+    int pid = pmt_pid(pat);
+    if (pid < 0)
+        return QByteArray();
+
+    QByteArray pmt = find_psi_packet(data, sync, pid);
+    if (pmt.isEmpty())
+        return QByteArray();
+
+    return pat + pmt;
+}
+
+/// Identifies the recording a remux index is read from, by the size of the
+/// file and the size and end of its seek table. Returns an empty string if
+/// the seek table can't be read.
+static QString remux_fingerprint(const QString &sourceFile, uint chanid,
+                                 const QDateTime &recstartts)
+{
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare(
+        "SELECT COUNT(*), MAX(mark), MAX(offset) "
+        "FROM recordedseek "
+        "WHERE chanid = :CHANID AND starttime = :STARTTIME AND "
+        "      type = :TYPE");
+    query.bindValue(":CHANID", chanid);
+    query.bindValue(":STARTTIME", recstartts);
+    query.bindValue(":TYPE", MARK_GOP_BYFRAME);
+
+    if (!query.exec() || !query.next())
+    {
+        MythDB::DBError("remux_fingerprint", query);
+        return QString();
+    }
+
+    return QString("%1,%2,%3,%4").arg(QFileInfo(sourceFile).size())
+        .arg(query.value(0).toLongLong()).arg(query.value(1).toLongLong())
+        .arg(query.value(2).toLongLong());
+}
+
+/// Groups the recording's keyframes into segments of about segmentSize
+/// seconds
+static HLSRemuxIndex build_remux_index(const QString &sourceFile,
+                                       uint16_t segmentSize)
+{
+    HLSRemuxIndex index;
+
+    ProgramInfo pginfo(sourceFile);
+    if (!pginfo.GetChanID())
+        return index;
+
+    // Before the seek table is read, so a change made while it is being
+    // read is noticed the next time the index is used
+    index.m_chanid      = pginfo.GetChanID();
+    index.m_recstartts  = pginfo.GetRecordingStartTime();
+    index.m_fingerprint = remux_fingerprint(sourceFile, index.m_chanid,
+                                            index.m_recstartts);
+
+    RecordingInfo recinfo(pginfo);
+
+    frm_pos_map_t posMap;
+    recinfo.QueryPositionMap(posMap, MARK_GOP_BYFRAME);
+    if (posMap.isEmpty())
+        return index;
+
+    frm_pos_map_t durMap;
+    recinfo.QueryPositionMap(durMap, MARK_DURATION_MS);
+
+    double fps = recinfo.QueryAverageFrameRate() / 1000.0;
+    if ((fps <= 0.0) && recinfo.GetRecordingFile())
+        fps = recinfo.GetRecordingFile()->m_videoFrameRate;
+    if ((fps <= 0.0) && durMap.isEmpty())
+        return index;
+
+    int64_t fileSize = QFileInfo(sourceFile).size();
+    int64_t target   = segmentSize * 1000;
+    int64_t startPos = 0;
+    int64_t startMs  = 0;
+    int64_t lastMs   = 0;
+
+    frm_pos_map_t::const_iterator it = posMap.constBegin();
+    for (; it != posMap.constEnd(); ++it)
+    {
+        int64_t pos = *it - (*it % kTSPacketSize);
+        frm_pos_map_t::const_iterator dur = durMap.constFind(it.key());
+        int64_t ms = (dur != durMap.constEnd()) ? *dur :
+            static_cast<int64_t>(it.key() * 1000 / fps);
+
+        if ((pos >= fileSize) || (ms < lastMs))
+            break;
+        lastMs = ms;
+
+        if ((ms - startMs < target) || (pos <= startPos))
+            continue;
+
+        HLSRemuxIndex::Segment segment;
+        segment.m_start    = startPos;
+        segment.m_end      = pos;
+        segment.m_duration = ms - startMs;
+        index.m_segments.push_back(segment);
+
+        startPos = pos;
+        startMs  = ms;
+    }
+
+    if (fileSize > startPos)
+    {
+        // The duration after the last keyframe is only known if the
+        // recording's total duration is, otherwise it is taken as zero
+        int64_t totalMs = qMax((int64_t)recinfo.QueryTotalDuration(), lastMs);
+        int64_t tailMs  = totalMs - startMs;
+
+        if ((tailMs < target) && !index.m_segments.isEmpty())
+        {
+            // A short tail would claim a bitrate far above the real one
+            HLSRemuxIndex::Segment &segment = index.m_segments.last();
+            segment.m_end       = fileSize;
+            segment.m_duration += tailMs;
+        }
+        else
+        {
+            HLSRemuxIndex::Segment segment;
+            segment.m_start    = startPos;
+            segment.m_end      = fileSize;
+            segment.m_duration = (tailMs > 0) ? tailMs : target;
+            index.m_segments.push_back(segment);
+        }
+    }
+
+    index.m_psi = find_psi(sourceFile);
+
+    foreach (const HLSRemuxIndex::Segment &segment, index.m_segments)
+    {
+        int64_t bps = (segment.m_end - segment.m_start) * 8 * 1000 /
+                      segment.m_duration;
+        index.m_bandwidth   = qMax(index.m_bandwidth,
+                                   (uint32_t)qMin(bps, (int64_t)UINT32_MAX));
+        index.m_maxDuration = qMax(index.m_maxDuration, segment.m_duration);
+    }
+
+    return index;
+}
+
+/// Returns the fingerprint written to a remux playlist, or an empty string
+static QString read_remux_fingerprint(const QString &playlist)
+{
+    QFile file(playlist);
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+
+    while (!file.atEnd())
+    {
+        QString line = QString::fromLatin1(file.readLine()).trimmed();
+        if (line.startsWith(kFingerprintTag))
+            return line.mid(kFingerprintTag.length());
+        if (line.startsWith("#EXTINF"))
+            break;
+    }
+
+    return QString();
+}
+
 
 HTTPLiveStream::HTTPLiveStream(QString srcFile, uint16_t width, uint16_t height,
                                uint32_t bitrate, uint32_t abitrate,
                                uint16_t maxSegments, uint16_t segmentSize,
-                               uint32_t aobitrate, int32_t srate)
-  : m_writing(false),
+                               uint32_t aobitrate, int32_t srate,
+                               uint16_t renditions, bool remux)
+  : m_writing(false),            m_remux(remux),
     m_streamid(-1),              m_sourceFile(srcFile),
     m_sourceWidth(0),            m_sourceHeight(0),
     m_segmentSize(segmentSize),  m_maxSegments(maxSegments),
@@ -103,33 +393,56 @@ HTTPLiveStream::HTTPLiveStream(QString srcFile, uint16_t width, uint16_t height,
     m_height(height),            m_width(width),
     m_bitrate(bitrate),
     m_audioBitrate(abitrate),    m_audioOnlyBitrate(aobitrate),
-    m_sampleRate(srate),
+    m_sampleRate(srate),         m_renditions(renditions),
     m_created(MythDate::current()),
     m_lastModified(MythDate::current()),
     m_percentComplete(0),
     m_status(kHLSStatusUndefined)
 {
-    if ((m_width == 0) && (m_height == 0))
-        m_width = 640;
+    if (m_segmentSize == 0)
+        m_segmentSize = 4;
+
+    QFileInfo finfo(m_sourceFile);
 
-    if (m_bitrate == 0)
-        m_bitrate = 800000;
+    if (m_remux)
+    {
+        // A remuxed stream keeps the recording's own video and audio. It is
+        // told apart from a transcoded one in the database by its zero
+        // bitrates, and has no audio only variant.
+        m_bitrate          = 0;
+        m_audioBitrate     = 0;
+        m_audioOnlyBitrate = 0;
+        m_sampleRate       = 0;
+        m_renditions       = 1;
+
+        m_outBase = finfo.fileName() +
+            QString(".remux_%1s").arg(m_segmentSize);
+    }
+    else
+    {
+        if ((m_width == 0) && (m_height == 0))
+            m_width = 640;
 
-    if (m_audioBitrate == 0)
-        m_audioBitrate = 64000;
+        if (m_bitrate == 0)
+            m_bitrate = 800000;
 
-    if (m_segmentSize == 0)
-        m_segmentSize = 4;
+        if (m_audioBitrate == 0)
+            m_audioBitrate = 64000;
 
-    if (m_audioOnlyBitrate == 0)
-        m_audioOnlyBitrate = 64000;
+        if (m_audioOnlyBitrate == 0)
+            m_audioOnlyBitrate = 64000;
 
-    m_sourceHost = gCoreContext->GetHostName();
+        m_renditions = qBound((uint16_t)1, m_renditions, kMaxRenditions);
 
-    QFileInfo finfo(m_sourceFile);
-    m_outBase = finfo.fileName() +
-        QString(".%1x%2_%3kV_%4kA").arg(m_width).arg(m_height)
-                .arg(m_bitrate/1000).arg(m_audioBitrate/1000);
+        m_outBase = finfo.fileName() +
+            QString(".%1x%2_%3kV_%4kA").arg(m_width).arg(m_height)
+                    .arg(m_bitrate/1000).arg(m_audioBitrate/1000);
+
+        if (m_renditions > 1)
+            m_outBase += QString("_%1r").arg(m_renditions);
+    }
+
+    m_sourceHost = gCoreContext->GetHostName();
 
     SetOutputVars();
 
@@ -152,7 +465,9 @@ HTTPLiveStream::HTTPLiveStream(QString srcFile, uint16_t width, uint16_t height,
 
 HTTPLiveStream::HTTPLiveStream(int streamid)
   : m_writing(false),
-    m_streamid(streamid)
+    m_remux(false),
+    m_streamid(streamid),
+    m_renditions(1)
 {
     LoadFromDB();
 }
@@ -161,7 +476,8 @@ HTTPLiveStream::~HTTPLiveStream()
 {
     if (m_writing)
     {
-        WritePlaylist(false, true);
+        for (uint16_t r = 0; r < m_renditions; ++r)
+            WritePlaylist(false, true, r);
         if (m_audioOnlyBitrate)
             WritePlaylist(true, true);
     }
@@ -182,7 +498,8 @@ bool HTTPLiveStream::InitForWrite(void)
 }
 
 QString HTTPLiveStream::GetFilename(uint16_t segmentNumber, bool fileOnly,
-                                    bool audioOnly, bool encoded) const
+                                    bool audioOnly, bool encoded,
+                                    uint16_t rendition) const
 {
     QString filename;
 
@@ -191,6 +508,9 @@ QString HTTPLiveStream::GetFilename(uint16_t segmentNumber, bool fileOnly,
     else
         filename = audioOnly ? m_audioOutFile : m_outFile;
 
+    if (rendition && !audioOnly)
+        filename += QString(".r%1").arg(rendition);
+
     filename += ".%1.ts";
 
     if (!fileOnly)
@@ -202,9 +522,37 @@ QString HTTPLiveStream::GetFilename(uint16_t segmentNumber, bool fileOnly,
     return filename.arg(1, 6, 10, QChar('0'));
 }
 
-QString HTTPLiveStream::GetCurrentFilename(bool audioOnly, bool encoded) const
+QString HTTPLiveStream::GetCurrentFilename(bool audioOnly, bool encoded,
+                                           uint16_t rendition) const
 {
-    return GetFilename(m_curSegment, false, audioOnly, encoded);
+    return GetFilename(m_curSegment, false, audioOnly, encoded, rendition);
+}
+
+/** \fn HTTPLiveStream::GetRenditionSize(uint16_t) const
+ *  \brief Returns the picture size of one of the stream's renditions.
+ *
+ *  Rendition 0 is the size the stream was asked for, and each one after
+ *  it is two thirds the size of the one before, so 1080 lines is followed
+ *  by 720, 480 and 320.
+ */
+QSize HTTPLiveStream::GetRenditionSize(uint16_t rendition) const
+{
+    double scale = pow(2.0 / 3.0, rendition);
+
+    // Dimensions valid for MPEG codecs, as mythtranscode uses
+    int width  = ((int)(m_width  * scale) + 15) & ~0xF;
+    int height = ((int)(m_height * scale) + 15) & ~0xF;
+
+    return QSize(width, height);
+}
+
+/** \fn HTTPLiveStream::GetRenditionBitrate(uint16_t) const
+ *  \brief Returns the video bitrate of one of the stream's renditions,
+ *         half that of the one before it.
+ */
+uint32_t HTTPLiveStream::GetRenditionBitrate(uint16_t rendition) const
+{
+    return m_bitrate >> rendition;
 }
 
 int HTTPLiveStream::AddStream(void)
@@ -232,12 +580,14 @@ int HTTPLiveStream::AddStream(void)
         "(width = :WIDTH OR height = :HEIGHT) AND bitrate = :BITRATE AND "
         "audioonlybitrate = :AUDIOONLYBITRATE AND samplerate = :SAMPLERATE AND "
         "audiobitrate = :AUDIOBITRATE AND segmentsize = :SEGMENTSIZE AND "
+        "renditions = :RENDITIONS AND "
         "sourcefile = :SOURCEFILE AND status <= :STATUS ");
     query.bindValue(":WIDTH", m_width);
     query.bindValue(":HEIGHT", m_height);
     query.bindValue(":BITRATE", m_bitrate);
     query.bindValue(":AUDIOBITRATE", m_audioBitrate);
     query.bindValue(":SEGMENTSIZE", m_segmentSize);
+    query.bindValue(":RENDITIONS", m_renditions);
     query.bindValue(":STATUS", (int)kHLSStatusCompleted);
     query.bindValue(":SOURCEFILE", m_sourceFile);
     query.bindValue(":AUDIOONLYBITRATE", m_audioOnlyBitrate);
@@ -258,14 +608,14 @@ int HTTPLiveStream::AddStream(void)
             "      percentcomplete, created, lastmodified, relativeurl, "
             "      fullurl, status, statusmessage, sourcefile, sourcehost, "
             "      sourcewidth, sourceheight, outdir, outbase, "
-            "      audioonlybitrate, samplerate ) "
+            "      audioonlybitrate, samplerate, renditions ) "
             "VALUES "
             "    ( :WIDTH, :HEIGHT, :BITRATE, :AUDIOBITRATE, :SEGMENTSIZE, "
             "      :MAXSEGMENTS, 0, 0, 0, "
             "      0, :CREATED, :LASTMODIFIED, :RELATIVEURL, "
             "      :FULLURL, :STATUS, :STATUSMESSAGE, :SOURCEFILE, :SOURCEHOST, "
             "      :SOURCEWIDTH, :SOURCEHEIGHT, :OUTDIR, :OUTBASE, "
-            "      :AUDIOONLYBITRATE, :SAMPLERATE ) ");
+            "      :AUDIOONLYBITRATE, :SAMPLERATE, :RENDITIONS ) ");
         query.bindValue(":WIDTH", m_width);
         query.bindValue(":HEIGHT", m_height);
         query.bindValue(":BITRATE", m_bitrate);
@@ -287,6 +637,7 @@ int HTTPLiveStream::AddStream(void)
         query.bindValue(":OUTBASE", tmpBase);
         query.bindValue(":AUDIOONLYBITRATE", m_audioOnlyBitrate);
         query.bindValue(":SAMPLERATE", (m_sampleRate == -1) ? 0 : m_sampleRate); // samplerate column is unsigned, -1 becomes 0
+        query.bindValue(":RENDITIONS", m_renditions);
 
         if (!query.exec())
         {
@@ -322,18 +673,24 @@ bool HTTPLiveStream::AddSegment(void)
     if ((m_maxSegments) &&
         (m_segmentCount > (uint16_t)(m_maxSegments + 1)))
     {
-        QString thisFile = GetFilename(m_startSegment);
+        for (uint16_t r = 0; r < m_renditions; ++r)
+        {
+            QString thisFile = GetFilename(m_startSegment, false, false,
+                                           false, r);
 
-        if (!QFile::remove(thisFile))
-            LOG(VB_GENERAL, LOG_ERR, LOC +
-                QString("Unable to delete %1.").arg(thisFile));
+            if (!QFile::remove(thisFile))
+                LOG(VB_GENERAL, LOG_ERR, LOC +
+                    QString("Unable to delete %1.").arg(thisFile));
+        }
 
         ++m_startSegment;
         --m_segmentCount;
     }
 
     SaveSegmentInfo();
-    WritePlaylist(false);
+
+    for (uint16_t r = 0; r < m_renditions; ++r)
+        WritePlaylist(false, false, r);
 
     if (m_audioOnlyBitrate)
         WritePlaylist(true);
@@ -408,15 +765,34 @@ bool HTTPLiveStream::WriteMetaPlaylist(void)
         return false;
     }
 
+    int bandwidth = (int)((m_bitrate + m_audioBitrate) * 1.1);
+
+    if (m_remux)
+        bandwidth = GetRemuxIndex().m_bandwidth;
+
     file.write(QString(
         "#EXTM3U\n"
         "#EXT-X-VERSION:4\n"
         "#EXT-X-MEDIA:TYPE=VIDEO,GROUP-ID=\"AV\",NAME=\"Main\",DEFAULT=YES,URI=\"%2.m3u8\"\n"
         "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%1\n"
         "%2.m3u8\n"
-        ).arg((int)((m_bitrate + m_audioBitrate) * 1.1))
+        ).arg(bandwidth)
          .arg(m_outFileEncoded).toLatin1());
 
+    // The lower renditions of a ladder, which players switch to when the
+    // bandwidth drops
+    for (uint16_t r = 1; r < m_renditions; ++r)
+    {
+        QSize size = GetRenditionSize(r);
+
+        file.write(QString(
+            "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%1,RESOLUTION=%2x%3\n"
+            "%4.r%5.m3u8\n"
+            ).arg((int)((GetRenditionBitrate(r) + m_audioBitrate) * 1.1))
+             .arg(size.width()).arg(size.height())
+             .arg(m_outFileEncoded).arg(r).toLatin1());
+    }
+
     if (m_audioOnlyBitrate)
     {
         file.write(QString(
@@ -432,7 +808,8 @@ bool HTTPLiveStream::WriteMetaPlaylist(void)
     return true;
 }
 
-QString HTTPLiveStream::GetPlaylistName(bool audioOnly) const
+QString HTTPLiveStream::GetPlaylistName(bool audioOnly,
+                                        uint16_t rendition) const
 {
     if (m_streamid == -1)
         return QString();
@@ -441,16 +818,20 @@ QString HTTPLiveStream::GetPlaylistName(bool audioOnly) const
         return QString();
 
     QString base = audioOnly ? m_audioOutFile : m_outFile;
+    if (rendition && !audioOnly)
+        base += QString(".r%1").arg(rendition);
+
     QString outFile = m_outDir + "/" + base + ".m3u8";
     return outFile;
 }
 
-bool HTTPLiveStream::WritePlaylist(bool audioOnly, bool writeEndTag)
+bool HTTPLiveStream::WritePlaylist(bool audioOnly, bool writeEndTag,
+                                   uint16_t rendition)
 {
     if (m_streamid == -1)
         return false;
 
-    QString outFile = GetPlaylistName(audioOnly);
+    QString outFile = GetPlaylistName(audioOnly, rendition);
     QString tmpFile = outFile + ".tmp";
 
     QFile file(tmpFile);
@@ -485,7 +866,8 @@ bool HTTPLiveStream::WritePlaylist(bool audioOnly, bool writeEndTag)
             "#EXTINF:%1,\n"
             "%2\n"
             ).arg(m_segmentSize)
-             .arg(GetFilename(segmentid + i, true, audioOnly, true)).toLatin1());
+             .arg(GetFilename(segmentid + i, true, audioOnly, true,
+                              rendition)).toLatin1());
 
         ++i;
     }
@@ -538,6 +920,9 @@ bool HTTPLiveStream::UpdateSizeInfo(uint16_t width, uint16_t height,
     QString newOutBase = finfo.fileName() +
         QString(".%1x%2_%3kV_%4kA").arg(width).arg(height)
                 .arg(m_bitrate/1000).arg(m_audioBitrate/1000);
+
+    if (m_renditions > 1)
+        newOutBase += QString("_%1r").arg(m_renditions);
     QString newFullURL = m_httpPrefix + newOutBase + ".m3u8";
     QString newRelativeURL = m_httpPrefixRel + newOutBase + ".m3u8";
 
@@ -695,7 +1080,7 @@ bool HTTPLiveStream::LoadFromDB(void)
         "   percentcomplete, created, lastmodified, relativeurl, "
         "   fullurl, status, statusmessage, sourcefile, sourcehost, "
         "   sourcewidth, sourceheight, outdir, outbase, audioonlybitrate, "
-        "   samplerate "
+        "   samplerate, renditions "
         "FROM livestream "
         "WHERE id = :STREAMID; ");
     query.bindValue(":STREAMID", m_streamid);
@@ -732,6 +1117,8 @@ bool HTTPLiveStream::LoadFromDB(void)
     m_outBase            = query.value(21).toString();
     m_audioOnlyBitrate   = query.value(22).toUInt();
     m_sampleRate         = query.value(23).toUInt();
+    m_renditions         = query.value(24).toUInt();
+    m_remux              = (m_bitrate == 0);
 
     SetOutputVars();
 
@@ -820,8 +1207,333 @@ bool HTTPLiveStream::CheckStop(void)
     return false;
 }
 
+/** \fn HTTPLiveStream::CanRemux(const ProgramInfo&, uint16_t, uint16_t, QSize*)
+ *  \brief Returns true if a stream of the recording can be cut from it as
+ *         it is, rather than transcoded.
+ *
+ *  That needs a finished transport stream recording of H.264 video with AAC
+ *  or MP3 audio, which every HLS player can play, and a request for a
+ *  picture no smaller than the recording's own. A width or height of 0
+ *  leaves it to the recording.
+ *
+ *  \param size Set to the recording's picture size
+ */
+bool HTTPLiveStream::CanRemux(const ProgramInfo &pginfo, uint16_t width,
+                              uint16_t height, QSize *size)
+{
+    if (!gCoreContext->GetBoolSetting("HTTPLiveStreamRemux", true))
+        return false;
+
+    // The seek table of a recording in progress is still growing
+    if (pginfo.GetRecordingEndTime() > MythDate::current())
+        return false;
+
+    RecordingInfo recinfo(pginfo);
+    const RecordingFile *recfile = recinfo.GetRecordingFile();
+
+    if (!recfile ||
+        (recfile->m_containerFormat != formatMPEG2_TS) ||
+        (recfile->m_videoCodec != "H264") ||
+        ((recfile->m_audioCodec != "AAC") && (recfile->m_audioCodec != "MP3")))
+        return false;
+
+    QSize recsize = recfile->m_videoResolution;
+
+    if ((recsize.width() <= 0) || (recsize.height() <= 0) ||
+        (width && (width < recsize.width())) ||
+        (height && (height < recsize.height())))
+        return false;
+
+    if (size)
+        *size = recsize;
+
+    return true;
+}
+
+/** \fn HTTPLiveStream::StartRemux(void)
+ *  \brief Writes the playlists of a remuxed stream.
+ *
+ *  Nothing is cut from the recording here, each segment is cut when it is
+ *  first asked for, by GetRemuxSegment(), so the stream is complete as soon
+ *  as its playlists are.
+ */
+bool HTTPLiveStream::StartRemux(void)
+{
+    HLSRemuxIndex index = GetRemuxIndex();
+
+    if (index.m_segments.isEmpty())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            "Unable to remux, the recording has no seek table");
+        UpdateStatusMessage("Recording has no seek table");
+        UpdateStatus(kHLSStatusErrored);
+        return false;
+    }
+
+    m_startSegment = 1;
+    m_curSegment   = index.m_segments.size();
+    m_segmentCount = index.m_segments.size();
+
+    if ((!SaveSegmentInfo()) ||
+        (!WriteHTML()) ||
+        (!WriteMetaPlaylist()) ||
+        (!WriteRemuxPlaylist(index)))
+    {
+        UpdateStatusMessage("Unable to write playlists");
+        UpdateStatus(kHLSStatusErrored);
+        return false;
+    }
+
+    UpdatePercentComplete(100);
+    UpdateStatusMessage("Remuxing on demand");
+    UpdateStatus(kHLSStatusCompleted);
+
+    return true;
+}
+
+/** \fn HTTPLiveStream::GetRemuxIndex(void)
+ *  \brief Returns the index of a remuxed stream, reading it on first use.
+ *
+ *  The index is read again when the recording has changed since it was
+ *  read. The playlists are then written again for the new index, and the
+ *  segments cut from the old recording are removed. If the recording no
+ *  longer has a seek table the stream fails.
+ */
+HLSRemuxIndex HTTPLiveStream::GetRemuxIndex(void)
+{
+    HLSRemuxIndex cached;
+    {
+        QMutexLocker locker(&s_remuxLock);
+        cached = s_remuxIndexes.value(m_streamid);
+    }
+
+    QString previous;
+    if (!cached.m_segments.isEmpty())
+    {
+        QString fingerprint = remux_fingerprint(
+            m_sourceFile, cached.m_chanid, cached.m_recstartts);
+
+        // keep using the index if the database can't tell
+        if (fingerprint.isEmpty() || (fingerprint == cached.m_fingerprint))
+            return cached;
+
+        previous = cached.m_fingerprint;
+    }
+    else
+    {
+        // the playlist may be from before a restart
+        previous = read_remux_fingerprint(GetPlaylistName());
+    }
+
+    HLSRemuxIndex index = build_remux_index(m_sourceFile, m_segmentSize);
+
+    if (index.m_segments.isEmpty())
+    {
+        QMutexLocker locker(&s_remuxLock);
+        s_remuxIndexes.remove(m_streamid);
+        locker.unlock();
+
+        if (!previous.isEmpty())
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC +
+                "The recording has changed and has no seek table");
+            UpdateStatusMessage("Recording has no seek table");
+            UpdateStatus(kHLSStatusErrored);
+        }
+        return index;
+    }
+
+    {
+        QMutexLocker locker(&s_remuxLock);
+        s_remuxIndexes.insert(m_streamid, index);
+    }
+
+    if (!previous.isEmpty() && !index.m_fingerprint.isEmpty() &&
+        (previous != index.m_fingerprint))
+    {
+        LOG(VB_GENERAL, LOG_INFO, LOC +
+            "The recording has changed, rewriting the playlists");
+
+        for (uint16_t i = 1; i <= m_segmentCount; ++i)
+            QFile::remove(GetFilename(i));
+
+        m_startSegment = 1;
+        m_curSegment   = index.m_segments.size();
+        m_segmentCount = index.m_segments.size();
+
+        if (!SaveSegmentInfo() || !WriteMetaPlaylist() ||
+            !WriteRemuxPlaylist(index))
+        {
+            UpdateStatusMessage("Unable to write playlists");
+            UpdateStatus(kHLSStatusErrored);
+        }
+    }
+
+    return index;
+}
+
+bool HTTPLiveStream::WriteRemuxPlaylist(const HLSRemuxIndex &index)
+{
+    if (m_streamid == -1)
+        return false;
+
+    QString outFile = GetPlaylistName();
+    QString tmpFile = outFile + ".tmp";
+
+    QFile file(tmpFile);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        LOG(VB_RECORD, LOG_ERR, QString("Error opening %1").arg(tmpFile));
+        return false;
+    }
+
+    file.write(QString(
+        "#EXTM3U\n"
+        "#EXT-X-VERSION:3\n"
+        "#EXT-X-PLAYLIST-TYPE:VOD\n"
+        "#EXT-X-TARGETDURATION:%1\n"
+        "#EXT-X-MEDIA-SEQUENCE:1\n"
+        "%2%3\n"
+        ).arg((index.m_maxDuration + 999) / 1000)
+         .arg(kFingerprintTag).arg(index.m_fingerprint).toLatin1());
+
+    // Segments are served by the Content service, which cuts them from the
+    // recording the first time they are asked for
+    for (int i = 0; i < index.m_segments.size(); ++i)
+    {
+        file.write(QString(
+            "#EXTINF:%1,\n"
+            "/Content/GetLiveStreamSegment?Id=%2&Segment=%3\n"
+            ).arg(index.m_segments[i].m_duration / 1000.0, 0, 'f', 3)
+             .arg(m_streamid).arg(i + 1).toLatin1());
+    }
+
+    file.write("#EXT-X-ENDLIST\n");
+    file.close();
+
+    if(rename(tmpFile.toLatin1().constData(),
+              outFile.toLatin1().constData()) == -1)
+    {
+        LOG(VB_RECORD, LOG_ERR, LOC +
+            QString("Error renaming %1 to %2").arg(tmpFile).arg(outFile) + ENO);
+        return false;
+    }
+
+    return true;
+}
+
+/** \fn HTTPLiveStream::GetRemuxSegment(uint16_t)
+ *  \brief Returns the file of a segment of a remuxed stream, cutting it
+ *         from the recording if no one has asked for it before.
+ *
+ *  Segments are kept with the stream's playlists, until the stream is
+ *  removed, so every viewer of the stream shares them. While one is being
+ *  cut, other viewers asking for it wait for it rather than cutting it too.
+ */
+QString HTTPLiveStream::GetRemuxSegment(uint16_t segmentNumber)
+{
+    if ((m_streamid == -1) || !m_remux || !segmentNumber ||
+        (segmentNumber > m_segmentCount))
+        return QString();
+
+    QString filename = GetFilename(segmentNumber);
+
+    QMutexLocker locker(&s_cutLock);
+
+    while (s_cutting.contains(filename))
+        s_cutWait.wait(&s_cutLock);
+
+    if (QFile::exists(filename))
+        return filename;
+
+    s_cutting.insert(filename);
+    locker.unlock();
+
+    bool ok = CutRemuxSegment(segmentNumber, filename);
+
+    locker.relock();
+    s_cutting.remove(filename);
+    s_cutWait.wakeAll();
+
+    return ok ? filename : QString();
+}
+
+bool HTTPLiveStream::CutRemuxSegment(uint16_t segmentNumber,
+                                     const QString &filename)
+{
+    HLSRemuxIndex index = GetRemuxIndex();
+
+    if ((int)segmentNumber > index.m_segments.size())
+        return false;
+
+    const HLSRemuxIndex::Segment &segment =
+        index.m_segments[segmentNumber - 1];
+
+    QFile source(m_sourceFile);
+    if (!source.open(QIODevice::ReadOnly) || !source.seek(segment.m_start))
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to read segment %1").arg(segmentNumber));
+        return false;
+    }
+
+    QString tmpFile = filename + ".tmp";
+    QFile file(tmpFile);
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        LOG(VB_RECORD, LOG_ERR, QString("Error opening %1").arg(tmpFile));
+        return false;
+    }
+
+    file.write(index.m_psi);
+
+    int64_t left = segment.m_end - segment.m_start;
+    while (left > 0)
+    {
+        QByteArray data = source.read(qMin(left, (int64_t)(1024 * 1024)));
+        if (data.isEmpty() || (file.write(data) != data.size()))
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC +
+                QString("Unable to cut segment %1").arg(segmentNumber));
+            file.close();
+            QFile::remove(tmpFile);
+            return false;
+        }
+        left -= data.size();
+    }
+
+    file.close();
+
+    if(rename(tmpFile.toLatin1().constData(),
+              filename.toLatin1().constData()) == -1)
+    {
+        LOG(VB_RECORD, LOG_ERR, LOC +
+            QString("Error renaming %1 to %2").arg(tmpFile).arg(filename) +
+            ENO);
+        QFile::remove(tmpFile);
+        return false;
+    }
+
+    LOG(VB_RECORD, LOG_DEBUG, LOC +
+        QString("Cut segment %1 of stream %2")
+            .arg(segmentNumber).arg(m_streamid));
+
+    return true;
+}
+
 DTC::LiveStreamInfo *HTTPLiveStream::StartStream(void)
 {
+    if (m_remux)
+    {
+        if (GetDBStatus() == kHLSStatusQueued)
+            StartRemux();
+
+        LoadFromDB();
+        return GetLiveStreamInfo();
+    }
+
     if (GetDBStatus() != kHLSStatusQueued)
         return GetLiveStreamInfo();
 
@@ -875,15 +1587,37 @@ bool HTTPLiveStream::RemoveStream(int id)
     {
         thisFile = hls->GetFilename(startSegment + x);
 
+        // A remuxed stream only has the segments someone asked for
+        if (hls->IsRemux() && !QFile::exists(thisFile))
+            continue;
+
         if (!thisFile.isEmpty() && !QFile::remove(thisFile))
             LOG(VB_GENERAL, LOG_ERR, SLOC +
                 QString("Unable to delete %1.").arg(thisFile));
 
+        if (hls->IsRemux())
+            continue;
+
         thisFile = hls->GetFilename(startSegment + x, false, true);
 
         if (!thisFile.isEmpty() && !QFile::remove(thisFile))
             LOG(VB_GENERAL, LOG_ERR, SLOC +
                 QString("Unable to delete %1.").arg(thisFile));
+
+        for (uint16_t r = 1; r < hls->GetRenditions(); ++r)
+        {
+            thisFile = hls->GetFilename(startSegment + x, false, false,
+                                        false, r);
+
+            if (!thisFile.isEmpty() && !QFile::remove(thisFile))
+                LOG(VB_GENERAL, LOG_ERR, SLOC +
+                    QString("Unable to delete %1.").arg(thisFile));
+        }
+    }
+
+    {
+        QMutexLocker locker(&s_remuxLock);
+        s_remuxIndexes.remove(id);
     }
 
     thisFile = hls->GetMetaPlaylistName();
@@ -901,6 +1635,14 @@ bool HTTPLiveStream::RemoveStream(int id)
         LOG(VB_GENERAL, LOG_ERR, SLOC +
             QString("Unable to delete %1.").arg(thisFile));
 
+    for (uint16_t r = 1; r < hls->GetRenditions(); ++r)
+    {
+        thisFile = hls->GetPlaylistName(false, r);
+        if (!thisFile.isEmpty() && !QFile::remove(thisFile))
+            LOG(VB_GENERAL, LOG_ERR, SLOC +
+                QString("Unable to delete %1.").arg(thisFile));
+    }
+
     thisFile = hls->GetHTMLPageName();
     if (!thisFile.isEmpty() && !QFile::remove(thisFile))
         LOG(VB_GENERAL, LOG_ERR, SLOC +
@@ -940,6 +1682,10 @@ DTC::LiveStreamInfo *HTTPLiveStream::StopStream(int id)
     if (!hls)
         return nullptr;
 
+    // Nothing runs for a remuxed stream that has to notice it was stopped
+    if (hls->IsRemux())
+        hls->UpdateStatus(kHLSStatusStopped);
+
     MythTimer statusTimer;
     int       delay = 250000;
     statusTimer.start();
@@ -992,6 +1738,7 @@ DTC::LiveStreamInfo *HTTPLiveStream::GetLiveStreamInfo(
     info->setSourceFile(m_sourceFile);
     info->setSourceHost(m_sourceHost);
     info->setAudioOnlyBitrate((int)m_audioOnlyBitrate);
+    info->setRenditions((int)m_renditions);
 
     if (m_width && m_height) {
         info->setRelativeURL(m_relativeURL);
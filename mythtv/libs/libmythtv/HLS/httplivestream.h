@@ -2,11 +2,15 @@
 #define HTTPLIVESTREAM_H
 
 #include <QString>
+#include <QSize>
 
 #include "datacontracts/liveStreamInfoList.h"
 
 #include "mythframe.h"
 
+class ProgramInfo;
+class HLSRemuxIndex;
+
 typedef enum {
     kHLSStatusUndefined    = -1,
     kHLSStatusQueued       = 0,
@@ -25,7 +29,8 @@ class MTV_PUBLIC HTTPLiveStream
     HTTPLiveStream(QString srcFile, uint16_t width = 640, uint16_t height = 480,
                    uint32_t bitrate = 800000, uint32_t abitrate = 64000,
                    uint16_t maxSegments = 0, uint16_t segmentSize = 10,
-                   uint32_t aobitrate = 32000, int32_t srate = -1);
+                   uint32_t aobitrate = 32000, int32_t srate = -1,
+                   uint16_t renditions = 1, bool remux = false);
     explicit HTTPLiveStream(int streamid);
    ~HTTPLiveStream();
 
@@ -39,15 +44,22 @@ class MTV_PUBLIC HTTPLiveStream
     uint32_t GetAudioBitrate(void) const { return m_audioBitrate; }
     uint32_t GetAudioOnlyBitrate(void) const { return m_audioOnlyBitrate; }
     uint16_t GetMaxSegments(void) const { return m_maxSegments; }
+    bool     IsRemux(void) const { return m_remux; }
+    uint16_t GetRenditions(void) const { return m_renditions; }
+    QSize    GetRenditionSize(uint16_t rendition) const;
+    uint32_t GetRenditionBitrate(uint16_t rendition) const;
     QString  GetSourceFile(void) const { return m_sourceFile; }
     QString  GetHTMLPageName(void) const;
     QString  GetMetaPlaylistName(void) const;
-    QString  GetPlaylistName(bool audioOnly = false) const;
+    QString  GetPlaylistName(bool audioOnly = false,
+                             uint16_t rendition = 0) const;
     uint16_t GetSegmentSize(void) const { return m_segmentSize; }
     QString  GetFilename(uint16_t segmentNumber = 0, bool fileOnly = false,
-                         bool audioOnly = false, bool encoded = false) const;
+                         bool audioOnly = false, bool encoded = false,
+                         uint16_t rendition = 0) const;
     QString  GetCurrentFilename(
-        bool audioOnly = false, bool encoded = false) const;
+        bool audioOnly = false, bool encoded = false,
+        uint16_t rendition = 0) const;
 
     void SetOutputVars(void);
 
@@ -58,7 +70,8 @@ class MTV_PUBLIC HTTPLiveStream
 
     bool WriteHTML(void);
     bool WriteMetaPlaylist(void);
-    bool WritePlaylist(bool audioOnly = false, bool writeEndTag = false);
+    bool WritePlaylist(bool audioOnly = false, bool writeEndTag = false,
+                       uint16_t rendition = 0);
 
     bool SaveSegmentInfo(void);
 
@@ -72,6 +85,10 @@ class MTV_PUBLIC HTTPLiveStream
 
     bool CheckStop(void);
 
+    QString GetRemuxSegment(uint16_t segmentNumber);
+    static bool CanRemux(const ProgramInfo &pginfo, uint16_t width,
+                         uint16_t height, QSize *size = nullptr);
+
            DTC::LiveStreamInfo     *StartStream(void);
     static DTC::LiveStreamInfo     *StopStream(int id);
     static bool                     RemoveStream(int id);
@@ -80,7 +97,14 @@ class MTV_PUBLIC HTTPLiveStream
     static DTC::LiveStreamInfoList *GetLiveStreamInfoList( const QString &FileName = "");
 
  protected:
+    bool        StartRemux(void);
+    HLSRemuxIndex GetRemuxIndex(void);
+    bool        WriteRemuxPlaylist(const HLSRemuxIndex &index);
+    bool        CutRemuxSegment(uint16_t segmentNumber,
+                                const QString &filename);
+
     bool        m_writing;
+    bool        m_remux;
     int         m_streamid;
     QString     m_sourceFile;
     QString     m_sourceHost;
@@ -106,6 +130,7 @@ class MTV_PUBLIC HTTPLiveStream
     uint32_t    m_audioBitrate;
     uint32_t    m_audioOnlyBitrate;
     int32_t     m_sampleRate;
+    uint16_t    m_renditions;
 
     QDateTime   m_created;
     QDateTime   m_lastModified;
@@ -26,6 +26,8 @@
 
 // QT
 #include <QObject>
+#include <QRunnable>
+#include <QSet>
 #include <QString>
 #include <QStringList>
 #include <QtAlgorithms>
@@ -33,6 +35,8 @@
 
 // C++
 #include <algorithm> // for min/max
+#include <atomic>
+#include <cmath>
 using std::max;
 using std::min;
 
@@ -41,11 +45,13 @@ using std::min;
 
 // libmythbase
 #include "mthread.h"
+#include "mthreadpool.h"
 #include "mythdownloadmanager.h"
 #include "mythlogging.h"
 
 // libmythtv
 #include "httplivestreambuffer.h"
+#include "hlsadaptation.h"
 
 #ifdef USING_LIBCRYPTO
 // encryption related stuff
@@ -58,6 +64,9 @@ using std::min;
 // Constants
 #define PLAYBACK_MINBUFFER 2    // number of segments to prefetch before playback starts
 #define PLAYBACK_READAHEAD 6    // number of segments download queue ahead of playback
+#define PLAYBACK_PARALLEL  3    // number of segments downloaded at once
+#define PLAYBACK_MAXBUFFER (64 * 1024 * 1024) // default limit of the segment
+                                // data held in memory (bytes)
 #define PLAYLIST_FAILURE   6    // number of consecutive failures after which
                                 // playback will abort
 enum
@@ -451,7 +460,7 @@ public:
         m_version       = rhs.m_version;
         m_startsequence = rhs.m_startsequence;
         m_targetduration= rhs.m_targetduration;
-        m_bitrate       = rhs.m_bitrate;
+        m_bitrate       = rhs.m_bitrate.load();
         m_size          = rhs.m_size;
         m_duration      = rhs.m_duration;
         m_live          = rhs.m_live;
@@ -635,8 +644,9 @@ public:
         segment->Lock();
         if (!segment->IsEmpty())
         {
-            /* Segment already downloaded */
+            /* Segment already downloaded, nothing measured */
             segment->Unlock();
+            bandwidth = 0;
             return RET_OK;
         }
 
@@ -646,9 +656,10 @@ public:
             .arg(stream));
 
         /* sanity check - can we download this segment on time? */
-        if ((bandwidth > 0) && (m_bitrate > 0))
+        uint64_t bitrate = m_bitrate;
+        if ((bandwidth > 0) && (bitrate > 0))
         {
-            uint64_t size = (segment->Duration() * m_bitrate); /* bits */
+            uint64_t size = (segment->Duration() * bitrate); /* bits */
             int estimated = (int)(size / bandwidth);
             if (estimated > segment->Duration())
             {
@@ -674,27 +685,31 @@ public:
         }
 
         uint64_t downloadduration = mdate() - start;
-        if (m_bitrate == 0 && segment->Duration() > 0)
+        if (bitrate == 0 && segment->Duration() > 0)
         {
-            /* Try to estimate the bandwidth for this stream */
-            m_bitrate = (uint64_t)(((double)segment->Size() * 8) /
-                                     ((double)segment->Duration()));
+            /* Try to estimate the bandwidth for this stream, unless another
+             * download has done so already */
+            m_bitrate.compare_exchange_strong(bitrate,
+                (uint64_t)(((double)segment->Size() * 8) /
+                           ((double)segment->Duration())));
         }
 
 #ifdef USING_LIBCRYPTO
         /* If the segment is encrypted, decode it */
         if (segment->HasKeyPath())
         {
-            /* Do we have loaded the key ? */
-            if (!segment->KeyLoaded())
+            /* Do we have loaded the key ? Downloads running at the same
+             * time load the keys of every segment, this one's included */
+            m_keylock.lock();
+            bool keyloaded = segment->KeyLoaded() ||
+                             (ManageSegmentKeys() == RET_OK);
+            m_keylock.unlock();
+            if (!keyloaded)
             {
-                if (ManageSegmentKeys() != RET_OK)
-                {
-                    LOG(VB_PLAYBACK, LOG_ERR, LOC +
-                        "couldn't retrieve segment AES-128 key");
-                    segment->Unlock();
-                    return RET_OK;
-                }
+                LOG(VB_PLAYBACK, LOG_ERR, LOC +
+                    "couldn't retrieve segment AES-128 key");
+                segment->Unlock();
+                return RET_OK;
             }
             if (segment->DecodeData(m_ivloaded ? m_AESIV : nullptr) != RET_OK)
             {
@@ -804,6 +819,7 @@ public:
      */
     int ManageSegmentKeys()
     {
+        // must own m_keylock
         HLSSegment   *seg       = nullptr;
         HLSSegment   *prev_seg  = nullptr;
         int          count      = NumSegments();
@@ -865,6 +881,7 @@ public:
 
 private:
     QString     m_keypath;              // URL path of the encrypted key
+    QMutex      m_keylock;              // serializes loading the segments' keys
     bool        m_ivloaded;
     uint8_t     m_AESIV[AES_BLOCK_SIZE];// IV used when decypher the block
 #endif
@@ -874,7 +891,7 @@ private:
     int         m_version;              // protocol version should be 1
     int         m_startsequence;        // media starting sequence number
     int         m_targetduration;       // maximum duration per segment (s)
-    uint64_t    m_bitrate;              // bitrate of stream content (bits per second)
+    std::atomic<uint64_t> m_bitrate;    // bitrate of stream content (bits per second)
     uint64_t    m_size;                 // stream length is calculated by taking the sum
                                         // foreach segment of (segment->duration * hls->bitrate/8)
     int64_t     m_duration;             // duration of the stream in seconds
@@ -938,15 +955,48 @@ private:
     QMutex          m_lock;
 };
 
+class StreamWorker;
+
+// Download of a single segment, run in StreamWorker's thread pool
+class SegmentDownload : public QRunnable
+{
+public:
+    SegmentDownload(StreamWorker *worker, int segnum, int stream, int concurrent)
+        : m_worker(worker), m_segnum(segnum), m_stream(stream),
+          m_concurrent(concurrent) {}
+
+    void run(void) override; // QRunnable
+
+private:
+    StreamWorker   *m_worker;
+    int             m_segnum;
+    int             m_stream;
+    int             m_concurrent;
+};
+
 // Stream Download Thread
+/**
+ * Schedules the download of the segments ahead of playback. Up to
+ * PLAYBACK_PARALLEL segments are downloaded at once, each in its own thread
+ * of a private pool, as long as the segments held in memory stay below
+ * the buffer size. The variant downloaded is adapted to the estimated
+ * bandwidth after each segment.
+ */
 class StreamWorker : public MThread
 {
 public:
-    StreamWorker(HLSRingBuffer *parent, int startup, int buffer) : MThread("HLSStream"),
+    StreamWorker(HLSRingBuffer *parent, int startup, int buffer,
+                 int64_t maxbuffered) : MThread("HLSStream"),
         m_parent(parent), m_interrupted(false), m_bandwidth(0), m_stream(0),
-        m_segment(startup), m_buffer(buffer),
-        m_sumbandwidth(0.0), m_countbandwidth(0)
+        m_segment(startup), m_buffer(buffer), m_bufferedbytes(0),
+        m_maxbuffered(maxbuffered), m_inflightbytes(0),
+        m_pool(new MThreadPool("HLSSegment"))
+    {
+        m_pool->setMaxThreadCount(PLAYBACK_PARALLEL);
+    }
+    ~StreamWorker()
     {
+        delete m_pool;
     }
     void Cancel(void)
     {
@@ -980,6 +1030,8 @@ public:
     {
         m_lock.lock();
         m_segment = val;
+        // give segments that previously failed another chance
+        m_failed.clear();
         m_lock.unlock();
         Wakeup();
     }
@@ -1016,6 +1068,9 @@ public:
         return true;
     }
 
+    /**
+     * number of segments downloaded, without gaps, ahead of playback
+     */
     int CurrentPlaybackBuffer(bool lock = true)
     {
         if (lock)
@@ -1038,17 +1093,11 @@ public:
         QMutexLocker lock(&m_lock);
         m_buffer = val;
     }
-    void AddSegmentToStream(int segnum, int stream)
-    {
-        if (m_interrupted)
-            return;
-        QMutexLocker lock(&m_lock);
-        m_segmap.insert(segnum, stream);
-    }
     void RemoveSegmentFromStream(int segnum)
     {
         QMutexLocker lock(&m_lock);
         m_segmap.remove(segnum);
+        m_bufferedbytes -= m_segsize.take(segnum);
     }
 
     /**
@@ -1099,12 +1148,79 @@ public:
     {
         return m_bandwidth;
     }
-    double AverageNewBandwidth(int64_t bandwidth)
+    int64_t BufferedBytes(void)
     {
-        m_sumbandwidth += bandwidth;
-        m_countbandwidth++;
-        m_bandwidth = m_sumbandwidth / m_countbandwidth;
-        return m_bandwidth;
+        QMutexLocker lock(&m_lock);
+        return m_bufferedbytes;
+    }
+
+    /**
+     * Download segment [segnum] from stream [stream], called from the pool.
+     * [concurrent] is the number of downloads that were running when it
+     * was started, including this one.
+     */
+    void DownloadSegment(int segnum, int stream, int concurrent)
+    {
+        HLSStream *hls  = m_parent->GetStream(stream);
+        uint64_t bw     = m_bandwidth;
+        int err         = RET_ERROR;
+
+        for (int retries = 0; hls && !m_interrupted && retries < 3; retries++)
+        {
+            if (retries == 2)
+                usleep(500000); // sleep 0.5s before the last try
+            bw  = m_bandwidth;
+            err = hls->DownloadSegmentData(segnum, bw, stream);
+            if (err == RET_OK)
+                break;
+            LOG(VB_PLAYBACK, LOG_DEBUG, LOC +
+                QString("download of segment %1 failed, retry #%2")
+                .arg(segnum).arg(retries + 1));
+        }
+
+        Lock();
+        m_inflight.remove(segnum);
+        m_inflightbytes -= m_inflightsize.take(segnum);
+        if (!m_interrupted)
+        {
+            if (err != RET_OK)
+            {
+                // no other stream to default to, skip segment
+                m_failed.insert(segnum);
+            }
+            else
+            {
+                HLSSegment *segment = hls->GetSegment(segnum);
+                int32_t size = segment ? segment->Size() : 0;
+                m_segmap.insert(segnum, stream);
+                m_bufferedbytes += size - m_segsize.value(segnum, 0);
+                m_segsize.insert(segnum, size);
+
+                // downloads running at the same time share the link, so
+                // each one only measured its own share of it
+                if (bw > 0 && segment)
+                {
+                    concurrent = max(1, min(concurrent, m_inflight.size() + 1));
+                    m_estimate.AddSample(segment->Duration(), bw * concurrent);
+                    m_bandwidth = m_estimate.Estimate();
+                }
+
+                LOG(VB_PLAYBACK, LOG_DEBUG, LOC +
+                    QString("download of segment %1 completed, %2 segments "
+                            "ahead, %3 bytes buffered, estimated bandwidth "
+                            "%4bit/s")
+                    .arg(segnum).arg(CurrentLiveBuffer())
+                    .arg(m_bufferedbytes).arg(m_bandwidth));
+
+                if (m_parent->m_meta && m_bandwidth > 0)
+                {
+                    Adapt();
+                }
+            }
+        }
+        Unlock();
+        // Signal we're done
+        Wakeup();
     }
 
 protected:
@@ -1112,157 +1228,201 @@ protected:
     {
         RunProlog();
 
-        int retries = 0;
         while (!m_interrupted)
         {
-            /*
-             * we can go into waiting if:
-             * - not live and download is more than 3 segments ahead of playback
-             * - we are at the end of the stream
-             */
-            Lock();
-            HLSStream *hls  = m_parent->GetStream(m_stream);
-            int dnldsegment = m_segment;
             int playsegment = m_parent->m_playback->Segment();
-            if ((!hls->Live() && (playsegment < dnldsegment - m_buffer)) ||
-                IsAtEnd())
+            ReleasePlayedSegments(playsegment);
+
+            Lock();
+            if (!m_interrupted)
             {
+                ScheduleDownloads(playsegment);
                 /* wait until
                  * 1- got interrupted
-                 * 2- we are less than 6 segments ahead of playback
-                 * 3- got asked to seek to a particular segment */
-                while (!m_interrupted && (m_segment == dnldsegment) &&
-                       (((m_segment - playsegment) > m_buffer) || IsAtEnd()))
-                {
-                    WaitForSignal();
-                    // do we have new segments available added by PlaylistWork?
-                    if (hls->Live() && !IsAtEnd())
-                        break;
-                    playsegment = m_parent->m_playback->Segment();
-                }
-                dnldsegment = m_segment;
+                 * 2- a download completed
+                 * 3- playback moved on or asked to seek
+                 * with a timeout as playback doesn't always signal us */
+                WaitForSignal(500);
             }
             Unlock();
+        }
+        // let on-going downloads find out they got interrupted
+        m_pool->waitForDone();
+        Wakeup();
+
+        RunEpilog();
+    }
+
+    /**
+     * Start downloading the segments ahead of playback that aren't already,
+     * until we have PLAYBACK_PARALLEL downloads running, we are more than
+     * [m_buffer] segments ahead (unless live) or the buffer is full.
+     * must own lock
+     */
+    void ScheduleDownloads(int playsegment)
+    {
+        HLSStream *hls = m_parent->GetStream(m_stream);
+        if (hls == nullptr)
+            return;
+
+        int count = m_parent->NumSegments();
+        // don't download what playback has already skipped over
+        m_segment = max(m_segment, playsegment);
+        while (m_segment < count &&
+               (m_segmap.contains(m_segment) || m_failed.contains(m_segment)))
+        {
+            m_segment++;
+        }
+
+        int last = hls->Live() ? count : min(count, playsegment + m_buffer + 1);
+        for (int segnum = m_segment;
+             segnum < last && m_inflight.size() < PLAYBACK_PARALLEL; segnum++)
+        {
+            if (m_segmap.contains(segnum) || m_inflight.contains(segnum) ||
+                m_failed.contains(segnum))
+            {
+                continue;
+            }
+
+            HLSSegment *segment = hls->GetSegment(segnum);
+            if (segment == nullptr)
+                break;
 
-            if (m_interrupted)
+            // always download what playback needs next, whatever its size
+            int64_t expected = segment->Duration() * hls->Bitrate() / 8;
+            if ((segnum > playsegment) &&
+                (m_bufferedbytes + m_inflightbytes + expected > m_maxbuffered))
             {
-                Wakeup();
                 break;
             }
-            // have we already downloaded the required segment?
-            if (StreamForSegment(dnldsegment) < 0)
-            {
-                uint64_t bw = m_bandwidth;
-                int err = hls->DownloadSegmentData(dnldsegment, bw, m_stream);
-                if (m_interrupted)
-                {
-                    // interrupt early
-                    Wakeup();
-                    break;
-                }
-                bw = AverageNewBandwidth(bw);
-                if (err != RET_OK)
-                {
-                    retries++;
-                    LOG(VB_PLAYBACK, LOG_DEBUG, LOC +
-                        QString("download failed, retry #%1").arg(retries));
-                    if (retries == 1)   // first error
-                        continue;       // will retry immediately
-                    usleep(500000);     // sleep 0.5s
-                    if (retries == 2)   // and retry once again
-                        continue;
-                    if (!m_parent->m_meta)
-                    {
-                        // no other stream to default to, skip packet
-                        retries = 0;
-                    }
-                    else
-                    {
-                        // TODO: should switch to another stream
-                        retries = 0;
-                    }
-                }
-                else
-                {
-                    LOG(VB_PLAYBACK, LOG_DEBUG, LOC +
-                        QString("download completed, %1 segments ahead")
-                        .arg(CurrentLiveBuffer()));
-                    AddSegmentToStream(dnldsegment, m_stream);
-                    if (m_parent->m_meta && hls->Bitrate() != bw)
-                    {
-                        int newstream = BandwidthAdaptation(hls->Id(), bw);
 
-                        if (newstream >= 0 && newstream != m_stream)
-                        {
-                            LOG(VB_PLAYBACK, LOG_INFO, LOC +
-                                QString("switching to %1 bitrate %2 stream; changing "
-                                        "from stream %3 to stream %4")
-                                .arg(bw >= hls->Bitrate() ? "faster" : "lower")
-                                .arg(bw).arg(m_stream).arg(newstream));
-                            m_stream = newstream;
-                        }
-                    }
-                }
-            }
-            Lock();
-            if (dnldsegment == m_segment)   // false if seek was called
+            m_inflight.insert(segnum);
+            m_inflightsize.insert(segnum, expected);
+            m_inflightbytes += expected;
+
+            LOG(VB_PLAYBACK, LOG_DEBUG, LOC +
+                QString("scheduling download of segment %1 from stream %2 "
+                        "(%3 running)")
+                .arg(segnum).arg(m_stream).arg(m_inflight.size()));
+
+            m_pool->start(new SegmentDownload(this, segnum, m_stream,
+                                              m_inflight.size()),
+                          "HLSSegment");
+        }
+    }
+
+    /**
+     * Free the data of segments that have already been played, oldest first,
+     * until we are back within the buffer size. Only segments kept for cached
+     * VOD streams get here, the others are freed as soon as they are read.
+     */
+    void ReleasePlayedSegments(int playsegment)
+    {
+        QList<HLSSegment*> released;
+
+        Lock();
+        QMap<int,int>::iterator it = m_segmap.begin();
+        while (it != m_segmap.end() && it.key() < playsegment &&
+               m_bufferedbytes > m_maxbuffered)
+        {
+            HLSStream *hls = m_parent->GetStream(*it);
+            HLSSegment *segment = hls ? hls->GetSegment(it.key()) : nullptr;
+            if (segment)
             {
-                m_segment++;
+                released.append(segment);
             }
-            Unlock();
-            // Signal we're done
-            Wakeup();
+            m_bufferedbytes -= m_segsize.take(it.key());
+            it = m_segmap.erase(it);
         }
+        Unlock();
 
-        RunEpilog();
+        // the segment lock is taken before ours when reading, so don't take
+        // it while we hold ours
+        foreach (HLSSegment *segment, released)
+        {
+            segment->Lock();
+            segment->Clear();
+            segment->Unlock();
+        }
     }
 
-    int BandwidthAdaptation(int progid, uint64_t &bandwidth) const
+    /**
+     * Switch to the best stream for the estimated bandwidth. Only switch up
+     * when there's enough buffered to absorb a download slower than expected.
+     * must own lock
+     */
+    void Adapt(void)
     {
-        int candidate = -1;
-        uint64_t bw = bandwidth;
-        uint64_t bw_candidate = 0;
+        HLSStream *hls = m_parent->GetStream(m_stream);
+        if (hls == nullptr)
+            return;
+
+        int newstream = BandwidthAdaptation(hls->Id(), m_bandwidth);
+        if (newstream < 0 || newstream == m_stream)
+            return;
+
+        HLSStream *next = m_parent->GetStream(newstream);
+        bool faster = next->Bitrate() > hls->Bitrate();
+        if (faster && CurrentPlaybackBuffer(false) < PLAYBACK_MINBUFFER)
+            return;
+
+        LOG(VB_PLAYBACK, LOG_INFO, LOC +
+            QString("switching to %1 bitrate %2 stream; changing "
+                    "from stream %3 to stream %4 (estimated bandwidth %5)")
+            .arg(faster ? "faster" : "lower")
+            .arg(next->Bitrate()).arg(m_stream).arg(newstream)
+            .arg(m_bandwidth));
+        m_stream = newstream;
+    }
+
+    /**
+     * Return the stream of the same PROGRAM-ID that best fits the
+     * bandwidth, see HLSChooseStream()
+     */
+    int BandwidthAdaptation(int progid, uint64_t bandwidth) const
+    {
+        QMap<int,uint64_t> bitrates;
 
         int count = m_parent->NumStreams();
         for (int n = 0; n < count; n++)
         {
-            /* Select best bandwidth match */
             HLSStream *hls = m_parent->GetStream(n);
             if (hls == nullptr)
                 break;
 
             /* only consider streams with the same PROGRAM-ID */
             if (hls->Id() == progid)
-            {
-                if ((bw >= hls->Bitrate()) &&
-                    (bw_candidate < hls->Bitrate()))
-                {
-                    LOG(VB_PLAYBACK, LOG_DEBUG, LOC +
-                        QString("candidate stream %1 bitrate %2 >= %3")
-                        .arg(n).arg(bw).arg(hls->Bitrate()));
-                    bw_candidate = hls->Bitrate();
-                    candidate = n; /* possible candidate */
-                }
-            }
+                bitrates.insert(n, hls->Bitrate());
         }
-        bandwidth = bw_candidate;
-        return candidate;
+        return HLSChooseStream(bitrates, bandwidth);
     }
 
 private:
     HLSRingBuffer  *m_parent;
     bool            m_interrupted;
-    int64_t         m_bandwidth;// measured average download bandwidth (bits per second)
+    int64_t         m_bandwidth;// estimated download bandwidth (bits per second)
     int             m_stream;   // current HLSStream
-    int             m_segment;  // current segment for downloading
+    int             m_segment;  // first segment not downloaded from playback
     int             m_buffer;   // buffer kept between download and playback
     QMap<int,int>   m_segmap;   // segment with streamid used for download
+    QMap<int,int32_t> m_segsize;// size of the segments in m_segmap
+    int64_t         m_bufferedbytes;// sum of m_segsize
+    int64_t         m_maxbuffered;  // limit for m_bufferedbytes
+    QSet<int>       m_inflight; // segments being downloaded
+    QMap<int,int64_t> m_inflightsize;// their expected size
+    int64_t         m_inflightbytes;// sum of m_inflightsize
+    QSet<int>       m_failed;   // segments we gave up downloading
+    HLSBandwidthEstimate m_estimate;
+    MThreadPool    *m_pool;
     mutable QMutex  m_lock;
     QWaitCondition  m_waitcond;
-    double          m_sumbandwidth;
-    int             m_countbandwidth;
 };
 
+void SegmentDownload::run(void)
+{
+    m_worker->DownloadSegment(m_segnum, m_stream, m_concurrent);
+}
+
 // Playlist Refresh Thread
 class PlaylistWorker : public MThread
 {
@@ -1569,7 +1729,8 @@ HLSRingBuffer::HLSRingBuffer(const QString &lfilename) :
     m_meta(false),          m_error(false),         m_aesmsg(false),
     m_startup(0),           m_bitrate(0),           m_seektoend(false),
     m_streamworker(nullptr),m_playlistworker(nullptr), m_fd(nullptr),
-    m_interrupted(false),   m_killed(false)
+    m_interrupted(false),   m_killed(false),
+    m_maxbuffered(PLAYBACK_MAXBUFFER), m_startuptime(-1), m_rebuffers(0)
 {
     startreadahead = false;
     OpenFile(lfilename);
@@ -1581,7 +1742,8 @@ HLSRingBuffer::HLSRingBuffer(const QString &lfilename, bool open) :
     m_meta(false),          m_error(false),         m_aesmsg(false),
     m_startup(0),           m_bitrate(0),           m_seektoend(false),
     m_streamworker(nullptr),m_playlistworker(nullptr), m_fd(nullptr),
-    m_interrupted(false),   m_killed(false)
+    m_interrupted(false),   m_killed(false),
+    m_maxbuffered(PLAYBACK_MAXBUFFER), m_startuptime(-1), m_rebuffers(0)
 {
     startreadahead = false;
     if (open)
@@ -2546,6 +2708,8 @@ bool HLSRingBuffer::OpenFile(const QString &lfilename, uint /*retry_ms*/)
     safefilename = lfilename;
     filename = lfilename;
 
+    int64_t starttime = mdate();
+
     QByteArray buffer;
     if (!downloadURL(filename, &buffer))
     {
@@ -2591,7 +2755,8 @@ bool HLSRingBuffer::OpenFile(const QString &lfilename, uint /*retry_ms*/)
     m_startup = 0;
     m_playback->SetSegment(m_startup);
 
-    m_streamworker = new StreamWorker(this, m_startup, PLAYBACK_READAHEAD);
+    m_streamworker = new StreamWorker(this, m_startup, PLAYBACK_READAHEAD,
+                                      m_maxbuffered);
     m_streamworker->start();
 
     if (Prefetch(min(NumSegments(), PLAYBACK_MINBUFFER)) != RET_OK)
@@ -2601,6 +2766,7 @@ bool HLSRingBuffer::OpenFile(const QString &lfilename, uint /*retry_ms*/)
         m_error = true;
         return false;
     }
+    m_startuptime = (mdate() - starttime) / 1000;
 
     // set bitrate value used to calculate the size of the stream
     HLSStream *hls  = GetCurrentStream();
@@ -2682,8 +2848,10 @@ void HLSRingBuffer::WaitUntilBuffered(void)
     }
 
     // danger of getting to the end... pause until we have some more
+    m_rebuffers++;
     LOG(VB_PLAYBACK, LOG_INFO, LOC +
-        QString("pausing until we get sufficient data buffered"));
+        QString("pausing until we get sufficient data buffered (%1 times)")
+        .arg(m_rebuffers));
     m_streamworker->Wakeup();
     m_streamworker->Lock();
     int retries = 0;
@@ -2909,7 +3077,8 @@ long long HLSRingBuffer::SeekInternal(long long pos, int whence)
      * the segments in less than 5s
      */
     if (hls->Live() && (segnum >= count - 1 || segnum < m_playback->Segment()) &&
-        ((hls->TargetDuration() * hls->Bitrate() / m_streamworker->Bandwidth()) > 5))
+        ((m_streamworker->Bandwidth() <= 0) ||
+         ((hls->TargetDuration() * hls->Bitrate() / m_streamworker->Bandwidth()) > 5)))
     {
         return m_playback->Offset();
     }
@@ -2981,6 +3150,21 @@ bool HLSRingBuffer::IsOpen(void) const
     return !m_error && !m_streams.isEmpty() && NumSegments() > 0;
 }
 
+/**
+ * Set the limit of the segment data held in memory, must be called before
+ * the stream is opened. The segment playback needs next is always
+ * downloaded, whatever its size.
+ */
+void HLSRingBuffer::SetMaxBufferedBytes(int64_t size)
+{
+    m_maxbuffered = size;
+}
+
+int64_t HLSRingBuffer::BufferedBytes(void) const
+{
+    return m_streamworker ? m_streamworker->BufferedBytes() : 0;
+}
+
 void HLSRingBuffer::Interrupt(void)
 {
     QMutexLocker lock(&m_lock);
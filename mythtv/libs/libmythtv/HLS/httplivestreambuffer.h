@@ -62,6 +62,12 @@ public:
     void Interrupt(void);
     void Continue(void);
     int DurationForBytes(uint size);
+    void SetMaxBufferedBytes(int64_t size);
+    int64_t BufferedBytes(void) const;
+    /// time taken by OpenFile() to buffer enough to start playback (ms)
+    int StartupTime(void) const             { return m_startuptime; }
+    /// number of times playback had to wait for segments to download
+    int RebufferCount(void) const           { return m_rebuffers; }
 
 protected:
     int safe_read(void *data, uint i_read) override; // RingBuffer
@@ -132,6 +138,9 @@ private:
     FILE               *m_fd;
     bool                m_interrupted;
     bool                m_killed;
+    int64_t             m_maxbuffered;  // limit of segment data held in memory
+    int                 m_startuptime;  // ms, -1 until opened
+    int                 m_rebuffers;
 };
 
 #endif
@@ -504,6 +504,11 @@ AvFormatDecoder::~AvFormatDecoder()
 
     sws_freeContext(sws_ctx);
 
+    LOG(VB_PLAYBACK, LOG_INFO, LOC +
+        QString("Video frames: %1 direct, %2 copied. Frame pool: %3")
+            .arg(m_framesDirect).arg(m_framesCopied)
+            .arg(m_framePool.GetStats()));
+
     av_freep(&audioSamples);
 
     if (avfRingBuffer)
@@ -2499,8 +2504,11 @@ int AvFormatDecoder::ScanStreams(bool novideo)
                 break;
             }
 
-            if (averror_count > SEQ_PKT_ERR_MAX)
+            // An open context ignores new threading settings, so start
+            // from a fresh one when the decode load asked for a change
+            if (averror_count > SEQ_PKT_ERR_MAX || m_reopenVideoCodec)
                 gCodecMap->freeCodecContext(ic->streams[selTrack]);
+            m_reopenVideoCodec = false;
             AVCodecContext *enc = gCodecMap->getCodecContext(ic->streams[selTrack], codec);
             StreamInfo si(selTrack, 0, 0, 0, 0);
 
@@ -2709,11 +2717,17 @@ int AvFormatDecoder::ScanStreams(bool novideo)
                 thread_count = 1;
 
             LOG(VB_PLAYBACK, LOG_INFO, LOC +
-                QString("Using %1 CPUs for decoding")
+                QString("Using up to %1 CPUs for decoding")
                 .arg(HAVE_THREADS ? thread_count : 1));
 
             if (HAVE_THREADS)
-                enc->thread_count = thread_count;
+            {
+                // Only software decoding is worth adapting, and reopening a
+                // DVD's codec mid title is best avoided
+                bool adaptive = codec_is_std(video_codec_id) && !private_dec &&
+                                !ringBuffer->IsDVD();
+                m_decodeLoad.Configure(enc, codec, thread_count, fps, adaptive);
+            }
 
             InitVideoCodec(ic->streams[selTrack], enc, true);
 
@@ -2734,6 +2748,9 @@ int AvFormatDecoder::ScanStreams(bool novideo)
                 }
             }
 
+            if (HAVE_THREADS)
+                m_decodeLoad.CodecOpened(enc);
+
             break;
         }
     }
@@ -4053,6 +4070,18 @@ bool AvFormatDecoder::ProcessVideoFrame(AVStream *stream, AVFrame *mpa_pic)
                     }
                 }
             }
+            if (!used_picframe && pixelformats)
+            {
+                // Transfer into a recycled picture rather than letting
+                // FFmpeg allocate a new one for every frame
+                AVFrame *pooled = m_framePool.GetFrame(
+                    pixelformats[0], mpa_pic->width, mpa_pic->height);
+                if (pooled)
+                {
+                    av_frame_free(&tmp_frame);
+                    tmp_frame = use_frame = pooled;
+                }
+            }
             if ((ret = av_hwframe_transfer_data(use_frame, mpa_pic, 0)) < 0)
             {
                 LOG(VB_GENERAL, LOG_ERR, LOC
@@ -4067,7 +4096,23 @@ bool AvFormatDecoder::ProcessVideoFrame(AVStream *stream, AVFrame *mpa_pic)
 #endif // USING_VAAPI2 || USING_NVDEC
             use_frame = mpa_pic;
 
-        if (!used_picframe)
+        if (!used_picframe && use_frame == tmp_frame &&
+            use_frame->format == AV_PIX_FMT_NV12 && !use_frame->buf[1])
+        {
+            // Pooled pictures are a single buffer, so the planes can be
+            // described as a VideoFrame and split with the SSE copy
+            // instead of going through swscale.
+            int pitches[3] = { use_frame->linesize[0], use_frame->linesize[1],
+                               0 };
+            int offsets[3] =
+                { 0, (int)(use_frame->data[1] - use_frame->data[0]), 0 };
+            VideoFrame nv12;
+            init(&nv12, FMT_NV12, use_frame->data[0], use_frame->width,
+                 use_frame->height, use_frame->buf[0]->size,
+                 pitches, offsets);
+            framecopy(picframe, &nv12);
+        }
+        else if (!used_picframe)
         {
             AVFrame tmppicture;
             av_image_fill_arrays(tmppicture.data, tmppicture.linesize,
@@ -4114,6 +4159,12 @@ bool AvFormatDecoder::ProcessVideoFrame(AVStream *stream, AVFrame *mpa_pic)
         return false;
     }
 
+    if (directrendering)
+        m_framesDirect++;
+    else if (!FlagIsSet(kDecodeNoDecode))
+        m_framesCopied++;
+    m_decodeLoad.FrameDecoded();
+
     long long pts;
     if (use_frame_timing)
     {
@@ -5507,8 +5558,15 @@ bool AvFormatDecoder::GetFrame(DecodeType decodetype)
                     break;
                 }
 
+                m_decodeLoad.DecodeStarted();
                 if (!ProcessVideoPacket(curstream, pkt))
                     have_err = true;
+                m_decodeLoad.DecodeFinished();
+                if (m_decodeLoad.NeedsReconfigure())
+                {
+                    m_reopenVideoCodec = true;
+                    m_streams_changed = true;
+                }
                 break;
             }
 
@@ -5618,6 +5676,14 @@ QString AvFormatDecoder::GetCodecDecoderName(void) const
     return get_decoder_name(video_codec_id);
 }
 
+void AvFormatDecoder::GetDecoderStats(InfoMap &infoMap) const
+{
+    infoMap["framepool"] = QString("%1 direct, %2 copied, pool %3")
+        .arg(m_framesDirect).arg(m_framesCopied)
+        .arg(m_framePool.GetStats());
+    infoMap["decodeload"] = m_decodeLoad.GetStats();
+}
+
 QString AvFormatDecoder::GetRawEncodingType(void)
 {
     int stream = selectedTrack[kTrackTypeVideo].av_stream_index;
@@ -19,6 +19,7 @@
 #include "H264Parser.h"
 #include "videodisplayprofile.h"
 #include "mythplayer.h"
+#include "decodeloadmonitor.h"
 
 extern "C" {
 #include "mythframe.h"
@@ -143,6 +144,9 @@ class AvFormatDecoder : public DecoderBase
     long UpdateStoredFrameNum(long frame) override { (void)frame; return 0;} // DecoderBase
 
     QString      GetCodecDecoderName(void) const override; // DecoderBase
+    void         GetDecoderStats(InfoMap &infoMap) const override; // DecoderBase
+    void         FrameDropped(void) override // DecoderBase
+                     { m_decodeLoad.FrameDropped(); }
     QString      GetRawEncodingType(void) override; // DecoderBase
     MythCodecID  GetVideoCodecID(void) const override { return video_codec_id; } // DecoderBase
     void        *GetVideoCodecPrivate(void) override; // DecoderBase
@@ -292,6 +296,16 @@ class AvFormatDecoder : public DecoderBase
 
     struct SwsContext *sws_ctx;
     bool directrendering;
+    /// Reusable pictures for frames that can't be decoded in place
+    MythAVFramePool m_framePool;
+    /// Frames decoded straight into a VideoBuffers frame
+    uint64_t m_framesDirect  {0};
+    /// Frames copied or converted into a VideoBuffers frame after decoding
+    uint64_t m_framesCopied  {0};
+    /// Video decoder threading and load
+    DecodeLoadMonitor m_decodeLoad;
+    /// The video codec must be reopened for new threading to apply
+    bool              m_reopenVideoCodec {false};
 
     bool no_dts_hack;
     bool dorewind;
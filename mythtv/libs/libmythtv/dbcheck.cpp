@@ -3449,6 +3449,17 @@ nullptr
             return false;
     }
 
+    if (dbver == "1350")
+    {
+        const char *updates[] = {
+            "ALTER TABLE livestream ADD COLUMN renditions "
+            "    INT UNSIGNED NOT NULL DEFAULT 1 AFTER samplerate;",
+            nullptr
+        };
+        if (!performActualUpdate(updates, "1351", dbver))
+            return false;
+    }
+
     return true;
 }
 
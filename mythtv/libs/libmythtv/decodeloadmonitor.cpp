@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <cmath>
+
+#include "mythlogging.h"
+#include "decodeloadmonitor.h"
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+}
+
+using namespace std;
+
+#define LOC QString("DecodeLoad: ")
+
+/// Streams up to about SD at 50 fields/s are cheap enough for slice threading
+static const double kSlicePixelRate = 720.0 * 576.0 * 50.0;
+/// Fraction of the frame interval above which the decoder is overloaded
+static const double kHighLoad = 0.85;
+/// Load above which dropped frames are blamed on the decoder
+static const double kBusyLoad = 0.5;
+/// Load below which fewer threads would do
+static const double kLowLoad  = 0.25;
+/// Load aimed for when choosing a leaner thread count
+static const double kTargetLoad = 0.5;
+/// Dropped frames in one window that count as falling behind
+static const int    kDropLimit = 2;
+/// Windows to wait after a change before judging the new setting
+static const int    kCooldownWindows = 3;
+
+QMutex DecodeLoadMonitor::s_historyLock;
+QHash<QString, DecodeLoadMonitor::Setting> DecodeLoadMonitor::s_history;
+
+DecodeLoadMonitor::DecodeLoadMonitor()
+{
+}
+
+/** \fn DecodeLoadMonitor::Configure(AVCodecContext*, const AVCodec*, uint, float, bool)
+ *  \brief Set the thread type and count of a codec context before it is
+ *         opened.
+ *
+ *  Streams that have been seen before reuse what was learnt about them;
+ *  otherwise slice threading is used for low pixel rates and frame
+ *  threading for the rest. The thread count never exceeds \p max_threads,
+ *  which comes from the video display profile.
+ *
+ *  \param adaptive Monitor the load and ask for more threads when needed.
+ */
+void DecodeLoadMonitor::Configure(AVCodecContext *enc, const AVCodec *codec,
+                                  uint max_threads, float fps, bool adaptive)
+{
+    if (fps < 1.0f || fps > 121.0f)
+        fps = 25.0f;
+
+    int caps = codec ? codec->capabilities : 0;
+    m_sliceCapable = caps & AV_CODEC_CAP_SLICE_THREADS;
+    m_frameCapable = caps & AV_CODEC_CAP_FRAME_THREADS;
+    m_maxThreads   = max((int)max_threads, 1);
+    m_adaptive     = adaptive && m_maxThreads > 1 &&
+                     (m_sliceCapable || m_frameCapable);
+    m_interval     = (int64_t)(1000000000.0 / fps);
+    m_windowSize   = max((int)lrint(fps * 2), 25);
+    m_key          = QString("%1:%2x%3@%4").arg(codec ? codec->name : "none")
+                         .arg(enc->width).arg(enc->height).arg(lrint(fps));
+
+    Setting setting;
+    bool known;
+    {
+        QMutexLocker locker(&s_historyLock);
+        known = s_history.contains(m_key);
+        if (known)
+            setting = s_history[m_key];
+    }
+
+    if (!known)
+    {
+        double pixelrate = (double)enc->width * enc->height * fps;
+        setting.threads = m_maxThreads;
+        if (m_sliceCapable && (pixelrate <= kSlicePixelRate || !m_frameCapable))
+            setting.type = FF_THREAD_SLICE;
+        else
+            setting.type = FF_THREAD_FRAME;
+    }
+
+    int threads = min(max(setting.threads, 1), m_maxThreads);
+    int type    = setting.type;
+    if (type == FF_THREAD_FRAME && !m_frameCapable)
+        type = FF_THREAD_SLICE;
+    else if (type == FF_THREAD_SLICE && !m_sliceCapable)
+        type = FF_THREAD_FRAME;
+
+    enc->thread_count = threads;
+    enc->thread_type  = type;
+
+    m_timer.stop();
+    m_windowBusy   = 0;
+    m_windowFrames = 0;
+    m_cooldown     = kCooldownWindows;
+    m_reconfigure  = false;
+    m_saturated    = false;
+    m_dropped.fetchAndStoreOrdered(0);
+
+    {
+        QMutexLocker locker(&m_statsLock);
+        m_threads = threads;
+        m_type    = type;
+        m_load = m_peakLoad = m_meanMs = 0.0;
+        m_lastDropped = 0;
+    }
+
+    LOG(VB_PLAYBACK, LOG_INFO, LOC +
+        QString("Using %1 %2 thread(s) for %3 (%4)")
+            .arg(m_threads).arg(TypeToString(m_type)).arg(m_key)
+            .arg(known ? "learnt" : "estimated"));
+}
+
+/** \fn DecodeLoadMonitor::CodecOpened(const AVCodecContext*)
+ *  \brief Check the threading libavcodec actually set up once the codec is
+ *         open, which need not be what Configure() asked for.
+ *
+ *  Reports what is really in use from then on. If the codec didn't take
+ *  the requested setting, asking again would only reopen it to the same
+ *  effect, so adapting stops for this stream. A single thread is no
+ *  threading at all to libavcodec, which then reports no thread type.
+ */
+void DecodeLoadMonitor::CodecOpened(const AVCodecContext *enc)
+{
+    int threads = max(enc->thread_count, 1);
+    int type    = enc->active_thread_type;
+
+    if (threads == m_threads && (type == m_type || threads == 1))
+        return;
+
+    LOG(VB_PLAYBACK, LOG_INFO, LOC +
+        QString("Asked for %1 %2 thread(s) for %3, got %4 %5")
+            .arg(m_threads).arg(TypeToString(m_type)).arg(m_key)
+            .arg(threads).arg(TypeToString(type)));
+
+    {
+        QMutexLocker locker(&m_statsLock);
+        m_threads = threads;
+        m_type    = type;
+    }
+    m_adaptive = false;
+}
+
+void DecodeLoadMonitor::DecodeStarted(void)
+{
+    m_timer.start();
+}
+
+void DecodeLoadMonitor::DecodeFinished(void)
+{
+    if (!m_timer.isRunning())
+        return;
+    m_windowBusy += m_timer.nsecsElapsed();
+    m_timer.stop();
+
+    if (m_windowFrames >= m_windowSize)
+        EndWindow();
+}
+
+/** \fn DecodeLoadMonitor::NeedsReconfigure(void)
+ *  \brief Returns true once after a heavier threading setting has been
+ *         chosen. The caller must reopen the codec, calling Configure()
+ *         again, for it to take effect.
+ */
+bool DecodeLoadMonitor::NeedsReconfigure(void)
+{
+    bool reconfigure = m_reconfigure;
+    m_reconfigure = false;
+    return reconfigure;
+}
+
+void DecodeLoadMonitor::EndWindow(void)
+{
+    double load = (double)m_windowBusy / ((double)m_windowFrames * m_interval);
+    double mean = (double)m_windowBusy / m_windowFrames / 1000000.0;
+    int dropped = m_dropped.fetchAndStoreOrdered(0);
+    m_windowBusy   = 0;
+    m_windowFrames = 0;
+
+    {
+        QMutexLocker locker(&m_statsLock);
+        m_load        = load;
+        m_peakLoad    = max(m_peakLoad, load);
+        m_meanMs      = mean;
+        m_lastDropped = dropped;
+    }
+
+    LOG(VB_PLAYBACK, LOG_DEBUG, LOC +
+        QString("Load: %1% Mean: %2ms Dropped: %3 (%4 x%5)")
+            .arg(load * 100, 0, 'f', 0).arg(mean, 0, 'f', 2).arg(dropped)
+            .arg(TypeToString(m_type)).arg(m_threads));
+
+    if (!m_adaptive)
+        return;
+
+    if (m_cooldown > 0)
+    {
+        m_cooldown--;
+        return;
+    }
+
+    bool behind = (load > kHighLoad) ||
+                  (dropped >= kDropLimit && load > kBusyLoad);
+    Setting setting = { m_threads, m_type };
+
+    if (behind)
+    {
+        if (m_threads < m_maxThreads)
+            setting.threads = min(m_threads * 2, m_maxThreads);
+        else if (m_type == FF_THREAD_SLICE && m_frameCapable)
+            setting.type = FF_THREAD_FRAME;
+
+        if (setting.threads == m_threads && setting.type == m_type)
+        {
+            if (!m_saturated)
+            {
+                LOG(VB_GENERAL, LOG_WARNING, LOC +
+                    QString("Decoder can't keep up with %1 using %2 %3 "
+                            "threads (load %4%)")
+                        .arg(m_key).arg(m_threads).arg(TypeToString(m_type))
+                        .arg(load * 100, 0, 'f', 0));
+                m_saturated = true;
+            }
+            return;
+        }
+
+        LOG(VB_GENERAL, LOG_INFO, LOC +
+            QString("Load %1%, dropped %2: switching %3 to %4 %5 threads")
+                .arg(load * 100, 0, 'f', 0).arg(dropped).arg(m_key)
+                .arg(setting.threads).arg(TypeToString(setting.type)));
+        m_reconfigure = true;
+    }
+    else if (load < kLowLoad && m_threads > 1)
+    {
+        // Reopening the codec would interrupt playback, so only remember
+        // that fewer threads are enough for the next stream like this one
+        setting.threads = max((int)ceil(m_threads * load / kTargetLoad), 1);
+    }
+    else
+    {
+        return;
+    }
+
+    QMutexLocker locker(&s_historyLock);
+    s_history[m_key] = setting;
+}
+
+QString DecodeLoadMonitor::GetStats(void) const
+{
+    QMutexLocker locker(&m_statsLock);
+    return QString("%1% (peak %2%) %3ms/frame, %4 x%5")
+        .arg(m_load * 100, 0, 'f', 0).arg(m_peakLoad * 100, 0, 'f', 0)
+        .arg(m_meanMs, 0, 'f', 1).arg(TypeToString(m_type)).arg(m_threads);
+}
+
+QString DecodeLoadMonitor::TypeToString(int type)
+{
+    if (type == FF_THREAD_FRAME)
+        return "frame";
+    if (type == FF_THREAD_SLICE)
+        return "slice";
+    return "none";
+}
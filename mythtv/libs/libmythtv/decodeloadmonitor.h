@@ -0,0 +1,89 @@
+#ifndef DECODELOADMONITOR_H
+#define DECODELOADMONITOR_H
+
+#include <cstdint>
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include "mythtimer.h"
+
+struct AVCodec;
+struct AVCodecContext;
+
+/** \class DecodeLoadMonitor
+ *  \brief Chooses libavcodec threading for a video stream and watches how
+ *         much of each frame's deadline the decoder uses.
+ *
+ *  Configure() picks slice or frame threading and a thread count for a
+ *  newly opened codec. Slice threading adds no latency and holds no extra
+ *  frames, so it is preferred for cheap streams; frame threading scales
+ *  better and is used for everything else.
+ *
+ *  While decoding, the time spent in the decoder is compared with the frame
+ *  interval over windows of roughly two seconds. When the decoder overruns,
+ *  or the player reports dropped frames while the decoder is busy, a
+ *  heavier configuration is recorded and NeedsReconfigure() asks the caller
+ *  to reopen the codec. A configuration that turns out to be wasteful is
+ *  only remembered, so that the next stream of the same kind starts leaner
+ *  without disturbing the current playback.
+ */
+class DecodeLoadMonitor
+{
+  public:
+    DecodeLoadMonitor();
+
+    void Configure(AVCodecContext *enc, const AVCodec *codec,
+                   uint max_threads, float fps, bool adaptive);
+    void CodecOpened(const AVCodecContext *enc);
+
+    void DecodeStarted(void);
+    void DecodeFinished(void);
+    void FrameDecoded(void) { m_windowFrames++; }
+    /// Called from the player thread when it drops a frame to keep up
+    void FrameDropped(void) { m_dropped.ref(); }
+    bool NeedsReconfigure(void);
+
+    QString GetStats(void) const;
+
+  private:
+    struct Setting
+    {
+        int threads;
+        int type;
+    };
+
+    void EndWindow(void);
+    static QString TypeToString(int type);
+
+    QString   m_key;
+    bool      m_adaptive      {false};
+    int       m_maxThreads    {1};
+    int       m_threads       {1};       ///< written under m_statsLock
+    int       m_type          {0};       ///< written under m_statsLock
+    bool      m_sliceCapable  {false};
+    bool      m_frameCapable  {false};
+    int64_t   m_interval      {40000000}; ///< frame interval in nanoseconds
+
+    MythTimer m_timer;
+    int64_t   m_windowBusy    {0};
+    int       m_windowFrames  {0};
+    int       m_windowSize    {50};
+    int       m_cooldown      {0};
+    bool      m_reconfigure   {false};
+    bool      m_saturated     {false};
+    QAtomicInt m_dropped      {0};
+
+    mutable QMutex m_statsLock;
+    double    m_load          {0.0};
+    double    m_peakLoad      {0.0};
+    double    m_meanMs        {0.0};
+    int       m_lastDropped   {0};
+
+    static QMutex                  s_historyLock;
+    static QHash<QString, Setting> s_history;
+};
+
+#endif // DECODELOADMONITOR_H
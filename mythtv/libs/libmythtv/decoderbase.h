@@ -211,6 +211,10 @@ class DecoderBase
     long long GetFramesPlayed(void) const { return framesPlayed; }
 
     virtual QString GetCodecDecoderName(void) const = 0;
+    /// Adds decoder statistics for the OSD debug screen to infoMap
+    virtual void GetDecoderStats(InfoMap &/*infoMap*/) const { }
+    /// Tells the decoder that the player dropped a frame to keep up
+    virtual void FrameDropped(void) { }
     virtual QString GetRawEncodingType(void) { return QString(); }
     virtual MythCodecID GetVideoCodecID(void) const = 0;
     virtual void *GetVideoCodecPrivate(void) { return nullptr; }
@@ -22,6 +22,8 @@ typedef struct FmtConv_
 typedef struct VideoFilter_ VideoFilter;
 
 typedef VideoFilter*(*init_filter)(int, int, int *, int *, char *, int);
+typedef int (*prepare_filter)(VideoFilter *, VideoFrame *, int, int);
+typedef int (*slice_filter)(VideoFilter *, VideoFrame *, int, int, int);
 
 typedef struct FilterInfo_
 {
@@ -30,6 +32,12 @@ typedef struct FilterInfo_
     char *descript;
     FmtConv *formats;
     char *libname;
+    /* Optional slice-parallel entry points. A filter that sets
+     * filter_slice declares that disjoint slices of a frame may be
+     * processed concurrently; filter_prepare, if set, is run once per
+     * frame before any slice. */
+    prepare_filter filter_prepare;
+    slice_filter filter_slice;
 } FilterInfo;
 
 struct VideoFilter_
@@ -42,9 +50,11 @@ struct VideoFilter_
     VideoFrameType outpixfmt;
     char *opts;
     FilterInfo *info;
+    prepare_filter filter_prepare; /* Copied from FilterInfo, may be NULL */
+    slice_filter filter_slice;     /* Copied from FilterInfo, may be NULL */
 };
 
-#define FILT_NULL {NULL,NULL,NULL,NULL,NULL}
+#define FILT_NULL {NULL,NULL,NULL,NULL,NULL,NULL,NULL}
 
 #ifdef TIME_FILTER
 
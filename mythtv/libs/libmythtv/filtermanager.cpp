@@ -9,12 +9,14 @@
 
 // Qt headers
 #include <QDir>
+#include <QRunnable>
 #include <QStringList>
 
 // MythTV headers
 #include "mythcontext.h"
 #include "filtermanager.h"
 #include "mythdirs.h"
+#include "mthreadpool.h"
 
 #define LOC QString("FilterManager: ")
 
@@ -37,8 +39,48 @@ static const char *FmtToString(VideoFrameType ft)
     }
 }
 
+/** \class FilterSliceRunnable
+ *  \brief Runs one slice of the current slice-parallel filter in a
+ *         FilterChain's thread pool.
+ */
+class FilterSliceRunnable : public QRunnable
+{
+  public:
+    FilterSliceRunnable(FilterChain *chain, int slice)
+        : m_chain(chain), m_slice(slice)
+    {
+        setAutoDelete(false);
+    }
+
+    void run(void) override // QRunnable
+    {
+        m_chain->RunSlice(m_slice);
+    }
+
+  private:
+    FilterChain *m_chain;
+    int          m_slice;
+};
+
+FilterChain::FilterChain(int max_threads)
+  : m_sliceCount(max(max_threads, 1))
+{
+}
+
 FilterChain::~FilterChain()
 {
+    if (m_slicePool)
+    {
+        m_slicePool->Stop();
+        m_slicePool->DeletePoolThreads();
+        delete m_slicePool;
+        m_slicePool = nullptr;
+    }
+    vector<FilterSliceRunnable*>::iterator rit = m_sliceRunners.begin();
+    for (; rit != m_sliceRunners.end(); ++rit)
+        delete *rit;
+    m_sliceRunners.clear();
+
     vector<VideoFilter*>::iterator it = filters.begin();
     for (; it != filters.end(); ++it)
     {
@@ -58,14 +100,74 @@ void FilterChain::ProcessFrame(VideoFrame *frame, FrameScanType scan)
     if (!frame)
         return;
 
+    int field = (kScan_Intr2ndField == scan) ? 1 : 0;
+
     vector<VideoFilter*>::iterator it = filters.begin();
     for (; it != filters.end(); ++it)
-        (*it)->filter(*it, frame, kScan_Intr2ndField == scan);
+    {
+        if ((*it)->filter_slice && m_sliceCount > 1)
+            ProcessSlices(*it, frame, field);
+        else
+            (*it)->filter(*it, frame, field);
+    }
+}
+
+/** \fn FilterChain::ProcessSlices(VideoFilter*,VideoFrame*,int)
+ *  \brief Splits the frame into m_sliceCount horizontal slices and filters
+ *         them concurrently, returning once every slice is done.
+ *
+ *   The calling thread processes slice 0 itself, so the pool only needs
+ *   m_sliceCount - 1 threads.
+ */
+void FilterChain::ProcessSlices(VideoFilter *filter, VideoFrame *frame,
+                                int field)
+{
+    if (filter->filter_prepare)
+        filter->filter_prepare(filter, frame, field, m_sliceCount);
+
+    if (!m_slicePool)
+    {
+        m_slicePool = new MThreadPool("FilterSlices");
+        m_slicePool->setMaxThreadCount(m_sliceCount - 1);
+        for (int i = 0; i < m_sliceCount; i++)
+            m_sliceRunners.push_back(new FilterSliceRunnable(this, i));
+        LOG(VB_PLAYBACK, LOG_INFO, LOC +
+            QString("Processing slice safe filters with %1 threads")
+                .arg(m_sliceCount));
+    }
+
+    m_sliceLock.lock();
+    m_sliceFilter   = filter;
+    m_sliceFrame    = frame;
+    m_sliceField    = field;
+    m_slicesPending = m_sliceCount - 1;
+    m_sliceLock.unlock();
+
+    for (int i = 1; i < m_sliceCount; i++)
+        m_slicePool->start(m_sliceRunners[i], "FilterSlice");
+
+    filter->filter_slice(filter, frame, field, 0, m_sliceCount);
+
+    QMutexLocker locker(&m_sliceLock);
+    while (m_slicesPending > 0)
+        m_sliceDone.wait(&m_sliceLock);
+    m_sliceFilter = nullptr;
+    m_sliceFrame  = nullptr;
+}
+
+void FilterChain::RunSlice(int slice)
+{
+    m_sliceFilter->filter_slice(m_sliceFilter, m_sliceFrame, m_sliceField,
+                                slice, m_sliceCount);
+
+    QMutexLocker locker(&m_sliceLock);
+    if (--m_slicesPending <= 0)
+        m_sliceDone.wakeAll();
 }
 
-FilterManager::FilterManager()
+FilterManager::FilterManager(const QString &filterdir)
 {
-    QDir FiltDir(GetFiltersDir());
+    QDir FiltDir(filterdir.isEmpty() ? GetFiltersDir() : filterdir);
 
     FiltDir.setFilter(QDir::Files | QDir::Readable);
     QString filter = GetFiltersNameFilter();
@@ -162,6 +264,8 @@ bool FilterManager::LoadFilterLib(const QString &path)
 
         FilterInfo *newFilter = new FilterInfo;
         newFilter->filter_init = nullptr;
+        newFilter->filter_prepare = nullptr;
+        newFilter->filter_slice = nullptr;
         newFilter->name     = strdup(filtInfo->name);
         newFilter->descript = strdup(filtInfo->descript);
 
@@ -204,7 +308,7 @@ FilterChain *FilterManager::LoadFilters(QString Filters,
         return nullptr;
 
     vector<const FilterInfo*> FiltInfoChain;
-    FilterChain *FiltChain = new FilterChain;
+    FilterChain *FiltChain = new FilterChain(max_threads);
     vector<FmtConv*> FmtList;
     const FilterInfo *FI;
     const FilterInfo *FI2;
@@ -554,5 +658,19 @@ VideoFilter * FilterManager::LoadFilter(const FilterInfo *FiltInfo,
     else
         Filter->opts = nullptr;
     Filter->info = const_cast<FilterInfo*>(FiltInfo);
+
+    // Pick up the slice entry points of the named filter, if it has any
+    Filter->filter_prepare = nullptr;
+    Filter->filter_slice = nullptr;
+    for (; filtInfo->filter_init; filtInfo++)
+    {
+        if (filtInfo->name && !strcmp(filtInfo->name, FiltInfo->name))
+        {
+            Filter->filter_prepare = filtInfo->filter_prepare;
+            Filter->filter_slice = filtInfo->filter_slice;
+            break;
+        }
+    }
+
     return Filter;
 }
@@ -11,16 +11,23 @@ using namespace std;
 
 // Qt headers
 #include <QString>
+#include <QMutex>
+#include <QWaitCondition>
 
 typedef map<QString,void*>       library_map_t;
 typedef map<QString,FilterInfo*> filter_map_t;
 
 #include "videoouttypes.h"
 
+class MThreadPool;
+class FilterSliceRunnable;
+
 class FilterChain
 {
+    friend class FilterSliceRunnable;
+
   public:
-    FilterChain() = default;
+    explicit FilterChain(int max_threads = 1);
     virtual ~FilterChain();
 
     void ProcessFrame(VideoFrame *Frame, FrameScanType scan = kScan_Ignore);
@@ -28,13 +35,27 @@ class FilterChain
     void Append(VideoFilter *f) { filters.push_back(f); }
 
   private:
+    void ProcessSlices(VideoFilter *filter, VideoFrame *frame, int field);
+    void RunSlice(int slice);
+
     vector<VideoFilter*> filters;
+
+    // Slice-parallel execution of filters which provide filter_slice
+    int                           m_sliceCount    {1};
+    MThreadPool                  *m_slicePool     {nullptr};
+    vector<FilterSliceRunnable*>  m_sliceRunners;
+    QMutex                        m_sliceLock;
+    QWaitCondition                m_sliceDone;
+    int                           m_slicesPending {0};
+    VideoFilter                  *m_sliceFilter   {nullptr};
+    VideoFrame                   *m_sliceFrame    {nullptr};
+    int                           m_sliceField    {0};
 };
 
 class FilterManager
 {
   public:
-    FilterManager();
+    explicit FilterManager(const QString &filterdir = QString());
    ~FilterManager();
 
     VideoFilter *LoadFilter(const FilterInfo *Filt, VideoFrameType inpixfmt,
@@ -10,7 +10,8 @@
 
 Jitterometer::Jitterometer(const QString &nname, int ncycles)
   : count(0), num_cycles(ncycles), starttime_valid(0), last_fps(0),
-    last_sd(0), name(nname), cpustat(nullptr), laststats(nullptr)
+    last_sd(0), name(nname), cpustat(nullptr), laststats(nullptr),
+    total_cycles(0), total_time(0), max_time(0)
 {
     times.resize(num_cycles);
     memset(&starttime, 0, sizeof(struct timeval));
@@ -76,6 +77,10 @@ bool Jitterometer::RecordEndTime()
     {
         times[count] = (timenow.tv_sec  - starttime.tv_sec ) * 1000000 +
                        (timenow.tv_usec - starttime.tv_usec) ;
+        total_cycles++;
+        total_time += times[count];
+        if (times[count] > max_time)
+            max_time = times[count];
         count++;
     }
 
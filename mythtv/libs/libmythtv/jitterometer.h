@@ -1,6 +1,8 @@
 #ifndef JITTEROMETER_H
 #define JITTEROMETER_H
 
+#include <cstdint>
+
 #include <QVector>
 #include <QFile>
 #include "mythtvexp.h"
@@ -43,6 +45,13 @@ class MTV_PUBLIC Jitterometer
     float GetLastFPS(void) const { return last_fps; }
     float GetLastSD(void) const { return last_sd;  }
     QString GetLastCPUStats(void) const { return lastcpustats; }
+    /// Number of cycles measured since construction
+    uint64_t GetTotalCycles(void) const { return total_cycles; }
+    /// Mean cycle length since construction, in microseconds
+    double GetTotalMean(void) const
+        { return total_cycles ? (double)total_time / total_cycles : 0.0; }
+    /// Longest cycle since construction, in microseconds
+    uint GetTotalMax(void) const { return max_time; }
     void SetNumCycles(int cycles);
     bool RecordCycleTime();
     void RecordStartTime();
@@ -61,6 +70,9 @@ class MTV_PUBLIC Jitterometer
     QFile *cpustat;
     unsigned long long *laststats;
     QString lastcpustats;
+    uint64_t total_cycles;
+    uint64_t total_time;
+    uint max_time;
 };
 
 #endif // JITTEROMETER_H
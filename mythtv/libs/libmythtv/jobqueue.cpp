@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <fcntl.h>
 #include <pthread.h>
+#include <algorithm>
 using namespace std;
 
 #include <QDateTime>
@@ -13,6 +14,7 @@ using namespace std;
 #include <QRegExp>
 #include <QEvent>
 #include <QCoreApplication>
+#include <QSet>
 
 #include "mythconfig.h"
 
@@ -26,9 +28,11 @@ using namespace std;
 #include "recordingprofile.h"
 #include "recordinginfo.h"
 #include "mthread.h"
+#include "mthreadpool.h"
 
 #include "mythdb.h"
 #include "mythdirs.h"
+#include "storagegroup.h"
 #include "mythsystemlegacy.h"
 #include "mythlogging.h"
 #include "mythmiscutil.h"
@@ -43,6 +47,50 @@ using namespace std;
 
 #define LOC     QString("JobQueue: ")
 
+/// Check intervals a job must wait before a host without local access to
+/// its recording may take it over from a busy host
+static const int kRemoteStealDelay = 2;
+
+class SendGlobalToMaster : public QRunnable
+{
+  public:
+    explicit SendGlobalToMaster(const QString &message) : m_message(message) {}
+
+    void run(void) override // QRunnable
+    {
+        QStringList strlist("MESSAGE");
+        strlist << m_message;
+        gCoreContext->SendReceiveStringList(strlist, true);
+    }
+
+  private:
+    QString m_message;
+};
+
+/** \brief Sends a GLOBAL_ job queue message to the job queues of every
+ *         backend.
+ *
+ *  Events sent on a backend are only dispatched in that process, and only
+ *  the master passes GLOBAL_ messages on to the other backends, as their
+ *  LOCAL_ form. A slave therefore hands the message to the master itself
+ *  and dispatches the LOCAL_ form for its own job queue.
+ */
+static void SendGlobalEvent(const QString &message)
+{
+    if (!gCoreContext->IsBackend() || gCoreContext->IsMasterBackend())
+    {
+        gCoreContext->SendEvent(MythEvent(message));
+        return;
+    }
+
+    QString local = message;
+    local.replace(0, 7, "LOCAL_");
+    gCoreContext->dispatch(MythEvent(local));
+
+    MThreadPool::globalInstance()->start(
+        new SendGlobalToMaster(message), "SendGlobalToMaster");
+}
+
 JobQueue::JobQueue(bool master) :
     m_hostname(gCoreContext->GetHostName()),
     jobsRunning(0),
@@ -51,7 +99,8 @@ JobQueue::JobQueue(bool master) :
     runningJobsLock(new QMutex(QMutex::Recursive)),
     isMaster(master),
     queueThread(new MThread("JobQueue", this)),
-    processQueue(false)
+    processQueue(false),
+    m_wakeRequested(false)
 {
     jobQueueCPU = gCoreContext->GetNumSetting("JobQueueCPU", 0);
 
@@ -91,6 +140,21 @@ void JobQueue::customEvent(QEvent *e)
         MythEvent *me = static_cast<MythEvent *>(e);
         QString message = me->Message();
 
+        // Look at the queue right away when a job was added or changed,
+        // or when a recording finished and its jobs may now run
+        if (message == "LOCAL_JOBQUEUE_CHANGE" ||
+            message.startsWith("DONE_RECORDING"))
+        {
+            Wake();
+            return;
+        }
+
+        if (message.startsWith("LOCAL_JOBQUEUE_CAPACITY"))
+        {
+            UpdateHostCapacity(message);
+            return;
+        }
+
         if (message.startsWith("LOCAL_JOB"))
         {
             // LOCAL_JOB action ID jobID
@@ -163,6 +227,191 @@ void JobQueue::run(void)
     ProcessQueue();
 }
 
+void JobQueue::Wake(void)
+{
+    QMutexLocker locker(&queueThreadCondLock);
+    m_wakeRequested = true;
+    queueThreadCond.wakeAll();
+}
+
+/** \fn JobQueue::AdvertiseCapacity(int, int, int)
+ *  \brief Tells the other backends how many more jobs this host can start.
+ *
+ *  The message is only sent when it changes, or to refresh it before the
+ *  other hosts consider it stale.
+ */
+void JobQueue::AdvertiseCapacity(int running, int free, int interval)
+{
+    QString message = QString("GLOBAL_JOBQUEUE_CAPACITY %1 %2 %3 %4")
+        .arg(m_hostname).arg(running).arg(free).arg(interval);
+
+    QDateTime now = MythDate::current();
+    if (message == m_lastCapacity && m_lastCapacityTime.isValid() &&
+        m_lastCapacityTime.secsTo(now) < interval / 2)
+        return;
+
+    m_lastCapacity = message;
+    m_lastCapacityTime = now;
+    SendGlobalEvent(message);
+}
+
+void JobQueue::UpdateHostCapacity(const QString &message)
+{
+    // LOCAL_JOBQUEUE_CAPACITY hostname running free interval
+    QStringList tokens = message.split(" ", QString::SkipEmptyParts);
+    if (tokens.size() != 5)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Bad capacity message: '%1'").arg(message));
+        return;
+    }
+
+    if (tokens[1] == m_hostname)
+        return;
+
+    JobHostCapacity capacity;
+    capacity.running  = tokens[2].toInt();
+    capacity.free     = tokens[3].toInt();
+    capacity.interval = tokens[4].toInt();
+    capacity.updated  = MythDate::current();
+
+    QMutexLocker locker(&m_capacityLock);
+    m_hostCapacity[tokens[1]] = capacity;
+}
+
+/// Returns true if \p hostname recently said it can't start any more jobs.
+/// Hosts we have not heard from are never considered busy.
+bool JobQueue::IsHostBusy(const QString &hostname)
+{
+    QMutexLocker locker(&m_capacityLock);
+    QMap<QString, JobHostCapacity>::const_iterator it =
+        m_hostCapacity.constFind(hostname);
+    if (it == m_hostCapacity.constEnd())
+        return false;
+
+    int maxAge = max((*it).interval, 5) * 3;
+    if ((*it).updated.secsTo(MythDate::current()) > maxAge)
+        return false;
+
+    return (*it).free <= 0;
+}
+
+/// Returns true if the recording of \p job is in a local storage group.
+bool JobQueue::HasLocalFile(const JobQueueEntry &job)
+{
+    if (!job.chanid)
+        return true;
+
+    ProgramInfo pginfo(job.chanid, job.recstartts);
+    if (!pginfo.GetChanID())
+        return false;
+
+    StorageGroup sgroup(pginfo.GetStorageGroup(), m_hostname);
+    return !sgroup.FindFileDir(pginfo.GetBasename()).isEmpty();
+}
+
+/** \fn JobQueue::FindStealableJob(const QMap<int, JobQueueEntry>&, const QList<int>&, int)
+ *  \brief Picks a queued job of a busy backend that this host could run.
+ *
+ *  Only the next job of a recording is considered, and only while no other
+ *  job of that recording is in progress, so a recording's jobs still run
+ *  in order. Jobs whose recording is in one of our storage groups are
+ *  taken first. Other jobs are only taken after they have waited a while,
+ *  leaving them to hosts with local access.
+ *
+ *  \return The key of the job in \p jobs, or -1.
+ */
+int JobQueue::FindStealableJob(const QMap<int, JobQueueEntry> &jobs,
+                               const QList<int> &remoteJobs, int interval)
+{
+    QDateTime now = MythDate::current();
+    int fallback = -1;
+
+    foreach (int x, remoteJobs)
+    {
+        const JobQueueEntry &job = jobs[x];
+
+        bool blocked = false;
+        QMap<int, JobQueueEntry>::const_iterator it = jobs.constBegin();
+        for (; it != jobs.constEnd() && !blocked; ++it)
+        {
+            if (it.key() == x || !job.chanid ||
+                (*it).chanid != job.chanid ||
+                (*it).recstartts != job.recstartts)
+                continue;
+            blocked = ((*it).status != JOB_QUEUED) || (it.key() < x);
+        }
+        if (blocked)
+            continue;
+
+        if (!IsHostBusy(job.hostname))
+            continue;
+
+        JobQueueEntry unassigned = job;
+        unassigned.hostname.clear();
+        if (!AllowedToRun(unassigned))
+            continue;
+
+        if (HasLocalFile(job))
+            return x;
+
+        QDateTime queued = max(job.inserttime, job.schedruntime);
+        if (fallback < 0 &&
+            queued.secsTo(now) >= (qint64)interval * kRemoteStealDelay)
+            fallback = x;
+    }
+
+    return fallback;
+}
+
+/// Moves a job that has not started yet from \p fromHost to \p toHost.
+/// Fails if the job was started or moved in the meantime.
+bool JobQueue::StealJob(int jobID, const QString &fromHost,
+                        const QString &toHost)
+{
+    MSqlQuery query(MSqlQuery::InitCon());
+
+    query.prepare("UPDATE jobqueue SET hostname = :NEWHOSTNAME "
+                  "WHERE id = :ID AND hostname = :OLDHOSTNAME "
+                  "AND status = :QUEUED AND cmds = :RUN;");
+    query.bindValue(":NEWHOSTNAME", toHost);
+    query.bindValue(":ID", jobID);
+    query.bindValue(":OLDHOSTNAME", fromHost);
+    query.bindValue(":QUEUED", JOB_QUEUED);
+    query.bindValue(":RUN", JOB_RUN);
+
+    if (!query.exec())
+    {
+        MythDB::DBError("Error in JobQueue::StealJob()", query);
+        return false;
+    }
+
+    return query.numRowsAffected() > 0;
+}
+
+/// Moves a queued job of \p hostname to pending, unless it was already
+/// started or moved to another host.
+bool JobQueue::MarkJobPending(int jobID, const QString &hostname)
+{
+    MSqlQuery query(MSqlQuery::InitCon());
+
+    query.prepare("UPDATE jobqueue SET status = :PENDING, comment = '' "
+                  "WHERE id = :ID AND hostname = :HOSTNAME "
+                  "AND status = :QUEUED;");
+    query.bindValue(":PENDING", JOB_PENDING);
+    query.bindValue(":ID", jobID);
+    query.bindValue(":HOSTNAME", hostname);
+    query.bindValue(":QUEUED", JOB_QUEUED);
+
+    if (!query.exec())
+    {
+        MythDB::DBError("Error in JobQueue::MarkJobPending()", query);
+        return false;
+    }
+
+    return query.numRowsAffected() > 0;
+}
+
 void JobQueue::ProcessQueue(void)
 {
     LOG(VB_JOBQUEUE, LOG_INFO, LOC + "ProcessQueue() started");
@@ -177,6 +426,10 @@ void JobQueue::ProcessQueue(void)
     QMap<int, int> jobStatus;
     QString message;
     QMap<int, JobQueueEntry> jobs;
+    QList<int> runningTypes;
+    QList<int> candidates;
+    QList<int> remoteJobs;
+    QSet<QString> queuedRecordings;
     bool atMax = false;
     bool inTimeWindow = true;
     QMap<int, RunningJobInfo>::Iterator rjiter;
@@ -186,7 +439,8 @@ void JobQueue::ProcessQueue(void)
     {
         locker.unlock();
 
-        bool startedJobAlready = false;
+        int startedJobs = 0;
+        int heldJobs = 0;
         int sleepTime = gCoreContext->GetNumSetting("JobQueueCheckFrequency", 30);
         int maxJobs = gCoreContext->GetNumSetting("JobQueueMaxSimultaneousJobs", 3);
         LOG(VB_JOBQUEUE, LOG_INFO, LOC +
@@ -205,8 +459,15 @@ void JobQueue::ProcessQueue(void)
         runningJobsLock->unlock();
 
         jobsRunning = 0;
+        runningTypes.clear();
+        candidates.clear();
+        remoteJobs.clear();
+        queuedRecordings.clear();
         GetJobsInQueue(jobs);
 
+        QDateTime now = MythDate::current();
+        qint64 nextScheduled = -1;
+
         if (jobs.size())
         {
             inTimeWindow = InJobRunWindow();
@@ -219,8 +480,12 @@ void JobQueue::ProcessQueue(void)
                      (status == JOB_STARTING) ||
                      (status == JOB_PAUSED)) &&
                     (hostname == m_hostname))
-                jobsRunning++;
+                {
+                    jobsRunning++;
+                    runningTypes.append(jobs[x].type);
+                }
             }
+            m_scheduler.BeginPass(runningTypes);
 
             message = QString("Currently Running %1 jobs.")
                               .arg(jobsRunning);
@@ -273,6 +538,11 @@ void JobQueue::ProcessQueue(void)
                     // completed on the remote host.
                     jobStatus[jobID] = status;
 
+                    // We may take it over if that host is too busy
+                    if ((status == JOB_QUEUED) && (cmds == JOB_RUN) &&
+                        (jobs[x].schedruntime <= now))
+                        remoteJobs.append(x);
+
                     message = QString("Skipping '%1' job for %2, "
                                       "should run on '%3' instead")
                                       .arg(JobText(jobs[x].type)).arg(logInfo)
@@ -314,8 +584,12 @@ void JobQueue::ProcessQueue(void)
                 }
 
                 // Is this job scheduled for the future
-                if (jobs[x].schedruntime > MythDate::current())
+                if (jobs[x].schedruntime > now)
                 {
+                    qint64 secs = now.secsTo(jobs[x].schedruntime);
+                    if (nextScheduled < 0 || secs < nextScheduled)
+                        nextScheduled = secs;
+
                     message = QString("Skipping '%1' job for %2, this job is "
                                       "not scheduled to run until %3.")
                                       .arg(JobText(jobs[x].type)).arg(logInfo)
@@ -428,42 +702,134 @@ void JobQueue::ProcessQueue(void)
                     continue;
                 }
 
-                // never start or claim more than one job in a single run
-                if (startedJobAlready)
+                if (!inTimeWindow)
+                {
+                    message = QString("Skipping '%1' job for %2, "
+                                      "current time is outside of the "
+                                      "Job Queue processing window.")
+                                      .arg(JobText(jobs[x].type)).arg(logInfo);
+                    LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
                     continue;
+                }
 
-                if ((inTimeWindow) &&
-                    (hostname.isEmpty()) &&
-                    (!ChangeJobHost(jobID, m_hostname)))
+                // Jobs for one recording run in the order they were queued
+                if (jobs[x].chanid)
                 {
-                    message = QString("Unable to claim '%1' job for %2")
-                                      .arg(JobText(jobs[x].type)).arg(logInfo);
-                    LOG(VB_JOBQUEUE, LOG_ERR, LOC + message);
+                    QString recording = QString("%1_%2").arg(jobs[x].chanid)
+                                                        .arg(jobs[x].startts);
+                    if (queuedRecordings.contains(recording))
+                    {
+                        message = QString("Skipping '%1' job for %2, "
+                                          "an earlier job for this recording "
+                                          "is still queued")
+                                          .arg(JobText(jobs[x].type))
+                                          .arg(logInfo);
+                        LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
+                        continue;
+                    }
+                    queuedRecordings.insert(recording);
+                }
+
+                candidates.append(x);
+            }
+
+            // Start the most urgent jobs that fit on this host, aging
+            // their priority by how long they have waited
+            std::stable_sort(candidates.begin(), candidates.end(),
+                [&](int a, int b)
+                {
+                    QDateTime qa = max(jobs[a].inserttime, jobs[a].schedruntime);
+                    QDateTime qb = max(jobs[b].inserttime, jobs[b].schedruntime);
+                    return m_scheduler.Priority(jobs[a].type, qa, now) >
+                           m_scheduler.Priority(jobs[b].type, qb, now);
+                });
+
+            foreach (int x, candidates)
+            {
+                if (jobsRunning >= maxJobs)
+                    break;
+
+                jobID = jobs[x].id;
+                if (!jobs[x].chanid)
+                    logInfo = QString("jobID #%1").arg(jobID);
+                else
+                    logInfo = QString("chanid %1 @ %2").arg(jobs[x].chanid)
+                                      .arg(jobs[x].startts);
+
+                QString reason;
+                if (!m_scheduler.Admit(jobs[x].type, reason))
+                {
+                    message = QString("Holding '%1' job for %2, %3")
+                                      .arg(JobText(jobs[x].type)).arg(logInfo)
+                                      .arg(reason);
+                    LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
+                    heldJobs++;
+
+                    // Don't let smaller jobs keep taking the resources a
+                    // long waiting job needs
+                    QDateTime queued = max(jobs[x].inserttime,
+                                           jobs[x].schedruntime);
+                    if (m_scheduler.IsStarving(queued, now))
+                        break;
                     continue;
                 }
 
-                if (!inTimeWindow)
+                if ((jobs[x].hostname.isEmpty()) &&
+                    (!ChangeJobHost(jobID, m_hostname)))
                 {
-                    message = QString("Skipping '%1' job for %2, "
-                                      "current time is outside of the "
-                                      "Job Queue processing window.")
+                    message = QString("Unable to claim '%1' job for %2")
                                       .arg(JobText(jobs[x].type)).arg(logInfo);
-                    LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
+                    LOG(VB_JOBQUEUE, LOG_ERR, LOC + message);
                     continue;
                 }
 
                 message = QString("Processing '%1' job for %2, "
                                   "current status is '%3'")
                                   .arg(JobText(jobs[x].type)).arg(logInfo)
-                                  .arg(StatusText(status));
+                                  .arg(StatusText(jobs[x].status));
                 LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
 
                 ProcessJob(jobs[x]);
 
-                startedJobAlready = true;
+                jobsRunning++;
+                startedJobs++;
             }
+
+            // With slots to spare, help out a backend that has none
+            if (inTimeWindow && !heldJobs && (jobsRunning < maxJobs) &&
+                !remoteJobs.empty() &&
+                gCoreContext->GetBoolSetting("JobQueueStealJobs", true))
+            {
+                int x = FindStealableJob(jobs, remoteJobs, sleepTime);
+                QString reason;
+                if (x >= 0 && m_scheduler.Admit(jobs[x].type, reason))
+                {
+                    QString owner = jobs[x].hostname;
+                    if (StealJob(jobs[x].id, owner, m_hostname))
+                    {
+                        message = QString("Took '%1' job ID %2 over from "
+                                          "'%3', which is busy")
+                                          .arg(JobText(jobs[x].type))
+                                          .arg(jobs[x].id).arg(owner);
+                        LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
+
+                        jobs[x].hostname = m_hostname;
+                        ProcessJob(jobs[x]);
+
+                        jobsRunning++;
+                        startedJobs++;
+                    }
+                }
+            }
+
+            if (!candidates.empty())
+                LOG(VB_JOBQUEUE, LOG_INFO, LOC + m_scheduler.GetStatus());
         }
 
+        int freeSlots = (inTimeWindow && !heldJobs) ?
+            max(maxJobs - jobsRunning, 0) : 0;
+        AdvertiseCapacity(jobsRunning, freeSlots, sleepTime);
+
         if (QCoreApplication::applicationName() == MYTH_APPNAME_MYTHJOBQUEUE)
         {
             if (jobsRunning > 0)
@@ -487,13 +853,19 @@ void JobQueue::ProcessQueue(void)
         }
 
 
+        // Sleep until a job is queued or changed, a running job ends or
+        // a scheduled job is due. Poll as well, for changes made directly
+        // in the database and for the host load to change.
         locker.relock();
-        if (processQueue)
+        if (processQueue && !m_wakeRequested)
         {
-            int st = (startedJobAlready) ? (5 * 1000) : (sleepTime * 1000);
+            int st = (startedJobs) ? (5 * 1000) : (sleepTime * 1000);
+            if (nextScheduled >= 0)
+                st = min(st, (int)(nextScheduled + 1) * 1000);
             if (st > 0)
                 queueThreadCond.wait(locker.mutex(), st);
         }
+        m_wakeRequested = false;
     }
 }
 
@@ -606,6 +978,9 @@ bool JobQueue::QueueJob(int jobType, uint chanid, const QDateTime &recstartts,
         return false;
     }
 
+    // Let the job queues look at the new job right away
+    SendGlobalEvent("GLOBAL_JOBQUEUE_CHANGE");
+
     return true;
 }
 
@@ -957,6 +1332,10 @@ bool JobQueue::ChangeJobCmds(int jobID, int newCmds)
         return false;
     }
 
+    // The queue itself resets commands to JOB_RUN once it has acted on them
+    if (newCmds != JOB_RUN)
+        SendGlobalEvent("GLOBAL_JOBQUEUE_CHANGE");
+
     return true;
 }
 
@@ -979,6 +1358,10 @@ bool JobQueue::ChangeJobCmds(int jobType, uint chanid,
         return false;
     }
 
+    // The queue itself resets commands to JOB_RUN once it has acted on them
+    if (newCmds != JOB_RUN)
+        SendGlobalEvent("GLOBAL_JOBQUEUE_CHANGE");
+
     return true;
 }
 
@@ -1011,6 +1394,9 @@ bool JobQueue::ChangeJobStatus(int jobID, int newStatus, QString comment)
     LOG(VB_JOBQUEUE, LOG_INFO, LOC + QString("ChangeJobStatus(%1, %2, '%3')")
             .arg(jobID).arg(StatusText(newStatus)).arg(comment));
 
+    // Only a change of status is announced, a new comment on its own is not
+    int oldStatus = GetJobStatus(jobID);
+
     MSqlQuery query(MSqlQuery::InitCon());
 
     query.prepare("UPDATE jobqueue SET status = :STATUS, comment = :COMMENT "
@@ -1027,6 +1413,14 @@ bool JobQueue::ChangeJobStatus(int jobID, int newStatus, QString comment)
         return false;
     }
 
+    // JOB_STATUS jobid status comment
+    if ((oldStatus != newStatus) && (query.numRowsAffected() > 0))
+    {
+        gCoreContext->SendEvent(MythEvent(QString("JOB_STATUS %1 %2 %3")
+                                          .arg(jobID).arg(newStatus)
+                                          .arg(comment)));
+    }
+
     return true;
 }
 
@@ -1052,6 +1446,10 @@ bool JobQueue::ChangeJobComment(int jobID, QString comment)
         return false;
     }
 
+    // JOB_PROGRESS jobid comment
+    gCoreContext->SendEvent(MythEvent(QString("JOB_PROGRESS %1 %2")
+                                      .arg(jobID).arg(comment)));
+
     return true;
 }
 
@@ -1722,7 +2120,14 @@ void JobQueue::ProcessJob(JobQueueEntry job)
         return;
     }
 
-    ChangeJobStatus(jobID, JOB_PENDING);
+    // Another backend may have taken the job over since the queue was read
+    if (!MarkJobPending(jobID, m_hostname))
+    {
+        LOG(VB_JOBQUEUE, LOG_INFO, LOC +
+            QString("ProcessJob(): Job ID %1 is no longer queued for this "
+                    "host").arg(jobID));
+        return;
+    }
     ProgramInfo *pginfo = nullptr;
 
     if (job.chanid)
@@ -1895,6 +2300,9 @@ void JobQueue::RemoveRunningJob(int id)
     }
 
     runningJobsLock->unlock();
+
+    // A finished job may leave room for a queued one
+    Wake();
 }
 
 QString JobQueue::PrettyPrint(off_t bytes)
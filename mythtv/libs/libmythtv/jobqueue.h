@@ -12,6 +12,7 @@
 #include <QMap>
 
 #include "mythtvexp.h"
+#include "jobscheduler.h"
 
 class MThread;
 class ProgramInfo;
@@ -122,6 +123,14 @@ typedef struct runningjobinfo {
     ProgramInfo *pginfo;
 } RunningJobInfo;
 
+/// The job slots another host last said it had, see JobQueue::ProcessQueue()
+typedef struct jobhostcapacity {
+    int          running;
+    int          free;     ///< 0 if the host can't start any more jobs
+    int          interval; ///< secs between the host's queue checks
+    QDateTime    updated;
+} JobHostCapacity;
+
 class JobQueue;
 
 class MTV_PUBLIC JobQueue : public QObject, public QRunnable
@@ -224,11 +233,22 @@ class MTV_PUBLIC JobQueue : public QObject, public QRunnable
 
     void run(void) override; // QRunnable
     void ProcessQueue(void);
+    void Wake(void);
 
     void ProcessJob(JobQueueEntry job);
 
     bool AllowedToRun(JobQueueEntry job);
 
+    void AdvertiseCapacity(int running, int free, int interval);
+    void UpdateHostCapacity(const QString &message);
+    bool IsHostBusy(const QString &hostname);
+    bool HasLocalFile(const JobQueueEntry &job);
+    int  FindStealableJob(const QMap<int, JobQueueEntry> &jobs,
+                          const QList<int> &remoteJobs, int interval);
+    static bool StealJob(int jobID, const QString &fromHost,
+                         const QString &toHost);
+    static bool MarkJobPending(int jobID, const QString &hostname);
+
     static bool InJobRunWindow(int orStartingWithinMins = 0);
 
     void StartChildJob(void *(*start_routine)(void *), int jobID);
@@ -270,6 +290,14 @@ class MTV_PUBLIC JobQueue : public QObject, public QRunnable
     QWaitCondition queueThreadCond;
     QMutex queueThreadCondLock;
     bool processQueue;
+    bool m_wakeRequested;
+
+    JobScheduler m_scheduler;
+
+    QMutex m_capacityLock;
+    QMap<QString, JobHostCapacity> m_hostCapacity;
+    QString m_lastCapacity;
+    QDateTime m_lastCapacityTime;
 };
 
 #endif
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include <QFile>
+#include <QStringList>
+#include <QThread>
+
+#include "compat.h"
+#include "mythcorecontext.h"
+#include "mythlogging.h"
+#include "mythmiscutil.h"
+#include "jobqueue.h"
+#include "jobscheduler.h"
+
+using namespace std;
+
+#define LOC QString("JobScheduler: ")
+
+/// Waiting time, in minutes, that raises a job's priority by one
+static const int kDefaultAgingMinutes = 30;
+/// Priority levels a job must have gained before it stops others starting
+static const int kStarvationLevels = 4;
+/// Memory, in MB, that jobs leave for recording and playback
+static const int kMemoryReserve = 256;
+
+JobScheduler::JobScheduler() :
+    m_cores(max(QThread::idealThreadCount(), 1)),
+    m_cpuBudget(m_cores),
+    m_load(0.0),
+    m_freeMemory(-1),
+    m_agingSecs(kDefaultAgingMinutes * 60),
+    m_running(0),
+    m_cpuCommitted(0.0),
+    m_ioCommitted(0.0),
+    m_memCommitted(0)
+{
+}
+
+/// Returns the suffix used by the per job type settings, e.g. "CommFlag".
+QString JobScheduler::TypeSettingName(int jobType)
+{
+    if (jobType & JOB_USERJOB)
+        return QString("UserJob%1").arg(JobQueue::UserJobTypeToIndex(jobType));
+
+    switch (jobType)
+    {
+        case JOB_TRANSCODE: return "Transcode";
+        case JOB_COMMFLAG:  return "CommFlag";
+        case JOB_METADATA:  return "Metadata";
+        case JOB_PREVIEW:   return "Preview";
+    }
+    return "Unknown";
+}
+
+JobCost JobScheduler::DefaultCost(int jobType)
+{
+    switch (jobType)
+    {
+        case JOB_TRANSCODE: return JobCost(2.0, 0.40, 400);
+        case JOB_COMMFLAG:  return JobCost(1.0, 0.30, 200);
+        case JOB_METADATA:  return JobCost(0.1, 0.00,  50);
+        case JOB_PREVIEW:   return JobCost(0.5, 0.10, 100);
+    }
+    return JobCost();
+}
+
+int JobScheduler::DefaultPriority(int jobType)
+{
+    switch (jobType)
+    {
+        case JOB_METADATA:  return 3;
+        case JOB_COMMFLAG:
+        case JOB_PREVIEW:   return 2;
+    }
+    return 1;
+}
+
+/** \fn JobScheduler::GetCost(int)
+ *  \brief Returns the declared cost of a job type, either from the
+ *         "JobQueueCost<type>" host setting or a built in estimate.
+ */
+JobCost JobScheduler::GetCost(int jobType)
+{
+    JobCost cost = DefaultCost(jobType);
+    QString setting = gCoreContext->GetSetting(
+        "JobQueueCost" + TypeSettingName(jobType));
+    if (setting.isEmpty())
+        return cost;
+
+    QStringList fields = setting.split(',');
+    bool ok = (fields.size() == 3);
+    JobCost custom;
+    if (ok)
+        custom.m_cpu = fields[0].toDouble(&ok);
+    if (ok)
+        custom.m_io = fields[1].toDouble(&ok);
+    if (ok)
+        custom.m_memory = fields[2].toInt(&ok);
+    if (!ok || custom.m_cpu < 0.0 || custom.m_io < 0.0 || custom.m_memory < 0)
+    {
+        LOG(VB_GENERAL, LOG_WARNING, LOC +
+            QString("Ignoring invalid cost '%1' for %2 jobs")
+                .arg(setting).arg(TypeSettingName(jobType)));
+        return cost;
+    }
+    return custom;
+}
+
+// Memory that can be used without swapping, which on Linux includes
+// reclaimable page cache
+int JobScheduler::AvailableMemory(void)
+{
+    QFile meminfo("/proc/meminfo");
+    if (meminfo.open(QIODevice::ReadOnly))
+    {
+        QByteArray line;
+        while (!(line = meminfo.readLine()).isEmpty())
+        {
+            if (!line.startsWith("MemAvailable:"))
+                continue;
+            QList<QByteArray> fields = line.simplified().split(' ');
+            if (fields.size() >= 2)
+                return fields[1].toLongLong() / 1024;
+        }
+    }
+
+    int totalMB, freeMB, totalVM, freeVM;
+    if (getMemStats(totalMB, freeMB, totalVM, freeVM))
+        return freeMB;
+    return -1;
+}
+
+/** \fn JobScheduler::BeginPass(const QList<int>&)
+ *  \brief Samples the host load and settings before a queue pass.
+ *  \param runningTypes The types of the jobs running on this host.
+ */
+void JobScheduler::BeginPass(const QList<int> &runningTypes)
+{
+    // JobQueueCPU: 0 = low, 1 = medium, 2 = high
+    int cpuSetting = gCoreContext->GetNumSetting("JobQueueCPU", 0);
+    m_cpuBudget = m_cores * ((cpuSetting >= 2) ? 1.0 :
+                             (cpuSetting == 1) ? 0.75 : 0.5);
+    m_agingSecs = max(gCoreContext->GetNumSetting(
+                          "JobQueueAgingMinutes", kDefaultAgingMinutes), 1) * 60;
+
+    double loads[1];
+    m_load = (getloadavg(loads, 1) == 1) ? loads[0] : 0.0;
+    m_freeMemory = AvailableMemory();
+
+    m_running      = runningTypes.size();
+    m_cpuCommitted = 0.0;
+    m_ioCommitted  = 0.0;
+    m_memCommitted = 0;
+    m_typeRunning.clear();
+    foreach (int type, runningTypes)
+    {
+        JobCost cost = GetCost(type);
+        m_cpuCommitted += cost.m_cpu;
+        m_ioCommitted  += cost.m_io;
+        m_typeRunning[type]++;
+    }
+}
+
+/** \fn JobScheduler::Priority(int, const QDateTime&, const QDateTime&) const
+ *  \brief Returns the priority of a job queued at \p queued, higher first.
+ */
+double JobScheduler::Priority(int jobType, const QDateTime &queued,
+                              const QDateTime &now) const
+{
+    int base = gCoreContext->GetNumSetting(
+        "JobQueuePriority" + TypeSettingName(jobType),
+        DefaultPriority(jobType));
+    double waited = max(queued.secsTo(now), (qint64)0);
+    return base + waited / m_agingSecs;
+}
+
+/// Returns true if a job has waited long enough that smaller jobs should
+/// no longer be started ahead of it.
+bool JobScheduler::IsStarving(const QDateTime &queued,
+                              const QDateTime &now) const
+{
+    return queued.secsTo(now) >= (qint64)m_agingSecs * kStarvationLevels;
+}
+
+/** \fn JobScheduler::Admit(int, QString&)
+ *  \brief Returns true if a job of \p jobType fits on this host now, and
+ *         if so counts it as running. Otherwise \p reason says why not.
+ */
+bool JobScheduler::Admit(int jobType, QString &reason)
+{
+    QString name = TypeSettingName(jobType);
+    int limit = gCoreContext->GetNumSetting("JobQueueMax" + name, 0);
+    if (limit > 0 && m_typeRunning.value(jobType) >= limit)
+    {
+        reason = QString("%1 %2 job(s) already running").arg(limit).arg(name);
+        return false;
+    }
+
+    JobCost cost = GetCost(jobType);
+    if (m_running > 0)
+    {
+        // Jobs that have just started don't show in the load average yet
+        double cpu = max(m_load, m_cpuCommitted) + cost.m_cpu;
+        if (cpu > m_cpuBudget)
+        {
+            reason = QString("CPU would be at %1 of %2 cores")
+                .arg(cpu, 0, 'f', 1).arg(m_cpuBudget, 0, 'f', 1);
+            return false;
+        }
+
+        double io = m_ioCommitted + cost.m_io;
+        if (io > 1.0)
+        {
+            reason = QString("disk IO would be at %1%")
+                .arg(io * 100, 0, 'f', 0);
+            return false;
+        }
+
+        if (m_freeMemory >= 0 &&
+            m_freeMemory - m_memCommitted - cost.m_memory < kMemoryReserve)
+        {
+            reason = QString("only %1 MB of memory available")
+                .arg(m_freeMemory - m_memCommitted);
+            return false;
+        }
+    }
+
+    m_running++;
+    m_cpuCommitted += cost.m_cpu;
+    m_ioCommitted  += cost.m_io;
+    m_memCommitted += cost.m_memory;
+    m_typeRunning[jobType]++;
+    return true;
+}
+
+QString JobScheduler::GetStatus(void) const
+{
+    return QString("%1 job(s) running, load %2 of %3, CPU committed %4, "
+                   "IO committed %5%, %6 MB available")
+        .arg(m_running).arg(m_load, 0, 'f', 2).arg(m_cpuBudget, 0, 'f', 1)
+        .arg(m_cpuCommitted, 0, 'f', 1).arg(m_ioCommitted * 100, 0, 'f', 0)
+        .arg(m_freeMemory);
+}
@@ -0,0 +1,71 @@
+// -*- Mode: c++ -*-
+#ifndef _JOB_SCHEDULER_H_
+#define _JOB_SCHEDULER_H_
+
+#include <QDateTime>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+/// Resources a job of one type is expected to use while it runs
+class JobCost
+{
+  public:
+    JobCost(double cpu = 1.0, double io = 0.25, int memory = 200) :
+        m_cpu(cpu), m_io(io), m_memory(memory) { }
+
+    double m_cpu;    ///< CPU cores
+    double m_io;     ///< share of the disk bandwidth, 1.0 being all of it
+    int    m_memory; ///< megabytes
+};
+
+/** \class JobScheduler
+ *  \brief Decides which queued jobs the JobQueue may start on this host.
+ *
+ *  Every job type declares what it costs in CPU, disk IO and memory. A job
+ *  is only started when its cost fits next to the jobs already running,
+ *  judged against the live load average and available memory of the
+ *  host, and when its type is below its own concurrency limit. One job is
+ *  always allowed to run so that the queue keeps moving on a busy host.
+ *
+ *  Queued jobs are ordered by a per-type priority that grows the longer
+ *  a job has been waiting, so cheap jobs can't starve expensive ones.
+ *
+ *  Costs, limits and priorities come from host settings named after the
+ *  job type, e.g. "JobQueueCostTranscode" ("cpu,io,memory"),
+ *  "JobQueueMaxTranscode" and "JobQueuePriorityTranscode".
+ */
+class JobScheduler
+{
+  public:
+    JobScheduler();
+
+    void BeginPass(const QList<int> &runningTypes);
+    double Priority(int jobType, const QDateTime &queued,
+                    const QDateTime &now) const;
+    bool Admit(int jobType, QString &reason);
+    bool IsStarving(const QDateTime &queued, const QDateTime &now) const;
+    QString GetStatus(void) const;
+
+    static QString TypeSettingName(int jobType);
+    static JobCost GetCost(int jobType);
+
+  private:
+    static JobCost DefaultCost(int jobType);
+    static int DefaultPriority(int jobType);
+    static int AvailableMemory(void);
+
+    int       m_cores;
+    double    m_cpuBudget;   ///< cores jobs may use
+    double    m_load;        ///< one minute load average
+    int       m_freeMemory;  ///< MB, -1 if unknown
+    int       m_agingSecs;   ///< wait that raises a job's priority by one
+
+    int       m_running;
+    double    m_cpuCommitted;
+    double    m_ioCommitted;
+    int       m_memCommitted; ///< by jobs started during this pass
+    QMap<int, int> m_typeRunning;
+};
+
+#endif // _JOB_SCHEDULER_H_
@@ -116,7 +116,7 @@ HEADERS += recordinginfo.h
 HEADERS += dbcheck.h
 HEADERS += videodbcheck.h
 HEADERS += tvremoteutil.h           tv.h
-HEADERS += jobqueue.h
+HEADERS += jobqueue.h jobscheduler.h
 HEADERS += filtermanager.h          recordingprofile.h
 HEADERS += remoteencoder.h          videosource.h
 HEADERS += cardutil.h               sourceutil.h
@@ -130,6 +130,7 @@ HEADERS += signalmonitorvalue.h     signalmonitorlistener.h
 HEADERS += livetvchain.h            playgroup.h
 HEADERS += channelsettings.h
 HEADERS += previewgenerator.h       previewgeneratorqueue.h
+HEADERS += previewdecoder.h         previewstrip.h
 HEADERS += transporteditor.h        listingsources.h
 HEADERS += channelgroup.h
 HEADERS += recordingrule.h
@@ -146,7 +147,7 @@ SOURCES += recordinginfo.cpp
 SOURCES += dbcheck.cpp
 SOURCES += videodbcheck.cpp
 SOURCES += tvremoteutil.cpp         tv.cpp
-SOURCES += jobqueue.cpp
+SOURCES += jobqueue.cpp jobscheduler.cpp
 SOURCES += filtermanager.cpp        recordingprofile.cpp
 SOURCES += remoteencoder.cpp        videosource.cpp
 SOURCES += cardutil.cpp             sourceutil.cpp
@@ -160,6 +161,7 @@ SOURCES += signalmonitorvalue.cpp
 SOURCES += livetvchain.cpp          playgroup.cpp
 SOURCES += channelsettings.cpp
 SOURCES += previewgenerator.cpp     previewgeneratorqueue.cpp
+SOURCES += previewdecoder.cpp       previewstrip.cpp
 SOURCES += transporteditor.cpp
 SOURCES += channelgroup.cpp
 SOURCES += recordingrule.cpp
@@ -326,7 +328,7 @@ LIBS += -lmythudfread-$$LIBVERSION
 #HLS stuff
 HEADERS += HLS/httplivestream.h
 SOURCES += HLS/httplivestream.cpp
-HEADERS += HLS/httplivestreambuffer.h
+HEADERS += HLS/httplivestreambuffer.h HLS/hlsadaptation.h
 SOURCES += HLS/httplivestreambuffer.cpp
 HEADERS += HLS/m3u.h
 SOURCES += HLS/m3u.cpp
@@ -366,11 +368,11 @@ using_frontend {
     HEADERS += decoderbase.h
     HEADERS += nuppeldecoder.h          avformatdecoder.h
     HEADERS += privatedecoder.h
-    HEADERS += mythcodeccontext.h
+    HEADERS += mythcodeccontext.h       decodeloadmonitor.h
     SOURCES += decoderbase.cpp
     SOURCES += nuppeldecoder.cpp        avformatdecoder.cpp
     SOURCES += privatedecoder.cpp
-    SOURCES += mythcodeccontext.cpp
+    SOURCES += mythcodeccontext.cpp     decodeloadmonitor.cpp
 
     using_crystalhd {
         DEFINES += USING_CRYSTALHD
@@ -412,8 +414,10 @@ using_frontend {
     # On screen display (video output overlay)
     HEADERS += osd.h                    teletextscreen.h
     HEADERS += subtitlescreen.h         interactivescreen.h
+    HEADERS += subtitlerendercache.h
     SOURCES += osd.cpp                  teletextscreen.cpp
     SOURCES += subtitlescreen.cpp       interactivescreen.cpp
+    SOURCES += subtitlerendercache.cpp
 
     # Video output
     HEADERS += videooutbase.h           videoout_null.h
@@ -18,6 +18,7 @@ extern "C" {
 #include "libavfilter/buffersrc.h"
 #include "libavfilter/buffersink.h"
 #include "libavutil/imgutils.h"
+#include "libavutil/buffer.h"
 #include "libavformat/avformat.h"
 }
 #include <QMutexLocker>
@@ -79,6 +80,75 @@ int AVPictureFill(AVFrame *pic, const VideoFrame *frame, AVPixelFormat fmt)
     return (int)buffersize(frame->codec, frame->width, frame->height);
 }
 
+MythAVFramePool::~MythAVFramePool()
+{
+    Reset();
+}
+
+AVBufferRef *MythAVFramePool::AllocBuffer(void *opaque, int size)
+{
+    // Only called when the pool has no free buffer to recycle
+    MythAVFramePool *pool = static_cast<MythAVFramePool*>(opaque);
+    pool->m_misses.ref();
+    return av_buffer_alloc(size);
+}
+
+AVFrame *MythAVFramePool::GetFrame(AVPixelFormat fmt, int width, int height)
+{
+    if (!m_pool || fmt != m_format || width != m_width || height != m_height)
+    {
+        Reset();
+        int size = av_image_get_buffer_size(fmt, width, height, IMAGE_ALIGN);
+        if (size <= 0)
+            return nullptr;
+        m_pool = av_buffer_pool_init2(size, this, AllocBuffer, nullptr);
+        if (!m_pool)
+            return nullptr;
+        m_format = fmt;
+        m_width  = width;
+        m_height = height;
+    }
+
+    AVBufferRef *buffer = av_buffer_pool_get(m_pool);
+    if (!buffer)
+        return nullptr;
+    m_requests.ref();
+
+    AVFrame *frame = av_frame_alloc();
+    if (!frame)
+    {
+        av_buffer_unref(&buffer);
+        return nullptr;
+    }
+
+    av_image_fill_arrays(frame->data, frame->linesize, buffer->data,
+                         fmt, width, height, IMAGE_ALIGN);
+    frame->buf[0] = buffer;
+    frame->format = fmt;
+    frame->width  = width;
+    frame->height = height;
+    return frame;
+}
+
+void MythAVFramePool::Reset(void)
+{
+    // Buffers still referenced by frames are freed when they are released
+    av_buffer_pool_uninit(&m_pool);
+    m_format = AV_PIX_FMT_NONE;
+    m_width  = 0;
+    m_height = 0;
+}
+
+QString MythAVFramePool::GetStats(void) const
+{
+    int hits   = GetHits();
+    int misses = GetMisses();
+    int total  = hits + misses;
+    return QString("%1 hits, %2 misses (%3%)")
+        .arg(hits).arg(misses)
+        .arg(total ? (hits * 100) / total : 0);
+}
+
 class MythAVCopyPrivate
 {
 public:
@@ -234,7 +304,7 @@ int MythAVCopy::Copy(AVFrame *pic, const VideoFrame *frame,
 
 int MythAVCopy::Copy(VideoFrame *frame, const AVFrame *pic, AVPixelFormat fmt)
 {
-    if (fmt == AV_PIX_FMT_NV12 || AV_PIX_FMT_YUV420P)
+    if (fmt == AV_PIX_FMT_NV12 || fmt == AV_PIX_FMT_YUV420P)
     {
         VideoFrame framein;
         FillFrame(&framein, pic, frame->width, frame->width, frame->height, fmt);
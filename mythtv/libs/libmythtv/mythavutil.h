@@ -14,9 +14,11 @@ extern "C" {
 #include "libavcodec/avcodec.h"
 }
 
+#include <QAtomicInt>
 #include <QMap>
 #include <QMutex>
 
+struct AVBufferPool;
 struct AVFilterGraph;
 struct AVFilterContext;
 struct AVStream;
@@ -75,6 +77,41 @@ private:
     AVFrame *m_frame;
 };
 
+/**
+ * MythAVFramePool
+ * Hands out ref-counted AVFrames whose picture buffers are recycled
+ * through an AVBufferPool. AvFormatDecoder uses it for the pictures that
+ * VAAPI2 and NVDEC hardware frames are transferred into, so those don't
+ * go back to the allocator every frame. A buffer returns to the pool once the last
+ * reference to the frame is released with av_frame_free().
+ * Changing the format or dimensions flushes the pool.
+ */
+class MTV_PUBLIC MythAVFramePool
+{
+  public:
+    MythAVFramePool() = default;
+    ~MythAVFramePool();
+
+    /// Returns a new frame backed by pooled buffers, or nullptr on failure
+    AVFrame *GetFrame(AVPixelFormat fmt, int width, int height);
+    void     Reset(void);
+
+    int      GetHits(void) const
+        { return m_requests.loadAcquire() - m_misses.loadAcquire(); }
+    int      GetMisses(void) const { return m_misses.loadAcquire(); }
+    QString  GetStats(void) const;
+
+  private:
+    static AVBufferRef *AllocBuffer(void *opaque, int size);
+
+    AVBufferPool  *m_pool   {nullptr};
+    AVPixelFormat  m_format {AV_PIX_FMT_NONE};
+    int            m_width  {0};
+    int            m_height {0};
+    QAtomicInt     m_requests;
+    QAtomicInt     m_misses;
+};
+
 /**
  * MythCodecMap
  * Utility class that keeps pointers to
@@ -1970,6 +1970,8 @@ void MythPlayer::AVSync(VideoFrame *buffer, bool limit_delay)
         lastsync = true;
         //currentaudiotime = AVSyncGetAudiotime();
         LOG(VB_PLAYBACK, LOG_INFO, LOC + dbg + "dropping frame to catch up.");
+        if (decoder)
+            decoder->FrameDropped();
         if (max_video_behind)
         {
             audio.Pause(true);
@@ -2320,7 +2322,11 @@ void MythPlayer::AVSync2(VideoFrame *buffer)
                 );
 
     if (dropframe)
+    {
         numdroppedframes++;
+        if (decoder)
+            decoder->FrameDropped();
+    }
     else
         numdroppedframes = 0;
 
@@ -5296,7 +5302,10 @@ void MythPlayer::GetPlaybackData(InfoMap &infoMap)
         infoMap.insert("videoframes", frames);
     }
     if (decoder)
+    {
         infoMap["videodecoder"] = decoder->GetCodecDecoderName();
+        decoder->GetDecoderStats(infoMap);
+    }
     if (output_jmeter)
     {
         infoMap["framerate"] = QString("%1%2%3")
@@ -0,0 +1,351 @@
+// C++ headers
+#include <cstring>
+
+// MythTV headers
+#include "mythcorecontext.h"
+#include "mythlogging.h"
+#include "previewdecoder.h"
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+#include "libswscale/swscale.h"
+}
+
+#define LOC QString("PreviewDecoder: ")
+
+/// How much of a recording libavformat may read to find its streams
+static const int64_t kAnalyzeDuration = 2 * AV_TIME_BASE;
+/// Video packets to read after a seek before giving up on finding a keyframe
+static const int kMaxVideoPackets = 600;
+
+PreviewDecoder::PreviewDecoder() :
+    m_frame(av_frame_alloc())
+{
+}
+
+PreviewDecoder::~PreviewDecoder()
+{
+    Close();
+    FreeCodec();
+    av_frame_free(&m_frame);
+    sws_freeContext(m_scaler);
+}
+
+/** \fn PreviewDecoder::Open(const QString&)
+ *  \brief Opens a recording and its video decoder, reusing the decoder of
+ *         the previous recording when the video format is unchanged.
+ */
+bool PreviewDecoder::Open(const QString &filename)
+{
+    Close();
+
+    if (!m_frame)
+        return false;
+
+    QByteArray fname = filename.toLocal8Bit();
+    if (avformat_open_input(&m_format, fname.constData(), nullptr, nullptr) < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Could not open '%1'").arg(filename));
+        m_format = nullptr;
+        return false;
+    }
+
+    m_format->max_analyze_duration = kAnalyzeDuration;
+    if (avformat_find_stream_info(m_format, nullptr) < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Could not find the streams of '%1'").arg(filename));
+        Close();
+        return false;
+    }
+
+    m_stream = av_find_best_stream(m_format, AVMEDIA_TYPE_VIDEO,
+                                   -1, -1, nullptr, 0);
+    if (m_stream < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("No video stream in '%1'").arg(filename));
+        Close();
+        return false;
+    }
+
+    // Let the demuxer skip audio, captions and data outright
+    for (uint i = 0; i < m_format->nb_streams; ++i)
+    {
+        if ((int)i != m_stream)
+            m_format->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    if (!OpenCodec(m_format->streams[m_stream]->codecpar))
+    {
+        Close();
+        return false;
+    }
+
+    m_filename = filename;
+    return true;
+}
+
+/// Closes the recording, keeping the decoder and scaler for the next one.
+void PreviewDecoder::Close(void)
+{
+    if (m_format)
+        avformat_close_input(&m_format);
+    m_format = nullptr;
+    m_stream = -1;
+    m_filename.clear();
+    if (m_frame)
+        av_frame_unref(m_frame);
+}
+
+bool PreviewDecoder::OpenCodec(const AVCodecParameters *par)
+{
+    if (m_codec && m_codecPar &&
+        m_codecPar->codec_id == par->codec_id &&
+        m_codecPar->width == par->width &&
+        m_codecPar->height == par->height &&
+        m_codecPar->format == par->format &&
+        m_codecPar->extradata_size == par->extradata_size &&
+        (!par->extradata_size ||
+         !memcmp(m_codecPar->extradata, par->extradata, par->extradata_size)))
+    {
+        avcodec_flush_buffers(m_codec);
+        return true;
+    }
+
+    FreeCodec();
+
+    AVCodec *codec = avcodec_find_decoder(par->codec_id);
+    if (!codec)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + QString("No decoder for %1")
+            .arg(avcodec_get_name(par->codec_id)));
+        return false;
+    }
+
+    m_codec    = avcodec_alloc_context3(codec);
+    m_codecPar = avcodec_parameters_alloc();
+    if (!m_codec || !m_codecPar ||
+        avcodec_parameters_to_context(m_codec, par) < 0 ||
+        avcodec_parameters_copy(m_codecPar, par) < 0)
+    {
+        FreeCodec();
+        return false;
+    }
+
+    // Previews are generated one per core, so each decode is single threaded
+    m_codec->thread_count = 1;
+    m_codec->skip_frame   = AVDISCARD_NONKEY;
+
+    int ret;
+    {
+        QMutexLocker locker(avcodeclock);
+        ret = avcodec_open2(m_codec, codec, nullptr);
+    }
+    if (ret < 0)
+    {
+        char error[AV_ERROR_MAX_STRING_SIZE];
+        av_make_error_string(error, sizeof(error), ret);
+        LOG(VB_GENERAL, LOG_ERR, LOC + QString("Could not open %1 decoder: %2")
+            .arg(avcodec_get_name(par->codec_id)).arg(error));
+        FreeCodec();
+        return false;
+    }
+
+    LOG(VB_PLAYBACK, LOG_INFO, LOC + QString("Opened %1 decoder for %2x%3")
+        .arg(avcodec_get_name(par->codec_id))
+        .arg(par->width).arg(par->height));
+    return true;
+}
+
+void PreviewDecoder::FreeCodec(void)
+{
+    if (m_codec)
+    {
+        QMutexLocker locker(avcodeclock);
+        avcodec_free_context(&m_codec);
+    }
+    m_codec = nullptr;
+    avcodec_parameters_free(&m_codecPar);
+}
+
+/** \fn PreviewDecoder::Grab(long long, bool)
+ *  \brief Decodes the keyframe at or before a position in the recording.
+ *
+ *  \param seektime     Seconds or frames into the video.
+ *  \param time_in_secs If true seektime is in seconds, otherwise in frames.
+ */
+bool PreviewDecoder::Grab(long long seektime, bool time_in_secs)
+{
+    if (!m_format || !m_codec)
+        return false;
+
+    if (!Seek(seektime, time_in_secs) || !DecodeKeyframe())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Failed to grab a keyframe at %1%2 from '%3'")
+                .arg(seektime).arg(time_in_secs ? "s" : "f").arg(m_filename));
+        return false;
+    }
+
+    SetVideoInfo();
+    LOG(VB_PLAYBACK, LOG_INFO, LOC +
+        QString("Grabbed '%1' %2x%3@%4%5")
+            .arg(m_filename).arg(m_frame->width).arg(m_frame->height)
+            .arg(seektime).arg(time_in_secs ? "s" : "f"));
+    return true;
+}
+
+/** \fn PreviewDecoder::GrabAtPosition(int64_t)
+ *  \brief Decodes the keyframe starting at a byte offset, as found in the
+ *         recording's seek table.
+ *
+ *   Grabbing a series of positions in increasing order reads the file in
+ *   a single forward pass.
+ */
+bool PreviewDecoder::GrabAtPosition(int64_t position)
+{
+    if (!m_format || !m_codec)
+        return false;
+
+    avcodec_flush_buffers(m_codec);
+    if (av_seek_frame(m_format, m_stream, position, AVSEEK_FLAG_BYTE) < 0 ||
+        !DecodeKeyframe())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Failed to grab a keyframe at byte %1 from '%2'")
+                .arg(position).arg(m_filename));
+        return false;
+    }
+
+    SetVideoInfo();
+    return true;
+}
+
+void PreviewDecoder::SetVideoInfo(void)
+{
+    m_videoSize = QSize(m_frame->width, m_frame->height);
+    AVRational sar = m_frame->sample_aspect_ratio;
+    if (sar.num <= 0 || sar.den <= 0)
+        sar = m_format->streams[m_stream]->sample_aspect_ratio;
+    if (sar.num <= 0 || sar.den <= 0)
+        sar = av_make_q(1, 1);
+    m_aspect = m_frame->width * av_q2d(sar) / m_frame->height;
+}
+
+/// Frames per second of the open recording, 0 if unknown
+double PreviewDecoder::GetFrameRate(void) const
+{
+    if (!m_format)
+        return 0.0;
+    AVRational rate = av_guess_frame_rate(
+        m_format, m_format->streams[m_stream], nullptr);
+    return (rate.num > 0 && rate.den > 0) ? av_q2d(rate) : 0.0;
+}
+
+/// Length in seconds of the open recording, 0 if unknown
+double PreviewDecoder::GetDuration(void) const
+{
+    if (!m_format || m_format->duration <= 0)
+        return 0.0;
+    return (double)m_format->duration / AV_TIME_BASE;
+}
+
+bool PreviewDecoder::Seek(long long seektime, bool time_in_secs)
+{
+    double seconds = seektime;
+    if (!time_in_secs)
+    {
+        double rate = GetFrameRate();
+        if (rate <= 0.0)
+            return false;
+        seconds = seektime / rate;
+    }
+
+    // Like MythPlayer, use the middle of a recording that is too short
+    if (m_format->duration > 0)
+    {
+        double length = (double)m_format->duration / AV_TIME_BASE;
+        if (seconds >= length)
+            seconds = length / 2;
+    }
+    avcodec_flush_buffers(m_codec);
+    if (seconds <= 0)
+        return true;
+
+    int64_t ts = (int64_t)(seconds * AV_TIME_BASE);
+    if (m_format->start_time != AV_NOPTS_VALUE)
+        ts += m_format->start_time;
+
+    return av_seek_frame(m_format, -1, ts, AVSEEK_FLAG_BACKWARD) >= 0;
+}
+
+// The decoder drops everything but keyframes, so the first picture
+// it returns is the one we want
+bool PreviewDecoder::DecodeKeyframe(void)
+{
+    AVPacket pkt;
+    av_init_packet(&pkt);
+    pkt.data = nullptr;
+    pkt.size = 0;
+
+    int videoPackets = 0;
+    while (videoPackets < kMaxVideoPackets &&
+           av_read_frame(m_format, &pkt) >= 0)
+    {
+        if (pkt.stream_index != m_stream)
+        {
+            av_packet_unref(&pkt);
+            continue;
+        }
+        videoPackets++;
+
+        int ret = avcodec_send_packet(m_codec, &pkt);
+        av_packet_unref(&pkt);
+        // Damaged data just after the seek point is expected
+        if (ret < 0 && ret != AVERROR(EAGAIN))
+            continue;
+
+        if (avcodec_receive_frame(m_codec, m_frame) == 0)
+            return true;
+    }
+
+    // Very short recordings may have their only keyframe held back
+    if (avcodec_send_packet(m_codec, nullptr) >= 0 &&
+        avcodec_receive_frame(m_codec, m_frame) == 0)
+    {
+        return true;
+    }
+    return false;
+}
+
+/** \fn PreviewDecoder::Scale(const QSize&, QImage&)
+ *  \brief Converts the last grabbed frame to an RGB image of \p size.
+ */
+bool PreviewDecoder::Scale(const QSize &size, QImage &image)
+{
+    if (size.isEmpty() || !m_frame->data[0])
+        return false;
+
+    m_scaler = sws_getCachedContext(
+        m_scaler, m_frame->width, m_frame->height,
+        (AVPixelFormat)m_frame->format, size.width(), size.height(),
+        AV_PIX_FMT_RGB32, SWS_BICUBIC, nullptr, nullptr, nullptr);
+    if (!m_scaler)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Failed to allocate sws context");
+        return false;
+    }
+
+    image = QImage(size, QImage::Format_RGB32);
+    if (image.isNull())
+        return false;
+
+    uint8_t *dst[4]       = { image.bits(), nullptr, nullptr, nullptr };
+    int      dstStride[4] = { image.bytesPerLine(), 0, 0, 0 };
+    sws_scale(m_scaler, m_frame->data, m_frame->linesize, 0, m_frame->height,
+              dst, dstStride);
+    return true;
+}
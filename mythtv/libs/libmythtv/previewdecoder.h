@@ -0,0 +1,69 @@
+// -*- Mode: c++ -*-
+#ifndef PREVIEW_DECODER_H_
+#define PREVIEW_DECODER_H_
+
+#include <cstdint>
+
+#include <QImage>
+#include <QString>
+#include <QSize>
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVCodecParameters;
+struct AVFrame;
+struct SwsContext;
+
+/** \class PreviewDecoder
+ *  \brief Grabs a single keyframe from a local recording for a preview.
+ *
+ *   Unlike MythPlayer this only demuxes the video stream, tells the
+ *   decoder to drop everything but keyframes, and has swscale convert the
+ *   picture straight to the size of the preview image.
+ *
+ *   A PreviewDecoder belongs to one thread at a time. The codec context is
+ *   kept when the recording is closed, and reused for the next recording
+ *   if its video has the same format, which for the recordings of one
+ *   backend is the usual case. The scaler context is cached in the same way.
+ */
+class PreviewDecoder
+{
+  public:
+    PreviewDecoder();
+   ~PreviewDecoder();
+
+    bool Open(const QString &filename);
+    void Close(void);
+
+    bool Grab(long long seektime, bool time_in_secs);
+    bool GrabAtPosition(int64_t position);
+    bool Scale(const QSize &size, QImage &image);
+
+    double GetFrameRate(void) const;
+    double GetDuration(void) const;
+
+    /// Size of the last grabbed frame
+    QSize GetVideoSize(void) const { return m_videoSize; }
+    /// Display aspect ratio of the last grabbed frame
+    float GetAspect(void) const { return m_aspect; }
+
+  private:
+    bool OpenCodec(const AVCodecParameters *par);
+    void FreeCodec(void);
+    bool Seek(long long seektime, bool time_in_secs);
+    bool DecodeKeyframe(void);
+    void SetVideoInfo(void);
+
+    AVFormatContext   *m_format   {nullptr};
+    int                m_stream   {-1};
+    AVCodecContext    *m_codec    {nullptr};
+    /// The stream parameters m_codec was opened with
+    AVCodecParameters *m_codecPar {nullptr};
+    AVFrame           *m_frame    {nullptr};
+    SwsContext        *m_scaler   {nullptr};
+    QString            m_filename;
+    QSize              m_videoSize;
+    float              m_aspect   {0.0f};
+};
+
+#endif // PREVIEW_DECODER_H_
@@ -23,6 +23,7 @@
 #include "ringbuffer.h"
 #include "mythplayer.h"
 #include "previewgenerator.h"
+#include "previewdecoder.h"
 #include "tv_rec.h"
 #include "mythsocket.h"
 #include "remotefile.h"
@@ -77,7 +78,8 @@ PreviewGenerator::PreviewGenerator(const ProgramInfo *pginfo,
       m_pathname(pginfo->GetPathname()),
       m_timeInSeconds(true),  m_captureTime(-1),
       m_outSize(0,0),  m_outFormat("PNG"),
-      m_token(token), m_gotReply(false), m_pixmapOk(false)
+      m_token(token), m_gotReply(false), m_pixmapOk(false),
+      m_makeStrip(false), m_stripWanted(false)
 {
     // Qt requires that a receiver have the same thread affinity as the QThread
     // sending the event, which is used to dispatch MythEvents sent by
@@ -205,17 +207,42 @@ bool PreviewGenerator::RunReal(void)
     return ok;
 }
 
-bool PreviewGenerator::Run(void)
+/** \fn PreviewGenerator::Run(PreviewDecoder*)
+ *  \brief Creates the preview, blocking until it is done.
+ *
+ *   Local recordings are first grabbed in process by a PreviewDecoder.
+ *   Only if that fails is mythpreviewgen run to grab the frame with a full
+ *   player, or the preview requested from the backend.
+ *
+ *  \param decoder Decoder to grab local recordings with. Passing the same
+ *                 decoder for every preview made on a thread lets it reuse
+ *                 its codec context. If null a temporary one is used.
+ *
+ *  \sa SetMakeStrip()
+ */
+bool PreviewGenerator::Run(PreviewDecoder *decoder)
 {
     QString msg;
     QDateTime dtm = MythDate::current();
     QTime tm = QTime::currentTime();
     bool ok = false;
     QString command = GetAppBinDir() + "mythpreviewgen";
-    bool local_ok = ((IsLocal() || !!(m_mode & kForceLocal)) &&
+    bool is_local = IsLocal();
+    bool local_ok = ((is_local || !!(m_mode & kForceLocal)) &&
                      (!!(m_mode & kLocal)) &&
                      QFileInfo(command).isExecutable());
-    if (!local_ok)
+
+    PreviewDecoder tmp_decoder;
+    if (is_local && !!(m_mode & kLocal) &&
+        DecoderPreviewRun(decoder ? *decoder : tmp_decoder))
+    {
+        ok = true;
+        msg = QString("Generated on %1 in %2 seconds, starting at %3")
+            .arg(gCoreContext->GetHostName())
+            .arg(tm.elapsed()*0.001)
+            .arg(tm.toString(Qt::ISODate));
+    }
+    else if (!local_ok)
     {
         if (!!(m_mode & kRemote))
         {
@@ -346,6 +373,8 @@ bool PreviewGenerator::Run(void)
         QCoreApplication::postEvent(m_listener, new MythEvent(message, list));
     }
 
+    m_stripWanted = ok && m_makeStrip && is_local && !!(m_mode & kLocal);
+
     return ok;
 }
 
@@ -569,13 +598,31 @@ bool PreviewGenerator::SavePreview(const QString &filename,
     const QImage img((unsigned char*) data,
                      width, height, QImage::Format_RGB32);
 
+    QSize size = GetPreviewSize(width, height, aspect,
+                                desired_width, desired_height);
+
+    QImage small_img = img.scaled(size.width(), size.height(),
+        Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    return SaveImage(filename, small_img, format);
+}
+
+/** \fn PreviewGenerator::GetPreviewSize(uint,uint,float,int,int)
+ *  \brief Returns the size of the preview of a video frame.
+ *
+ *   If neither desired dimension is given the frame size is used, if one
+ *   is given the other follows from the aspect ratio of the video.
+ */
+QSize PreviewGenerator::GetPreviewSize(uint width, uint height, float aspect,
+                                       int desired_width, int desired_height)
+{
     float ppw = max(desired_width, 0);
     float pph = max(desired_height, 0);
     bool desired_size_exactly_specified = true;
     if ((ppw < 1.0f) && (pph < 1.0f))
     {
-        ppw = img.width();
-        pph = img.height();
+        ppw = width;
+        pph = height;
         desired_size_exactly_specified = false;
     }
 
@@ -592,14 +639,17 @@ bool PreviewGenerator::SavePreview(const QString &filename,
     }
 
     ppw = max(1.0f, ppw);
-    pph = max(1.0f, pph);;
+    pph = max(1.0f, pph);
 
-    QImage small_img = img.scaled((int) ppw, (int) pph,
-        Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    return QSize((int) ppw, (int) pph);
+}
 
+bool PreviewGenerator::SaveImage(const QString &filename, const QImage &image,
+                                 const QString &format)
+{
     QTemporaryFile f(QFileInfo(filename).absoluteFilePath()+".XXXXXX");
     f.setAutoRemove(false);
-    if (f.open() && small_img.save(&f, format.toLocal8Bit().constData()))
+    if (f.open() && image.save(&f, format.toLocal8Bit().constData()))
     {
         // Let anybody update it
         bool ret = makeFileAccessible(f.fileName().toLocal8Bit().constData());
@@ -615,7 +665,7 @@ bool PreviewGenerator::SavePreview(const QString &filename,
         if (f.rename(filename))
         {
             LOG(VB_PLAYBACK, LOG_INFO, LOC + QString("Saved preview '%0' %1x%2")
-                    .arg(filename).arg((int) ppw).arg((int) pph));
+                    .arg(filename).arg(image.width()).arg(image.height()));
             return true;
         }
         f.remove();
@@ -624,18 +674,28 @@ bool PreviewGenerator::SavePreview(const QString &filename,
     return false;
 }
 
-bool PreviewGenerator::LocalPreviewRun(void)
+// Backdate the file to the start of preview generation in case a
+// bookmark was made while we were generating the preview.
+static void backdate_preview(const QString &filename, const QDateTime &dt)
 {
-    m_programInfo.MarkAsInUse(true, kPreviewGeneratorInUseID);
-    m_programInfo.SetIgnoreProgStart(true);
-    m_programInfo.SetAllowLastPlayPos(false);
+    struct utimbuf times;
+#if QT_VERSION < QT_VERSION_CHECK(5,8,0)
+    times.actime = times.modtime = dt.toTime_t();
+#else
+    times.actime = times.modtime = dt.toSecsSinceEpoch();
+#endif
+    utime(filename.toLocal8Bit().constData(), &times);
+}
 
-    float aspect = 0;
-    int   width, height, sz;
+/** \fn PreviewGenerator::GetCaptureTime(void)
+ *  \brief Returns where in the recording to grab the preview: the
+ *         requested time, else the bookmark, else a third of the way into
+ *         the program. m_timeInSeconds is updated to match.
+ */
+long long PreviewGenerator::GetCaptureTime(void)
+{
     long long captime = m_captureTime;
 
-    QDateTime dt = MythDate::current();
-
     if (captime > 0)
         LOG(VB_GENERAL, LOG_INFO, "Preview from time spec");
 
@@ -685,6 +745,22 @@ bool PreviewGenerator::LocalPreviewRun(void)
             QString("Preview at calculated offset (%1 seconds)").arg(captime));
     }
 
+    return captime;
+}
+
+bool PreviewGenerator::LocalPreviewRun(void)
+{
+    m_programInfo.MarkAsInUse(true, kPreviewGeneratorInUseID);
+    m_programInfo.SetIgnoreProgStart(true);
+    m_programInfo.SetAllowLastPlayPos(false);
+
+    float aspect = 0;
+    int   width, height, sz;
+
+    QDateTime dt = MythDate::current();
+
+    long long captime = GetCaptureTime();
+
     width = height = sz = 0;
     unsigned char *data = (unsigned char*)
         GetScreenGrab(m_programInfo, m_pathname,
@@ -701,20 +777,55 @@ bool PreviewGenerator::LocalPreviewRun(void)
     bool ok = SavePreview(outname, data, width, height, aspect, dw, dh,
                           format);
 
+    if (ok)
+        backdate_preview(outname, dt);
+
+    delete[] data;
+
+    m_programInfo.MarkAsInUse(false, kPreviewGeneratorInUseID);
+
+    return ok;
+}
+
+/** \fn PreviewGenerator::DecoderPreviewRun(PreviewDecoder&)
+ *  \brief Creates the preview from the nearest keyframe, decoding and
+ *         scaling it in this process.
+ *
+ *   DVDs, Blu-rays and streamed files are left to LocalPreviewRun(),
+ *   as they need a full player.
+ */
+bool PreviewGenerator::DecoderPreviewRun(PreviewDecoder &decoder)
+{
+    if (!m_pathname.startsWith("/"))
+        return false;
+
+    m_programInfo.MarkAsInUse(true, kPreviewGeneratorInUseID);
+
+    QDateTime dt = MythDate::current();
+
+    long long captime = GetCaptureTime();
+
+    QString outname = CreateAccessibleFilename(m_pathname, m_outFileName);
+
+    QString format = (m_outFormat.isEmpty()) ? "PNG" : m_outFormat;
+
+    bool ok = decoder.Open(m_pathname) &&
+              decoder.Grab(captime, m_timeInSeconds);
     if (ok)
     {
-        // Backdate file to start of preview time in case a bookmark was made
-        // while we were generating the preview.
-        struct utimbuf times;
-#if QT_VERSION < QT_VERSION_CHECK(5,8,0)
-        times.actime = times.modtime = dt.toTime_t();
-#else
-        times.actime = times.modtime = dt.toSecsSinceEpoch();
-#endif
-        utime(outname.toLocal8Bit().constData(), &times);
+        QSize video = decoder.GetVideoSize();
+        int dw = (m_outSize.width()  < 0) ? video.width()  : m_outSize.width();
+        int dh = (m_outSize.height() < 0) ? video.height() : m_outSize.height();
+        QSize size = GetPreviewSize(video.width(), video.height(),
+                                    decoder.GetAspect(), dw, dh);
+
+        QImage image;
+        ok = decoder.Scale(size, image) && SaveImage(outname, image, format);
     }
+    decoder.Close();
 
-    delete[] data;
+    if (ok)
+        backdate_preview(outname, dt);
 
     m_programInfo.MarkAsInUse(false, kPreviewGeneratorInUseID);
 
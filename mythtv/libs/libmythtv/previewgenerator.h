@@ -16,10 +16,12 @@
 #include "mythdate.h"
 
 class PreviewGenerator;
+class PreviewDecoder;
 class QByteArray;
 class MythSocket;
 class QObject;
 class QEvent;
+class QImage;
 
 typedef QMap<QString,QDateTime> FileTimeStampMap;
 
@@ -59,11 +61,17 @@ class MTV_PUBLIC PreviewGenerator : public QObject, public MThread
         { SetPreviewTime(frame_number, false); }
     void SetOutputFilename(const QString&);
     void SetOutputSize(const QSize &size) { m_outSize = size; }
+    /// Have the recording's thumbnail strip made after the preview, if it
+    /// is out of date
+    void SetMakeStrip(bool make) { m_makeStrip = make; }
+    /// True once Run() has made a preview that wants a strip made after it
+    bool IsStripWanted(void) const { return m_stripWanted; }
 
     QString GetToken(void) const { return m_token; }
+    const ProgramInfo &GetProgramInfo(void) const { return m_programInfo; }
 
     void run(void) override; // MThread
-    bool Run(void);
+    bool Run(PreviewDecoder *decoder = nullptr);
 
     void AttachSignals(QObject*);
 
@@ -76,7 +84,9 @@ class MTV_PUBLIC PreviewGenerator : public QObject, public MThread
 
     bool RemotePreviewRun(void);
     bool LocalPreviewRun(void);
+    bool DecoderPreviewRun(PreviewDecoder &decoder);
     bool IsLocal(void) const;
+    long long GetCaptureTime(void);
 
     bool RunReal(void);
 
@@ -94,6 +104,10 @@ class MTV_PUBLIC PreviewGenerator : public QObject, public MThread
                             uint width, uint height, float aspect,
                             int desired_width, int desired_height,
                             const QString &format);
+    static QSize GetPreviewSize(uint width, uint height, float aspect,
+                                int desired_width, int desired_height);
+    static bool SaveImage(const QString &filename, const QImage &image,
+                          const QString &format);
 
 
     static QString CreateAccessibleFilename(
@@ -122,6 +136,8 @@ class MTV_PUBLIC PreviewGenerator : public QObject, public MThread
     QString            m_token;
     bool               m_gotReply;
     bool               m_pixmapOk;
+    bool               m_makeStrip;
+    bool               m_stripWanted;
 };
 
 #endif // PREVIEW_GENERATOR_H_
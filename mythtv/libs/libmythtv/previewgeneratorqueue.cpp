@@ -21,9 +21,52 @@ using std::max;
 
 // libmythtv
 #include "previewgenerator.h"
+#include "previewdecoder.h"
+#include "previewstrip.h"
 
 #define LOC QString("PreviewQueue: ")
 
+/**
+ * A thread that takes preview generators and thumbnail strips off the
+ * queue and makes them, one at a time, with a decoder it keeps for all
+ * of them.
+ */
+class PreviewWorker : public MThread
+{
+  public:
+    PreviewWorker(PreviewGeneratorQueue *queue, uint id) :
+        MThread(QString("PreviewWorker%1").arg(id)), m_queue(queue) {}
+    ~PreviewWorker() { wait(); }
+
+  protected:
+    void run(void) override // MThread
+    {
+        RunProlog();
+        PreviewDecoder decoder;
+        QString key;
+        PreviewGenerator *gen;
+        ProgramInfo pginfo;
+        while (m_queue->TakeWork(key, gen, pginfo))
+        {
+            if (gen)
+            {
+                gen->Run(&decoder);
+                m_queue->ReleasePreviewGenerator(key, gen);
+                continue;
+            }
+
+            PreviewStrip strip(pginfo);
+            if (strip.IsNeeded())
+                strip.Generate(decoder);
+            m_queue->ReleaseStrip();
+        }
+        RunEpilog();
+    }
+
+  private:
+    PreviewGeneratorQueue *m_queue;
+};
+
 PreviewGeneratorQueue *PreviewGeneratorQueue::s_pgq = nullptr;
 
 /**
@@ -85,29 +128,48 @@ PreviewGeneratorQueue::PreviewGeneratorQueue(
     uint maxAttempts, uint minBlockSeconds) :
     MThread("PreviewGeneratorQueue"),
     m_mode(mode),
-    m_running(0), m_maxThreads(2),
+    m_stopping(false), m_stripsRunning(0), m_maxThreads(2),
     m_maxAttempts(maxAttempts), m_minBlockSeconds(minBlockSeconds)
 {
+    // Local previews are decoded in process, so use one worker per core.
+    // Remote ones mostly wait for the backend.
     if (PreviewGenerator::kLocal & mode)
     {
         int idealThreads = QThread::idealThreadCount();
-        m_maxThreads = (idealThreads >= 1) ? idealThreads * 2 : 2;
+        m_maxThreads = (idealThreads >= 1) ? idealThreads : 2;
     }
 
     moveToThread(qthread());
     start();
+
+    for (uint i = 0; i < m_maxThreads; ++i)
+    {
+        PreviewWorker *worker = new PreviewWorker(this, i);
+        m_workers.push_back(worker);
+        worker->start();
+    }
 }
 
 /**
- * Destroy the preview generation queue.  This function doesn't
- * directly destroy the PreviewGenState objects, but marks them for
- * later destruction by the thread(s) that created them.
+ * Destroy the preview generation queue.  This function waits for the
+ * workers to finish the previews they are generating, and marks the
+ * generators of the queued previews for later destruction by the
+ * thread that created them.
  *
  * \note Never directly destroy this object. Call the
  * TeardownPreviewGeneratorQueue function instead.
  */
 PreviewGeneratorQueue::~PreviewGeneratorQueue()
 {
+    {
+        QMutexLocker locker(&m_lock);
+        m_stopping = true;
+        m_workAvailable.wakeAll();
+    }
+    foreach (PreviewWorker *worker, m_workers)
+        delete worker;
+    m_workers.clear();
+
     // disconnect preview generators
     QMutexLocker locker(&m_lock);
     PreviewMap::iterator it = m_previewMap.begin();
@@ -281,8 +343,7 @@ bool PreviewGeneratorQueue::event(QEvent *e)
                 return true;
             }
 
-            if ((*it).gen)
-                (*it).gen->deleteLater();
+            // The worker that ran the generator deletes it
             (*it).gen           = nullptr;
             (*it).genStarted    = false;
             if (me->Message() == "PREVIEW_SUCCESS")
@@ -323,8 +384,6 @@ bool PreviewGeneratorQueue::event(QEvent *e)
                 }
                 (*it).tokens.clear();
             }
-
-            m_running = (m_running > 0) ? m_running - 1 : 0;
         }
 
         UpdatePreviewGeneratorThreads();
@@ -537,13 +596,16 @@ QString PreviewGeneratorQueue::GeneratePreviewImage(
             LOG(VB_PLAYBACK, LOG_INFO, LOC +
                 QString("Requesting preview for '%1'") .arg(key));
             PreviewGenerator *pg = new PreviewGenerator(&pginfo, token, m_mode);
-            if (!outputfile.isEmpty() || time >= 0 ||
-                size.width() || size.height())
+            if (is_special)
             {
                 pg->SetPreviewTime(time, in_seconds);
                 pg->SetOutputFilename(outputfile);
                 pg->SetOutputSize(size);
             }
+            else
+            {
+                pg->SetMakeStrip(true);
+            }
 
             SetPreviewGenerator(key, pg);
 
@@ -636,25 +698,104 @@ void PreviewGeneratorQueue::IncPreviewGeneratorPriority(
 }
 
 /**
- * As long as there are items in the queue, make sure we're running
- * the maximum allowed number of preview generators.
+ * As long as there are items in the queue, make sure a worker is
+ * awake to process them.
  */
 void PreviewGeneratorQueue::UpdatePreviewGeneratorThreads(void)
 {
     QMutexLocker locker(&m_lock);
-    QStringList &q = m_queue;
-    if (!q.empty() && (m_running < m_maxThreads))
+    if (!m_queue.empty())
+        m_workAvailable.wakeOne();
+}
+
+/**
+ * Waits for the next piece of work for a worker: a queued preview, or
+ * when there is none a thumbnail strip. A strip takes much longer than a
+ * preview, so one worker is kept free of them for the previews requested
+ * meanwhile. A generator belongs to the worker until it is passed back to
+ * ReleasePreviewGenerator(), a strip is passed back to ReleaseStrip().
+ *
+ * \param[out] key The key of the preview to be generated.
+ * \param[out] gen The generator, or nullptr for a strip.
+ * \param[out] pginfo The recording to make a strip of, if gen is nullptr.
+ * \return false once the queue is being torn down.
+ */
+bool PreviewGeneratorQueue::TakeWork(
+    QString &key, PreviewGenerator *&gen, ProgramInfo &pginfo)
+{
+    QMutexLocker locker(&m_lock);
+    while (!m_stopping)
     {
-        QString fn = q.back();
-        q.pop_back();
-        PreviewMap::iterator it = m_previewMap.find(fn);
-        if (it != m_previewMap.end() && (*it).gen && !(*it).genStarted)
+        while (!m_queue.empty())
         {
-            m_running++;
-            (*it).gen->start();
-            (*it).genStarted = true;
+            key = m_queue.back();
+            m_queue.pop_back();
+            PreviewMap::iterator it = m_previewMap.find(key);
+            if (it != m_previewMap.end() && (*it).gen && !(*it).genStarted)
+            {
+                (*it).genStarted = true;
+                gen = (*it).gen;
+                return true;
+            }
+        }
+
+        uint maxStrips = max(m_maxThreads, 2U) - 1;
+        if (!m_stripQueue.empty() && m_stripsRunning < maxStrips)
+        {
+            pginfo = m_stripQueue.takeFirst();
+            gen = nullptr;
+            m_stripsRunning++;
+            return true;
+        }
+
+        m_workAvailable.wait(&m_lock);
+    }
+    return false;
+}
+
+/**
+ * Called by a worker when it has made a strip.
+ */
+void PreviewGeneratorQueue::ReleaseStrip(void)
+{
+    QMutexLocker locker(&m_lock);
+    m_stripsRunning--;
+    if (!m_stripQueue.empty())
+        m_workAvailable.wakeOne();
+}
+
+/**
+ * Called by a worker when a generator has run. The generator is
+ * detached from its preview, unless the PREVIEW_SUCCESS or
+ * PREVIEW_FAILED event it sent has already done so, and deleted.
+ */
+void PreviewGeneratorQueue::ReleasePreviewGenerator(
+    const QString &key, PreviewGenerator *g)
+{
+    {
+        QMutexLocker locker(&m_lock);
+        PreviewMap::iterator it = m_previewMap.find(key);
+        if (it != m_previewMap.end() && (*it).gen == g)
+        {
+            (*it).gen        = nullptr;
+            (*it).genStarted = false;
+        }
+
+        // The strip waits until no preview is left to make
+        if (g->IsStripWanted())
+        {
+            const ProgramInfo &pginfo = g->GetProgramInfo();
+            bool queued = false;
+            foreach (const ProgramInfo &strip, m_stripQueue)
+                queued |= strip.GetPathname() == pginfo.GetPathname();
+            if (!queued)
+            {
+                m_stripQueue.push_back(pginfo);
+                m_workAvailable.wakeOne();
+            }
         }
     }
+    g->deleteLater();
 }
 
 /** \brief Sets the PreviewGenerator for a specific file.
@@ -2,6 +2,7 @@
 #ifndef _PREVIEW_GENERATOR_QUEUE_H_
 #define _PREVIEW_GENERATOR_QUEUE_H_
 
+#include <QWaitCondition>
 #include <QStringList>
 #include <QDateTime>
 #include <QMutex>
@@ -13,6 +14,7 @@
 #include "mthread.h"
 
 class ProgramInfo;
+class PreviewWorker;
 class QSize;
 
 /**
@@ -60,6 +62,18 @@ typedef QMap<QString,PreviewGenState> PreviewMap;
  * that the queue will be created at application startup, and torn
  * down at application shutdown.
  *
+ * The previews are generated by a pool of worker threads, one per core
+ * when previews are made locally. Each worker keeps a PreviewDecoder, so
+ * consecutive previews reuse its codec context instead of starting a
+ * player for every recording.
+ *
+ * Requests for the same preview are merged, and the most recently
+ * requested preview is generated first. The thumbnail strips that go
+ * with default previews are made when no previews are waiting, and never
+ * on every worker at once. The frontends request previews
+ * of the items on screen as they come into view, so those overtake the
+ * backlog of items that have been scrolled past.
+ *
  * Preview requestors use tokens to refer to their request.  These
  * have no meaning to the preview generator code, and are mapped to
  * keys which are the used internally for indexing.  Multiple caller
@@ -70,6 +84,8 @@ class MTV_PUBLIC PreviewGeneratorQueue : public QObject, public MThread
 {
     Q_OBJECT
 
+    friend class PreviewWorker;
+
   public:
     static void CreatePreviewGeneratorQueue(
         PreviewGenerator::Mode mode,
@@ -112,6 +128,9 @@ class MTV_PUBLIC PreviewGeneratorQueue : public QObject, public MThread
     void SetPreviewGenerator(const QString &key, PreviewGenerator *g);
     void IncPreviewGeneratorPriority(const QString &key, QString token);
     void UpdatePreviewGeneratorThreads(void);
+    bool TakeWork(QString &key, PreviewGenerator *&gen, ProgramInfo &pginfo);
+    void ReleasePreviewGenerator(const QString &key, PreviewGenerator *g);
+    void ReleaseStrip(void);
     bool IsGeneratingPreview(const QString &key) const;
     uint IncPreviewGeneratorAttempts(const QString &key);
     void ClearPreviewGeneratorAttempts(const QString &key);
@@ -144,8 +163,17 @@ class MTV_PUBLIC PreviewGeneratorQueue : public QObject, public MThread
     /// The queue of previews to be generated. The next item to be
     /// processed is the one at the *back* of the queue.
     QStringList            m_queue;
-    /// The number of threads currently generating previews.
-    uint                   m_running;
+    /// Recordings whose thumbnail strip is to be made once no previews
+    /// are queued, oldest first.
+    QList<ProgramInfo>     m_stripQueue;
+    /// The threads that generate the previews.
+    QList<PreviewWorker*>  m_workers;
+    /// Signalled when a preview is queued or the workers should exit.
+    QWaitCondition         m_workAvailable;
+    /// Set when the queue is being torn down.
+    bool                   m_stopping;
+    /// The number of workers making strips.
+    uint                   m_stripsRunning;
     /// The maximum number of threads that may concurrently generate
     /// previews.
     uint                   m_maxThreads;
@@ -0,0 +1,348 @@
+// C++ headers
+#include <algorithm>
+#include <cstdlib>
+using namespace std;
+
+// Qt headers
+#include <QFileInfo>
+#include <QPainter>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QTime>
+#include <QVector>
+
+// MythTV headers
+#include "mythcorecontext.h"
+#include "mythlogging.h"
+#include "mythmiscutil.h"
+#include "mythdate.h"
+#include "previewdecoder.h"
+#include "previewstrip.h"
+
+#define LOC QString("PreviewStrip: ")
+
+/// Thumbnails per recording unless "PreviewStripThumbnails" says otherwise
+static const int kDefaultThumbnails = 40;
+/// Keyframes decoded per thumbnail, to choose the thumbnail from
+static const int kCandidatesPerThumb = 3;
+/// Width of a thumbnail in pixels
+static const int kThumbWidth = 160;
+/// Thumbnails per row of the sprite sheet
+static const int kMaxColumns = 10;
+/// Luma levels per histogram bucket
+static const int kHistogramShift = 4;
+/// Share of a frame in one histogram bucket that makes it too flat to use
+static const double kFlatShare = 0.85;
+
+QSet<QString> PreviewStrip::s_active;
+QMutex        PreviewStrip::s_activeLock;
+
+PreviewStrip::PreviewStrip(const ProgramInfo &pginfo) :
+    m_programInfo(pginfo), m_pathname(pginfo.GetPathname())
+{
+}
+
+/** \fn PreviewStrip::IsNeeded(void) const
+ *  \brief Returns true if strips are enabled and the recording has
+ *         finished, but has no strip or has changed since it was made.
+ */
+bool PreviewStrip::IsNeeded(void) const
+{
+    if (gCoreContext->GetNumSetting("PreviewStripThumbnails",
+                                    kDefaultThumbnails) <= 0)
+    {
+        return false;
+    }
+
+    if (!m_pathname.startsWith("/"))
+        return false;
+
+    // A recording in progress would need a new strip every time it grows
+    if (MythDate::current() < m_programInfo.GetRecordingEndTime())
+        return false;
+
+    QFileInfo recording(m_pathname);
+    QFileInfo index(GetIndexFilename(m_pathname));
+    if (!recording.exists())
+        return false;
+    return !index.exists() || index.lastModified() < recording.lastModified();
+}
+
+/** \fn PreviewStrip::Generate(PreviewDecoder&)
+ *  \brief Makes the sprite sheet and index of the recording.
+ *
+ *  \param decoder The decoder to grab the keyframes with. It is left closed.
+ */
+bool PreviewStrip::Generate(PreviewDecoder &decoder)
+{
+    int thumbs = gCoreContext->GetNumSetting("PreviewStripThumbnails",
+                                             kDefaultThumbnails);
+    if (thumbs <= 0)
+        return false;
+
+    {
+        QMutexLocker locker(&s_activeLock);
+        if (s_active.contains(m_pathname))
+            return false;
+        s_active.insert(m_pathname);
+    }
+
+    QTime tm = QTime::currentTime();
+    bool ok = Build(decoder, thumbs);
+    decoder.Close();
+
+    if (ok)
+    {
+        LOG(VB_GENERAL, LOG_INFO, LOC +
+            QString("Generated %1 thumbnails for '%2' in %3 seconds")
+                .arg(thumbs).arg(m_pathname).arg(tm.elapsed() * 0.001));
+    }
+    else
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Failed to generate thumbnails for '%1'").arg(m_pathname));
+    }
+
+    QMutexLocker locker(&s_activeLock);
+    s_active.remove(m_pathname);
+    return ok;
+}
+
+bool PreviewStrip::Build(PreviewDecoder &decoder, int thumbs)
+{
+    if (!decoder.Open(m_pathname))
+        return false;
+
+    QList<Candidate> candidates;
+    double length = 0.0;
+    if (!GetCandidates(decoder, thumbs, candidates, length))
+        return false;
+
+    QVector<QImage> best(thumbs);
+    // Flat frames score -1, so a slot never keeps one
+    QVector<double> bestScore(thumbs, -1.0);
+    QVector<int>    lastHistogram;
+    QSize           thumbSize;
+
+    foreach (const Candidate &candidate, candidates)
+    {
+        bool grabbed = (candidate.position >= 0) ?
+            decoder.GrabAtPosition(candidate.position) :
+            decoder.Grab((long long)candidate.time, true);
+        if (!grabbed)
+            continue;
+
+        // Every cell of the sheet has the size of the first thumbnail
+        if (thumbSize.isEmpty())
+        {
+            float aspect = decoder.GetAspect();
+            int height = (aspect > 0.0f) ?
+                qRound(kThumbWidth / aspect) & ~1 : kThumbWidth * 9 / 16;
+            thumbSize = QSize(kThumbWidth, max(height, 2));
+        }
+
+        QImage thumb;
+        if (!decoder.Scale(thumbSize, thumb))
+            continue;
+
+        QVector<int> histogram;
+        double score = Score(thumb, histogram);
+        if (score >= 0.0 && !lastHistogram.empty())
+        {
+            // Share of the pixels that changed brightness bucket
+            int changed = 0;
+            for (int i = 0; i < histogram.size(); ++i)
+                changed += abs(histogram[i] - lastHistogram[i]);
+            score = changed / (2.0 * thumb.width() * thumb.height());
+        }
+        lastHistogram = histogram;
+
+        if (score > bestScore[candidate.slot])
+        {
+            bestScore[candidate.slot] = score;
+            best[candidate.slot]      = thumb;
+        }
+    }
+
+    // Slots without a thumbnail, e.g. because one long GOP spans several
+    // of them, show the nearest one before them
+    QImage last;
+    for (int i = 0; i < thumbs && last.isNull(); ++i)
+        last = best[i];
+    if (last.isNull())
+        return false;
+
+    int columns = min(thumbs, kMaxColumns);
+    int rows    = (thumbs + columns - 1) / columns;
+    QImage sheet(columns * thumbSize.width(), rows * thumbSize.height(),
+                 QImage::Format_RGB32);
+    sheet.fill(Qt::black);
+
+    QList<double> starts;
+    QPainter painter(&sheet);
+    for (int i = 0; i < thumbs; ++i)
+    {
+        if (!best[i].isNull())
+            last = best[i];
+        painter.drawImage((i % columns) * thumbSize.width(),
+                          (i / columns) * thumbSize.height(), last);
+        starts.push_back(i * length / thumbs);
+    }
+    painter.end();
+
+    return Save(sheet, starts, length, thumbSize, columns);
+}
+
+// Seconds into the recording of a frame, using the recording's duration
+// map where there is one
+static double frame_to_seconds(const frm_pos_map_t &durations, double fps,
+                               long long frame)
+{
+    frm_pos_map_t::const_iterator it = durations.upperBound(frame);
+    if (it == durations.constBegin())
+        return (fps > 0.0) ? frame / fps : 0.0;
+    --it;
+    double ms = it.value();
+    if (fps > 0.0)
+        ms += (frame - it.key()) * 1000.0 / fps;
+    return ms / 1000.0;
+}
+
+/** \fn PreviewStrip::GetCandidates(PreviewDecoder&, int, QList<Candidate>&, double&) const
+ *  \brief Picks evenly spaced keyframes to choose the thumbnails from, in
+ *         file order.
+ *
+ *   The keyframe positions the recorder saved are used when there are
+ *   enough of them, so each keyframe is reached with a single seek to its
+ *   offset. Otherwise the recording is sought by time.
+ *
+ *  \param[out] length The length of the recording in seconds.
+ */
+bool PreviewStrip::GetCandidates(PreviewDecoder &decoder, int thumbs,
+                                 QList<Candidate> &candidates,
+                                 double &length) const
+{
+    int total  = thumbs * kCandidatesPerThumb;
+    double fps = decoder.GetFrameRate();
+
+    frm_pos_map_t positions;
+    frm_pos_map_t durations;
+    m_programInfo.QueryPositionMap(positions, MARK_GOP_BYFRAME);
+    m_programInfo.QueryPositionMap(durations, MARK_DURATION_MS);
+
+    if (positions.size() >= total && (fps > 0.0 || !durations.empty()))
+    {
+        long long frames = positions.lastKey();
+        length = frame_to_seconds(durations, fps, frames);
+        for (int i = 0; i < total; ++i)
+        {
+            long long target = (long long)((i + 0.5) * frames / total);
+            frm_pos_map_t::const_iterator it = positions.upperBound(target);
+            if (it != positions.constBegin())
+                --it;
+            if (!candidates.empty() && candidates.back().position == *it)
+                continue;
+
+            Candidate candidate;
+            candidate.slot     = i / kCandidatesPerThumb;
+            candidate.time     = frame_to_seconds(durations, fps, it.key());
+            candidate.position = *it;
+            candidates.push_back(candidate);
+        }
+        return length > 0.0;
+    }
+
+    length = decoder.GetDuration();
+    if (length <= 0.0)
+        return false;
+
+    for (int i = 0; i < total; ++i)
+    {
+        Candidate candidate;
+        candidate.slot     = i / kCandidatesPerThumb;
+        candidate.time     = (i + 0.5) * length / total;
+        candidate.position = -1;
+        candidates.push_back(candidate);
+    }
+    return true;
+}
+
+/** \fn PreviewStrip::Score(const QImage&, QVector<int>&)
+ *  \brief Fills in the brightness histogram of a thumbnail. Returns -1 if
+ *         the thumbnail is black or otherwise flat, and 0 if not.
+ */
+double PreviewStrip::Score(const QImage &image, QVector<int> &histogram)
+{
+    histogram.fill(0, 256 >> kHistogramShift);
+    for (int y = 0; y < image.height(); ++y)
+    {
+        const QRgb *line = (const QRgb *)image.constScanLine(y);
+        for (int x = 0; x < image.width(); ++x)
+            histogram[qGray(line[x]) >> kHistogramShift]++;
+    }
+
+    int peak = *max_element(histogram.constBegin(), histogram.constEnd());
+    if (peak > kFlatShare * image.width() * image.height())
+        return -1.0;
+    return 0.0;
+}
+
+QString PreviewStrip::FormatTime(double seconds)
+{
+    qint64 ms = qRound64(seconds * 1000.0);
+    return QString("%1:%2:%3.%4")
+        .arg(ms / 3600000, 2, 10, QChar('0'))
+        .arg((ms / 60000) % 60, 2, 10, QChar('0'))
+        .arg((ms / 1000) % 60, 2, 10, QChar('0'))
+        .arg(ms % 1000, 3, 10, QChar('0'));
+}
+
+bool PreviewStrip::Save(const QImage &sheet, const QList<double> &starts,
+                        double length, const QSize &thumbSize,
+                        int columns) const
+{
+    QString imageName = GetImageFilename(m_pathname);
+    QSaveFile image(imageName);
+    if (!image.open(QIODevice::WriteOnly) ||
+        !sheet.save(&image, "JPG", 75) || !image.commit())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to save '%1'").arg(imageName));
+        return false;
+    }
+    makeFileAccessible(imageName);
+
+    QString indexName = GetIndexFilename(m_pathname);
+    QString sheetName = QFileInfo(imageName).fileName();
+    QSaveFile index(indexName);
+    if (!index.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to save '%1'").arg(indexName));
+        return false;
+    }
+
+    QTextStream stream(&index);
+    stream.setCodec("UTF-8");
+    stream << "WEBVTT\n";
+    for (int i = 0; i < starts.size(); ++i)
+    {
+        double end = (i + 1 < starts.size()) ? starts[i + 1] : length;
+        stream << "\n" << FormatTime(starts[i]) << " --> " << FormatTime(end)
+               << "\n" << sheetName
+               << QString("#xywh=%1,%2,%3,%4\n")
+                      .arg((i % columns) * thumbSize.width())
+                      .arg((i / columns) * thumbSize.height())
+                      .arg(thumbSize.width()).arg(thumbSize.height());
+    }
+    stream.flush();
+
+    if (!index.commit())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to save '%1'").arg(indexName));
+        return false;
+    }
+    makeFileAccessible(indexName);
+    return true;
+}
@@ -0,0 +1,74 @@
+// -*- Mode: c++ -*-
+#ifndef PREVIEW_STRIP_H_
+#define PREVIEW_STRIP_H_
+
+#include <QMutex>
+#include <QString>
+#include <QImage>
+#include <QList>
+#include <QSet>
+#include <QSize>
+#include <QVector>
+
+#include "programinfo.h"
+
+class PreviewDecoder;
+
+/** \class PreviewStrip
+ *  \brief Makes a sprite sheet of thumbnails spread over a recording, and a
+ *         WebVTT index of the part of the recording each one stands for.
+ *
+ *   The recording is divided into equal slots, one per thumbnail. A few
+ *   keyframes are decoded for every slot, taken from the seek table the
+ *   recorder wrote, and visited in file order so the recording is read in
+ *   a single forward pass. Each slot keeps the keyframe that differs most
+ *   from the one before it, which favours scene changes over the middle
+ *   of a static shot, and passes over black or flat frames.
+ *
+ *   The files are written next to the recording as "<file>.strip.jpg" and
+ *   "<file>.strip.vtt", so they can be fetched from the storage group like
+ *   the preview image. The cues in the index use media fragments, e.g.
+ *   "<file>.strip.jpg#xywh=160,0,160,90", relative to the index.
+ *
+ *   The number of thumbnails is set by the "PreviewStripThumbnails"
+ *   setting; 0 turns the strips off.
+ */
+class PreviewStrip
+{
+  public:
+    explicit PreviewStrip(const ProgramInfo &pginfo);
+
+    bool IsNeeded(void) const;
+    bool Generate(PreviewDecoder &decoder);
+
+    static QString GetImageFilename(const QString &pathname)
+        { return pathname + ".strip.jpg"; }
+    static QString GetIndexFilename(const QString &pathname)
+        { return pathname + ".strip.vtt"; }
+
+  private:
+    /// A keyframe that may be used for a thumbnail
+    struct Candidate
+    {
+        int     slot;
+        double  time;     ///< seconds into the recording
+        int64_t position; ///< byte offset, -1 to seek by time
+    };
+
+    bool Build(PreviewDecoder &decoder, int thumbs);
+    bool GetCandidates(PreviewDecoder &decoder, int thumbs,
+                       QList<Candidate> &candidates, double &length) const;
+    static double Score(const QImage &image, QVector<int> &histogram);
+    bool Save(const QImage &sheet, const QList<double> &starts, double length,
+              const QSize &thumbSize, int columns) const;
+    static QString FormatTime(double seconds);
+
+    ProgramInfo m_programInfo;
+    QString     m_pathname;
+
+    /// Recordings whose strip is being generated
+    static QSet<QString> s_active;
+    static QMutex        s_activeLock;
+};
+
+#endif // PREVIEW_STRIP_H_
@@ -0,0 +1,391 @@
+#include <cstring>
+
+#include "mythpainter.h"
+#include "subtitlerendercache.h"
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+}
+
+/// Memory that finished images may use before the oldest are dropped
+static const int64_t kMaxCacheSize = 32 * 1024 * 1024;
+
+/// Flags used by MythUISimpleText for subtitle chunks
+static const int kTextFlags = Qt::AlignLeft | Qt::AlignTop;
+
+SubtitleRenderCache::SubtitleRenderCache() :
+    MThread("SubtitleRender")
+{
+}
+
+SubtitleRenderCache::~SubtitleRenderCache()
+{
+    Stop();
+    wait();
+}
+
+void SubtitleRenderCache::Stop(void)
+{
+    QMutexLocker locker(&m_lock);
+    m_jobs.clear();
+    m_pending.clear();
+    m_run = false;
+    m_wait.wakeAll();
+}
+
+/** \fn SubtitleRenderCache::TextKey(const QString&, const QSize&, const MythFontProperties&)
+ *  \brief Returns the key of the image of \p text drawn in \p font into an
+ *         area of \p size, the same way MythPainter identifies it.
+ */
+QString SubtitleRenderCache::TextKey(const QString &text, const QSize &size,
+                                     const MythFontProperties &font)
+{
+    return font.GetHash() + QString::number(size.width()) +
+        QString::number(size.height()) + QString::number(kTextFlags) +
+        QString::number(font.color().rgba()) + text;
+}
+
+void SubtitleRenderCache::RequestText(const QString &key, const QString &text,
+                                      const QSize &size,
+                                      const MythFontProperties &font)
+{
+    Job job;
+    job.type = kJobText;
+    job.key  = key;
+    job.text = text;
+    job.size = size;
+    job.font = font;
+    Queue(job);
+}
+
+/** \fn SubtitleRenderCache::RequestBitmap(const QString&, const AVSubtitleRect*, int)
+ *  \brief Queues the cropping of a bitmap subtitle, split into the parts
+ *         above and below line \p split. The bitmap is copied, so \p rect
+ *         may be freed as soon as this returns.
+ */
+void SubtitleRenderCache::RequestBitmap(const QString &key,
+                                        const AVSubtitleRect *rect, int split)
+{
+    Job job;
+    job.type   = kJobBitmap;
+    job.key    = key;
+    job.bitmap = CopyBitmap(rect);
+    job.split  = split;
+    Queue(job);
+}
+
+void SubtitleRenderCache::RequestScale(const QString &key, const QImage &image,
+                                       const QSize &size)
+{
+    Job job;
+    job.type  = kJobScale;
+    job.key   = key;
+    job.image = image;
+    job.size  = size;
+    Queue(job);
+}
+
+void SubtitleRenderCache::Queue(const Job &job)
+{
+    QMutexLocker locker(&m_lock);
+    if (!m_run || m_pending.contains(job.key) || m_results.contains(job.key))
+        return;
+    m_pending.insert(job.key);
+    m_jobs.append(job);
+    m_wait.wakeAll();
+}
+
+/// Returns true if \p key has been requested, whether or not it is ready.
+bool SubtitleRenderCache::IsQueued(const QString &key) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_pending.contains(key) || m_results.contains(key);
+}
+
+bool SubtitleRenderCache::IsReady(const QString &key) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_results.contains(key);
+}
+
+bool SubtitleRenderCache::GetImage(const QString &key, QImage &image) const
+{
+    QMutexLocker locker(&m_lock);
+    QHash<QString, Entry>::const_iterator it = m_results.constFind(key);
+    if (it == m_results.constEnd())
+        return false;
+    image = (*it).image;
+    return true;
+}
+
+bool SubtitleRenderCache::TakeImage(const QString &key, QImage &image)
+{
+    QMutexLocker locker(&m_lock);
+    QHash<QString, Entry>::const_iterator it = m_results.constFind(key);
+    if (it == m_results.constEnd())
+        return false;
+    image = (*it).image;
+    Remove(key);
+    return true;
+}
+
+bool SubtitleRenderCache::GetBitmaps(const QString &key,
+                                     Bitmap &top, Bitmap &bottom) const
+{
+    QMutexLocker locker(&m_lock);
+    QHash<QString, Entry>::const_iterator it = m_results.constFind(key);
+    if (it == m_results.constEnd())
+        return false;
+    top    = (*it).top;
+    bottom = (*it).bottom;
+    return true;
+}
+
+bool SubtitleRenderCache::TakeBitmaps(const QString &key,
+                                      Bitmap &top, Bitmap &bottom)
+{
+    QMutexLocker locker(&m_lock);
+    QHash<QString, Entry>::const_iterator it = m_results.constFind(key);
+    if (it == m_results.constEnd())
+        return false;
+    top    = (*it).top;
+    bottom = (*it).bottom;
+    Remove(key);
+    return true;
+}
+
+/// Drops all queued work and finished images.
+void SubtitleRenderCache::Clear(void)
+{
+    QMutexLocker locker(&m_lock);
+    m_jobs.clear();
+    m_pending.clear();
+    m_results.clear();
+    m_order.clear();
+    m_size = 0;
+}
+
+void SubtitleRenderCache::Store(const QString &key, const Entry &entry)
+{
+    // A Clear() while the job was running means it is no longer wanted
+    if (!m_pending.remove(key))
+        return;
+
+    m_results.insert(key, entry);
+    m_order.append(key);
+    m_size += entry.cost;
+
+    while (m_size > kMaxCacheSize && m_order.size() > 1)
+        Remove(m_order.first());
+}
+
+void SubtitleRenderCache::Remove(const QString &key)
+{
+    QHash<QString, Entry>::iterator it = m_results.find(key);
+    if (it == m_results.end())
+        return;
+    m_size -= (*it).cost;
+    m_results.erase(it);
+    m_order.removeOne(key);
+}
+
+void SubtitleRenderCache::run(void)
+{
+    RunProlog();
+    QMutexLocker locker(&m_lock);
+    while (true)
+    {
+        while (m_jobs.empty() && m_run)
+            m_wait.wait(&m_lock);
+
+        if (!m_run)
+            break;
+
+        Job job = m_jobs.takeFirst();
+        locker.unlock();
+
+        Entry entry;
+        switch (job.type)
+        {
+            case kJobText:
+                entry.image = MythPainter::RenderText(job.text, kTextFlags,
+                                                      QRect(QPoint(), job.size),
+                                                      job.font);
+                break;
+            case kJobBitmap:
+                SplitBitmap(job.bitmap, job.split, entry.top, entry.bottom);
+                break;
+            case kJobScale:
+                entry.image = ScaleImage(job.image, job.size);
+                break;
+        }
+        entry.cost = entry.image.byteCount() + entry.top.image.byteCount() +
+                     entry.bottom.image.byteCount();
+
+        locker.relock();
+        Store(job.key, entry);
+    }
+    RunEpilog();
+}
+
+/** \fn SubtitleRenderCache::CopyBitmap(const AVSubtitleRect*)
+ *  \brief Copies the pixels and palette of a bitmap subtitle, so that they
+ *         can be used after the subtitle has been freed.
+ */
+SubtitleRenderCache::BitmapSource
+SubtitleRenderCache::CopyBitmap(const AVSubtitleRect *rect)
+{
+    BitmapSource src;
+    if (!rect || !rect->data[0] || !rect->data[1] || rect->w <= 0 ||
+        rect->h <= 0)
+    {
+        return src;
+    }
+
+    src.width    = rect->w;
+    src.height   = rect->h;
+    src.linesize = rect->linesize[0];
+    src.pixels   = QByteArray((const char *)rect->data[0],
+                              src.linesize * (src.height - 1) + src.width);
+
+    // Pixels are looked up without a range check, so pad the palette
+    // out to every possible index
+    int colors = qBound(0, rect->nb_colors, 256);
+    src.palette.fill(0, 256);
+    memcpy(src.palette.data(), rect->data[1], colors * sizeof(uint32_t));
+    return src;
+}
+
+/** \fn SubtitleRenderCache::SplitBitmap(const BitmapSource&, int, Bitmap&, Bitmap&)
+ *  \brief Splits a bitmap subtitle into the parts above and below line
+ *         \p split, so that they can be zoomed towards the top and bottom
+ *         of the screen, and crops each part to its visible pixels.
+ */
+void SubtitleRenderCache::SplitBitmap(const BitmapSource &src, int split,
+                                      Bitmap &top, Bitmap &bottom)
+{
+    top    = Bitmap();
+    bottom = Bitmap();
+    if (src.pixels.isEmpty())
+        return;
+
+    int uh = split;
+    if (uh > 0)
+    {
+        top = CropBitmap(src, QRect(0, 0, src.width, uh), true);
+        uh = top.next;
+    }
+    else
+        uh = 0;
+
+    int lh = src.height - uh;
+    if (lh > 0)
+        bottom = CropBitmap(src, QRect(0, uh, src.width, lh), false);
+}
+
+// Find the active part of the bitmap within bbox and convert it to ARGB.
+// For the top half, the split point is the empty line nearest the middle.
+SubtitleRenderCache::Bitmap
+SubtitleRenderCache::CropBitmap(const BitmapSource &src, QRect bbox, bool top)
+{
+    Bitmap result;
+    const uint8_t  *pixels  = (const uint8_t *)src.pixels.constData();
+    const uint32_t *palette = src.palette.constData();
+    int xmin, xmax, ymin, ymax;
+    int ylast, ysplit;
+    bool prev_empty = false;
+
+    // initialize to opposite edges
+    xmin = bbox.right();
+    xmax = bbox.left();
+    ymin = bbox.bottom();
+    ymax = bbox.top();
+    ylast = bbox.top();
+    ysplit = bbox.bottom();
+
+    // find bounds of active image
+    for (int y = bbox.top(); y <= bbox.bottom(); ++y)
+    {
+        if (y >= src.height)
+        {
+            // end of image
+            if (!prev_empty)
+                ylast = y;
+            break;
+        }
+
+        bool empty = true;
+        const uint8_t *line = pixels + y * src.linesize;
+        for (int x = bbox.left(); x <= bbox.right(); ++x)
+        {
+            if (palette[line[x]] & 0xff000000)
+            {
+                empty = false;
+                if (x < xmin)
+                    xmin = x;
+                if (x > xmax)
+                    xmax = x;
+            }
+        }
+
+        if (!empty)
+        {
+            if (y < ymin)
+                ymin = y;
+            if (y > ymax)
+                ymax = y;
+        }
+        else if (!prev_empty)
+        {
+            // remember uppermost empty line
+            ylast = y;
+        }
+        prev_empty = empty;
+    }
+
+    if (ymax <= ymin)
+        return result;
+
+    if (top)
+    {
+        if (ylast < ymin)
+            // no empty lines
+            return result;
+
+        if (ymax == bbox.bottom())
+        {
+            ymax = ylast;
+            ysplit = ylast;
+        }
+    }
+
+    // set new bounds
+    bbox.setLeft(xmin);
+    bbox.setRight(xmax);
+    bbox.setTop(ymin);
+    bbox.setBottom(ymax);
+
+    // copy active region, converting it from the palette
+    QImage image(bbox.width(), bbox.height(), QImage::Format_ARGB32);
+    for (int y = 0; y < bbox.height(); ++y)
+    {
+        const uint8_t *in = pixels + (y + bbox.top()) * src.linesize +
+                            bbox.left();
+        QRgb *out = (QRgb *)image.scanLine(y);
+        for (int x = 0; x < bbox.width(); ++x)
+            out[x] = palette[in[x]];
+    }
+
+    result.image = image;
+    result.bbox  = bbox;
+    result.next  = ysplit + 1;
+    return result;
+}
+
+QImage SubtitleRenderCache::ScaleImage(const QImage &image, const QSize &size)
+{
+    if (image.size() == size)
+        return image;
+    return image.scaled(size.width(), size.height(),
+                        Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
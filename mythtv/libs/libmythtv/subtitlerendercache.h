@@ -0,0 +1,127 @@
+// -*- Mode: c++ -*-
+
+#ifndef SUBTITLERENDERCACHE_H
+#define SUBTITLERENDERCACHE_H
+
+#include <cstdint>
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QRect>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "mthread.h"
+#include "mythfontproperties.h"
+
+struct AVSubtitleRect;
+
+/** \class SubtitleRenderCache
+ *  \brief Rasterizes subtitle text and bitmaps on a background thread.
+ *
+ *  SubtitleScreen queues the expensive parts of subtitle rendering here as
+ *  soon as it knows what will be shown: glyph rasterization of each text
+ *  chunk, and the cropping, palette conversion and scaling of bitmap
+ *  subtitles. The results are kept keyed by their content, so that the UI
+ *  thread only has to wrap a finished image and composite it. Anything
+ *  that is not ready in time is still rendered synchronously by the caller,
+ *  using the same static helpers.
+ *
+ *  Finished images are evicted, oldest first, once they use more than a
+ *  fixed amount of memory.
+ */
+class SubtitleRenderCache : public MThread
+{
+  public:
+    /// The visible part of one half of a bitmap subtitle
+    struct Bitmap
+    {
+        QImage image; ///< null if the half is empty
+        QRect  bbox;  ///< location of the image within the source bitmap
+        int    next {0}; ///< first line of the following half
+    };
+
+    /// A private copy of a palettized AVSubtitleRect
+    struct BitmapSource
+    {
+        QByteArray        pixels;
+        int               linesize {0};
+        int               width    {0};
+        int               height   {0};
+        QVector<uint32_t> palette;
+    };
+
+    SubtitleRenderCache();
+   ~SubtitleRenderCache();
+
+    void Stop(void);
+
+    static QString TextKey(const QString &text, const QSize &size,
+                           const MythFontProperties &font);
+    void RequestText(const QString &key, const QString &text,
+                     const QSize &size, const MythFontProperties &font);
+    void RequestBitmap(const QString &key, const AVSubtitleRect *rect,
+                       int split);
+    void RequestScale(const QString &key, const QImage &image,
+                      const QSize &size);
+
+    bool IsQueued(const QString &key) const;
+    bool IsReady(const QString &key) const;
+    bool GetImage(const QString &key, QImage &image) const;
+    bool TakeImage(const QString &key, QImage &image);
+    bool GetBitmaps(const QString &key, Bitmap &top, Bitmap &bottom) const;
+    bool TakeBitmaps(const QString &key, Bitmap &top, Bitmap &bottom);
+    void Clear(void);
+
+    static BitmapSource CopyBitmap(const AVSubtitleRect *rect);
+    static void SplitBitmap(const BitmapSource &src, int split,
+                            Bitmap &top, Bitmap &bottom);
+    static QImage ScaleImage(const QImage &image, const QSize &size);
+
+  protected:
+    void run(void) override; // MThread
+
+  private:
+    enum JobType { kJobText, kJobBitmap, kJobScale };
+
+    struct Job
+    {
+        JobType            type;
+        QString            key;
+        QString            text;
+        QSize              size;
+        MythFontProperties font;
+        BitmapSource       bitmap;
+        int                split {0};
+        QImage             image;
+    };
+
+    struct Entry
+    {
+        QImage image;
+        Bitmap top;
+        Bitmap bottom;
+        int    cost {0};
+    };
+
+    static Bitmap CropBitmap(const BitmapSource &src, QRect bbox, bool top);
+    void Queue(const Job &job);
+    void Store(const QString &key, const Entry &entry);
+    void Remove(const QString &key);
+
+    mutable QMutex         m_lock;
+    QWaitCondition         m_wait;
+    bool                   m_run {true};
+    QList<Job>             m_jobs;
+    QSet<QString>          m_pending;
+    QHash<QString, Entry>  m_results;
+    QList<QString>         m_order;  ///< oldest result first
+    int64_t                m_size {0};
+};
+
+#endif // SUBTITLERENDERCACHE_H
@@ -72,6 +72,16 @@ public:
     MythImage *GetImage(void) { return m_Images[0]; }
 };
 
+// Text that was rasterized ahead of time by the SubtitleRenderCache
+class SubTextImage : public MythUIImage, public SubWrapper
+{
+public:
+    SubTextImage(const QString &name, const MythRect &area,
+                 int whichImageCache, long long expireTime) :
+        MythUIImage(nullptr, name),
+        SubWrapper(area, expireTime, whichImageCache) {}
+};
+
 ////////////////////////////////////////////////////////////////////////////
 
 // Class SubtitleFormat manages fonts and backgrounds for subtitles.
@@ -201,6 +211,13 @@ static const QString kSubAttrOutlinecolor("outlinecolor");
 static const QString kSubAttrOutlinesize ("outlinesize");
 static const QString kSubAttrOutlinealpha("outlinealpha");
 
+// Longest time, in ms, that text subtitles wait for their rasterized text
+static const int kMaxRenderWait = 100;
+// Clear mask that removes all subtitles, not just some cc708 windows
+static const uint64_t kClearAll = UINT64_MAX;
+// Number of upcoming bitmap subtitles to prepare in advance
+static const int kAVLookahead = 4;
+
 static QString srtColorString(QColor color)
 {
     return QString("#%1%2%3")
@@ -878,6 +895,52 @@ void FormattedTextSubtitle::PreRender(void)
     }
 }
 
+// Queues the text of each chunk to be rasterized by the render thread.
+// PreRender() must have been called first.
+void FormattedTextSubtitle::RequestRender(void)
+{
+    SubtitleRenderCache *cache = m_subScreen->GetRenderCache();
+    for (int i = 0; i < m_lines.size(); i++)
+    {
+        QList<FormattedTextChunk>::iterator chunk;
+        for (chunk = m_lines[i].chunks.begin();
+             chunk != m_lines[i].chunks.end();
+             ++chunk)
+        {
+            (*chunk).imageKey.clear();
+            MythFontProperties *mythfont =
+                m_subScreen->GetFont((*chunk).m_format);
+            if (!mythfont || (*chunk).textRect.width() <= 0 ||
+                (*chunk).textRect.height() <= 0)
+                continue;
+            // MythUISimpleText trims its text, so do the same
+            QString text = (*chunk).text.trimmed();
+            QSize size = (*chunk).textRect.size();
+            (*chunk).imageKey =
+                SubtitleRenderCache::TextKey(text, size, *mythfont);
+            cache->RequestText((*chunk).imageKey, text, size, *mythfont);
+        }
+    }
+}
+
+bool FormattedTextSubtitle::IsRendered(void) const
+{
+    SubtitleRenderCache *cache = m_subScreen->GetRenderCache();
+    for (int i = 0; i < m_lines.size(); i++)
+    {
+        QList<FormattedTextChunk>::const_iterator chunk;
+        for (chunk = m_lines[i].chunks.constBegin();
+             chunk != m_lines[i].chunks.constEnd();
+             ++chunk)
+        {
+            if (!(*chunk).imageKey.isEmpty() &&
+                !cache->IsReady((*chunk).imageKey))
+                return false;
+        }
+    }
+    return true;
+}
+
 // Returns true if anything new was drawn, false if not.  The caller
 // should call SubtitleScreen::OptimiseDisplayedArea() if true is
 // returned.
@@ -901,13 +964,18 @@ void FormattedTextSubtitle::Draw(void)
             // shapes should be added/drawn first, and text drawn on
             // top.
             if ((*chunk).textRect.width() > 0) {
-                SubSimpleText *text =
-                    new SubSimpleText((*chunk).text, *mythfont,
-                                      (*chunk).textRect,
-                                      Qt::AlignLeft|Qt::AlignTop,
-                                      /*m_subScreen*/nullptr,
-                                      (*chunk).textName, CacheNum(),
-                                      m_start + m_duration);
+                // Use the prerendered text if it is ready, otherwise
+                // let the painter rasterize it.
+                MythUIType *text =
+                    m_subScreen->CreateTextImage(*chunk, CacheNum(),
+                                                 m_start + m_duration);
+                if (!text)
+                    text = new SubSimpleText((*chunk).text, *mythfont,
+                                             (*chunk).textRect,
+                                             Qt::AlignLeft|Qt::AlignTop,
+                                             /*m_subScreen*/nullptr,
+                                             (*chunk).textName, CacheNum(),
+                                             m_start + m_duration);
                 textList += text;
             }
             if ((*chunk).bgShapeRect.width() > 0) {
@@ -1374,9 +1442,12 @@ SubtitleScreen::SubtitleScreen(MythPlayer *player, const char * name,
     m_textFontDelayMs(0), m_textFontDelayMsPrev(0),
     m_refreshModified(false), m_refreshDeleted(false),
     m_fontStretch(fontStretch),
+    m_renderCache(new SubtitleRenderCache),
+    m_prefetchStart(UINT64_MAX),
     m_format(new SubtitleFormat)
 {
     m_removeHTML.setMinimal(true);
+    m_renderCache->start();
 
 #ifdef USING_LIBASS
     m_assLibrary   = nullptr;
@@ -1390,6 +1461,7 @@ SubtitleScreen::SubtitleScreen(MythPlayer *player, const char * name,
 SubtitleScreen::~SubtitleScreen(void)
 {
     ClearAllSubtitles();
+    delete m_renderCache;
     delete m_format;
 #ifdef USING_LIBASS
     CleanupAssLibrary();
@@ -1467,7 +1539,10 @@ void SubtitleScreen::ClearAllSubtitles(void)
 void SubtitleScreen::ClearNonDisplayedSubtitles(void)
 {
     if (m_subreader && (kDisplayAVSubtitle == m_subtitleType))
+    {
         m_subreader->ClearAVSubtitles();
+        m_renderCache->Clear();
+    }
     if (m_subreader && (kDisplayRawTextSubtitle == m_subtitleType))
         m_subreader->ClearRawTextSubtitles();
     if (m_608reader && (kDisplayCC608 == m_subtitleType))
@@ -1478,6 +1553,7 @@ void SubtitleScreen::ClearNonDisplayedSubtitles(void)
 
 void SubtitleScreen::ClearDisplayedSubtitles(void)
 {
+    DiscardBatches();
     SetElementDeleted();
     DeleteAllChildren();
 }
@@ -1491,6 +1567,7 @@ void SubtitleScreen::DisplayDVDButton(AVSubtitle* dvdButton, QRect &buttonPos)
     if (!vo)
         return;
 
+    DiscardBatches();
     DeleteAllChildren();
     SetElementDeleted();
 
@@ -1768,10 +1845,12 @@ void SubtitleScreen::Pulse(void)
         fsub->WrapLongLines();
         fsub->Layout();
         fsub->PreRender();
-        fsub->Draw();
-        delete fsub;
-        SetElementAdded();
+        fsub->RequestRender();
+        if (m_batches.isEmpty())
+            QueueClear(0);
+        m_batches.last().subs.append(fsub);
     }
+    ApplyBatches();
 
     OptimiseDisplayedArea();
     MythScreenType::Pulse();
@@ -1786,6 +1865,89 @@ void SubtitleScreen::ResetElementState(void)
     m_refreshDeleted = false;
 }
 
+// Starts a new batch of text subtitles.  When the batch is shown, the
+// cc708 windows in mask, or everything for kClearAll, are removed first.
+void SubtitleScreen::QueueClear(uint64_t mask)
+{
+    RenderBatch batch;
+    batch.clearMask = mask;
+    batch.age.start();
+    m_batches.append(batch);
+}
+
+// Shows the queued text subtitles, in order, as soon as their text has
+// been rasterized.  Anything that takes too long is drawn regardless and
+// rasterized by the painter instead.  What is currently displayed stays
+// up until its replacement is ready.
+void SubtitleScreen::ApplyBatches(void)
+{
+    while (!m_batches.isEmpty())
+    {
+        RenderBatch &batch = m_batches.first();
+        bool ready = true;
+        for (int i = 0; ready && i < batch.subs.size(); i++)
+            ready = batch.subs[i]->IsRendered();
+        if (!ready && batch.age.elapsed() < kMaxRenderWait)
+            break;
+
+        if (batch.clearMask == kClearAll)
+        {
+            SetElementDeleted();
+            DeleteAllChildren();
+        }
+        else if (batch.clearMask)
+        {
+            Clear708Cache(batch.clearMask);
+        }
+
+        while (!batch.subs.isEmpty())
+        {
+            FormattedTextSubtitle *fsub = batch.subs.takeFirst();
+            fsub->Draw();
+            delete fsub;
+            SetElementAdded();
+        }
+        m_batches.removeFirst();
+    }
+}
+
+void SubtitleScreen::DiscardBatches(void)
+{
+    while (!m_batches.isEmpty())
+    {
+        RenderBatch batch = m_batches.takeFirst();
+        while (!batch.subs.isEmpty())
+            delete batch.subs.takeFirst();
+    }
+}
+
+// Returns an image of the chunk's text if it has already been
+// rasterized, nullptr otherwise.
+MythUIType *SubtitleScreen::CreateTextImage(const FormattedTextChunk &chunk,
+                                            int whichImageCache,
+                                            long long expireTime)
+{
+    QImage rendered;
+    if (chunk.imageKey.isEmpty() ||
+        !m_renderCache->GetImage(chunk.imageKey, rendered))
+        return nullptr;
+
+    VideoOutput *vo = m_player ? m_player->GetVideoOutput() : nullptr;
+    MythPainter *osd_painter = vo ? vo->GetOSDPainter() : nullptr;
+    MythImage *image = osd_painter ? osd_painter->GetFormatImage() : nullptr;
+    if (!image)
+        return nullptr;
+
+    image->Assign(rendered);
+    SubTextImage *uiimage =
+        new SubTextImage(chunk.textName, MythRect(chunk.textRect),
+                         whichImageCache, expireTime);
+    uiimage->SetImage(image);
+    uiimage->SetArea(MythRect(chunk.textRect));
+    image->DecrRef();
+    return uiimage;
+}
+
 void SubtitleScreen::OptimiseDisplayedArea(void)
 {
     if (!m_refreshModified)
@@ -1821,6 +1983,20 @@ void SubtitleScreen::OptimiseDisplayedArea(void)
     }
 }
 
+// Identifies one bitmap of a queued AV subtitle in the render cache
+static QString avSubtitleKey(const AVSubtitle &subtitle, uint index)
+{
+    return QString("avsub%1:%2:%3")
+        .arg(subtitle.start_display_time).arg(index)
+        .arg((quintptr)subtitle.rects[index]->data[0], 0, 16);
+}
+
+static QString avScaleKey(const QString &key, const QSize &size, bool top)
+{
+    return QString("%1%2@%3x%4").arg(key).arg(top ? 't' : 'b')
+        .arg(size.width()).arg(size.height());
+}
+
 void SubtitleScreen::DisplayAVSubtitles(void)
 {
     if (!m_player || !m_subreader)
@@ -1871,58 +2047,29 @@ void SubtitleScreen::DisplayAVSubtitles(void)
 
             if (displaysub && rect->type == SUBTITLE_BITMAP)
             {
-                QRect display(rect->display_x, rect->display_y,
-                              rect->display_w, rect->display_h);
-
-                // XSUB and some DVD/DVB subs are based on the original video
-                // size before the video was converted. We need to guess the
-                // original size and allow for the difference
-
-                int right  = rect->x + rect->w;
-                int bottom = rect->y + rect->h;
-                if (subs->fixPosition || (currentFrame->height < bottom) ||
-                    (currentFrame->width  < right) ||
-                    !display.width() || !display.height())
+                QRect display = CalcAVDisplay(rect, currentFrame,
+                                              subs->fixPosition);
+
+                // split into upper/lower to allow zooming, using the
+                // halves prepared in advance if they are ready
+                QString key = avSubtitleKey(subtitle, i);
+                SubtitleRenderCache::Bitmap upper, lower;
+                if (!m_renderCache->TakeBitmaps(key, upper, lower))
                 {
-                    int sd_height = 576;
-                    if ((m_player->GetFrameRate() > 26.0f ||
-                         m_player->GetFrameRate() < 24.0f) && bottom <= 480)
-                        sd_height = 480;
-                    int height = ((currentFrame->height <= sd_height) &&
-                                  (bottom <= sd_height)) ? sd_height :
-                                 ((currentFrame->height <= 720) && bottom <= 720)
-                                   ? 720 : 1080;
-                    int width  = ((currentFrame->width  <= 720) &&
-                                  (right <= 720)) ? 720 :
-                                 ((currentFrame->width  <= 1280) &&
-                                  (right <= 1280)) ? 1280 : 1920;
-                    display = QRect(0, 0, width, height);
+                    SubtitleRenderCache::SplitBitmap(
+                        SubtitleRenderCache::CopyBitmap(rect),
+                        display.height() / 2 - rect->y, upper, lower);
                 }
 
-                // split into upper/lower to allow zooming
-                QRect bbox;
-                int uh = display.height() / 2 - rect->y;
-                int lh;
                 long long displayuntil = currentFrame->timecode + displayfor;
-                if (uh > 0)
-                {
-                    bbox = QRect(0, 0, rect->w, uh);
-                    uh = DisplayScaledAVSubtitles(rect, bbox, true, display,
-                                                  subtitle.forced,
-                                                  QString("avsub%1t").arg(i),
-                                                  displayuntil, late);
-                }
-                else
-                    uh = 0;
-                lh = rect->h - uh;
-                if (lh > 0)
-                {
-                    bbox = QRect(0, uh, rect->w, lh);
-                    DisplayScaledAVSubtitles(rect, bbox, false, display,
-                                             subtitle.forced,
-                                             QString("avsub%1b").arg(i),
-                                             displayuntil, late);
-                }
+                DisplayScaledAVSubtitles(rect, upper, key, true, display,
+                                         subtitle.forced,
+                                         QString("avsub%1t").arg(i),
+                                         displayuntil, late);
+                DisplayScaledAVSubtitles(rect, lower, key, false, display,
+                                         subtitle.forced,
+                                         QString("avsub%1b").arg(i),
+                                         displayuntil, late);
             }
 #ifdef USING_LIBASS
             else if (displaysub && rect->type == SUBTITLE_ASS)
@@ -1934,117 +2081,96 @@ void SubtitleScreen::DisplayAVSubtitles(void)
         }
         m_subreader->FreeAVSubtitle(subtitle);
     }
+    PrepareAVSubtitles(subs, currentFrame);
 #ifdef USING_LIBASS
     RenderAssTrack(currentFrame->timecode);
 #endif
 }
 
-int SubtitleScreen::DisplayScaledAVSubtitles(const AVSubtitleRect *rect,
-                                             QRect &bbox, bool top,
-                                             QRect &display, int forced,
-                                             QString imagename,
-                                             long long displayuntil,
-                                             long long late)
-{
-    // split image vertically if it spans middle of display
-    // - split point is empty line nearest the middle
-    // crop image to reduce scaling time
-    int xmin, xmax, ymin, ymax;
-    int ylast, ysplit;
-    bool prev_empty = false;
-
-    // initialize to opposite edges
-    xmin = bbox.right();
-    xmax = bbox.left();
-    ymin = bbox.bottom();
-    ymax = bbox.top();
-    ylast = bbox.top();
-    ysplit = bbox.bottom();
-
-    // find bounds of active image
-    for (int y = bbox.top(); y <= bbox.bottom(); ++y)
-    {
-        if (y >= rect->h)
+// Start cropping and scaling the bitmap subtitles that are due next, so
+// that DisplayScaledAVSubtitles() only has to composite them.
+void SubtitleScreen::PrepareAVSubtitles(const AVSubtitles *subs,
+                                        const VideoFrame *frame)
+{
+    int count = 0;
+    MythDeque<AVSubtitle>::const_iterator it;
+    for (it = subs->buffers.begin();
+         it != subs->buffers.end() && count < kAVLookahead; ++it, ++count)
+    {
+        const AVSubtitle &subtitle = *it;
+        for (std::size_t i = 0; i < subtitle.num_rects; ++i)
         {
-            // end of image
-            if (!prev_empty)
-                ylast = y;
-            break;
-        }
+            const AVSubtitleRect *rect = subtitle.rects[i];
+            if (rect->type != SUBTITLE_BITMAP)
+                continue;
 
-        bool empty = true;
-        for (int x = bbox.left(); x <= bbox.right(); ++x)
-        {
-            const uint8_t color =
-                rect->data[0][y * rect->linesize[0] + x];
-            const uint32_t pixel = *((uint32_t *)rect->data[1] + color);
-            if (pixel & 0xff000000)
+            QRect display = CalcAVDisplay(rect, frame, subs->fixPosition);
+            QString key = avSubtitleKey(subtitle, i);
+            SubtitleRenderCache::Bitmap halves[2];
+            if (!m_renderCache->GetBitmaps(key, halves[0], halves[1]))
             {
-                empty = false;
-                if (x < xmin)
-                    xmin = x;
-                if (x > xmax)
-                    xmax = x;
+                if (!m_renderCache->IsQueued(key))
+                    m_renderCache->RequestBitmap(
+                        key, rect, display.height() / 2 - rect->y);
+                continue;
             }
-        }
-
-        if (!empty)
-        {
-            if (y < ymin)
-                ymin = y;
-            if (y > ymax)
-                ymax = y;
-        }
-        else if (!prev_empty)
-        {
-            // remember uppermost empty line
-            ylast = y;
-        }
-        prev_empty = empty;
-    }
-
-    if (ymax <= ymin)
-        return 0;
-
-    if (top)
-    {
-        if (ylast < ymin)
-            // no empty lines
-            return 0;
 
-        if (ymax == bbox.bottom())
-        {
-            ymax = ylast;
-            ysplit = ylast;
+            for (int half = 0; half < 2; half++)
+            {
+                const SubtitleRenderCache::Bitmap &bitmap = halves[half];
+                if (bitmap.image.isNull())
+                    continue;
+                bool top = (half == 0);
+                QSize size = CalcAVSubtitleRect(rect, bitmap.bbox, top,
+                                                display).size();
+                if (size != bitmap.image.size())
+                    m_renderCache->RequestScale(
+                        avScaleKey(key, size, top), bitmap.image, size);
+            }
         }
     }
+}
 
-    // set new bounds
-    bbox.setLeft(xmin);
-    bbox.setRight(xmax);
-    bbox.setTop(ymin);
-    bbox.setBottom(ymax);
-
-    // copy active region
-    // AVSubtitleRect's image data's not guaranteed to be 4 byte
-    // aligned.
+QRect SubtitleScreen::CalcAVDisplay(const AVSubtitleRect *rect,
+                                    const VideoFrame *frame,
+                                    bool fixPosition) const
+{
+    QRect display(rect->display_x, rect->display_y,
+                  rect->display_w, rect->display_h);
 
-    QRect orig_rect(bbox.left(), bbox.top(), bbox.width(), bbox.height());
+    // XSUB and some DVD/DVB subs are based on the original video
+    // size before the video was converted. We need to guess the
+    // original size and allow for the difference
 
-    QImage qImage(bbox.width(), bbox.height(), QImage::Format_ARGB32);
-    for (int y = 0; y < bbox.height(); ++y)
+    int right  = rect->x + rect->w;
+    int bottom = rect->y + rect->h;
+    if (fixPosition || (frame->height < bottom) ||
+        (frame->width  < right) ||
+        !display.width() || !display.height())
     {
-        int ysrc = y + bbox.top();
-        for (int x = 0; x < bbox.width(); ++x)
-        {
-            int xsrc = x + bbox.left();
-            const uint8_t color =
-                rect->data[0][ysrc * rect->linesize[0] + xsrc];
-            const uint32_t pixel = *((uint32_t *)rect->data[1] + color);
-            qImage.setPixel(x, y, pixel);
-        }
+        int sd_height = 576;
+        if ((m_player->GetFrameRate() > 26.0f ||
+             m_player->GetFrameRate() < 24.0f) && bottom <= 480)
+            sd_height = 480;
+        int height = ((frame->height <= sd_height) &&
+                      (bottom <= sd_height)) ? sd_height :
+                     ((frame->height <= 720) && bottom <= 720)
+                       ? 720 : 1080;
+        int width  = ((frame->width  <= 720) &&
+                      (right <= 720)) ? 720 :
+                     ((frame->width  <= 1280) &&
+                      (right <= 1280)) ? 1280 : 1920;
+        display = QRect(0, 0, width, height);
     }
+    return display;
+}
 
+// Returns where a cropped part of a bitmap subtitle is shown, allowing
+// for the zoom factor.
+QRect SubtitleScreen::CalcAVSubtitleRect(const AVSubtitleRect *rect,
+                                         QRect bbox, bool top,
+                                         QRect &display) const
+{
     // translate to absolute coordinates
     bbox.translate(rect->x, rect->y);
 
@@ -2055,10 +2181,6 @@ int SubtitleScreen::DisplayScaledAVSubtitles(const AVSubtitleRect *rect,
     VideoOutput *videoOut = m_player->GetVideoOutput();
     QRect scaled = videoOut->GetImageRect(bbox, &display);
 
-    if (scaled.size() != orig_rect.size())
-        qImage = qImage.scaled(scaled.width(), scaled.height(),
-                               Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-
     int hsize = m_safeArea.width();
     int vsize = m_safeArea.height();
 
@@ -2073,8 +2195,24 @@ int SubtitleScreen::DisplayScaledAVSubtitles(const AVSubtitleRect *rect,
         scaled.moveTop(((100 - m_textFontZoom) * vsize +
                         m_textFontZoom * scaled.top()) /
                        100);
+    return scaled;
+}
+
+void SubtitleScreen::DisplayScaledAVSubtitles(
+    const AVSubtitleRect *rect, const SubtitleRenderCache::Bitmap &bitmap,
+    const QString &key, bool top, QRect &display, int forced,
+    QString imagename, long long displayuntil, long long late)
+{
+    if (bitmap.image.isNull())
+        return;
+
+    QRect scaled = CalcAVSubtitleRect(rect, bitmap.bbox, top, display);
 
+    QImage qImage;
+    if (!m_renderCache->TakeImage(avScaleKey(key, scaled.size(), top), qImage))
+        qImage = SubtitleRenderCache::ScaleImage(bitmap.image, scaled.size());
 
+    VideoOutput *videoOut = m_player->GetVideoOutput();
     MythPainter *osd_painter = videoOut->GetOSDPainter();
     MythImage *image = nullptr;
     if (osd_painter)
@@ -2105,8 +2243,6 @@ int SubtitleScreen::DisplayScaledAVSubtitles(const AVSubtitleRect *rect,
             LOG(VB_PLAYBACK, LOG_INFO, LOC +
                 QString("AV Sub was %1ms late").arg(late));
     }
-
-    return (ysplit + 1);
 }
 
 void SubtitleScreen::DisplayTextSubtitles(void)
@@ -2154,16 +2290,20 @@ void SubtitleScreen::DisplayTextSubtitles(void)
         playPos = m_player->GetDecoder()->NormalizeVideoTimecode(currentFrame->timecode);
     }
     playPos -= playPosAdj;
+    if (changed)
+        m_prefetchStart = UINT64_MAX;
     if (playPos != 0)
+    {
         changed |= subs->HasSubtitleChanged(playPos);
+        PrefetchTextSubtitles(subs, playPos);
+    }
     if (!changed)
     {
         subs->Unlock();
         return;
     }
 
-    SetElementDeleted();
-    DeleteAllChildren();
+    QueueClear(kClearAll);
 
     if (playPos == 0)
     {
@@ -2182,6 +2322,24 @@ void SubtitleScreen::DisplayTextSubtitles(void)
     DrawTextSubtitles(rawsubs, 0, 0);
 }
 
+// Rasterizes the next subtitle ahead of its start time, so that it can be
+// shown as soon as it is due.
+void SubtitleScreen::PrefetchTextSubtitles(const TextSubtitles *subs,
+                                           uint64_t playPos)
+{
+    uint64_t start = 0;
+    QStringList next = subs->GetNextSubtitles(playPos, start);
+    if (next.empty() || start == m_prefetchStart)
+        return;
+    m_prefetchStart = start;
+
+    FormattedTextSubtitleSRT fsub(m_family, m_safeArea, 0, 0, this, next);
+    fsub.WrapLongLines();
+    fsub.Layout();
+    fsub.PreRender();
+    fsub.RequestRender();
+}
+
 void SubtitleScreen::DisplayRawTextSubtitles(void)
 {
     if (!m_player || !m_subreader)
@@ -2202,9 +2360,8 @@ void SubtitleScreen::DisplayRawTextSubtitles(void)
 
     m_safeArea = vo->GetSafeRect();
 
-    // delete old subs that may still be on screen
-    DeleteAllChildren();
-    SetElementDeleted();
+    // replace old subs that may still be on screen
+    QueueClear(kClearAll);
     DrawTextSubtitles(subs, currentFrame->timecode, duration);
 }
 
@@ -2232,8 +2389,7 @@ void SubtitleScreen::DisplayCC608Subtitles(void)
     if (!changed)
         return;
 
-    SetElementDeleted();
-    DeleteAllChildren();
+    QueueClear(kClearAll);
 
     if (!textlist)
         return;
@@ -2294,7 +2450,7 @@ void SubtitleScreen::DisplayCC708Subtitles(void)
     }
     if (clearMask)
     {
-        Clear708Cache(clearMask);
+        QueueClear(clearMask);
     }
     if (addList.size())
         m_qInited.append(addList);
@@ -23,6 +23,8 @@ extern "C" {
 #include "mythuishape.h"
 #include "mythuisimpletext.h"
 #include "mythuiimage.h"
+#include "mythtimer.h"
+#include "subtitlerendercache.h"
 
 class SubtitleScreen;
 
@@ -51,6 +53,8 @@ public:
     MythFontProperties *textFont;
     QString textName;
     QRect textRect;
+    // Key of the rasterized text, set by RequestRender().
+    QString imageKey;
 };
 
 class FormattedTextLine
@@ -81,6 +85,8 @@ public:
     virtual void WrapLongLines(void) {}
     virtual void Layout(void);
     virtual void PreRender(void);
+    void RequestRender(void);
+    bool IsRendered(void) const;
     // This is the step that can only be done in the UI thread.
     virtual void Draw(void);
     virtual int CacheNum(void) const { return -1; }
@@ -197,6 +203,9 @@ public:
                      int &left, int &right) const;
     MythFontProperties* GetFont(const CC708CharacterAttribute &attr) const;
     void SetFontSize(int pixelSize) { m_fontSize = pixelSize; }
+    SubtitleRenderCache *GetRenderCache(void) { return m_renderCache; }
+    MythUIType *CreateTextImage(const FormattedTextChunk &chunk,
+                                int whichImageCache, long long expireTime);
 
     // Temporary methods until teletextscreen.cpp is refactored into
     // subtitlescreen.cpp
@@ -208,14 +217,33 @@ public:
     void Pulse(void) override; // MythUIType
 
 private:
+    // Text subtitles that replace what is shown once they are rasterized
+    struct RenderBatch
+    {
+        uint64_t clearMask; // cc708 windows to remove, or everything
+        QList<FormattedTextSubtitle *> subs;
+        MythTimer age;
+    };
+
     void ResetElementState(void);
     void OptimiseDisplayedArea(void);
+    void QueueClear(uint64_t mask);
+    void ApplyBatches(void);
+    void DiscardBatches(void);
     void DisplayAVSubtitles(void);
-    int  DisplayScaledAVSubtitles(const AVSubtitleRect *rect, QRect &bbox,
-                                  bool top, QRect &display, int forced,
+    void PrepareAVSubtitles(const AVSubtitles *subs, const VideoFrame *frame);
+    QRect CalcAVDisplay(const AVSubtitleRect *rect, const VideoFrame *frame,
+                        bool fixPosition) const;
+    QRect CalcAVSubtitleRect(const AVSubtitleRect *rect, QRect bbox,
+                             bool top, QRect &display) const;
+    void DisplayScaledAVSubtitles(const AVSubtitleRect *rect,
+                                  const SubtitleRenderCache::Bitmap &bitmap,
+                                  const QString &key, bool top,
+                                  QRect &display, int forced,
                                   QString imagename,
                                   long long displayuntil, long long late);
     void DisplayTextSubtitles(void);
+    void PrefetchTextSubtitles(const TextSubtitles *subs, uint64_t playPos);
     void DisplayRawTextSubtitles(void);
     void DrawTextSubtitles(const QStringList &subs, uint64_t start,
                            uint64_t duration);
@@ -242,6 +270,10 @@ private:
     QString            m_family; // 608, 708, text, teletext
     // Subtitles initialized but still to be processed and drawn
     QList<FormattedTextSubtitle *> m_qInited;
+    // Subtitles waiting for their text to be rasterized
+    QList<RenderBatch> m_batches;
+    SubtitleRenderCache *m_renderCache;
+    uint64_t           m_prefetchStart;
     class SubtitleFormat *m_format;
 
 #ifdef USING_LIBASS
@@ -0,0 +1,263 @@
+/*
+ *  Class TestFilterChain
+ *
+ *  Benchmarks software video filters through FilterChain, with and without
+ *  slice-parallel execution.
+ *
+ *  By default the filters are fed a synthetic interlaced 1080i pattern.
+ *  Real footage can be used instead by pointing MYTHTV_FILTERBENCH_YV12 at
+ *  a file of raw, unpadded YV12 frames and MYTHTV_FILTERBENCH_SIZE at its
+ *  dimensions (e.g. "1920x1080"). Filters are loaded from the installed
+ *  filters directory unless MYTHTV_FILTERBENCH_DIR names another one.
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <QtTest/QtTest>
+#include <QFile>
+
+#include "mythcorecontext.h"
+#include "mythdirs.h"
+#include "mythframe.h"
+#include "filtermanager.h"
+
+extern "C" {
+#include "libavutil/mem.h"
+}
+
+#define BENCH_FRAMES  8
+#define SYNTH_WIDTH   1920
+#define SYNTH_HEIGHT  1080
+
+class TestFilterChain: public QObject
+{
+    Q_OBJECT
+
+  private:
+    FilterManager       *m_filterManager {nullptr};
+    QVector<VideoFrame>  m_frames;
+    int                  m_width  {SYNTH_WIDTH};
+    int                  m_height {SYNTH_HEIGHT};
+
+    VideoFrame NewFrame(void)
+    {
+        VideoFrame frame;
+        int size = buffersize(FMT_YV12, m_width, m_height);
+        unsigned char *buf = (unsigned char*)av_malloc(size);
+        memset(buf, 0, size);
+        init(&frame, FMT_YV12, buf, m_width, m_height, size);
+        return frame;
+    }
+
+    // Copy an unpadded YV12 image into a (possibly padded) VideoFrame
+    static void FillFrame(VideoFrame &frame, const unsigned char *src)
+    {
+        int widths[3]  = { frame.width,  frame.width  / 2, frame.width  / 2 };
+        int heights[3] = { frame.height, frame.height / 2, frame.height / 2 };
+        for (int plane = 0; plane < 3; plane++)
+        {
+            for (int y = 0; y < heights[plane]; y++)
+            {
+                memcpy(frame.buf + frame.offsets[plane] +
+                       frame.pitches[plane] * y, src, widths[plane]);
+                src += widths[plane];
+            }
+        }
+    }
+
+    bool LoadRawFrames(const QString &filename, const QString &size)
+    {
+        QStringList dims = size.split('x');
+        if (dims.size() != 2)
+            return false;
+        m_width  = dims[0].toInt();
+        m_height = dims[1].toInt();
+        if (m_width < 16 || m_height < 16)
+            return false;
+
+        QFile file(filename);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+
+        int rawsize = m_width * m_height * 3 / 2;
+        while (m_frames.size() < BENCH_FRAMES)
+        {
+            QByteArray raw = file.read(rawsize);
+            if (raw.size() != rawsize)
+                break;
+            VideoFrame frame = NewFrame();
+            FillFrame(frame, (const unsigned char*)raw.constData());
+            m_frames.push_back(frame);
+        }
+        return !m_frames.isEmpty();
+    }
+
+    // Moving diagonal bars, offset between fields so that every line
+    // pair is combed and the deinterlacers have real work to do
+    void SynthesizeFrames(void)
+    {
+        m_width  = SYNTH_WIDTH;
+        m_height = SYNTH_HEIGHT;
+        for (int i = 0; i < BENCH_FRAMES; i++)
+        {
+            VideoFrame frame = NewFrame();
+            for (int y = 0; y < m_height; y++)
+            {
+                unsigned char *line = frame.buf + frame.offsets[0] +
+                                      frame.pitches[0] * y;
+                int shift = i * 8 + ((y & 1) ? 4 : 0);
+                for (int x = 0; x < m_width; x++)
+                    line[x] = (((x + y + shift) >> 4) & 1) ? 235 : 16;
+            }
+            for (int plane = 1; plane < 3; plane++)
+            {
+                for (int y = 0; y < m_height / 2; y++)
+                {
+                    memset(frame.buf + frame.offsets[plane] +
+                           frame.pitches[plane] * y,
+                           128 + ((y + i) & 31) - 16, m_width / 2);
+                }
+            }
+            m_frames.push_back(frame);
+        }
+    }
+
+    FilterChain *LoadChain(const QString &filter, int threads)
+    {
+        VideoFrameType itmp = FMT_YV12;
+        VideoFrameType otmp = FMT_YV12;
+        int width  = m_width;
+        int height = m_height;
+        int bufsize;
+        return m_filterManager->LoadFilters(filter, itmp, otmp, width,
+                                            height, bufsize, threads);
+    }
+
+    void RunChain(FilterChain *chain, VideoFrame &work, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            const VideoFrame &src = m_frames[i % m_frames.size()];
+            memcpy(work.buf, src.buf, src.size);
+            work.frameNumber = i;
+            chain->ProcessFrame(&work, kScan_Interlaced);
+        }
+    }
+
+  private slots:
+    // called at the beginning of these sets of tests
+    void initTestCase(void)
+    {
+        gCoreContext = new MythCoreContext("bin_version", nullptr);
+
+        QString dir = qgetenv("MYTHTV_FILTERBENCH_DIR");
+        if (dir.isEmpty())
+            InitializeMythDirs();
+        m_filterManager = new FilterManager(dir);
+
+        QString raw  = qgetenv("MYTHTV_FILTERBENCH_YV12");
+        QString size = qgetenv("MYTHTV_FILTERBENCH_SIZE");
+        if (raw.isEmpty() || !LoadRawFrames(raw, size))
+            SynthesizeFrames();
+    }
+
+    // called at the end of these sets of tests
+    void cleanupTestCase(void)
+    {
+        for (int i = 0; i < m_frames.size(); i++)
+            av_freep(&m_frames[i].buf);
+        m_frames.clear();
+        delete m_filterManager;
+        m_filterManager = nullptr;
+    }
+
+    void FilterBenchmark_data(void)
+    {
+        QTest::addColumn<QString>("filter");
+        QTest::addColumn<int>("threads");
+
+        QStringList filters;
+        filters << "yadifdeint" << "yadifdoubleprocessdeint"
+                << "denoise3d" << "kerneldeint";
+        foreach (const QString &filter, filters)
+        {
+            for (int threads = 1; threads <= 4; threads *= 2)
+            {
+                QTest::newRow(qPrintable(QString("%1/%2 threads")
+                                         .arg(filter).arg(threads)))
+                    << filter << threads;
+            }
+        }
+    }
+
+    void FilterBenchmark(void)
+    {
+        QFETCH(QString, filter);
+        QFETCH(int, threads);
+
+        if (!m_filterManager->GetFilterInfo(filter))
+            QSKIP("Filter is not installed");
+
+        FilterChain *chain = LoadChain(filter, threads);
+        QVERIFY(chain != nullptr);
+
+        VideoFrame work = NewFrame();
+        QBENCHMARK
+        {
+            RunChain(chain, work, m_frames.size() * 4);
+        }
+
+        delete chain;
+        av_freep(&work.buf);
+    }
+
+    void SlicesMatch_data(void)
+    {
+        QTest::addColumn<QString>("filter");
+
+        QTest::newRow("yadifdeint") << "yadifdeint";
+        QTest::newRow("denoise3d")  << "denoise3d";
+    }
+
+    // Any number of slices must produce the same picture as a single
+    // thread, including the state carried over from earlier frames
+    void SlicesMatch(void)
+    {
+        QFETCH(QString, filter);
+
+        if (!m_filterManager->GetFilterInfo(filter))
+            QSKIP("Filter is not installed");
+
+        FilterChain *single = LoadChain(filter, 1);
+        FilterChain *sliced = LoadChain(filter, 4);
+        QVERIFY(single != nullptr);
+        QVERIFY(sliced != nullptr);
+
+        VideoFrame out1 = NewFrame();
+        VideoFrame out4 = NewFrame();
+        int count = m_frames.size();
+        RunChain(single, out1, count);
+        RunChain(sliced, out4, count);
+
+        bool match = memcmp(out1.buf, out4.buf, out1.size) == 0;
+
+        delete single;
+        delete sliced;
+        av_freep(&out1.buf);
+        av_freep(&out4.buf);
+
+        QVERIFY(match);
+    }
+};
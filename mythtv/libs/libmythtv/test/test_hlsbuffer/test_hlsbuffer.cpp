@@ -0,0 +1,3 @@
+#include "test_hlsbuffer.h"
+
+QTEST_GUILESS_MAIN(TestHLSBuffer)
@@ -0,0 +1,456 @@
+/*
+ *  Class TestHLSBuffer
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include "mythcorecontext.h"
+#include "HLS/httplivestreambuffer.h"
+#include "HLS/hlsadaptation.h"
+
+// The fixture stream has two variants of kSegments one second segments,
+// each segment filled with the variant's marker so the test can tell which
+// one it is reading
+static const int kSegments      = 8;
+static const int kHighBitrate   = 2400000;
+static const int kLowBitrate    = 300000;
+
+/**
+ *  Serves the fixture stream from a local socket, on threads of its own so
+ *  the ring buffer can be driven from the test thread. Every connection
+ *  shares one link of a set bandwidth, and each request waits a set latency
+ *  before it is answered.
+ */
+class HLSFixtureServer
+{
+  public:
+    HLSFixtureServer(void)
+    {
+        m_fd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        struct sockaddr_in addr {};
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = 0;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+        listen(m_fd, 16);
+
+        socklen_t len = sizeof(addr);
+        getsockname(m_fd, reinterpret_cast<struct sockaddr *>(&addr), &len);
+        m_port = ntohs(addr.sin_port);
+
+        m_thread = std::thread([this]() { Accept(); });
+    }
+
+    ~HLSFixtureServer()
+    {
+        m_stop = true;
+        shutdown(m_fd, SHUT_RDWR);
+        close(m_fd);
+        m_thread.join();
+        // let connections still being answered finish
+        while (m_connections > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    /// bits per second shared by all connections, 0 for unlimited
+    void SetBandwidth(int bandwidth)    { m_bandwidth = bandwidth; }
+    void SetLatency(int ms)             { m_latency = ms; }
+    int  Requests(void) const           { return m_requests; }
+
+    /// Url of the master playlist, under a path of its own so nothing
+    /// cached by an earlier test is used
+    QString Url(const QString &name) const
+    {
+        return QString("http://127.0.0.1:%1/%2/master.m3u8")
+            .arg(m_port).arg(name);
+    }
+
+  private:
+    void Accept(void)
+    {
+        while (!m_stop)
+        {
+            int fd = accept(m_fd, nullptr, nullptr);
+            if (fd < 0)
+                continue;
+            m_connections++;
+            std::thread([this, fd]()
+            {
+                Serve(fd);
+                close(fd);
+                m_connections--;
+            }).detach();
+        }
+    }
+
+    void Serve(int fd)
+    {
+        QByteArray request;
+        char buf[4096];
+        while (!request.contains("\r\n\r\n"))
+        {
+            ssize_t len = read(fd, buf, sizeof(buf));
+            if (len <= 0)
+                return;
+            request.append(buf, len);
+        }
+        m_requests++;
+
+        // GET /<name>/<file> HTTP/1.1
+        QString path = QString(request).section(' ', 1, 1);
+        QByteArray body = Content(path.section('/', 2));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(m_latency));
+
+        QByteArray header = QString("HTTP/1.1 %1\r\n"
+                                    "Content-Length: %2\r\n"
+                                    "Cache-Control: no-store\r\n"
+                                    "Connection: close\r\n\r\n")
+            .arg(body.isNull() ? "404 Not Found" : "200 OK")
+            .arg(body.size()).toLatin1();
+        Send(fd, header);
+        Send(fd, body);
+    }
+
+    static QByteArray Content(const QString &file)
+    {
+        if (file == "master.m3u8")
+        {
+            return QString("#EXTM3U\n"
+                           "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%1\n"
+                           "high.m3u8\n"
+                           "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%2\n"
+                           "low.m3u8\n")
+                .arg(kHighBitrate).arg(kLowBitrate).toLatin1();
+        }
+
+        if (file == "high.m3u8" || file == "low.m3u8")
+        {
+            QString variant = file.section('.', 0, 0);
+            QString playlist = "#EXTM3U\n"
+                               "#EXT-X-TARGETDURATION:1\n"
+                               "#EXT-X-MEDIA-SEQUENCE:0\n";
+            for (int i = 0; i < kSegments; i++)
+                playlist += QString("#EXTINF:1,\n%1/%2.ts\n").arg(variant).arg(i);
+            playlist += "#EXT-X-ENDLIST\n";
+            return playlist.toLatin1();
+        }
+
+        if (file.startsWith("high/"))
+            return QByteArray(kHighBitrate / 8, 'H');
+        if (file.startsWith("low/"))
+            return QByteArray(kLowBitrate / 8, 'L');
+
+        return QByteArray();
+    }
+
+    /// Sends the data at the link's bandwidth, sharing it with the other
+    /// connections
+    void Send(int fd, const QByteArray &data)
+    {
+        static const int kChunk = 4096;
+
+        for (int sent = 0; sent < data.size(); sent += kChunk)
+        {
+            int len = std::min(kChunk, data.size() - sent);
+            if (m_bandwidth > 0)
+            {
+                std::chrono::steady_clock::time_point until;
+                {
+                    std::lock_guard<std::mutex> locker(m_linkLock);
+                    m_linkFree = std::max(m_linkFree,
+                                          std::chrono::steady_clock::now());
+                    m_linkFree += std::chrono::microseconds(
+                        len * 8LL * 1000000 / m_bandwidth);
+                    until = m_linkFree;
+                }
+                std::this_thread::sleep_until(until);
+            }
+            if (write(fd, data.constData() + sent, len) != len)
+                return;
+        }
+    }
+
+    int                 m_fd          {-1};
+    quint16             m_port        {0};
+    std::thread         m_thread;
+    std::atomic<bool>   m_stop        {false};
+    std::atomic<int>    m_connections {0};
+    std::atomic<int>    m_requests    {0};
+    std::atomic<int>    m_bandwidth   {0};
+    std::atomic<int>    m_latency     {0};
+    std::mutex          m_linkLock;
+    std::chrono::steady_clock::time_point m_linkFree;
+};
+
+class TestHLSBuffer : public QObject
+{
+    Q_OBJECT
+
+    /// What a player reading the stream saw
+    struct Playback
+    {
+        qint64  m_bytes      {0};
+        char    m_last       {0};       // marker of the last segment read
+        qint64  m_maxBuffered{0};
+    };
+
+    /**
+     *  Reads the whole stream, at the speed it plays unless [paced] is
+     *  false. Returns what was read.
+     */
+    static Playback Play(HLSRingBuffer &buffer, bool paced)
+    {
+        Playback playback;
+        QElapsedTimer timer;
+        timer.start();
+        qint64 played = 0;  // ms of media read
+        char data[16 * 1024];
+
+        while (timer.elapsed() < 60000)
+        {
+            int duration = buffer.DurationForBytes(sizeof(data));
+            int len = buffer.Read(data, sizeof(data));
+            if (len <= 0)
+                break;
+
+            playback.m_bytes += len;
+            playback.m_last = data[len - 1];
+            playback.m_maxBuffered = std::max(playback.m_maxBuffered,
+                                              (qint64)buffer.BufferedBytes());
+
+            played += (qint64)duration * len / sizeof(data);
+            if (paced && played > timer.elapsed())
+                QThread::msleep(played - timer.elapsed());
+        }
+        return playback;
+    }
+
+    /// Start-up and rebuffering depend on the machine's load, so the
+    /// tests measuring them only run when asked for
+    static bool Benchmark(void)
+    {
+        return qEnvironmentVariableIsSet("MYTHTV_HLSBENCH");
+    }
+
+    static QString Describe(const HLSRingBuffer &buffer)
+    {
+        return QString("startup %1 ms, %2 rebuffers")
+            .arg(buffer.StartupTime()).arg(buffer.RebufferCount());
+    }
+
+  private slots:
+    void initTestCase(void)
+    {
+        gCoreContext = new MythCoreContext("bin_version", nullptr);
+        m_server = new HLSFixtureServer();
+    }
+
+    void cleanupTestCase(void)
+    {
+        delete m_server;
+        m_server = nullptr;
+    }
+
+    void EstimateStartsAtZero(void)
+    {
+        HLSBandwidthEstimate estimate;
+        QCOMPARE(estimate.Estimate(), (uint64_t)0);
+    }
+
+    /// The first samples aren't pulled towards the averages' start at 0
+    void EstimateOfSteadyBandwidth(void)
+    {
+        HLSBandwidthEstimate estimate;
+        estimate.AddSample(1, 1000000);
+        QVERIFY(qAbs((qint64)estimate.Estimate() - 1000000) <= 1);
+
+        for (int i = 0; i < 10; i++)
+            estimate.AddSample(1, 1000000);
+        QVERIFY(qAbs((qint64)estimate.Estimate() - 1000000) <= 1);
+    }
+
+    /// Two seconds of a slower network take the estimate at least halfway
+    /// down to it
+    void EstimateFollowsDrop(void)
+    {
+        HLSBandwidthEstimate estimate;
+        for (int i = 0; i < 10; i++)
+            estimate.AddSample(1, 4000000);
+        estimate.AddSample(2, 1000000);
+        QVERIFY(estimate.Estimate() < 2500000);
+        QVERIFY(estimate.Estimate() > 1000000);
+    }
+
+    /// One quick segment doesn't make the estimate jump up
+    void EstimateIgnoresSpike(void)
+    {
+        HLSBandwidthEstimate estimate;
+        for (int i = 0; i < 10; i++)
+            estimate.AddSample(1, 1000000);
+        estimate.AddSample(1, 10000000);
+        QVERIFY(estimate.Estimate() > 1000000);
+        QVERIFY(estimate.Estimate() < 3000000);
+    }
+
+    /// Samples count for the duration of their segment
+    void EstimateWeightsByDuration(void)
+    {
+        HLSBandwidthEstimate longfast;
+        longfast.AddSample(1, 1000000);
+        longfast.AddSample(4, 4000000);
+
+        HLSBandwidthEstimate shortfast;
+        shortfast.AddSample(4, 1000000);
+        shortfast.AddSample(1, 4000000);
+
+        QVERIFY(longfast.Estimate() > shortfast.Estimate());
+
+        // segments without a duration count as one second
+        HLSBandwidthEstimate zero;
+        zero.AddSample(0, 1000000);
+        QVERIFY(qAbs((qint64)zero.Estimate() - 1000000) <= 1);
+    }
+
+    void ChooseStream_data(void)
+    {
+        QTest::addColumn<uint64_t>("bandwidth");
+        QTest::addColumn<int>("stream");
+
+        // kHighBitrate fits exactly into PLAYBACK_HEADROOM of this
+        uint64_t fits = (uint64_t)kHighBitrate * 100 / PLAYBACK_HEADROOM;
+
+        QTest::newRow("plenty")      << fits * 10 << 0;
+        QTest::newRow("headroom")    << fits      << 0;
+        QTest::newRow("no headroom") << fits - 1  << 1;
+        QTest::newRow("none fit")    << (uint64_t)1000 << 1;
+        QTest::newRow("unknown")     << (uint64_t)0    << 1;
+    }
+
+    /// The best stream that leaves some bandwidth spare, or the lowest
+    void ChooseStream(void)
+    {
+        QFETCH(uint64_t, bandwidth);
+        QFETCH(int, stream);
+
+        QMap<int,uint64_t> bitrates;
+        bitrates.insert(0, kHighBitrate);
+        bitrates.insert(1, kLowBitrate);
+        QCOMPARE(HLSChooseStream(bitrates, bandwidth), stream);
+    }
+
+    /// Streams are known by their number, which needn't start at 0
+    void ChooseStreamNumbers(void)
+    {
+        QMap<int,uint64_t> bitrates;
+        QCOMPARE(HLSChooseStream(bitrates, 10000000), -1);
+
+        bitrates.insert(3, 500000);
+        bitrates.insert(5, 1000000);
+        bitrates.insert(7, 20000000);
+        QCOMPARE(HLSChooseStream(bitrates, 10000000), 5);
+        QCOMPARE(HLSChooseStream(bitrates, 100000), 3);
+    }
+
+    /**
+     * On a fast link playback starts quickly, never waits for data and
+     * stays on the best variant
+     */
+    void FastNetwork(void)
+    {
+        if (!Benchmark())
+            QSKIP("Set MYTHTV_HLSBENCH to measure start-up and rebuffering");
+
+        m_server->SetBandwidth(0);
+        m_server->SetLatency(50);
+
+        HLSRingBuffer buffer(m_server->Url("fast"), false);
+        QVERIFY(buffer.OpenFile(m_server->Url("fast")));
+        QVERIFY(buffer.StartupTime() >= 0);
+        QVERIFY2(buffer.StartupTime() < 2000, qPrintable(Describe(buffer)));
+
+        Playback playback = Play(buffer, true);
+
+        QCOMPARE(playback.m_bytes, (qint64)kSegments * kHighBitrate / 8);
+        QCOMPARE(playback.m_last, 'H');
+        QVERIFY2(buffer.RebufferCount() == 0, qPrintable(Describe(buffer)));
+    }
+
+    /**
+     * When the best variant doesn't fit the link, the bandwidth estimate
+     * moves playback to the one that does before the buffer runs out
+     */
+    void SlowNetwork(void)
+    {
+        if (!Benchmark())
+            QSKIP("Set MYTHTV_HLSBENCH to measure start-up and rebuffering");
+
+        m_server->SetBandwidth(2000000);
+        m_server->SetLatency(50);
+
+        HLSRingBuffer buffer(m_server->Url("slow"), false);
+        QVERIFY(buffer.OpenFile(m_server->Url("slow")));
+        QVERIFY(buffer.StartupTime() >= 0);
+
+        Playback playback = Play(buffer, true);
+
+        QCOMPARE(playback.m_last, 'L');
+        QVERIFY2(buffer.RebufferCount() <= 1, qPrintable(Describe(buffer)));
+    }
+
+    /**
+     * The segments held in memory stay within the buffer size, give or
+     * take the segment playback needs next. Nothing here depends on
+     * timing: the stream is served and read as fast as possible.
+     */
+    void BoundedMemory(void)
+    {
+        static const int kSegmentSize = kHighBitrate / 8;
+        static const int kLimit       = 2 * kSegmentSize + kSegmentSize / 2;
+
+        m_server->SetBandwidth(0);
+        m_server->SetLatency(0);
+
+        HLSRingBuffer buffer(m_server->Url("bounded"), false);
+        buffer.SetMaxBufferedBytes(kLimit);
+        QVERIFY(buffer.OpenFile(m_server->Url("bounded")));
+
+        Playback playback = Play(buffer, false);
+
+        QCOMPARE(playback.m_bytes, (qint64)kSegments * kSegmentSize);
+        QVERIFY(playback.m_maxBuffered <= kLimit + kSegmentSize);
+    }
+
+  private:
+    HLSFixtureServer   *m_server {nullptr};
+};
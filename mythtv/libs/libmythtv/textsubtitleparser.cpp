@@ -251,6 +251,31 @@ QStringList TextSubtitles::GetSubtitles(uint64_t timecode)
     return list;
 }
 
+/** \fn TextSubtitles::GetNextSubtitles(uint64_t, uint64_t&) const
+ *  \brief Returns the first subtitle that starts after the given timecode.
+ *
+ *  Unlike GetSubtitles() this does not change what HasSubtitleChanged()
+ *  reports, so it can be used to prepare upcoming subtitles early.
+ *
+ *  \param timecode The timecode (frame number or time stamp) of the
+ *         current video position.
+ *  \param start Set to the timecode the subtitle starts at.
+ *  \return The subtitles as a list of strings, empty if there is none.
+ */
+QStringList TextSubtitles::GetNextSubtitles(uint64_t timecode,
+                                            uint64_t &start) const
+{
+    text_subtitle_t searchTarget(timecode + 1, timecode + 1);
+
+    TextSubtitleList::const_iterator nextSubPos =
+        lower_bound(m_subtitles.begin(), m_subtitles.end(), searchTarget);
+    if (nextSubPos == m_subtitles.end())
+        return QStringList();
+
+    start = (*nextSubPos).start;
+    return (*nextSubPos).textLines;
+}
+
 void TextSubtitles::AddSubtitle(const text_subtitle_t &newSub)
 {
     QMutexLocker locker(&m_lock);
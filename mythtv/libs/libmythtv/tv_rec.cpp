@@ -1093,6 +1093,14 @@ void TVRec::HandleStateChange(void)
     internalState = nextState;
     changeState = false;
 
+    // ENCODER_STATE inputid state
+    if (changed)
+    {
+        gCoreContext->SendEvent(MythEvent(QString("ENCODER_STATE %1 %2")
+                                          .arg(inputid)
+                                          .arg(StateToString(internalState))));
+    }
+
     eitScanStartTime = MythDate::current();
     if (scanner && (internalState == kState_None))
     {
@@ -204,6 +204,19 @@ void MythPainter::DrawTextPriv(MythImage *im, const QString &msg, int flags,
     if (!im)
         return;
 
+    im->Assign(RenderText(msg, flags, r, font));
+}
+
+/** \fn MythPainter::RenderText(const QString&, int, const QRect&, const MythFontProperties&)
+ *  \brief Rasterizes \p msg, with the font's shadow and outline, into an
+ *         image the size of \p r.
+ *
+ *  This only uses QImage and QPainter, so it may be called from any thread
+ *  to prepare text ahead of time.
+ */
+QImage MythPainter::RenderText(const QString &msg, int flags, const QRect &r,
+                               const MythFontProperties &font)
+{
     QColor outlineColor;
     int outlineSize = 0;
     int outlineAlpha;
@@ -308,7 +321,7 @@ void MythPainter::DrawTextPriv(MythImage *im, const QString &msg, int flags,
     tmp.drawText(textOffsetX, textOffsetY, r.width(), r.height(),
                  flags, msg);
     tmp.end();
-    im->Assign(pm);
+    return pm;
 }
 
 void MythPainter::DrawRectPriv(MythImage *im, const QRect &area, int radius,
@@ -2,6 +2,7 @@
 #define MYTHPAINTER_H_
 
 #include <QMap>
+#include <QImage>
 #include <QString>
 #include <QTextLayout>
 #include <QWidget>
@@ -98,6 +99,9 @@ class MUI_PUBLIC MythPainter
 
     void SetMaximumCacheSizes(int hardware, int software);
 
+    static QImage RenderText(const QString &msg, int flags, const QRect &r,
+                             const MythFontProperties &font);
+
   protected:
     void DrawTextPriv(MythImage *im, const QString &msg, int flags,
                       const QRect &r, const MythFontProperties &font);
@@ -0,0 +1,379 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: httpkeepalive.cpp
+// Created     : Oct. 19, 2026
+//
+// Purpose     : Holds idle HTTP connections until their next request
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// Own headers
+#include "httpkeepalive.h"
+
+// POSIX headers
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+// Qt headers
+#include <QTcpSocket>
+#include <QThread>
+#include <QList>
+
+// MythTV headers
+#include "httpserver.h"
+#include "mythlogging.h"
+
+#define LOC QString("HttpKeepAlive: ")
+
+// Events handled per epoll_wait() call
+static const int kMaxEvents = 256;
+
+// A request head that has not ended after this many bytes is handed to a
+// worker anyway, which will reject it if it is really that long
+static const int kPeekSize  = 8 * 1024;
+
+typedef enum
+{
+    kRequestWaiting = 0,
+    kRequestReady   = 1,
+    kRequestClosed  = 2
+} RequestState;
+
+/////////////////////////////////////////////////////////////////////////////
+// Looks at what the client has sent, without reading it, to see if the
+// head of a request is complete. Encrypted data can't be looked into, so
+// any data at all is enough for an SSL connection.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifdef __linux__
+static RequestState PeekRequest( const HttpConnection *pConnection )
+{
+    char    aBuffer[ kPeekSize ];
+    ssize_t nBytes = recv( pConnection->m_nSocket, aBuffer, sizeof( aBuffer ),
+                           MSG_PEEK | MSG_DONTWAIT );
+
+    if (nBytes == 0)
+        return kRequestClosed;
+
+    if (nBytes < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            return kRequestWaiting;
+        return kRequestClosed;
+    }
+
+    if (pConnection->m_eType == kSSLServer || nBytes == sizeof( aBuffer ))
+        return kRequestReady;
+
+    QByteArray sHead = QByteArray::fromRawData( aBuffer, nBytes );
+
+    if (sHead.contains( "\r\n\r\n" ) || sHead.contains( "\n\n" ))
+        return kRequestReady;
+
+    return kRequestWaiting;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+HttpKeepAlive::HttpKeepAlive( HttpServer &httpServer )
+  : MThread      ( "HttpKeepAlive" ),
+    m_httpServer ( httpServer ),
+    m_nEpoll     ( -1 ),
+    m_nWakeup    ( -1 ),
+    m_bRunning   ( false )
+{
+    m_clock.start();
+
+#ifdef __linux__
+    m_nEpoll  = epoll_create1( EPOLL_CLOEXEC );
+    m_nWakeup = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+    if (m_nEpoll >= 0 && m_nWakeup >= 0)
+    {
+        struct epoll_event event;
+        memset( &event, 0, sizeof( event ));
+        event.events  = EPOLLIN;
+        event.data.fd = m_nWakeup;
+
+        m_bRunning = (epoll_ctl( m_nEpoll, EPOLL_CTL_ADD,
+                                 m_nWakeup, &event ) == 0);
+    }
+
+    if (m_bRunning)
+        start();
+    else
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to create epoll instance, "
+            "idle connections will each hold a worker thread" + ENO);
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+HttpKeepAlive::~HttpKeepAlive()
+{
+    Stop();
+
+#ifdef __linux__
+    if (m_nWakeup >= 0)
+        close( m_nWakeup );
+    if (m_nEpoll >= 0)
+        close( m_nEpoll );
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Takes over a connection until its next request arrives. Returns false if
+// the connection can't be parked, it then remains the caller's.
+/////////////////////////////////////////////////////////////////////////////
+
+bool HttpKeepAlive::Park( HttpConnection *pConnection )
+{
+#ifdef __linux__
+    QMutexLocker locker( &m_lock );
+
+    if (!m_bRunning)
+        return false;
+
+    int nSocket = pConnection->m_nSocket;
+
+    // Edge triggered, so a partial request head is looked at again only
+    // once more of it has arrived
+    struct epoll_event event;
+    memset( &event, 0, sizeof( event ));
+    event.events  = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    event.data.fd = nSocket;
+
+    if (epoll_ctl( m_nEpoll, EPOLL_CTL_ADD, nSocket, &event ) < 0)
+    {
+        LOG(VB_HTTP, LOG_ERR, LOC + QString("Unable to park connection %1")
+                                        .arg(nSocket) + ENO);
+        return false;
+    }
+
+    pConnection->m_nDeadline = m_clock.elapsed() + pConnection->m_nTimeout;
+
+    bool bEarliest = m_deadlines.isEmpty() ||
+                     pConnection->m_nDeadline < m_deadlines.firstKey();
+
+    m_connections.insert( nSocket, pConnection );
+    m_deadlines.insert( pConnection->m_nDeadline, nSocket );
+
+    // The epoll thread may be waiting without a timeout, or for a later
+    // deadline, so have it work out how long to wait again
+    if (bEarliest)
+    {
+        uint64_t nWake = 1;
+        if (write( m_nWakeup, &nWake, sizeof( nWake )) < 0 && errno != EAGAIN)
+            LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to wake epoll thread" + ENO);
+    }
+
+    return true;
+#else
+    Q_UNUSED( pConnection );
+    return false;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Stops parking connections, and closes the ones that are still parked.
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpKeepAlive::Stop( void )
+{
+    {
+        QMutexLocker locker( &m_lock );
+
+        if (!m_bRunning)
+            return;
+
+        m_bRunning = false;
+    }
+
+#ifdef __linux__
+    uint64_t nWake = 1;
+    if (write( m_nWakeup, &nWake, sizeof( nWake )) < 0)
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to wake epoll thread" + ENO);
+#endif
+
+    wait();
+
+    QList< HttpConnection* > parked;
+
+    m_lock.lock();
+    parked = m_connections.values();
+    m_connections.clear();
+    m_deadlines.clear();
+    m_lock.unlock();
+
+    for (int nIdx = 0; nIdx < parked.size(); ++nIdx)
+        Close( parked[ nIdx ] );
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+int HttpKeepAlive::Count( void ) const
+{
+    QMutexLocker locker( &m_lock );
+
+    return m_connections.size();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Must be called with m_lock held.
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpKeepAlive::Remove( HttpConnection *pConnection )
+{
+    int nSocket = pConnection->m_nSocket;
+
+#ifdef __linux__
+    epoll_ctl( m_nEpoll, EPOLL_CTL_DEL, nSocket, nullptr );
+#endif
+
+    m_connections.remove( nSocket );
+    m_deadlines.remove( pConnection->m_nDeadline, nSocket );
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpKeepAlive::Close( HttpConnection *pConnection )
+{
+    LOG(VB_HTTP, LOG_INFO, LOC + QString("Connection %1 closed. "
+                                         "%2 requests were handled")
+                                    .arg(pConnection->m_nSocket)
+                                    .arg(pConnection->m_nRequestsHandled));
+
+    if (pConnection->m_pSocket != nullptr)
+    {
+        // A parked socket belongs to no thread, so it can be taken over
+        pConnection->m_pSocket->moveToThread( QThread::currentThread() );
+        pConnection->m_pSocket->close();
+        delete pConnection->m_pSocket;
+    }
+#ifdef __linux__
+    else
+        close( pConnection->m_nSocket );
+#endif
+
+    delete pConnection;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpKeepAlive::run( void )
+{
+    RunProlog();
+
+#ifdef __linux__
+    struct epoll_event aEvents[ kMaxEvents ];
+
+    while (true)
+    {
+        int nWait = -1;
+
+        m_lock.lock();
+        bool bRunning = m_bRunning;
+        if (!m_deadlines.isEmpty())
+            nWait = int(qMax( m_deadlines.firstKey() - m_clock.elapsed(),
+                              qint64(0) ));
+        m_lock.unlock();
+
+        if (!bRunning)
+            break;
+
+        int nEvents = epoll_wait( m_nEpoll, aEvents, kMaxEvents, nWait );
+
+        if (nEvents < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            LOG(VB_GENERAL, LOG_ERR, LOC + "epoll_wait() failed" + ENO);
+            break;
+        }
+
+        QList< HttpConnection* > ready;
+        QList< HttpConnection* > closed;
+
+        m_lock.lock();
+
+        for (int nIdx = 0; nIdx < nEvents; ++nIdx)
+        {
+            int nSocket = aEvents[ nIdx ].data.fd;
+
+            if (nSocket == m_nWakeup)
+            {
+                uint64_t nWake;
+                ssize_t  nRead = read( m_nWakeup, &nWake, sizeof( nWake ));
+                Q_UNUSED( nRead );
+                continue;
+            }
+
+            HttpConnection *pConnection = m_connections.value( nSocket );
+
+            if (pConnection == nullptr)
+                continue;
+
+            RequestState eState = kRequestClosed;
+
+            if ((aEvents[ nIdx ].events & (EPOLLERR | EPOLLHUP)) == 0)
+                eState = PeekRequest( pConnection );
+
+            if (eState == kRequestWaiting)
+                continue;
+
+            Remove( pConnection );
+
+            if (eState == kRequestReady)
+                ready.append( pConnection );
+            else
+                closed.append( pConnection );
+        }
+
+        qint64 nNow = m_clock.elapsed();
+
+        while (!m_deadlines.isEmpty() && m_deadlines.firstKey() <= nNow)
+        {
+            HttpConnection *pConnection =
+                m_connections.value( m_deadlines.first() );
+
+            if (pConnection == nullptr)
+            {
+                m_deadlines.erase( m_deadlines.begin() );
+                continue;
+            }
+
+            Remove( pConnection );
+            closed.append( pConnection );
+        }
+
+        m_lock.unlock();
+
+        for (int nIdx = 0; nIdx < ready.size(); ++nIdx)
+            m_httpServer.ResumeConnection( ready[ nIdx ] );
+
+        for (int nIdx = 0; nIdx < closed.size(); ++nIdx)
+            Close( closed[ nIdx ] );
+    }
+#endif
+
+    RunEpilog();
+}
@@ -0,0 +1,106 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: httpkeepalive.h
+// Created     : Oct. 19, 2026
+//
+// Purpose     : Holds idle HTTP connections until their next request
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HTTPKEEPALIVE_H_
+#define HTTPKEEPALIVE_H_
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QMultiMap>
+#include <QMutex>
+#include <QHash>
+
+// MythTV headers
+#include "mythqtcompat.h"
+#include "serverpool.h"
+#include "mthread.h"
+
+class QTcpSocket;
+class HttpServer;
+
+/////////////////////////////////////////////////////////////////////////////
+// HttpConnection
+//
+// A client connection while no worker is handling it. Until the first
+// request has been read there is only the descriptor, afterwards the
+// socket is kept so SSL and keep-alive state carry over between workers.
+/////////////////////////////////////////////////////////////////////////////
+
+class HttpConnection
+{
+    public:
+
+        HttpConnection( qt_socket_fd_t nSocket, PoolServerType eType )
+          : m_nSocket         ( nSocket ),
+            m_eType           ( eType   ),
+            m_pSocket         ( nullptr ),
+            m_bEncrypted      ( false   ),
+            m_nRequestsHandled( 0       ),
+            m_nTimeout        ( 5000    ),
+            m_nDeadline       ( 0       ) {}
+
+        qt_socket_fd_t  m_nSocket;
+        PoolServerType  m_eType;
+        QTcpSocket     *m_pSocket;          // Not owned by any thread
+        bool            m_bEncrypted;
+        int             m_nRequestsHandled;
+        int             m_nTimeout;         // Idle msecs before closing
+        qint64          m_nDeadline;        // Used by HttpKeepAlive
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// HttpKeepAlive
+//
+// Connections are parked here between requests instead of keeping a pool
+// thread blocked in waitForReadyRead() for as long as the client stays
+// connected. One thread waits on all of them with epoll, and hands a
+// connection back to the HttpServer once the head of its next request has
+// arrived, or closes it when the client hangs up or its keep-alive timeout
+// runs out.
+//
+// Only Linux has epoll; elsewhere Park() refuses every connection, and the
+// workers keep waiting on their connections themselves as before.
+/////////////////////////////////////////////////////////////////////////////
+
+class HttpKeepAlive : public MThread
+{
+    public:
+
+        explicit HttpKeepAlive( HttpServer &httpServer );
+        virtual ~HttpKeepAlive();
+
+        bool Park  ( HttpConnection *pConnection );
+        void Stop  ( void );
+        int  Count ( void ) const;
+
+        static void Close( HttpConnection *pConnection );
+
+    protected:
+
+        void run( void ) override; // MThread
+
+    private:
+
+        Q_DISABLE_COPY( HttpKeepAlive )
+
+        void Remove( HttpConnection *pConnection );
+
+        HttpServer                       &m_httpServer;
+        int                               m_nEpoll;
+        int                               m_nWakeup;
+        QElapsedTimer                     m_clock;
+
+        mutable QMutex                    m_lock;
+        bool                              m_bRunning;    // protected by m_lock
+        QHash< int, HttpConnection* >     m_connections; // protected by m_lock
+        QMultiMap< qint64, int >          m_deadlines;   // protected by m_lock
+};
+
+#endif
@@ -46,6 +46,7 @@
 #include "mythcorecontext.h"
 #include "mythtimer.h"
 #include "mythcoreutil.h"
+#include "httpresponsestream.h"
 
 #include "serializers/xmlSerializer.h"
 #include "serializers/soapSerializer.h"
@@ -172,6 +173,7 @@ HTTPRequest::HTTPRequest() : m_procReqLineExp ( "[ \r\n][ \r\n]*"  ),
                              m_eResponseType  ( ResponseTypeUnknown),
                              m_nResponseStatus( 200 ),
                              m_pPostProcess   ( nullptr ),
+                             m_pResponseStream( nullptr ),
                              m_bKeepAlive     ( true ),
                              m_nKeepAliveTimeout ( 0 )
 {
@@ -182,6 +184,15 @@ HTTPRequest::HTTPRequest() : m_procReqLineExp ( "[ \r\n][ \r\n]*"  ),
 //
 /////////////////////////////////////////////////////////////////////////////
 
+HTTPRequest::~HTTPRequest()
+{
+    delete m_pResponseStream;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
 RequestType HTTPRequest::SetRequestType( const QString &sType )
 {
     // HTTP
@@ -252,7 +263,11 @@ QString HTTPRequest::BuildResponseHeader( long long nSize )
             SetResponseHeader("Content-Disposition", QString("inline; filename=\"%2\"").arg(QString(filename.toLatin1())));
         }
 
-        SetResponseHeader("Content-Length", QString::number(nSize));
+        // A negative size is a response streamed while it is produced
+        if (nSize < 0)
+            SetResponseHeader("Transfer-Encoding", "chunked");
+        else
+            SetResponseHeader("Content-Length", QString::number(nSize));
 
         // See DLNA  7.4.1.3.11.4.3 Tolerance to unavailable contentFeatures.dlna.org header
         //
@@ -320,6 +335,27 @@ qint64 HTTPRequest::SendResponse( void )
 {
     qint64      nBytes    = 0;
 
+    // ----------------------------------------------------------------------
+    // A serializer has already sent most of a large response, finish it.
+    // One that stayed small is sent below, like any other.
+    // ----------------------------------------------------------------------
+
+    if (m_pResponseStream != nullptr)
+    {
+        if (m_pResponseStream->IsStreaming())
+        {
+            LOG(VB_HTTP, LOG_INFO,
+                QString("HTTPRequest::SendResponse( Streamed ) :%1 -> %2:")
+                    .arg(GetResponseStatus()) .arg(GetPeerAddress()));
+            return m_pResponseStream->Finish();
+        }
+
+        QByteArray buffered = m_pResponseStream->TakeBuffered();
+
+        if (m_response.buffer().isEmpty())
+            m_response.buffer() = buffered;
+    }
+
     switch( m_eResponseType )
     {
         // The following are all eligable for gzip compression
@@ -426,7 +462,11 @@ qint64 HTTPRequest::SendResponse( void )
 
     if (( nContentLen > 0 ) && m_mapHeaders[ "accept-encoding" ].contains( "gzip" ))
     {
-        QByteArray compressed = gzipCompress( m_response.buffer() );
+        QByteArray compressed = m_gzipResponse;
+
+        if (compressed.isEmpty())
+            compressed = gzipCompress( m_response.buffer() );
+
         compBuffer.setData( compressed );
 
         if (!compBuffer.buffer().isEmpty())
@@ -489,6 +529,26 @@ qint64 HTTPRequest::SendResponse( void )
     return( nBytes );
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// Sends the headers of a response whose body follows in chunks, see
+// HTTPResponseStream
+/////////////////////////////////////////////////////////////////////////////
+
+qint64 HTTPRequest::SendChunkedHeader( bool bGzip )
+{
+    if (bGzip)
+        SetResponseHeader( "Content-Encoding", "gzip" );
+
+    QByteArray sHeader = BuildResponseHeader( -1 ).toUtf8();
+
+    qint64 nBytes = WriteBlock( sHeader.constData(), sHeader.length() );
+
+    if (nBytes < sHeader.length())
+        return -1;
+
+    return nBytes;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //
 /////////////////////////////////////////////////////////////////////////////
@@ -1765,20 +1825,52 @@ Serializer *HTTPRequest::GetSerializer()
     {
         QString sAccept = GetRequestHeader( "Accept", "*/*" );
 
-        if (sAccept.contains( "application/json", Qt::CaseInsensitive ))
-            pSerializer = (Serializer *)new JSONSerializer(&m_response,
-                                                           m_sMethod);
-        else if (sAccept.contains( "text/javascript", Qt::CaseInsensitive ))
-            pSerializer = (Serializer *)new JSONSerializer(&m_response,
-                                                           m_sMethod);
-        else if (sAccept.contains( "text/x-apple-plist+xml", Qt::CaseInsensitive ))
+        if (sAccept.contains( "text/x-apple-plist+xml", Qt::CaseInsensitive ))
             pSerializer = (Serializer *)new XmlPListSerializer(&m_response);
-    }
+        else
+        {
+            // JSON and XML responses can be large, so they are streamed
+            // to HTTP/1.1 clients, which understand chunked responses.
+
+            QIODevice *pDevice = &m_response;
+
+            bool bChunked = (m_eType != RequestTypeHead) &&
+                            ((m_nMajor > 1) ||
+                             (m_nMajor == 1 && m_nMinor >= 1));
+
+            if (bChunked && m_pResponseStream == nullptr)
+            {
+                bool bGzip = m_mapHeaders[ "accept-encoding" ].contains( "gzip" );
+
+                m_pResponseStream = new HTTPResponseStream( this, bGzip );
+                pDevice = m_pResponseStream;
+            }
+
+            if (sAccept.contains( "application/json", Qt::CaseInsensitive ) ||
+                sAccept.contains( "text/javascript", Qt::CaseInsensitive ))
+                pSerializer = (Serializer *)new JSONSerializer(pDevice,
+                                                               m_sMethod);
+            else
+                pSerializer = (Serializer *)new XmlSerializer(pDevice,
+                                                              m_sMethod);
 
-    // Default to XML
+            // The headers of a streamed response go out with its first
+            // chunk, before FormatActionResponse() is called, so they are
+            // set here. Its body isn't complete yet, so it has no content
+            // hash ETag. One that turns out small enough to be sent whole
+            // gets the ETag from FormatActionResponse().
 
-    if (pSerializer == nullptr)
-        pSerializer = (Serializer *)new XmlSerializer(&m_response, m_sMethod);
+            if (pDevice == m_pResponseStream)
+            {
+                m_eResponseType     = ResponseTypeOther;
+                m_sResponseTypeText = pSerializer->GetContentType();
+                m_nResponseStatus   = 200;
+
+                pSerializer->AddHeaders( m_mapRespHeaders );
+                m_mapRespHeaders.remove( "ETag" );
+            }
+        }
+    }
 
     return pSerializer;
 }
@@ -1789,21 +1881,42 @@ Serializer *HTTPRequest::GetSerializer()
 
 QString HTTPRequest::Encode(const QString &sIn)
 {
-    QString sStr = sIn;
-#if 0
-    LOG(VB_HTTP, LOG_DEBUG,
-        QString("HTTPRequest::Encode Input : %1").arg(sStr));
-#endif
-    sStr.replace('&', "&amp;" ); // This _must_ come first
-    sStr.replace('<', "&lt;"  );
-    sStr.replace('>', "&gt;"  );
-    sStr.replace('"', "&quot;");
-    sStr.replace("'", "&apos;");
+    // Most values have nothing to escape and are returned as they are.
+    // The rest are escaped in a single pass, rather than one replace()
+    // per character, which copied large DIDL-Lite results five times.
+
+    const QChar *pBegin = sIn.constData();
+    const QChar *pEnd   = pBegin + sIn.size();
+    const QChar *pChar  = pBegin;
+
+    for (; pChar != pEnd; ++pChar)
+    {
+        ushort c = pChar->unicode();
+
+        if (c == '&' || c == '<' || c == '>' || c == '"' || c == '\'')
+            break;
+    }
+
+    if (pChar == pEnd)
+        return sIn;
+
+    QString sStr;
+    sStr.reserve( sIn.size() + sIn.size() / 8 + 16 );
+    sStr.append( pBegin, pChar - pBegin );
+
+    for (; pChar != pEnd; ++pChar)
+    {
+        switch (pChar->unicode())
+        {
+            case '&':  sStr += "&amp;";  break;
+            case '<':  sStr += "&lt;";   break;
+            case '>':  sStr += "&gt;";   break;
+            case '"':  sStr += "&quot;"; break;
+            case '\'': sStr += "&apos;"; break;
+            default:   sStr += *pChar;   break;
+        }
+    }
 
-#if 0
-    LOG(VB_HTTP, LOG_DEBUG,
-        QString("HTTPRequest::Encode Output : %1").arg(sStr));
-#endif
     return sStr;
 }
 
@@ -26,6 +26,8 @@
 #include "upnputil.h"
 #include "serializers/serializer.h"
 
+class HTTPResponseStream;
+
 #define SOAP_ENVELOPE_BEGIN  "<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" " \
                              "s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\">"     \
                              "<s:Body>"
@@ -151,9 +153,12 @@ class UPNP_PUBLIC HTTPRequest
         QString             m_sFileName;
 
         QBuffer             m_response;
+        QByteArray          m_gzipResponse;     // m_response, gzip'd ahead
 
         IPostProcess       *m_pPostProcess;
 
+        HTTPResponseStream *m_pResponseStream;  // Set if the serializer streams
+
         QString             m_sPrivateToken;
         MythUserSession     m_userSession;
 
@@ -204,7 +209,7 @@ class UPNP_PUBLIC HTTPRequest
     public:
 
                         HTTPRequest     ();
-        virtual        ~HTTPRequest     () = default;
+        virtual        ~HTTPRequest     ();
 
         bool            ParseRequest    ();
 
@@ -219,6 +224,7 @@ class UPNP_PUBLIC HTTPRequest
 
         qint64          SendResponse    ( void );
         qint64          SendResponseFile( QString sFileName );
+        qint64          SendChunkedHeader( bool bGzip );
 
         void            SetResponseHeader ( const QString &sKey,
                                             const QString &sValue,
@@ -0,0 +1,233 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: httpresponsestream.cpp
+// Created     : Oct. 19, 2026
+//
+// Purpose     : Chunked, optionally gzip'd, response body writer
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "httpresponsestream.h"
+
+#include <zlib.h>
+
+#include "httprequest.h"
+#include "mythlogging.h"
+
+// Responses up to this size are sent whole, with a Content-Length
+static const int kStreamThreshold = 256 * 1024;
+
+// Encoded output is sent in chunks of about this size
+static const int kChunkSize       = 64 * 1024;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+HTTPResponseStream::HTTPResponseStream( HTTPRequest *pRequest, bool bGzip )
+                  : m_pRequest  ( pRequest ),
+                    m_bGzip     ( bGzip    ),
+                    m_pZStream  ( nullptr  ),
+                    m_bStreaming( false    ),
+                    m_bFailed   ( false    ),
+                    m_nBytesSent( 0        )
+{
+    open( QIODevice::WriteOnly );
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+HTTPResponseStream::~HTTPResponseStream()
+{
+    if (m_pZStream != nullptr)
+    {
+        deflateEnd( m_pZStream );
+        delete m_pZStream;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns a copy of what was written, if it was not large enough to be
+// streamed, leaving it to be sent.
+/////////////////////////////////////////////////////////////////////////////
+
+QByteArray HTTPResponseStream::GetBuffered( void ) const
+{
+    if (m_bStreaming)
+        return QByteArray();
+
+    return m_buffer;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns what was written, if it was not large enough to be streamed.
+/////////////////////////////////////////////////////////////////////////////
+
+QByteArray HTTPResponseStream::TakeBuffered( void )
+{
+    QByteArray buffer;
+
+    if (!m_bStreaming)
+        buffer.swap( m_buffer );
+
+    return buffer;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Ends a streamed response. Returns the bytes sent, or -1 on an error.
+/////////////////////////////////////////////////////////////////////////////
+
+qint64 HTTPResponseStream::Finish( void )
+{
+    if (!m_bStreaming || m_bFailed)
+        return m_bFailed ? -1 : 0;
+
+    if (!Encode( nullptr, 0, true ) || !SendChunk())
+        return -1;
+
+    static const char kLastChunk[] = "0\r\n\r\n";
+
+    if (m_pRequest->WriteBlock( kLastChunk, sizeof( kLastChunk ) - 1 ) < 0)
+        return -1;
+
+    m_nBytesSent += sizeof( kLastChunk ) - 1;
+
+    LOG(VB_HTTP, LOG_DEBUG,
+        QString("HTTPResponseStream: Streamed %1 bytes").arg(m_nBytesSent));
+
+    return m_nBytesSent;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+qint64 HTTPResponseStream::writeData( const char *pData, qint64 nLen )
+{
+    if (m_bFailed)
+        return -1;
+
+    if (!m_bStreaming)
+    {
+        m_buffer.append( pData, nLen );
+
+        if (m_buffer.size() < kStreamThreshold)
+            return nLen;
+
+        QByteArray pending;
+        pending.swap( m_buffer );
+
+        if (!Start() || !Encode( pending.constData(), pending.size(), false ))
+            m_bFailed = true;
+    }
+    else if (!Encode( pData, nLen, false ))
+        m_bFailed = true;
+
+    return m_bFailed ? -1 : nLen;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+bool HTTPResponseStream::Start( void )
+{
+    m_bStreaming = true;
+
+    if (m_bGzip)
+    {
+        m_pZStream = new z_stream;
+        m_pZStream->zalloc = Z_NULL;
+        m_pZStream->zfree  = Z_NULL;
+        m_pZStream->opaque = Z_NULL;
+
+        // 15 + 16 for gzip rather than zlib framing, as gzipCompress()
+        if (deflateInit2( m_pZStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                          15 + 16, 8, Z_DEFAULT_STRATEGY ) != Z_OK)
+        {
+            delete m_pZStream;
+            m_pZStream = nullptr;
+            m_bGzip    = false;
+        }
+    }
+
+    qint64 nBytes = m_pRequest->SendChunkedHeader( m_bGzip );
+
+    if (nBytes < 0)
+        return false;
+
+    m_nBytesSent += nBytes;
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+bool HTTPResponseStream::Encode( const char *pData, qint64 nLen, bool bFinish )
+{
+    if (!m_bGzip)
+        m_buffer.append( pData, nLen );
+    else
+    {
+        char aOut[ 16 * 1024 ];
+        int  nRet;
+
+        m_pZStream->next_in  = (Bytef *)pData;
+        m_pZStream->avail_in = nLen;
+
+        do
+        {
+            m_pZStream->next_out  = (Bytef *)aOut;
+            m_pZStream->avail_out = sizeof( aOut );
+
+            nRet = deflate( m_pZStream, bFinish ? Z_FINISH : Z_NO_FLUSH );
+
+            if (nRet == Z_STREAM_ERROR)
+            {
+                LOG(VB_GENERAL, LOG_ERR,
+                    "HTTPResponseStream: Error compressing response");
+                return false;
+            }
+
+            m_buffer.append( aOut, sizeof( aOut ) - m_pZStream->avail_out );
+        }
+        while (m_pZStream->avail_out == 0);
+    }
+
+    if (m_buffer.size() >= kChunkSize)
+        return SendChunk();
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+bool HTTPResponseStream::SendChunk( void )
+{
+    if (m_buffer.isEmpty())
+        return true;
+
+    QByteArray sChunk = QByteArray::number( m_buffer.size(), 16 ) + "\r\n";
+    sChunk.append( m_buffer );
+    sChunk.append( "\r\n" );
+    m_buffer.clear();
+
+    if (m_pRequest->WriteBlock( sChunk.constData(), sChunk.size() )
+            != sChunk.size())
+    {
+        LOG(VB_HTTP, LOG_ERR,
+            "HTTPResponseStream: Error writing response chunk");
+        return false;
+    }
+
+    m_nBytesSent += sChunk.size();
+
+    return true;
+}
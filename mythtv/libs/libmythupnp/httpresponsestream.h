@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: httpresponsestream.h
+// Created     : Oct. 19, 2026
+//
+// Purpose     : Chunked, optionally gzip'd, response body writer
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef HTTPRESPONSESTREAM_H_
+#define HTTPRESPONSESTREAM_H_
+
+#include <QIODevice>
+#include <QByteArray>
+
+#include "upnpexp.h"
+
+class HTTPRequest;
+struct z_stream_s;
+
+/////////////////////////////////////////////////////////////////////////////
+// HTTPResponseStream
+//
+// A serializer writes its output here instead of into the response buffer.
+// Small responses are only collected, and then sent by SendResponse() the
+// usual way, with a Content-Length and an ETag. Once a response outgrows
+// kStreamThreshold the headers are sent, and the body follows in chunks
+// (Transfer-Encoding: chunked) while it is being serialized, compressed on
+// the fly if the client accepts gzip. The response then never has to be
+// held in memory as a whole, nor compressed in one go after the fact.
+/////////////////////////////////////////////////////////////////////////////
+
+class UPNP_PUBLIC HTTPResponseStream : public QIODevice
+{
+    public:
+
+        HTTPResponseStream( HTTPRequest *pRequest, bool bGzip );
+        virtual ~HTTPResponseStream();
+
+        bool        IsStreaming  ( void ) const { return m_bStreaming; }
+        QByteArray  GetBuffered  ( void ) const;
+        QByteArray  TakeBuffered ( void );
+        qint64      Finish       ( void );
+
+    protected:
+
+        qint64 readData ( char *, qint64 ) override // QIODevice
+            { return -1; }
+        qint64 writeData( const char *pData, qint64 nLen ) override; // QIODevice
+
+    private:
+
+        Q_DISABLE_COPY( HTTPResponseStream )
+
+        bool Start     ( void );
+        bool Encode    ( const char *pData, qint64 nLen, bool bFinish );
+        bool SendChunk ( void );
+
+        HTTPRequest    *m_pRequest;
+        bool            m_bGzip;
+        z_stream_s     *m_pZStream;
+        bool            m_bStreaming;
+        bool            m_bFailed;
+        QByteArray      m_buffer;       // Raw until streaming, then encoded
+        qint64          m_nBytesSent;
+};
+
+#endif
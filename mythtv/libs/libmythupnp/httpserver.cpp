@@ -114,11 +114,12 @@ QString  HttpServer::s_platform;
 /////////////////////////////////////////////////////////////////////////////
 
 HttpServer::HttpServer() :
-    ServerPool(), m_sSharePath(GetShareDir()),
+    ServerPool(), m_sSharePath(GetShareDir()), m_keepAlive(*this),
     m_threadPool("HttpServerPool"), m_running(true),
     m_privateToken(QUuid::createUuid().toString()) // Cryptographically random and sufficiently long enough to act as a secure token
 {
-    // Number of connections processed concurrently
+    // Number of requests processed concurrently, idle keep-alive
+    // connections wait in m_keepAlive without a worker
     int maxHttpWorkers = max(QThread::idealThreadCount() * 2, 2); // idealThreadCount can return -1
     // Don't allow more connections than we can process, it causes browsers
     // to open lots of new connections instead of reusing existing ones
@@ -173,6 +174,7 @@ HttpServer::~HttpServer()
     m_running = false;
     m_rwlock.unlock();
 
+    m_keepAlive.Stop();
     m_threadPool.Stop();
 
     while (!m_extensions.empty())
@@ -309,13 +311,27 @@ void HttpServer::newTcpConnection(qt_socket_fd_t socket)
     if (server)
         type = server->GetServerType();
 
+    HttpConnection *pConnection = new HttpConnection(socket, type);
+
+    // Browsers and DLNA clients often connect well before they send a
+    // request, so only take a worker once there is one to read
+    if (!ParkConnection(pConnection))
+        ResumeConnection(pConnection);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpServer::ResumeConnection(HttpConnection *pConnection)
+{
     m_threadPool.startReserved(
-        new HttpWorker(*this, socket, type
+        new HttpWorker(*this, pConnection
 #ifndef QT_NO_OPENSSL
                        , m_sslConfig
 #endif
                        ),
-        QString("HttpServer%1").arg(socket));
+        QString("HttpServer%1").arg(pConnection->m_nSocket));
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -449,26 +465,69 @@ uint HttpServer::GetSocketTimeout(HTTPRequest* pRequest) const
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
-HttpWorker::HttpWorker(HttpServer &httpServer, qt_socket_fd_t sock,
-                       PoolServerType type
+HttpWorker::HttpWorker(HttpServer &httpServer, HttpConnection *connection
 #ifndef QT_NO_OPENSSL
                        , QSslConfiguration sslConfig
 #endif
 )
-           : m_httpServer(httpServer), m_socket(sock),
-             m_socketTimeout(5 * 1000), m_connectionType(type)
+           : m_httpServer(httpServer), m_connection(connection),
+             m_socket(connection->m_nSocket),
+             m_socketTimeout(connection->m_nTimeout),
+             m_connectionType(connection->m_eType)
 #ifndef QT_NO_OPENSSL
              , m_sslConfig(sslConfig)
 #endif
 {
-    LOG(VB_HTTP, LOG_INFO, QString("HttpWorker(%1): New connection")
-                                        .arg(m_socket));
+    if (m_connection->m_pSocket == nullptr)
+        LOG(VB_HTTP, LOG_INFO, QString("HttpWorker(%1): New connection")
+                                            .arg(m_socket));
 }                  
 
 /////////////////////////////////////////////////////////////////////////////
 //
 /////////////////////////////////////////////////////////////////////////////
 
+HttpWorker::~HttpWorker()
+{
+    delete m_connection;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Hands an idle connection back to the server to wait for its next request
+// without holding this thread. Returns false if it still belongs to us.
+/////////////////////////////////////////////////////////////////////////////
+
+bool HttpWorker::Park(QTcpSocket *pSocket, bool bEncrypted,
+                      int nRequestsHandled)
+{
+    // Anything buffered in the socket would not wake the epoll thread
+    if (pSocket->bytesAvailable() > 0 || pSocket->bytesToWrite() > 0)
+        return false;
+
+    m_connection->m_pSocket          = pSocket;
+    m_connection->m_bEncrypted       = bEncrypted;
+    m_connection->m_nRequestsHandled = nRequestsHandled;
+    m_connection->m_nTimeout         = m_socketTimeout;
+
+    // Whichever worker resumes the connection takes the socket over
+    pSocket->moveToThread(nullptr);
+
+    if (m_httpServer.ParkConnection(m_connection))
+    {
+        m_connection = nullptr;
+        return true;
+    }
+
+    pSocket->moveToThread(QThread::currentThread());
+    m_connection->m_pSocket = nullptr;
+
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
 void HttpWorker::run(void)
 {
 #if 0
@@ -480,9 +539,17 @@ void HttpWorker::run(void)
     bool                    bKeepAlive = true;
     HTTPRequest            *pRequest   = nullptr;
     QTcpSocket             *pSocket;
-    bool                    bEncrypted = false;
+    bool                    bEncrypted = m_connection->m_bEncrypted;
+    bool                    bHandled   = false;
 
-    if (m_connectionType == kSSLServer)
+    if (m_connection->m_pSocket != nullptr)
+    {
+        // Resumed after waiting for this request in the keep-alive thread
+        pSocket = m_connection->m_pSocket;
+        pSocket->moveToThread(QThread::currentThread());
+        m_connection->m_pSocket = nullptr;
+    }
+    else if (m_connectionType == kSSLServer)
     {
 
 #ifndef QT_NO_OPENSSL
@@ -533,7 +600,8 @@ void HttpWorker::run(void)
     }
 
     pSocket->setSocketOption(QAbstractSocket::KeepAliveOption, QVariant(1));
-    int nRequestsHandled = 0; // Allow debugging of keep-alive and connection re-use
+    // Allow debugging of keep-alive and connection re-use
+    int nRequestsHandled = m_connection->m_nRequestsHandled;
 
     try
     {
@@ -543,7 +611,12 @@ void HttpWorker::run(void)
             // We set a timeout on keep-alive connections to avoid blocking
             // new clients from connecting - Default at time of writing was
             // 5 seconds for initial connection, then up to 10 seconds of idle
-            // time between each subsequent request on the same connection
+            // time between each subsequent request on the same connection.
+            // The wait happens in the keep-alive thread where possible,
+            // leaving this one free for other connections' requests
+            if (bHandled && Park(pSocket, bEncrypted, nRequestsHandled))
+                return;
+
             bTimeout = !(pSocket->waitForReadyRead(m_socketTimeout));
 
             if (bTimeout) // Either client closed the socket or we timed out waiting for new data
@@ -613,6 +686,7 @@ void HttpWorker::run(void)
 
                     delete pRequest;
                     pRequest = nullptr;
+                    bHandled = true;
                 }
                 else
                 {
@@ -38,6 +38,7 @@
 #include "mythqtcompat.h"
 #include "serverpool.h"
 #include "httprequest.h"
+#include "httpkeepalive.h"
 #include "mthreadpool.h"
 #include "upnputil.h"
 #include "compat.h"
@@ -125,6 +126,27 @@ class UPNP_PUBLIC HttpServer : public ServerPool
      */
     uint GetSocketTimeout(HTTPRequest*) const;
 
+    /**
+     * \brief Hand a connection to a worker, to read its next request
+     */
+    void ResumeConnection(HttpConnection *pConnection);
+    /**
+     * \brief Hold a connection without a worker until its next request
+     *
+     * Returns false if it can't be held, it then remains the caller's.
+     */
+    bool ParkConnection(HttpConnection *pConnection)
+    {
+        return m_keepAlive.Park(pConnection);
+    }
+    /**
+     * \brief Number of idle connections waiting for their next request
+     */
+    int GetParkedConnectionCount(void) const
+    {
+        return m_keepAlive.Count();
+    }
+
     QString GetSharePath(void) const
     { // never modified after creation, so no need to lock
         return m_sSharePath;
@@ -147,6 +169,9 @@ class UPNP_PUBLIC HttpServer : public ServerPool
     // This multimap does NOT take ownership of the HttpServerExtension*
     QMultiMap< QString, HttpServerExtension* >  m_basePaths;
     QString                 m_sSharePath;
+    // Declared before m_threadPool, so it outlives the workers parking
+    // connections in it
+    HttpKeepAlive           m_keepAlive;
     MThreadPool             m_threadPool;
     bool                    m_running; // protected by m_rwlock
 
@@ -180,20 +205,24 @@ class HttpWorker : public QRunnable
 
     /**
      * \param httpServer The parent server of this request
-     * \param sock       The socket
-     * \param type       The type of connection - Plain TCP, SSL or other?
+     * \param connection The connection, new or resumed. The worker takes
+     *                   ownership of it
      * \param sslConfig  The SSL configuration (for SSL sockets)
      */
-    HttpWorker(HttpServer &httpServer, qt_socket_fd_t sock, PoolServerType type
+    HttpWorker(HttpServer &httpServer, HttpConnection *connection
 #ifndef QT_NO_OPENSSL
                , QSslConfiguration sslConfig
 #endif
     );
+    ~HttpWorker();
 
     void run(void) override; // QRunnable
 
   protected:
+    bool Park(QTcpSocket *pSocket, bool bEncrypted, int nRequestsHandled);
+
     HttpServer &m_httpServer; 
+    HttpConnection *m_connection;
     qt_socket_fd_t m_socket;
     int         m_socketTimeout;
     PoolServerType m_connectionType;
@@ -244,29 +244,47 @@ void JSONSerializer::RenderMap( const QVariantMap &map )
 
 QString JSONSerializer::Encode(const QString &sIn)
 {
-    if (sIn.isEmpty())
-        return sIn;
+    // Most values need no escaping, so return those without copying them
+
+    const QChar *pIn  = sIn.constData();
+    int          nLen = sIn.length();
+    int          nIdx = 0;
+
+    for (; nIdx < nLen; ++nIdx)
+    {
+        ushort ch = pIn[ nIdx ].unicode();
+
+        if (ch == '\\' || ch == '"' || ch == '/' || ch < 0x20)
+            break;
+    }
 
-    QString sStr = sIn;
+    if (nIdx == nLen)
+        return sIn;
 
-    // -=>TODO: Would it be better to just loop through string once and build 
-    // new string with encoded chars instead of calling replace multiple times?
-    // It might perform better.
+    QString sStr;
+    sStr.reserve( nLen + 16 );
+    sStr.append( pIn, nIdx );
 
-    sStr.replace( '\\', "\\\\" ); // This must be first
-    sStr.replace( '"' , "\\\"" ); 
+    for (; nIdx < nLen; ++nIdx)
+    {
+        QChar ch = pIn[ nIdx ];
 
-    sStr.replace( '\b', "\\b"  );
-    sStr.replace( '\f', "\\f"  );
-    sStr.replace( '\n', "\\n"  );
-    sStr.replace( "\r", "\\r"  );
-    sStr.replace( "\t", "\\t"  );
-    sStr.replace(  "/", "\\/"  );
+        switch (ch.unicode())
+        {
+            case '\\': sStr += "\\\\"; break;
+            case '"' : sStr += "\\\""; break;
+            case '/' : sStr += "\\/";  break;
+            case '\b': sStr += "\\b";  break;
+            case '\f': sStr += "\\f";  break;
+            case '\n': sStr += "\\n";  break;
+            case '\r': sStr += "\\r";  break;
+            case '\t': sStr += "\\t";  break;
+            default:
+                // we don't handle hex values yet...
+                sStr += ch;
+                break;
+        }
+    }
 
-    // we don't handle hex values yet...
-    /*
-    if(ch>='\u0000' && ch<='\u001F')
-        sb.append("\\u####"); 
-    */
     return sStr;
 }
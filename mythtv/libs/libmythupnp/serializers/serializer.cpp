@@ -14,6 +14,92 @@
 
 #include <QMetaObject>
 #include <QMetaProperty>
+#include <QReadWriteLock>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//////////////////////////////////////////////////////////////////////////////
+
+SerializerClass::SerializerClass( const QMetaObject *pMetaObject )
+{
+    for (int nIdx = 0; nIdx < pMetaObject->classInfoCount(); ++nIdx)
+    {
+        QMetaClassInfo info  = pMetaObject->classInfo( nIdx );
+        QString        sName = info.name();
+
+        classInfo.insert( sName, info.value() );
+        m_options.insert( sName, QString( info.value() ).split( ';' ) );
+    }
+
+    int nCount = pMetaObject->propertyCount();
+
+    for (int nIdx = 0; nIdx < nCount; ++nIdx)
+    {
+        SerializerProperty prop;
+
+        prop.metaProp = pMetaObject->property( nIdx );
+        prop.sName    = prop.metaProp.name();
+
+        if (prop.sName == "objectName")
+            continue;
+
+        prop.utf8Name   = prop.sName.toUtf8();
+        prop.bTransient = Option( prop.sName, "transient" ).toLower() == "true";
+
+        properties.append( prop );
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Returns the value of \p sKey in the class info options named \p sName
+//////////////////////////////////////////////////////////////////////////////
+
+QString SerializerClass::Option( const QString &sName,
+                                 const QString &sKey ) const
+{
+    QHash< QString, QStringList >::const_iterator it = m_options.find( sName );
+
+    if (it == m_options.end())
+        return QString();
+
+    QString sFullKey = sKey + "=";
+
+    foreach (const QString &sOption, *it)
+    {
+        if (sOption.startsWith( sFullKey ))
+            return sOption.mid( sFullKey.length() );
+    }
+
+    return QString();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Classes are never unloaded, so neither are their entries
+//////////////////////////////////////////////////////////////////////////////
+
+const SerializerClass *SerializerClass::Get( const QMetaObject *pMetaObject )
+{
+    static QReadWriteLock                                   s_lock;
+    static QHash< const QMetaObject *, SerializerClass * >  s_classes;
+
+    {
+        QReadLocker locker( &s_lock );
+
+        SerializerClass *pClass = s_classes.value( pMetaObject );
+
+        if (pClass != nullptr)
+            return pClass;
+    }
+
+    QWriteLocker locker( &s_lock );
+
+    SerializerClass *&pClass = s_classes[ pMetaObject ];
+
+    if (pClass == nullptr)
+        pClass = new SerializerClass( pMetaObject );
+
+    return pClass;
+}
 
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -103,40 +189,29 @@ void Serializer::SerializeObjectProperties( const QObject *pObject )
 {
     if (pObject != nullptr)
     {
-        const QMetaObject *pMetaObject = pObject->metaObject();
+        const QMetaObject     *pMetaObject = pObject->metaObject();
+        const SerializerClass *pClass      = SerializerClass::Get( pMetaObject );
 
-        int nCount = pMetaObject->propertyCount();
+        int nCount = pClass->properties.size();
 
         for (int nIdx=0; nIdx < nCount; ++nIdx ) 
         {
-            QMetaProperty metaProperty = pMetaObject->property( nIdx );
+            const SerializerProperty &prop = pClass->properties.at( nIdx );
 
-            if (metaProperty.isDesignable( pObject ))
+            // Designable may be a method of the object, so ask every time
+            if (prop.metaProp.isDesignable( pObject ))
             {
-                const char *pszPropName = metaProperty.name();
-                QString     sPropName( pszPropName );
+                if (!prop.bTransient)
+                    m_hash.addData( prop.utf8Name );
 
-                if ( sPropName.compare( "objectName" ) == 0)
-                    continue;
-                
-                bool bHash = false;
+                QVariant value( prop.metaProp.read( pObject ) );
 
-                if (ReadPropertyMetadata( pObject, 
-                                          sPropName, 
-                                          "transient").toLower() != "true" )
-                {
-                    bHash = true;
-                    m_hash.addData( sPropName.toUtf8() );
-                }
-
-                QVariant value( pObject->property( pszPropName ) );
-
-                if (bHash && !value.canConvert< QObject* >()) 
+                if (!prop.bTransient && !value.canConvert< QObject* >()) 
                 {
                     m_hash.addData( value.toString().toUtf8() );
                 }
 
-                AddProperty( sPropName, value, pMetaObject, &metaProperty );
+                AddProperty( prop.sName, value, pMetaObject, &prop.metaProp );
             }
         }
     }
@@ -152,26 +227,10 @@ QString Serializer::ReadPropertyMetadata( const QObject *pObject,
 {
     const QMetaObject *pMeta = pObject->metaObject();
 
-    int nIdx = -1;
-
-    if (pMeta)
-        nIdx = pMeta->indexOfClassInfo( sPropName.toUtf8());
-
-    if (nIdx >=0)
-    {
-        QString     sMetadata = pMeta->classInfo( nIdx ).value();
-        QStringList sOptions  = sMetadata.split( ';' );
-
-        QString     sFullKey  = sKey + "=";
+    if (pMeta == nullptr)
+        return QString();
 
-        for (nIdx = 0; nIdx < sOptions.size(); ++nIdx)
-        {
-            if (sOptions.at( nIdx ).startsWith( sFullKey ))
-                return sOptions.at( nIdx ).mid( sFullKey.length() );
-        }
-    }
-
-    return QString();
+    return SerializerClass::Get( pMeta )->Option( sPropName, sKey );
 }
 
 
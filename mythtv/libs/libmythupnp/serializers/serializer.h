@@ -17,9 +17,45 @@
 #include "upnputil.h"
 
 #include <QList>
+#include <QHash>
+#include <QVector>
 #include <QMetaType>
+#include <QMetaProperty>
+#include <QStringList>
 #include <QCryptographicHash>
 
+//////////////////////////////////////////////////////////////////////////////
+// What a serializer needs to know about the properties of a class. It is
+// read from the class's QMetaObject and class info once, and then shared
+// by every serializer, rather than looked up again for each object.
+//////////////////////////////////////////////////////////////////////////////
+
+struct SerializerProperty
+{
+    QMetaProperty   metaProp;
+    QString         sName;
+    QByteArray      utf8Name;       // Hashed for the ETag
+    bool            bTransient;     // Left out of the ETag
+};
+
+class UPNP_PUBLIC SerializerClass
+{
+    public:
+
+        QVector< SerializerProperty >   properties; // All but objectName
+        QHash< QString, QString >       classInfo;
+
+        QString Option( const QString &sName, const QString &sKey ) const;
+
+        static const SerializerClass *Get( const QMetaObject *pMetaObject );
+
+    private:
+
+        explicit SerializerClass( const QMetaObject *pMetaObject );
+
+        QHash< QString, QStringList >   m_options;  // classInfo split at ';'
+};
+
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -68,6 +104,7 @@ class UPNP_PUBLIC Serializer
 
 
         inline Serializer();
+        virtual ~Serializer() = default;
 };
 
 Q_DECLARE_METATYPE( QList<QObject*> )
@@ -91,13 +91,16 @@ void XmlSerializer::BeginObject( const QString &sName, const QObject  *pObject )
 
     const QMetaObject *pMeta = pObject->metaObject();
 
-    int nIdx = -1;
-
     if (pMeta)
-        nIdx = pMeta->indexOfClassInfo( "version" );
+    {
+        const SerializerClass *pClass = SerializerClass::Get( pMeta );
 
-    if (nIdx >=0)
-        m_pXmlWriter->writeAttribute( "version", pMeta->classInfo( nIdx ).value() );
+        QHash< QString, QString >::const_iterator it =
+            pClass->classInfo.find( "version" );
+
+        if (it != pClass->classInfo.end())
+            m_pXmlWriter->writeAttribute( "version", *it );
+    }
 
     m_pXmlWriter->writeAttribute( "serializerVersion", XML_SERIALIZER_VERSION );
 
@@ -327,20 +330,14 @@ QString XmlSerializer::GetContentName( const QString        &sName,
 {
     // Try to read Name or TypeName from classinfo metadata.
 
-    int nClassIdx = -1;
-
     if ( pMetaObject )
-        nClassIdx = pMetaObject->indexOfClassInfo( sName.toLatin1() );
-
-    if (nClassIdx >=0 )
     {
-        QString     sOptionData = pMetaObject->classInfo( nClassIdx ).value();
-        QStringList sOptions    = sOptionData.split( ';' );
-        
-        QString sNameOption = FindOptionValue( sOptions, "name" );
+        const SerializerClass *pClass = SerializerClass::Get( pMetaObject );
+
+        QString sNameOption = pClass->Option( sName, "name" );
 
         if (sNameOption.isEmpty())
-            sNameOption = FindOptionValue( sOptions, "type" );
+            sNameOption = pClass->Option( sName, "type" );
 
         if (!sNameOption.isEmpty())
             return GetItemName(  sNameOption );
@@ -0,0 +1,336 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: servicecache.cpp
+// Created     : Oct. 19, 2026
+//
+// Purpose     : Cache of serialized service method responses
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "servicecache.h"
+
+#include <QCoreApplication>
+#include <QThread>
+
+#include "httprequest.h"
+#include "httpresponsestream.h"
+#include "mythcorecontext.h"
+#include "mythcoreutil.h"
+#include "mythlogging.h"
+#include "mythevent.h"
+#include "mythdate.h"
+
+// Longest a response is served from the cache, in seconds
+static const int kMaxAge        = 60;
+
+// Total size of the cached responses, in bytes
+static const int kMaxCacheBytes = 32 * 1024 * 1024;
+
+// Statistics are logged after this many lookups
+static const int kStatsInterval = 1000;
+
+// The events that announce changes to what the stamps stand for
+static const struct
+{
+    const char *m_pszEvent;
+    const char *m_pszStamp;
+}
+kEventStamps[] =
+{
+    { "RECORDING_LIST_CHANGE",  "recorded" },
+    { "MASTER_UPDATE_REC_INFO", "recorded" },
+    { "UPDATE_FILE_SIZE",       "recorded" },
+    { "SCHEDULE_CHANGE",        "schedule" },
+    { "SETTING_CHANGED",        "settings" },
+    { "CLEAR_SETTINGS_CACHE",   "settings" },
+    // Sent when mythtv-setup exits, which is where channels are edited
+    { "CLEAR_SETTINGS_CACHE",   "channel"  },
+};
+
+ServiceCache *ServiceCache::g_pServiceCache = nullptr;
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+ServiceCache *ServiceCache::Instance()
+{
+    static QMutex s_lock;
+
+    QMutexLocker locker( &s_lock );
+
+    if (g_pServiceCache == nullptr)
+        g_pServiceCache = new ServiceCache();
+
+    return g_pServiceCache;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+ServiceCache::ServiceCache()
+  : m_entries( kMaxCacheBytes ),
+    m_started( MythDate::current() ),
+    m_nHits  ( 0 ),
+    m_nMisses( 0 )
+{
+    // The first request may come from any worker thread, events are only
+    // delivered to objects in a thread with an event loop
+    if (QCoreApplication::instance() != nullptr)
+        moveToThread( QCoreApplication::instance()->thread() );
+
+    if (gCoreContext != nullptr)
+        gCoreContext->addListener( this );
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+ServiceCache::~ServiceCache()
+{
+    if (gCoreContext != nullptr)
+        gCoreContext->removeListener( this );
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns a number that changes whenever any of the stamps is bumped.
+/////////////////////////////////////////////////////////////////////////////
+
+quint64 ServiceCache::GetVersion( const QStringList &stamps )
+{
+    QMutexLocker locker( &m_lock );
+
+    quint64 nVersion = 0;
+
+    foreach (const QString &sStamp, stamps)
+        nVersion += m_stamps.value( sStamp ).m_nVersion;
+
+    return nVersion;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Bumps a stamp. The responses that depend on it stay in the cache until
+// they are next looked up, or pushed out by newer ones.
+/////////////////////////////////////////////////////////////////////////////
+
+void ServiceCache::Invalidate( const QString &sStamp )
+{
+    QMutexLocker locker( &m_lock );
+
+    Stamp &stamp = m_stamps[ sStamp ];
+
+    stamp.m_nVersion++;
+    stamp.m_changed = MythDate::current();
+
+    LOG(VB_HTTP, LOG_DEBUG, QString("ServiceCache: '%1' changed, version %2")
+                                .arg(sStamp).arg(stamp.m_nVersion));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void ServiceCache::Clear( void )
+{
+    QMutexLocker locker( &m_lock );
+
+    m_entries.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Fills in the response from the cache, if it has a current one.
+/////////////////////////////////////////////////////////////////////////////
+
+bool ServiceCache::Respond( const QString &sKey, quint64 nVersion,
+                            HTTPRequest *pRequest )
+{
+    bool  bGzip = pRequest->m_mapHeaders[ "accept-encoding" ].contains( "gzip" );
+    Entry entry;
+
+    {
+        QMutexLocker locker( &m_lock );
+
+        Entry *pEntry = m_entries.object( sKey );
+
+        if (pEntry != nullptr &&
+            (pEntry->m_nVersion != nVersion ||
+             pEntry->m_created.secsTo( MythDate::current() ) > kMaxAge))
+        {
+            m_entries.remove( sKey );
+            pEntry = nullptr;
+        }
+
+        if (pEntry == nullptr)
+            ++m_nMisses;
+        else
+        {
+            ++m_nHits;
+            entry = *pEntry;
+        }
+
+        if ((m_nHits + m_nMisses) % kStatsInterval == 0)
+            LogStats();
+
+        if (pEntry == nullptr)
+            return false;
+    }
+
+    // Compress once, for the first client that wants it
+
+    if (bGzip && entry.m_gzip.isEmpty() && !entry.m_body.isEmpty())
+    {
+        entry.m_gzip = gzipCompress( entry.m_body );
+
+        QMutexLocker locker( &m_lock );
+
+        Entry *pEntry = m_entries.object( sKey );
+
+        if (pEntry != nullptr && pEntry->m_nVersion == nVersion)
+        {
+            m_entries.insert( sKey, new Entry( entry ),
+                              entry.m_body.size() + entry.m_gzip.size() );
+        }
+    }
+
+    pRequest->m_eResponseType     = ResponseTypeOther;
+    pRequest->m_sResponseTypeText = entry.m_sContentType;
+    pRequest->m_nResponseStatus   = 200;
+
+    QStringMap::const_iterator it = entry.m_headers.constBegin();
+
+    for (; it != entry.m_headers.constEnd(); ++it)
+        pRequest->SetResponseHeader( it.key(), it.value() );
+
+    pRequest->m_response.buffer() = entry.m_body;
+
+    if (bGzip)
+        pRequest->m_gzipResponse = entry.m_gzip;
+
+    LOG(VB_HTTP, LOG_DEBUG, QString("ServiceCache: Hit for %1").arg(sKey));
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Keeps a copy of a response that was just built, if it is one of the
+// ones a serializer wrote. A response that was large enough to be streamed
+// has already been sent, and is not kept.
+/////////////////////////////////////////////////////////////////////////////
+
+void ServiceCache::Store( const QString &sKey, quint64 nVersion,
+                          const QStringList &stamps, HTTPRequest *pRequest )
+{
+    HTTPResponseStream *pStream = pRequest->m_pResponseStream;
+
+    if (pRequest->m_eResponseType   != ResponseTypeOther ||
+        pRequest->m_nResponseStatus != 200 ||
+        (pStream != nullptr && pStream->IsStreaming()))
+    {
+        return;
+    }
+
+    Entry *pEntry = new Entry;
+
+    pEntry->m_nVersion     = nVersion;
+    pEntry->m_created      = MythDate::current();
+    pEntry->m_sContentType = pRequest->m_sResponseTypeText;
+    pEntry->m_body         = (pStream != nullptr) ? pStream->GetBuffered() :
+                                                    pRequest->m_response.buffer();
+
+    QDateTime lastModified = m_started;
+
+    {
+        QMutexLocker locker( &m_lock );
+
+        foreach (const QString &sStamp, stamps)
+        {
+            QDateTime changed = m_stamps.value( sStamp ).m_changed;
+
+            if (changed.isValid() && changed > lastModified)
+                lastModified = changed;
+        }
+    }
+
+    pRequest->SetResponseHeader( "Last-Modified",
+        MythDate::toString( lastModified, MythDate::kOverrideUTC |
+                                          MythDate::kRFC822 ));
+
+    static const char *kHeaders[] = { "ETag", "Cache-Control",
+                                      "Last-Modified" };
+
+    for (const char *pszHeader : kHeaders)
+    {
+        if (pRequest->m_mapRespHeaders.contains( pszHeader ))
+            pEntry->m_headers[ pszHeader ] =
+                pRequest->m_mapRespHeaders[ pszHeader ];
+    }
+
+    if (pRequest->m_mapHeaders[ "accept-encoding" ].contains( "gzip" ) &&
+        !pEntry->m_body.isEmpty())
+    {
+        pEntry->m_gzip = gzipCompress( pEntry->m_body );
+        pRequest->m_gzipResponse = pEntry->m_gzip;
+    }
+
+    QMutexLocker locker( &m_lock );
+
+    // QCache deletes an entry that is too large to be held
+    m_entries.insert( sKey, pEntry,
+                      pEntry->m_body.size() + pEntry->m_gzip.size() );
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+quint64 ServiceCache::GetHits( void ) const
+{
+    QMutexLocker locker( &m_lock );
+
+    return m_nHits;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+quint64 ServiceCache::GetMisses( void ) const
+{
+    QMutexLocker locker( &m_lock );
+
+    return m_nMisses;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Must be called with m_lock held.
+/////////////////////////////////////////////////////////////////////////////
+
+void ServiceCache::LogStats( void ) const
+{
+    LOG(VB_HTTP, LOG_INFO,
+        QString("ServiceCache: %1 hits, %2 misses, %3 responses, %4 KB")
+            .arg(m_nHits).arg(m_nMisses).arg(m_entries.size())
+            .arg(m_entries.totalCost() / 1024));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void ServiceCache::customEvent( QEvent *pEvent )
+{
+    if (pEvent->type() != MythEvent::MythEventMessage)
+        return;
+
+    MythEvent *me    = static_cast< MythEvent * >( pEvent );
+    QString    sName = me->Message().section( ' ', 0, 0 );
+
+    for (const auto &eventStamp : kEventStamps)
+    {
+        if (sName == eventStamp.m_pszEvent)
+            Invalidate( eventStamp.m_pszStamp );
+    }
+}
@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: servicecache.h
+// Created     : Oct. 19, 2026
+//
+// Purpose     : Cache of serialized service method responses
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef SERVICECACHE_H_
+#define SERVICECACHE_H_
+
+#include <QStringList>
+#include <QByteArray>
+#include <QDateTime>
+#include <QObject>
+#include <QCache>
+#include <QMutex>
+#include <QHash>
+
+#include "upnpexp.h"
+#include "upnputil.h"
+
+class HTTPRequest;
+
+/////////////////////////////////////////////////////////////////////////////
+// ServiceCache
+//
+// Holds the serialized responses of read-only service methods, keyed by
+// method, arguments and requested format. A method takes part by naming
+// what its result depends on in its service contract, e.g.
+//
+//     Q_CLASSINFO( "GetRecordedList_Cache", "recorded" )
+//
+// Each name is a version stamp. Stamps are bumped by the backend events
+// listed in kEventStamps, and a service's own stamp (its extension name)
+// by every POST to that service. A cached response is used only while the
+// versions of its stamps are unchanged, and for at most kMaxAge seconds,
+// which bounds how stale it gets after a change no event announces.
+//
+// A cached response keeps the content hash ETag it was built with, so a
+// client polling with If-None-Match gets its 304 without the method being
+// called at all. Only responses small enough to be sent whole are kept,
+// larger ones are streamed as they are built (see HTTPResponseStream),
+// every time they are asked for.
+/////////////////////////////////////////////////////////////////////////////
+
+class UPNP_PUBLIC ServiceCache : public QObject
+{
+    Q_OBJECT
+
+    public:
+
+        static ServiceCache *Instance();
+
+        quint64 GetVersion ( const QStringList &stamps );
+        void    Invalidate ( const QString     &sStamp );
+        void    Clear      ( void );
+
+        bool    Respond    ( const QString     &sKey,
+                             quint64            nVersion,
+                             HTTPRequest       *pRequest );
+        void    Store      ( const QString     &sKey,
+                             quint64            nVersion,
+                             const QStringList &stamps,
+                             HTTPRequest       *pRequest );
+
+        quint64 GetHits    ( void ) const;
+        quint64 GetMisses  ( void ) const;
+
+    protected:
+
+        void customEvent( QEvent *pEvent ) override; // QObject
+
+    private:
+
+        class Entry
+        {
+            public:
+                Entry() : m_nVersion( 0 ) {}
+
+                quint64     m_nVersion;
+                QDateTime   m_created;
+                QString     m_sContentType;
+                QStringMap  m_headers;
+                QByteArray  m_body;
+                QByteArray  m_gzip;         // Compressed when first asked for
+        };
+
+        class Stamp
+        {
+            public:
+                Stamp() : m_nVersion( 0 ) {}
+
+                quint64     m_nVersion;
+                QDateTime   m_changed;
+        };
+
+        ServiceCache();
+       ~ServiceCache();
+
+        Q_DISABLE_COPY( ServiceCache )
+
+        void LogStats( void ) const;
+
+        static ServiceCache        *g_pServiceCache;
+
+        mutable QMutex              m_lock;
+        QCache< QString, Entry >    m_entries;  // protected by m_lock
+        QHash< QString, Stamp >     m_stamps;   // protected by m_lock
+        QDateTime                   m_started;
+        quint64                     m_nHits;    // protected by m_lock
+        quint64                     m_nMisses;  // protected by m_lock
+};
+
+#endif
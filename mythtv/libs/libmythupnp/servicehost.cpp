@@ -14,6 +14,7 @@
 
 #include "mythlogging.h"
 #include "servicehost.h"
+#include "servicecache.h"
 #include "wsdl.h"
 #include "xsd.h"
 //#include "services/rtti.h"
@@ -261,6 +262,30 @@ ServiceHost::ServiceHost(const QMetaObject &metaObject,
                                                          RequestTypeHead);
             }
 
+            // --------------------------------------------------------------
+            // Read only methods may name the version stamps their results
+            // depend on, so their responses can be cached (see ServiceCache)
+            // --------------------------------------------------------------
+
+            QString sCacheClassInfo = oInfo.m_sName + "_Cache";
+
+            nClassIdx =
+                m_oMetaObject.indexOfClassInfo(sCacheClassInfo.toLatin1());
+
+            if (nClassIdx >=0)
+            {
+                QString sStamps = m_oMetaObject.classInfo(nClassIdx).value();
+
+                foreach (const QString &sStamp,
+                         sStamps.split( ',', QString::SkipEmptyParts ))
+                {
+                    oInfo.m_cacheStamps << sStamp.trimmed();
+                }
+
+                // Anything POSTed to this service may change the result
+                oInfo.m_cacheStamps << m_sName;
+            }
+
             m_Methods.insert( oInfo.m_sName, oInfo );
         }
     }
@@ -406,6 +431,30 @@ bool ServiceHost::ProcessRequest( HTTPRequest *pRequest )
 
                 if (( pRequest->m_eType & oInfo.m_eRequestType ) != 0)
                 {
+                    // ------------------------------------------------------
+                    // Answer from the response cache if nothing the method
+                    // depends on changed since it was last called
+                    // ------------------------------------------------------
+
+                    bool    bCacheable = !oInfo.m_cacheStamps.isEmpty() &&
+                                         !pRequest->m_bSOAPRequest    &&
+                                         (pRequest->m_eType &
+                                          (RequestTypeGet | RequestTypeHead));
+                    QString sCacheKey;
+                    quint64 nVersion   = 0;
+
+                    if (bCacheable)
+                    {
+                        sCacheKey = GetCacheKey( pRequest, sMethodName );
+                        nVersion  = ServiceCache::Instance()->GetVersion(
+                                                      oInfo.m_cacheStamps );
+
+                        if (ServiceCache::Instance()->Respond( sCacheKey,
+                                                               nVersion,
+                                                               pRequest ))
+                            return true;
+                    }
+
                     // ------------------------------------------------------
                     // Create new Instance of the Service Class so
                     // it's guaranteed to be on the same thread
@@ -419,6 +468,14 @@ bool ServiceHost::ProcessRequest( HTTPRequest *pRequest )
                                                     pRequest->m_mapParams);
 
                     bHandled = FormatResponse( pRequest, vResult );
+
+                    if (bHandled && bCacheable)
+                        ServiceCache::Instance()->Store( sCacheKey, nVersion,
+                                                         oInfo.m_cacheStamps,
+                                                         pRequest );
+
+                    if (pRequest->m_eType == RequestTypePost)
+                        ServiceCache::Instance()->Invalidate( m_sName );
                 }
             }
 
@@ -462,6 +519,32 @@ bool ServiceHost::ProcessRequest( HTTPRequest *pRequest )
     return bHandled;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// Everything a response depends on besides the stamps: the method, its
+// arguments (names are case insensitive, as in MethodInfo::Invoke) and
+// the format asked for.
+/////////////////////////////////////////////////////////////////////////////
+
+QString ServiceHost::GetCacheKey( HTTPRequest   *pRequest,
+                                  const QString &sMethodName ) const
+{
+    QStringMap lowerParams;
+
+    QStringMap::const_iterator it = pRequest->m_mapParams.constBegin();
+
+    for (; it != pRequest->m_mapParams.constEnd(); ++it)
+        lowerParams[ it.key().toLower() ] = it.value();
+
+    QStringList params;
+
+    for (it = lowerParams.constBegin(); it != lowerParams.constEnd(); ++it)
+        params << it.key() + "=" + it.value();
+
+    return QString( "%1/%2?%3 %4" )
+               .arg( m_sBaseUrl, sMethodName, params.join( "&" ),
+                     pRequest->GetRequestHeader( "Accept", "*/*" ));
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //
 /////////////////////////////////////////////////////////////////////////////
@@ -476,6 +559,7 @@ bool ServiceHost::FormatResponse( HTTPRequest *pRequest, QObject *pResults )
 
         pRequest->FormatActionResponse( pSer );
 
+        delete pSer;
         delete pResults;
 
         return true;
@@ -541,5 +625,7 @@ bool ServiceHost::FormatResponse( HTTPRequest *pRequest, QVariant vValue )
 
     pRequest->FormatActionResponse( pSer );
 
+    delete pSer;
+
     return true;
 }
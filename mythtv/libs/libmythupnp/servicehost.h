@@ -38,6 +38,7 @@ class UPNP_PUBLIC MethodInfo
         QString         m_sName;
         QMetaMethod     m_oMethod;
         RequestType     m_eRequestType;
+        QStringList     m_cacheStamps;  // Empty if responses aren't cached
 
     public:
         MethodInfo();
@@ -72,6 +73,8 @@ class UPNP_PUBLIC ServiceHost : public HttpServerExtension
         virtual bool FormatResponse( HTTPRequest *pRequest, QFileInfo  oInfo    );
         virtual bool FormatResponse( HTTPRequest *pRequest, QVariant   vValue   );
 
+        QString GetCacheKey( HTTPRequest *pRequest, const QString &sMethodName ) const;
+
     public:
 
                  ServiceHost( const QMetaObject &metaObject,
@@ -0,0 +1,377 @@
+/*
+ *  Class TestHttpServer
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+
+#include "mythcorecontext.h"
+#include "httpserver.h"
+
+// Connections parked at once by ParkedConnectionsResume
+static const int kConnections   = 20;
+// Client threads used by the load test, which only runs when
+// MYTH_HTTP_LOAD_CONNECTIONS is set to the number of connections it holds
+// open. Each also uses a descriptor in the server, so that is reduced to
+// fit the process limit.
+static const int kClientThreads = 16;
+
+/// Answers every request under /<name> with "pong"
+class PongExtension : public HttpServerExtension
+{
+  public:
+    PongExtension(const QString &name, int timeout)
+        : HttpServerExtension(name, QString())
+    {
+        m_nSocketTimeout = timeout;
+    }
+
+    QStringList GetBasePaths(void) override
+    {
+        return QStringList("/" + m_sName);
+    }
+
+    bool ProcessRequest(HTTPRequest *pRequest) override
+    {
+        if (pRequest->m_sBaseUrl != "/" + m_sName)
+            return false;
+
+        pRequest->m_eResponseType   = ResponseTypeText;
+        pRequest->m_nResponseStatus = 200;
+        pRequest->m_response.write("pong");
+        return true;
+    }
+};
+
+static int connect_to(quint16 port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    struct sockaddr_in addr {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                  sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    struct timeval timeout {10, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+static bool send_all(int fd, const QByteArray &data)
+{
+    for (int sent = 0; sent < data.size(); )
+    {
+        ssize_t n = send(fd, data.constData() + sent, data.size() - sent,
+                         MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+static QByteArray request_head(const QString &path)
+{
+    return QString("GET %1 HTTP/1.1\r\n"
+                   "Host: localhost\r\n"
+                   "Connection: keep-alive\r\n\r\n").arg(path).toLatin1();
+}
+
+/// Reads one response, returns true if it was a "200 OK" with "pong"
+static bool read_pong(int fd)
+{
+    QByteArray response;
+    int headEnd = -1;
+    int length  = -1;
+    char buffer[4096];
+
+    while (headEnd < 0 || response.size() < headEnd + 4 + length)
+    {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+            return false;
+        response.append(buffer, n);
+
+        if (headEnd < 0 && (headEnd = response.indexOf("\r\n\r\n")) >= 0)
+        {
+            QRegExp re("Content-Length:\\s*(\\d+)", Qt::CaseInsensitive);
+            if (re.indexIn(QString::fromLatin1(response.left(headEnd))) < 0)
+                return false;
+            length = re.cap(1).toInt();
+        }
+    }
+
+    return response.startsWith("HTTP/1.1 200") && response.endsWith("pong");
+}
+
+static bool request(int fd, const QString &path)
+{
+    return send_all(fd, request_head(path)) && read_pong(fd);
+}
+
+class TestHttpServer : public QObject
+{
+    Q_OBJECT
+
+    HttpServer *m_server      {nullptr};
+    quint16     m_port        {0};
+
+    /// Runs the client side on other threads while this one runs the
+    /// server's event loop, which accepts the connections
+    template <typename Client>
+    void Drive(int threads, Client client)
+    {
+        std::atomic<int> running {threads};
+        std::vector<std::thread> clients;
+        for (int i = 0; i < threads; i++)
+        {
+            clients.emplace_back([&running, client, i]()
+            {
+                client(i);
+                running--;
+            });
+        }
+
+        while (running > 0)
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+
+        for (auto &thread : clients)
+            thread.join();
+    }
+
+  private slots:
+    void initTestCase(void)
+    {
+        gCoreContext = new MythCoreContext("bin_version", nullptr);
+
+        m_server = new HttpServer();
+        m_server->RegisterExtension(new PongExtension("load", 60));
+        m_server->RegisterExtension(new PongExtension("short", 1));
+        QVERIFY(m_server->listen(QList<QHostAddress>() << QHostAddress::LocalHost,
+                                 0, true));
+        m_port = m_server->serverPort();
+    }
+
+    void cleanupTestCase(void)
+    {
+        delete m_server;
+        m_server = nullptr;
+    }
+
+    void KeepAliveReusesConnection(void)
+    {
+        bool ok = false;
+        int fd = -1;
+        Drive(1, [&](int)
+        {
+            fd = connect_to(m_port);
+            ok = fd >= 0 && request(fd, "/load/ping") &&
+                 request(fd, "/load/ping") && request(fd, "/load/ping");
+        });
+        QVERIFY(ok);
+
+#ifdef __linux__
+        // Waiting for its next request without a worker
+        QTRY_COMPARE(m_server->GetParkedConnectionCount(), 1);
+#endif
+
+        close(fd);
+
+#ifdef __linux__
+        QTRY_COMPARE(m_server->GetParkedConnectionCount(), 0);
+#endif
+    }
+
+    // The head of a request arriving in pieces must still be answered
+    void SplitRequestHead(void)
+    {
+        bool ok = false;
+        Drive(1, [&](int)
+        {
+            int fd = connect_to(m_port);
+            QByteArray head = request_head("/load/ping");
+            ok = fd >= 0 && send_all(fd, head.left(10));
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            ok = ok && send_all(fd, head.mid(10)) && read_pong(fd);
+            close(fd);
+        });
+        QVERIFY(ok);
+    }
+
+    // An idle connection is closed once its keep-alive timeout is up, even
+    // when it is the only one parked. The server closing it makes recv()
+    // return 0, while -1 means the client's own, ten times longer, receive
+    // timeout ran out first.
+    void IdleConnectionTimesOut(void)
+    {
+        bool ok = false;
+        ssize_t closed = -1;
+        int error = 0;
+        qint64 waited = 0;
+        Drive(1, [&](int)
+        {
+            int fd = connect_to(m_port);
+            ok = fd >= 0 && request(fd, "/short/ping");
+            QElapsedTimer timer;
+            timer.start();
+            char c;
+            do
+                closed = recv(fd, &c, 1, 0);
+            while (closed < 0 && errno == EINTR);
+            error = errno;
+            waited = timer.elapsed();
+            close(fd);
+        });
+        QVERIFY(ok);
+        QVERIFY2(closed == 0,
+                 qPrintable(QString("recv() returned %1 after %2 ms (%3)")
+                            .arg(closed).arg(waited).arg(strerror(error))));
+    }
+
+    // Connections parked together are each handed back to a worker when
+    // their next request arrives, and answered
+    void ParkedConnectionsResume(void)
+    {
+        std::vector<int> fds(kConnections, -1);
+        int answered = 0;
+
+        Drive(1, [&](int)
+        {
+            for (int &fd : fds)
+            {
+                fd = connect_to(m_port);
+                if (fd >= 0 && request(fd, "/load/ping"))
+                    answered++;
+            }
+        });
+        QCOMPARE(answered, kConnections);
+
+#ifdef __linux__
+        QTRY_COMPARE(m_server->GetParkedConnectionCount(), kConnections);
+#endif
+
+        answered = 0;
+        Drive(1, [&](int)
+        {
+            for (int fd : fds)
+                send_all(fd, request_head("/load/ping"));
+            for (int fd : fds)
+                if (read_pong(fd))
+                    answered++;
+        });
+        QCOMPARE(answered, kConnections);
+
+        for (int fd : fds)
+            close(fd);
+
+#ifdef __linux__
+        QTRY_COMPARE(m_server->GetParkedConnectionCount(), 0);
+#endif
+    }
+
+    // Holds thousands of keep-alive connections open, while a new client
+    // is still answered promptly, then has every one of them make another
+    // request at once. Its timing depends on the machine, so it only runs
+    // when asked for with MYTH_HTTP_LOAD_CONNECTIONS.
+    void ThousandsOfConnections(void)
+    {
+        if (!qEnvironmentVariableIsSet("MYTH_HTTP_LOAD_CONNECTIONS"))
+            QSKIP("Set MYTH_HTTP_LOAD_CONNECTIONS to run the load test");
+
+        struct rlimit limit {};
+        getrlimit(RLIMIT_NOFILE, &limit);
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+
+        int connections = qgetenv("MYTH_HTTP_LOAD_CONNECTIONS").toInt();
+        rlim_t available = qMin(limit.rlim_cur, rlim_t(1 << 20)) - 100;
+        connections = qMin(connections, int(available / 2));
+
+        std::vector<int> fds(connections, -1);
+        std::atomic<int> answered {0};
+
+        Drive(kClientThreads, [&](int thread)
+        {
+            for (int i = thread; i < int(fds.size()); i += kClientThreads)
+            {
+                fds[i] = connect_to(m_port);
+                if (fds[i] >= 0 && request(fds[i], "/load/ping"))
+                    answered++;
+            }
+        });
+        QCOMPARE(int(answered), connections);
+
+#ifdef __linux__
+        QTRY_COMPARE(m_server->GetParkedConnectionCount(), connections);
+#endif
+
+        bool ok = false;
+        QElapsedTimer timer;
+        timer.start();
+        Drive(1, [&](int)
+        {
+            int fd = connect_to(m_port);
+            ok = fd >= 0 && request(fd, "/load/ping");
+            close(fd);
+        });
+        QVERIFY(ok);
+        QVERIFY2(timer.elapsed() < 1000,
+                 qPrintable(QString("New client waited %1 ms")
+                            .arg(timer.elapsed())));
+
+        answered = 0;
+        Drive(kClientThreads, [&](int thread)
+        {
+            for (int i = thread; i < int(fds.size()); i += kClientThreads)
+                send_all(fds[i], request_head("/load/ping"));
+            for (int i = thread; i < int(fds.size()); i += kClientThreads)
+                if (read_pong(fds[i]))
+                    answered++;
+        });
+        QCOMPARE(int(answered), connections);
+
+        for (int fd : fds)
+            close(fd);
+
+#ifdef __linux__
+        QTRY_COMPARE(m_server->GetParkedConnectionCount(), 0);
+#endif
+    }
+};
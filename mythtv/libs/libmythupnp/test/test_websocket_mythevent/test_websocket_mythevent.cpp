@@ -0,0 +1,3 @@
+#include "test_websocket_mythevent.h"
+
+QTEST_APPLESS_MAIN(TestWebSocketMythEvent)
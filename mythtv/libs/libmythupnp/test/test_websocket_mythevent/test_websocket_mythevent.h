@@ -0,0 +1,111 @@
+/*
+ *  Class TestWebSocketMythEvent
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+
+#include "mythcorecontext.h"
+#include "mythevent.h"
+#include "websocket_mythevent.h"
+
+class TestWebSocketMythEvent : public QObject
+{
+    Q_OBJECT
+
+    static bool Command(WebSocketMythEvent &extension, const QString &text)
+    {
+        WebSocketFrame frame;
+        frame.payload = text.toUtf8();
+        frame.payloadSize = frame.payload.size();
+        frame.finalFrame = true;
+        return extension.HandleTextFrame(frame);
+    }
+
+    /// Dispatches the events to the extension, returns what it sent
+    static QStringList Send(WebSocketMythEvent &extension,
+                            const QStringList &events)
+    {
+        QSignalSpy spy(&extension, SIGNAL(SendTextMessage(const QString &)));
+        foreach (const QString &event, events)
+        {
+            MythEvent me(event);
+            extension.customEvent(&me);
+        }
+
+        QStringList sent;
+        for (int i = 0; i < spy.count(); i++)
+            sent << spy.at(i).at(0).toString();
+        return sent;
+    }
+
+    QStringList m_events;
+
+  private slots:
+    void initTestCase(void)
+    {
+        gCoreContext = new MythCoreContext("bin_version", nullptr);
+
+        m_events << "SYSTEM_EVENT REC_STARTED CARDID 1 SENDER backend"
+                 << "SYSTEM_EVENT REC_FINISHED CARDID 1 SENDER backend"
+                 << "SCHEDULE_CHANGE"
+                 << "JOB_PROGRESS 12 45% Completed @ 30 fps."
+                 << "JOB_STATUS 12 272 Finished."
+                 << "ENCODER_STATE 1 RecordingOnly";
+    }
+
+    void NothingUntilEnabled(void)
+    {
+        WebSocketMythEvent extension;
+        QVERIFY(Command(extension, "WS_EVENT_SET_FILTER ALL"));
+        QVERIFY(Send(extension, m_events).isEmpty());
+
+        QVERIFY(Command(extension, "WS_EVENT_ENABLE"));
+        QCOMPARE(Send(extension, m_events).size(), m_events.size());
+
+        QVERIFY(Command(extension, "WS_EVENT_DISABLE"));
+        QVERIFY(Send(extension, m_events).isEmpty());
+    }
+
+    void Filters(void)
+    {
+        WebSocketMythEvent extension;
+        QVERIFY(Command(extension, "WS_EVENT_ENABLE"));
+        QVERIFY(Send(extension, m_events).isEmpty());
+
+        QVERIFY(Command(extension, "WS_EVENT_SET_FILTER SCHEDULE_CHANGE REC_*"));
+        QCOMPARE(Send(extension, m_events), QStringList()
+                 << "REC_STARTED CARDID 1 SENDER backend"
+                 << "REC_FINISHED CARDID 1 SENDER backend"
+                 << "SCHEDULE_CHANGE");
+
+        QVERIFY(Command(extension, "WS_EVENT_ADD_FILTER JOB_PROGRESS"));
+        QVERIFY(Command(extension, "WS_EVENT_REMOVE_FILTER REC_*"));
+        QCOMPARE(Send(extension, m_events), QStringList()
+                 << "SCHEDULE_CHANGE"
+                 << "JOB_PROGRESS 12 45% Completed @ 30 fps.");
+
+        QVERIFY(Command(extension, "WS_EVENT_SET_FILTER"));
+        QVERIFY(Send(extension, m_events).isEmpty());
+    }
+
+    void OtherFramesIgnored(void)
+    {
+        WebSocketMythEvent extension;
+        QVERIFY(!Command(extension, "HELLO"));
+    }
+};
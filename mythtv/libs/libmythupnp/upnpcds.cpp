@@ -15,6 +15,8 @@
 #include <cstdint>
 using namespace std;
 
+#include <QTextStream>
+
 #include "upnp.h"
 #include "upnpcds.h"
 #include "upnputil.h"
@@ -58,15 +60,28 @@ void UPnpCDSExtensionResults::Add( CDSObjects objects )
 QString UPnpCDSExtensionResults::GetResultXML(FilterMap &filter,
                                               bool ignoreChildren)
 {
-    QString sXML;
+    QString     sXML;
+    QTextStream os( &sXML, QIODevice::WriteOnly );
 
-    CDSObjects::const_iterator it = m_List.begin();
-    for (; it != m_List.end(); ++it)
-        sXML += (*it)->toXml(filter, ignoreChildren);
+    WriteResultXML( os, filter, ignoreChildren );
+    os.flush();
 
     return sXML;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// Writes the objects straight into the result, rather than building a
+// string for each of them to be appended.
+/////////////////////////////////////////////////////////////////////////////
+
+void UPnpCDSExtensionResults::WriteResultXML(QTextStream &os, FilterMap &filter,
+                                             bool ignoreChildren)
+{
+    CDSObjects::const_iterator it = m_List.begin();
+    for (; it != m_List.end(); ++it)
+        (*it)->toXml(os, filter, ignoreChildren);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //
 /////////////////////////////////////////////////////////////////////////////
@@ -408,9 +423,12 @@ void UPnpCDS::HandleBrowse( HTTPRequest *pRequest )
     uint16_t       nNumberReturned = 0;
     uint16_t       nTotalMatches   = 0;
     uint16_t       nUpdateID       = 0;
-    QString        sResultXML;
+    QString        sResults;
+    QTextStream    os( &sResults, QIODevice::WriteOnly );
     FilterMap filter =  request.m_sFilter.split(',');
 
+    os << DIDL_LITE_BEGIN;
+
     LOG(VB_UPNP, LOG_INFO,
         QString("UPnpCDS::HandleBrowse ObjectID=%1")
             .arg(request.m_sObjectId));
@@ -437,7 +455,7 @@ void UPnpCDS::HandleBrowse( HTTPRequest *pRequest )
                 m_root.SetChildCount( m_extensions.count() );
                 m_root.SetChildContainerCount( m_extensions.count() );
 
-                sResultXML      = m_root.toXml(filter);
+                m_root.toXml(os, filter);
 
                 break;
             }
@@ -465,7 +483,7 @@ void UPnpCDS::HandleBrowse( HTTPRequest *pRequest )
                 {
                     UPnpCDSExtension *pExtension = m_extensions[i];
                     CDSObject* pExtensionRoot = pExtension->GetRoot();
-                    sResultXML += pExtensionRoot->toXml(filter, true); // Ignore Children
+                    pExtensionRoot->toXml(os, filter, true); // Ignore Children
                     nNumberReturned ++;
                 }
 
@@ -501,9 +519,9 @@ void UPnpCDS::HandleBrowse( HTTPRequest *pRequest )
                 nTotalMatches   = pResult->m_nTotalMatches;
                 nUpdateID       = pResult->m_nUpdateID;
                 if (request.m_eBrowseFlag == CDS_BrowseMetadata)
-                    sResultXML      = pResult->GetResultXML(filter, true); // Ignore children
+                    pResult->WriteResultXML(os, filter, true); // Ignore children
                 else
-                    sResultXML      = pResult->GetResultXML(filter);
+                    pResult->WriteResultXML(os, filter);
             }
 
             delete pResult;
@@ -519,9 +537,8 @@ void UPnpCDS::HandleBrowse( HTTPRequest *pRequest )
     {
         NameValues list;
 
-        QString sResults = DIDL_LITE_BEGIN;
-        sResults += sResultXML;
-        sResults += DIDL_LITE_END;
+        os << DIDL_LITE_END;
+        os.flush();
 
         list.push_back(NameValue("Result",         sResults));
         list.push_back(NameValue("NumberReturned", nNumberReturned));
@@ -549,7 +566,8 @@ void UPnpCDS::HandleSearch( HTTPRequest *pRequest )
     uint16_t         nNumberReturned = 0;
     uint16_t         nTotalMatches   = 0;
     uint16_t         nUpdateID       = 0;
-    QString       sResultXML;
+    QString       sResults;
+    QTextStream   os( &sResults, QIODevice::WriteOnly );
 
     DetermineClient( pRequest, &request );
     request.m_sObjectId         = pRequest->m_mapParams[ "objectid"      ];
@@ -643,7 +661,10 @@ void UPnpCDS::HandleSearch( HTTPRequest *pRequest )
             nNumberReturned = pResult->m_List.count();
             nTotalMatches   = pResult->m_nTotalMatches;
             nUpdateID       = pResult->m_nUpdateID;
-            sResultXML      = pResult->GetResultXML(filter);
+            os << DIDL_LITE_BEGIN;
+            pResult->WriteResultXML(os, filter);
+            os << DIDL_LITE_END;
+            os.flush();
 #if 0
             bSearchDone = true;
 #endif
@@ -655,15 +676,12 @@ void UPnpCDS::HandleSearch( HTTPRequest *pRequest )
 
 #if 0
     nUpdateID       = 0;
-    LOG(VB_UPNP, LOG_DEBUG, sResultXML);
+    LOG(VB_UPNP, LOG_DEBUG, sResults);
 #endif
 
     if (eErrorCode == UPnPResult_Success)
     {
         NameValues list;
-        QString sResults = DIDL_LITE_BEGIN;
-        sResults += sResultXML;
-        sResults += DIDL_LITE_END;
 
         list.push_back(NameValue("Result",         sResults));
         list.push_back(NameValue("NumberReturned", nNumberReturned));
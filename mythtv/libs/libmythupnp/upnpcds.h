@@ -135,6 +135,8 @@ class UPNP_PUBLIC UPnpCDSExtensionResults
         void    Add         ( CDSObject *pObject );
         void    Add         ( CDSObjects objects );
         QString GetResultXML(FilterMap &filter, bool ignoreChildren = false);
+        void    WriteResultXML(QTextStream &os, FilterMap &filter,
+                               bool ignoreChildren = false);
 };
 
 //////////////////////////////////////////////////////////////////////////////
@@ -329,7 +329,7 @@ void CDSObject::toXml( QTextStream &os, FilterMap &filter,
             if (!bFilter || filter.contains("@childContainerCount"))
                 os << "\" childContainerCount=\"" << GetChildContainerCount();
 
-               os << "\" >" << endl;
+               os << "\" >" << '\n';
 
             sEndTag = "</container>";
 
@@ -343,7 +343,7 @@ void CDSObject::toXml( QTextStream &os, FilterMap &filter,
             os << "<item id=\"" << m_sId
                << "\" parentID=\"" << m_sParentId
                << "\" restricted=\"" << GetBool( m_bRestricted )
-               << "\" >" << endl;
+               << "\" >" << '\n';
 
             sEndTag = "</item>";
 
@@ -352,8 +352,8 @@ void CDSObject::toXml( QTextStream &os, FilterMap &filter,
         default: break;
     }
 
-    os << "<dc:title>"   << m_sTitle << "</dc:title>" << endl;
-    os << "<upnp:class>" << m_sClass << "</upnp:class>" << endl;
+    os << "<dc:title>"   << m_sTitle << "</dc:title>" << '\n';
+    os << "<upnp:class>" << m_sClass << "</upnp:class>" << '\n';
 
     // ----------------------------------------------------------------------
     // Output all Properties
@@ -378,7 +378,7 @@ void CDSObject::toXml( QTextStream &os, FilterMap &filter,
                 FilterContains(filter, sName))
             {
                 bool filterAttributes = true;
-                if (!bFilter || filter.contains(QString("%1#").arg(sName)))
+                if (!bFilter || filter.contains(sName + '#'))
                     filterAttributes = false;
 
                 os << "<"  << sName;
@@ -386,16 +386,14 @@ void CDSObject::toXml( QTextStream &os, FilterMap &filter,
                 NameValues::const_iterator nit = pProp->m_lstAttributes.begin();
                 for (; nit != pProp->m_lstAttributes.end(); ++ nit)
                 {
-                    QString filterName = QString("%1@%2").arg(sName)
-                                                         .arg((*nit).sName);
                     if ((*nit).bRequired  || !filterAttributes ||
-                        filter.contains(filterName))
+                        filter.contains(sName + '@' + (*nit).sName))
                         os << " " << (*nit).sName << "=\"" << (*nit).sValue << "\"";
                 }
 
                 os << ">";
                 os << pProp->GetEncodedValue();
-                os << "</" << sName << ">" << endl;
+                os << "</" << sName << ">" << '\n';
             }
         }
     }
@@ -414,18 +412,16 @@ void CDSObject::toXml( QTextStream &os, FilterMap &filter,
         {
             os << "<res protocolInfo=\"" << (*rit)->m_sProtocolInfo << "\" ";
 
-            QString filterName;
             NameValues::const_iterator nit = (*rit)->m_lstAttributes.begin();
             for (; nit != (*rit)->m_lstAttributes.end(); ++ nit)
             {
-                filterName = QString("res@%1").arg((*nit).sName);
                 if ((*nit).bRequired  || !filterAttributes ||
-                    filter.contains(filterName))
+                    filter.contains("res@" + (*nit).sName))
                     os << (*nit).sName << "=\"" << (*nit).sValue << "\" ";
             }
 
             os << ">" << (*rit)->m_sURI;
-            os << "</res>" << endl;
+            os << "</res>" << '\n';
         }
     }
 
@@ -444,8 +440,7 @@ void CDSObject::toXml( QTextStream &os, FilterMap &filter,
     // Close Element Tag
     // ----------------------------------------------------------------------
 
-    os << sEndTag << endl;
-    os << flush;
+    os << sEndTag << '\n';
 }
 
 
@@ -47,6 +47,43 @@ bool WebSocketMythEvent::HandleTextFrame(const WebSocketFrame &frame)
         QString filterString = m_filters.join(", ");
         LOG(VB_HTTP, LOG_NOTICE, QString("WebSocketMythEvent: Updated filters (%1)").arg(filterString));
     }
+    else if (tokens[0] == "WS_EVENT_ADD_FILTER")
+    {
+        foreach (const QString &filter, tokens.mid(1))
+        {
+            if (!m_filters.contains(filter))
+                m_filters.append(filter);
+        }
+
+        QString filterString = m_filters.join(", ");
+        LOG(VB_HTTP, LOG_NOTICE, QString("WebSocketMythEvent: Updated filters (%1)").arg(filterString));
+    }
+    else if (tokens[0] == "WS_EVENT_REMOVE_FILTER")
+    {
+        foreach (const QString &filter, tokens.mid(1))
+            m_filters.removeAll(filter);
+
+        QString filterString = m_filters.join(", ");
+        LOG(VB_HTTP, LOG_NOTICE, QString("WebSocketMythEvent: Updated filters (%1)").arg(filterString));
+    }
+    else
+    {
+        // Not for us
+        return false;
+    }
+
+    return true;
+}
+
+bool WebSocketMythEvent::IsSubscribed(const QString &event) const
+{
+    foreach (const QString &filter, m_filters)
+    {
+        if (filter == "ALL" || filter == event)
+            return true;
+        if (filter.endsWith('*') && event.startsWith(filter.left(filter.length() - 1)))
+            return true;
+    }
 
     return false;
 }
@@ -70,7 +107,7 @@ void WebSocketMythEvent::customEvent(QEvent* event)
             return;
 
         // If no-one is listening for this event, then ignore it
-        if (!m_filters.contains("ALL") && !m_filters.contains(tokens[0]))
+        if (!IsSubscribed(tokens[0]))
             return;
 
         SendTextMessage(message);
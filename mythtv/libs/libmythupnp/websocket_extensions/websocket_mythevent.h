@@ -9,9 +9,22 @@
  *
  *  \brief Extension for sending MythEvents over WebSocketServer
  *
+ * Clients control what they receive with text frames:
+ *
+ *   WS_EVENT_ENABLE                    start sending events
+ *   WS_EVENT_DISABLE                   stop sending events
+ *   WS_EVENT_SET_FILTER [EVENT ...]    only send these events
+ *   WS_EVENT_ADD_FILTER EVENT ...      also send these events
+ *   WS_EVENT_REMOVE_FILTER EVENT ...   stop sending these events
+ *
+ * An EVENT is the first word of the event's message (REC_STARTED,
+ * SCHEDULE_CHANGE, JOB_PROGRESS...), ALL, or a prefix ending in '*' such
+ * as REC_* or JOB_*. Each event is sent as a text frame holding its message,
+ * without the SYSTEM_EVENT prefix of system events.
+ *
  * \ingroup WebSocket_Extensions
  */
-class WebSocketMythEvent : public WebSocketExtension
+class UPNP_PUBLIC WebSocketMythEvent : public WebSocketExtension
 {
   Q_OBJECT
 
@@ -23,6 +36,8 @@ class WebSocketMythEvent : public WebSocketExtension
     void customEvent(QEvent*) override; // QObject
 
   private:
+    bool IsSubscribed(const QString &event) const;
+
     QStringList m_filters;
     bool m_sendEvents; /// True if the client has enabled events
 };
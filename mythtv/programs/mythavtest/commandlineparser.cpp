@@ -50,5 +50,27 @@ void MythAVTestCommandLineParser::LoadArguments(void)
                     "The number of seconds to run the test (default 5).", "")
                     ->SetGroup("Video Performance Testing")
                     ->SetChildOf("test");
+    add(QStringList{"--headless"},
+                    "headless", false,
+                    "Decode into the null video output without a display.",
+                    "Play the file into the null video output. No display, "
+                    "theme or audio configuration is required, which makes "
+                    "the results reproducible across machines.")
+                    ->SetGroup("Video Performance Testing")
+                    ->SetChildOf("test");
+    add(QStringList{"--realtime"},
+                    "realtime", false,
+                    "Pace frames at the video frame rate.",
+                    "Present frames at the video frame rate rather than as "
+                    "fast as possible, dropping frames that are late. Audio is "
+                    "played into the null audio output so that A/V sync "
+                    "drift can be measured.")
+                    ->SetGroup("Video Performance Testing")
+                    ->SetChildOf("test");
+    add(QStringList{"--json"}, "json", "",
+                    "Write the results as JSON to the given file ('-' for stdout).",
+                    "")
+                    ->SetGroup("Video Performance Testing")
+                    ->SetChildOf("test");
 }
 
@@ -7,13 +7,18 @@ using namespace std;
 #include <QRegExp>
 #include <QDir>
 #include <QApplication>
+#include <QScopedPointer>
 #include <QTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 #include "tv_play.h"
 #include "programinfo.h"
 #include "commandlineparser.h"
 #include "mythplayer.h"
 #include "jitterometer.h"
+#include "audiooutput.h"
 
 #include "exitcodes.h"
 #include "mythcontext.h"
@@ -24,6 +29,7 @@ using namespace std;
 #include "mythlogging.h"
 #include "signalhandling.h"
 #include "mythmiscutil.h"
+#include "mythtimer.h"
 #include "videooutbase.h"
 
 // libmythui
@@ -34,9 +40,11 @@ class VideoPerformanceTest
 {
   public:
     VideoPerformanceTest(const QString &filename, bool novsync, bool onlydecode,
-                         int runfor, bool deint, bool gpu)
+                         int runfor, bool deint, bool gpu, bool nullvideo,
+                         bool paced, const QString &jsonfile)
       : file(filename), novideosync(novsync), decodeonly(onlydecode),
-        secondstorun(runfor), deinterlace(deint), allowgpu(gpu), ctx(nullptr)
+        secondstorun(runfor), deinterlace(deint), allowgpu(gpu),
+        headless(nullvideo), realtime(paced), json(jsonfile), ctx(nullptr)
     {
         if (secondstorun < 1)
             secondstorun = 1;
@@ -49,46 +57,72 @@ class VideoPerformanceTest
         delete ctx;
     }
 
-    void Test(void)
+    bool Test(void)
     {
         PIPMap dummy;
 
         if (novideosync) // TODO
             LOG(VB_GENERAL, LOG_INFO, "Will attempt to disable sync-to-vblank.");
 
+        int flags = kAudioMuted;
+        if (allowgpu)
+            flags |= kDecodeAllowGPU;
+        if (headless)
+            flags |= kVideoIsNull | kNoITV;
+
         RingBuffer *rb  = RingBuffer::Create(file, false, true, 2000);
-        MythPlayer  *mp  = new MythPlayer((PlayerFlags)(kAudioMuted | (allowgpu ? kDecodeAllowGPU : kNoFlags)));
+        MythPlayer  *mp  = new MythPlayer((PlayerFlags)flags);
         mp->GetAudio()->SetAudioInfo("NULL", "NULL", 0, 0);
-        mp->GetAudio()->SetNoAudio();
+        if (realtime)
+        {
+            // Play the audio into the NULL sound card so that the audio
+            // clock runs and A/V sync can be measured
+            mp->GetAudio()->SetAudioOutput(
+                AudioOutput::OpenAudio("NULL", "NULL", false));
+        }
+        else
+        {
+            mp->GetAudio()->SetNoAudio();
+        }
         ctx = new PlayerContext("VideoPerformanceTest");
         ctx->SetRingBuffer(rb);
         ctx->SetPlayer(mp);
         ctx->SetPlayingInfo(new ProgramInfo(file));
-        mp->SetPlayerInfo(nullptr, GetMythMainWindow(), ctx);
+        mp->SetPlayerInfo(nullptr, headless ? nullptr : GetMythMainWindow(),
+                          ctx);
 
         FrameScanType scan = deinterlace ? kScan_Interlaced : kScan_Progressive;
         if (!mp->StartPlaying())
         {
             LOG(VB_GENERAL, LOG_ERR, "Failed to start playback.");
-            return;
+            return false;
         }
 
         VideoOutput *vo = mp->GetVideoOutput();
         if (!vo)
         {
             LOG(VB_GENERAL, LOG_ERR, "No video output.");
-            return;
+            return false;
         }
 
         LOG(VB_GENERAL, LOG_INFO, "-----------------------------------");
-        LOG(VB_GENERAL, LOG_INFO, "Ensure Sync to VBlank is disabled.");
-        LOG(VB_GENERAL, LOG_INFO, "Otherwise rate will be limited to that of the display.");
-        LOG(VB_GENERAL, LOG_INFO, "-----------------------------------");
+        if (!headless && !realtime)
+        {
+            LOG(VB_GENERAL, LOG_INFO, "Ensure Sync to VBlank is disabled.");
+            LOG(VB_GENERAL, LOG_INFO, "Otherwise rate will be limited to that of the display.");
+            LOG(VB_GENERAL, LOG_INFO, "-----------------------------------");
+        }
         LOG(VB_GENERAL, LOG_INFO, QString("Starting video performance test for '%1'.")
             .arg(file));
         LOG(VB_GENERAL, LOG_INFO, QString("Test will run for %1 seconds.")
             .arg(secondstorun));
 
+        if (headless)
+            LOG(VB_GENERAL, LOG_INFO, "Headless - using the null video output.");
+
+        if (realtime)
+            LOG(VB_GENERAL, LOG_INFO, "Pacing frames at the video frame rate.");
+
         if (decodeonly)
             LOG(VB_GENERAL, LOG_INFO, "Decoding frames only - skipping display.");
 
@@ -109,14 +143,34 @@ class VideoPerformanceTest
         if (dec)
             LOG(VB_GENERAL, LOG_INFO, QString("Using decoder: %1").arg(dec->GetCodecDecoderName()));
 
-        Jitterometer *jitter = new Jitterometer("Performance: ", mp->GetFrameRate() * (doublerate ? 2 : 1));
+        double framerate = mp->GetFrameRate();
+        if (framerate < 1.0 || framerate > 120.0)
+            framerate = 25.0;
+        int cycles = (int)framerate * (doublerate ? 2 : 1);
+        int64_t interval = (int64_t)(1000000000.0 / framerate); // nanoseconds
+
+        Jitterometer *jitter  = new Jitterometer("Performance: ", cycles);
+        Jitterometer *decode  = new Jitterometer("Decode wait: ", cycles);
+        Jitterometer *process = new Jitterometer("Process: ", cycles);
+        Jitterometer *display = new Jitterometer("Display: ", cycles);
+
+        uint64_t frames  = 0;
+        uint64_t dropped = 0;
+        bool     haveav  = false;
+        int64_t  avbase  = 0;
+        int64_t  avsum   = 0;
+        int64_t  avmax   = 0;
+        uint64_t avcount = 0;
+        bool     ok      = true;
 
         int ms = secondstorun * 1000;
-        QTime start = QTime::currentTime();
+        MythTimer timer;
+        timer.start();
+        decode->RecordStartTime();
         while (true)
         {
-            int duration = start.msecsTo(QTime::currentTime());
-            if (duration < 0 || duration > ms)
+            int duration = timer.elapsed();
+            if (duration > ms)
             {
                 LOG(VB_GENERAL, LOG_INFO, "Complete.");
                 break;
@@ -125,6 +179,7 @@ class VideoPerformanceTest
             if (mp->IsErrored())
             {
                 LOG(VB_GENERAL, LOG_ERR, "Playback error.");
+                ok = false;
                 break;
             }
 
@@ -140,11 +195,53 @@ class VideoPerformanceTest
             mp->SetBuffering(false);
             vo->StartDisplayingFrame();
             VideoFrame *frame = vo->GetLastShownFrame();
+            decode->RecordEndTime();
             mp->CheckAspectRatio(frame);
 
-            if (!decodeonly)
+            bool drop = false;
+            if (realtime)
             {
+                // Hold each frame until it is due, and drop it if it is
+                // already a whole frame interval late
+                int64_t due  = (int64_t)frames * interval;
+                int64_t late = timer.nsecsElapsed() - due;
+                if (late < 0)
+                    usleep(-late / 1000);
+                else if (late > interval)
+                    drop = true;
+
+                int64_t audiotime = mp->GetAudio()->GetAudioTime();
+                if (frame && audiotime > 0 && !drop)
+                {
+                    // Report drift relative to the first measurement so
+                    // that the start up offset doesn't count
+                    int64_t offset = frame->timecode - audiotime;
+                    if (!haveav)
+                    {
+                        avbase = offset;
+                        haveav = true;
+                    }
+                    int64_t drift = offset - avbase;
+                    if (drift < 0)
+                        drift = -drift;
+                    avsum += drift;
+                    avmax  = max(avmax, drift);
+                    avcount++;
+                }
+            }
+            frames++;
+
+            if (drop)
+            {
+                dropped++;
+            }
+            else if (!decodeonly)
+            {
+                process->RecordStartTime();
                 vo->ProcessFrame(frame, nullptr, nullptr, dummy, scan);
+                process->RecordEndTime();
+
+                display->RecordStartTime();
                 vo->PrepareFrame(frame, scan, nullptr);
                 vo->Show(scan);
 
@@ -153,21 +250,108 @@ class VideoPerformanceTest
                     vo->PrepareFrame(frame, kScan_Intr2ndField, nullptr);
                     vo->Show(scan);
                 }
+                display->RecordEndTime();
             }
             vo->DoneDisplayingFrame(frame);
             jitter->RecordCycleTime();
+            decode->RecordStartTime();
         }
+        double seconds = timer.nsecsElapsed() / 1000000000.0;
         LOG(VB_GENERAL, LOG_INFO, "-----------------------------------");
+
+        if (!json.isEmpty())
+        {
+            QJsonObject result;
+            result["file"]        = file;
+            result["decoder"]     = dec ? dec->GetCodecDecoderName() : QString();
+            result["headless"]    = headless;
+            result["realtime"]    = realtime;
+            result["decodeonly"]  = decodeonly;
+            result["deinterlace"] = deinterlace;
+            result["framerate"]   = framerate;
+            result["seconds"]     = seconds;
+            result["frames"]      = (double)frames;
+            result["fps"]         = seconds > 0.0 ? frames / seconds : 0.0;
+            result["dropped"]     = (double)dropped;
+            result["completed"]   = ok;
+
+            QJsonObject avsync;
+            if (avcount)
+            {
+                avsync["samples"]  = (double)avcount;
+                avsync["mean_ms"]  = (double)avsum / avcount;
+                avsync["max_ms"]   = (double)avmax;
+                result["avsync"]   = avsync;
+            }
+            else
+            {
+                // No audio clock to compare against
+                result["avsync"]   = QJsonValue();
+            }
+
+            QJsonObject stages;
+            stages["cycle"]   = StageStats(jitter);
+            stages["decode"]  = StageStats(decode);
+            stages["process"] = StageStats(process);
+            stages["display"] = StageStats(display);
+            result["stages"]  = stages;
+
+            InfoMap decstats;
+            if (dec)
+                dec->GetDecoderStats(decstats);
+            QJsonObject decoder;
+            InfoMap::const_iterator it = decstats.begin();
+            for (; it != decstats.end(); ++it)
+                decoder[it.key()] = it.value();
+            result["decoderstats"] = decoder;
+
+            if (!WriteJson(QJsonDocument(result).toJson()))
+                ok = false;
+        }
+
         delete jitter;
+        delete decode;
+        delete process;
+        delete display;
+        return ok;
     }
 
   private:
+    static QJsonObject StageStats(const Jitterometer *stage)
+    {
+        QJsonObject stats;
+        stats["cycles"]  = (double)stage->GetTotalCycles();
+        stats["mean_us"] = stage->GetTotalMean();
+        stats["max_us"]  = (double)stage->GetTotalMax();
+        return stats;
+    }
+
+    bool WriteJson(const QByteArray &data)
+    {
+        QFile out(json);
+        bool opened;
+        if (json == "-")
+            opened = out.open(stdout, QIODevice::WriteOnly);
+        else
+            opened = out.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        if (!opened || out.write(data) != data.size())
+        {
+            LOG(VB_GENERAL, LOG_ERR, QString("Failed to write results to '%1'")
+                .arg(json));
+            return false;
+        }
+        return true;
+    }
+
     QString file;
     bool    novideosync;
     bool    decodeonly;
     int     secondstorun;
     bool    deinterlace;
     bool    allowgpu;
+    bool    headless;
+    bool    realtime;
+    QString json;
     PlayerContext *ctx;
 };
 
@@ -201,7 +385,10 @@ int main(int argc, char *argv[])
         return GENERIC_EXIT_OK;
     }
 
-    QApplication a(argc, argv);
+    // A headless benchmark needs neither a display nor a theme
+    bool headless = cmdline.toBool("test") && cmdline.toBool("headless");
+    QScopedPointer<QCoreApplication> app(headless ?
+        new QCoreApplication(argc, argv) : new QApplication(argc, argv));
     QCoreApplication::setApplicationName(MYTH_APPNAME_MYTHAVTEST);
 
     int retval;
@@ -225,7 +412,7 @@ int main(int argc, char *argv[])
         filename = cmdline.GetArgs()[0];
 
     gContext = new MythContext(MYTH_BINARY_VERSION, true);
-    if (!gContext->Init())
+    if (!gContext->Init(!headless))
     {
         LOG(VB_GENERAL, LOG_ERR, "Failed to init MythContext, exiting.");
         return GENERIC_EXIT_NO_MYTHCONTEXT;
@@ -233,36 +420,39 @@ int main(int argc, char *argv[])
 
     cmdline.ApplySettingsOverride();
 
-    QString themename = gCoreContext->GetSetting("Theme");
-    QString themedir = GetMythUI()->FindThemeDir(themename);
-    if (themedir.isEmpty())
+    if (!headless)
     {
-        QString msg = QString("Fatal Error: Couldn't find theme '%1'.")
-            .arg(themename);
-        LOG(VB_GENERAL, LOG_ERR, msg);
-        return GENERIC_EXIT_NO_THEME;
-    }
+        QString themename = gCoreContext->GetSetting("Theme");
+        QString themedir = GetMythUI()->FindThemeDir(themename);
+        if (themedir.isEmpty())
+        {
+            QString msg = QString("Fatal Error: Couldn't find theme '%1'.")
+                .arg(themename);
+            LOG(VB_GENERAL, LOG_ERR, msg);
+            return GENERIC_EXIT_NO_THEME;
+        }
 
-    GetMythUI()->LoadQtConfig();
+        GetMythUI()->LoadQtConfig();
 
 #if defined(Q_OS_MACX)
-    // Mac OS X doesn't define the AudioOutputDevice setting
+        // Mac OS X doesn't define the AudioOutputDevice setting
 #else
-    QString auddevice = gCoreContext->GetSetting("AudioOutputDevice");
-    if (auddevice.isEmpty())
-    {
-        LOG(VB_GENERAL, LOG_ERR, "Fatal Error: Audio not configured, you need "
-                                 "to run 'mythfrontend', not 'mythtv'.");
-        return GENERIC_EXIT_SETUP_ERROR;
-    }
+        QString auddevice = gCoreContext->GetSetting("AudioOutputDevice");
+        if (auddevice.isEmpty())
+        {
+            LOG(VB_GENERAL, LOG_ERR, "Fatal Error: Audio not configured, you need "
+                                     "to run 'mythfrontend', not 'mythtv'.");
+            return GENERIC_EXIT_SETUP_ERROR;
+        }
 #endif
 
-    MythMainWindow *mainWindow = GetMythMainWindow();
+        MythMainWindow *mainWindow = GetMythMainWindow();
 #if CONFIG_DARWIN
-    mainWindow->Init(OPENGL2_PAINTER);
+        mainWindow->Init(OPENGL2_PAINTER);
 #else
-    mainWindow->Init();
+        mainWindow->Init();
 #endif
+    }
 
 #ifndef _WIN32
     QList<int> signallist;
@@ -283,8 +473,10 @@ int main(int argc, char *argv[])
         VideoPerformanceTest *test = new VideoPerformanceTest(filename, false,
                     cmdline.toBool("decodeonly"), seconds,
                     cmdline.toBool("deinterlace"),
-                    cmdline.toBool("gpu"));
-        test->Test();
+                    cmdline.toBool("gpu"), headless,
+                    cmdline.toBool("realtime"), cmdline.toString("json"));
+        if (!test->Test())
+            retval = GENERIC_EXIT_NOT_OK;
         delete test;
     }
     else
@@ -315,7 +507,9 @@ int main(int argc, char *argv[])
 
     SignalHandler::Done();
 
-    return GENERIC_EXIT_OK;
+    app.reset();
+
+    return retval;
 }
 
 /* vim: set expandtab tabstop=4 shiftwidth=4: */
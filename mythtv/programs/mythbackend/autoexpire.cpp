@@ -24,6 +24,7 @@ using namespace std;
 #include <QDateTime>
 #include <QFileInfo>
 #include <QList>
+#include <QStringList>
 
 // MythTV headers
 #include "filesysteminfo.h"
@@ -52,6 +53,13 @@ extern AutoExpire *expirer;
  */
 #define SPACE_TOO_BIG_KB (3*1024*1024)
 
+/// Seconds between full reloads of the expire index from the database
+static const int kIndexReloadInterval = 6 * 60 * 60;
+/// Seconds between refreshes of the free space of all filesystems
+static const int kReconcileInterval = 30 * 60;
+/// Age in seconds of the free space numbers that may be used to expire
+static const int kMaxSpaceAge = 60;
+
 /// \brief This calls AutoExpire::RunExpirer() from within a new thread.
 void ExpireThread::run(void)
 {
@@ -117,6 +125,43 @@ AutoExpire::~AutoExpire()
     }
 }
 
+void AutoExpire::customEvent(QEvent *event)
+{
+    if (event->type() != MythEvent::MythEventMessage)
+        return;
+
+    MythEvent *me = static_cast<MythEvent *>(event);
+    QString message = me->Message();
+    QStringList tokens = message.split(" ", QString::SkipEmptyParts);
+
+    // This runs in the event thread, so only note what changed here and
+    // leave the database work to the expire thread.
+    if (message.startsWith("RECORDING_LIST_CHANGE") && tokens.size() == 3)
+    {
+        uint recordedid = tokens[2].toUInt();
+        if (tokens[1] == "ADD")
+            expire_index.MarkChanged(recordedid);
+        else if (tokens[1] == "DELETE")
+        {
+            expire_index.MarkDeleted(recordedid);
+
+            QMutexLocker locker(&update_lock);
+            pending_sizes.remove(recordedid);
+            reconcile_needed = true;
+        }
+    }
+    else if (message.startsWith("MASTER_UPDATE_REC_INFO") &&
+             tokens.size() >= 2)
+    {
+        expire_index.MarkChanged(tokens[1].toUInt());
+    }
+    else if (message.startsWith("UPDATE_FILE_SIZE") && tokens.size() == 3)
+    {
+        QMutexLocker locker(&update_lock);
+        pending_sizes[tokens[1].toUInt()] = tokens[2].toULongLong();
+    }
+}
+
 /**
  *   \brief  Used by the scheduler to select the next recording dir
  *   \return the desired free space for each file system
@@ -142,14 +187,15 @@ void AutoExpire::CalcParams()
     instance_lock.lock();
     if (main_server)
     {
-        // The scheduler relies on something forcing the mainserver
-        // fsinfos cache to get updated periodically.  Currently, that
-        // is done here.  Don't remove or change this invocation
+        // The scheduler relies on something keeping the mainserver
+        // fsinfos cache up to date.  Currently, that is done here,
+        // by UpdateSpaceModel().  Don't remove or change this invocation
         // without handling that issue too.  It is done this way
         // because the scheduler thread can't afford to be blocked by
         // an unresponsive, remote filesystem and the autoexpirer
         // thrad can.
-        main_server->GetFilesystemInfos(fsInfos, false);
+        UpdateSpaceModel();
+        main_server->GetFilesystemInfos(fsInfos, true);
     }
     instance_lock.unlock();
 
@@ -273,6 +319,135 @@ void AutoExpire::CalcParams()
     instance_lock.unlock();
 }
 
+/** \fn AutoExpire::ReconcileFilesystems(void)
+ *  \brief Refreshes the free space of every filesystem from its host.
+ *
+ *  Must be called with instance_lock held.
+ */
+bool AutoExpire::ReconcileFilesystems(void)
+{
+    if (!main_server)
+        return false;
+
+    LOG(VB_FILE, LOG_INFO, LOC + "Reading free space of all filesystems");
+
+    QList<FileSystemInfo> fsInfos;
+    main_server->GetFilesystemInfos(fsInfos, false);
+    last_reconcile = MythDate::current();
+
+    // Everything written so far is now counted, so measure from the
+    // current sizes on and forget recordings that are no longer written.
+    update_lock.lock();
+    QMap<uint, uint64_t> sizes = pending_sizes;
+    pending_sizes.clear();
+    reconcile_needed = false;
+    update_lock.unlock();
+
+    QMap<uint, int> fsids;
+    QMap<uint, uint64_t>::const_iterator it = sizes.begin();
+    for (; it != sizes.end(); ++it)
+    {
+        if (recording_fsids.contains(it.key()))
+            fsids[it.key()] = recording_fsids[it.key()];
+    }
+    applied_sizes = sizes;
+    recording_fsids = fsids;
+
+    return !fsInfos.empty();
+}
+
+/** \fn AutoExpire::UpdateSpaceModel(void)
+ *  \brief Brings the cached free space of the filesystems up to date.
+ *
+ *  The recorders report the size of the files they write, and the growth
+ *  since the last report is subtracted from the free space of the
+ *  filesystem the recording goes to. The filesystems themselves are only
+ *  queried every kReconcileInterval, or sooner after recordings were
+ *  deleted.
+ *
+ *  Must be called with instance_lock held.
+ */
+void AutoExpire::UpdateSpaceModel(void)
+{
+    if (!main_server)
+        return;
+
+    update_lock.lock();
+    bool reconcile = reconcile_needed;
+    update_lock.unlock();
+
+    if (reconcile || !last_reconcile.isValid() ||
+        last_reconcile.secsTo(MythDate::current()) >= kReconcileInterval)
+    {
+        ReconcileFilesystems();
+        return;
+    }
+
+    update_lock.lock();
+    QMap<uint, uint64_t> sizes = pending_sizes;
+    pending_sizes.clear();
+    update_lock.unlock();
+
+    if (sizes.empty())
+        return;
+
+    // Find out where new recordings are written, from the recorders
+    // that told us their filesystem
+    QMap<uint, QDateTime> startTimes;
+    QMap<uint, uint64_t>::const_iterator it = sizes.begin();
+    for (; it != sizes.end(); ++it)
+    {
+        if (!recording_fsids.contains(it.key()))
+            break;
+    }
+    if (it != sizes.end() && encoderList)
+    {
+        QMap<int, int>::const_iterator ueit = used_encoders.begin();
+        for (; ueit != used_encoders.end(); ++ueit)
+        {
+            EncoderLink *enc = encoderList->value(ueit.key());
+            if (*ueit < 0 || !enc || !enc->IsConnected())
+                continue;
+
+            ProgramInfo *pginfo = enc->GetRecording();
+            if (!pginfo)
+                continue;
+
+            uint recordedid = pginfo->GetRecordingID();
+            if (sizes.contains(recordedid) &&
+                !recording_fsids.contains(recordedid))
+            {
+                recording_fsids[recordedid] = *ueit;
+                startTimes[recordedid] = pginfo->GetRecordingStartTime();
+            }
+            delete pginfo;
+        }
+    }
+
+    QMap<int, int64_t> usedKB;
+    for (it = sizes.begin(); it != sizes.end(); ++it)
+    {
+        uint recordedid = it.key();
+        uint64_t size = *it;
+
+        // A recording started since the last refresh has written all
+        // of its bytes since
+        if (!applied_sizes.contains(recordedid) &&
+            startTimes.value(recordedid) > last_reconcile)
+            applied_sizes[recordedid] = 0;
+
+        uint64_t applied = applied_sizes.value(recordedid, size);
+        applied_sizes[recordedid] = size;
+
+        int fsID = recording_fsids.value(recordedid, -1);
+        if (fsID >= 0 && size > applied)
+            usedKB[fsID] += (size - applied) >> 10;
+    }
+
+    if (!usedKB.empty())
+        main_server->AdjustFilesystemUsage(usedKB);
+}
+
 /** \brief This contains the main loop for the auto expire process.
  *
  *   Responsible for cleanup of old LiveTV programs as well as deleting as
@@ -379,7 +554,7 @@ void AutoExpire::ExpireLiveTV(int type)
     pginfolist_t expireList;
 
     LOG(VB_FILE, LOG_INFO, LOC + QString("ExpireLiveTV(%1)").arg(type));
-    FillDBOrdered(expireList, type);
+    FillOrdered(expireList, type);
     SendDeleteMessages(expireList);
     ClearExpireList(expireList);
 }
@@ -392,7 +567,7 @@ void AutoExpire::ExpireOldDeleted(void)
     pginfolist_t expireList;
 
     LOG(VB_FILE, LOG_INFO, LOC + QString("ExpireOldDeleted()"));
-    FillDBOrdered(expireList, emOldDeletedPrograms);
+    FillOrdered(expireList, emOldDeletedPrograms);
     SendDeleteMessages(expireList);
     ClearExpireList(expireList);
 }
@@ -405,7 +580,7 @@ void AutoExpire::ExpireQuickDeleted(void)
     pginfolist_t expireList;
 
     LOG(VB_FILE, LOG_INFO, LOC + QString("ExpireQuickDeleted()"));
-    FillDBOrdered(expireList, emQuickDeletedPrograms);
+    FillOrdered(expireList, emQuickDeletedPrograms);
     SendDeleteMessages(expireList);
     ClearExpireList(expireList);
 }
@@ -416,7 +591,8 @@ void AutoExpire::ExpireQuickDeleted(void)
  */
 void AutoExpire::ExpireRecordings(void)
 {
-    pginfolist_t expireList;
+    QList<ExpireEntry> expireList;
+    QHash<uint, ProgramInfo *> loaded;
     pginfolist_t deleteList;
     QList<FileSystemInfo> fsInfos;
     QList<FileSystemInfo>::iterator fsit;
@@ -426,6 +602,23 @@ void AutoExpire::ExpireRecordings(void)
     if (main_server)
         main_server->GetFilesystemInfos(fsInfos, true);
 
+    // The cached free space is partly estimated, so check with the
+    // filesystems before deleting anything because of it
+    bool shortOfSpace = false;
+    for (fsit = fsInfos.begin(); fsit != fsInfos.end(); ++fsit)
+    {
+        if (fsit->getTotalSpace() != -1 && fsit->getUsedSpace() != -1 &&
+            max((int64_t)0LL, fsit->getFreeSpace()) <
+            desired_space.value(fsit->getFSysID()))
+            shortOfSpace = true;
+    }
+    if (shortOfSpace && last_reconcile.isValid() &&
+        last_reconcile.secsTo(MythDate::current()) > kMaxSpaceAge &&
+        ReconcileFilesystems())
+    {
+        main_server->GetFilesystemInfos(fsInfos, true);
+    }
+
     if (fsInfos.empty())
     {
         LOG(VB_GENERAL, LOG_ERR, LOC + "Filesystem Info cache is empty, unable "
@@ -543,14 +736,34 @@ void AutoExpire::ExpireRecordings(void)
             LOG(VB_FILE, LOG_INFO,
                 "    Searching for files expirable in these directories");
             QString myHostName = gCoreContext->GetHostName();
-            pginfolist_t::iterator it = expireList.begin();
+            QList<ExpireEntry>::const_iterator it = expireList.begin();
             while ((it != expireList.end()) &&
                    (max((int64_t)0LL, fsit->getFreeSpace()) <
                     desired_space[fsit->getFSysID()]))
             {
-                ProgramInfo *p = *it;
+                uint recordedid = (*it).recordedid;
                 ++it;
 
+                // Only load the recordings we get to
+                if (!loaded.contains(recordedid))
+                {
+                    ProgramInfo *pginfo = new ProgramInfo(recordedid);
+                    if (!pginfo->GetChanID())
+                    {
+                        LOG(VB_FILE, LOG_INFO, LOC +
+                            QString("        Skipping recording %1 because "
+                                    "it could not be loaded from the DB")
+                                .arg(recordedid));
+                        delete pginfo;
+                        pginfo = nullptr;
+                    }
+                    loaded[recordedid] = pginfo;
+                }
+
+                ProgramInfo *p = loaded[recordedid];
+                if (!p)
+                    continue;
+
                 LOG(VB_FILE, LOG_INFO, QString("        Checking %1 => %2")
                         .arg(p->toString(ProgramInfo::kRecordingKey))
                         .arg(p->GetTitle()));
@@ -620,8 +833,15 @@ void AutoExpire::ExpireRecordings(void)
 
     SendDeleteMessages(deleteList);
 
+    // Look at the real free space once the files are gone
+    if (!deleteList.empty())
+    {
+        QMutexLocker locker(&update_lock);
+        reconcile_needed = true;
+    }
+
     ClearExpireList(deleteList, false);
-    ClearExpireList(expireList);
+    qDeleteAll(loaded);
 }
 
 /**
@@ -780,29 +1000,42 @@ void AutoExpire::ExpireEpisodesOverMax(void)
     }
 }
 
-/** \fn AutoExpire::FillExpireList(pginfolist_t&)
+/** \fn AutoExpire::FillExpireList(QList<ExpireEntry>&)
  *  \brief Uses the "AutoExpireMethod" setting in the database to
  *         fill the list of files that are deletable.
  */
-void AutoExpire::FillExpireList(pginfolist_t &expireList)
+void AutoExpire::FillExpireList(QList<ExpireEntry> &expireList)
 {
     int expMethod = gCoreContext->GetNumSetting("AutoExpireMethod", 1);
 
-    ClearExpireList(expireList);
+    expireList.clear();
 
-    FillDBOrdered(expireList, emNormalDeletedPrograms);
+    FillOrdered(expireList, emNormalDeletedPrograms);
 
     switch(expMethod)
     {
         case emOldestFirst:
         case emLowestPriorityFirst:
         case emWeightedTimePriority:
-                FillDBOrdered(expireList, expMethod);
+                FillOrdered(expireList, expMethod);
                 break;
         // default falls through so list is empty so no AutoExpire
     }
 }
 
+/** \fn AutoExpire::FillExpireList(pginfolist_t&)
+ *  \brief Fills \p expireList with the programs FillExpireList(QList<ExpireEntry>&)
+ *         finds, loaded from the database.
+ */
+void AutoExpire::FillExpireList(pginfolist_t &expireList)
+{
+    QList<ExpireEntry> entries;
+
+    ClearExpireList(expireList);
+    FillExpireList(entries);
+    LoadExpireList(entries, expireList);
+}
+
 /** \fn AutoExpire::PrintExpireList(QString)
  *  \brief Prints a summary of the files that can be deleted.
  */
@@ -853,13 +1086,16 @@ void AutoExpire::GetAllExpiring(QStringList &strList)
     QMutexLocker lockit(&instance_lock);
     pginfolist_t expireList;
 
+    QList<ExpireEntry> entries;
+
     UpdateDontExpireSet();
 
-    FillDBOrdered(expireList, emShortLiveTVPrograms);
-    FillDBOrdered(expireList, emNormalLiveTVPrograms);
-    FillDBOrdered(expireList, emNormalDeletedPrograms);
-    FillDBOrdered(expireList, gCoreContext->GetNumSetting("AutoExpireMethod",
-                  emOldestFirst));
+    FillOrdered(entries, emShortLiveTVPrograms);
+    FillOrdered(entries, emNormalLiveTVPrograms);
+    FillOrdered(entries, emNormalDeletedPrograms);
+    FillOrdered(entries, gCoreContext->GetNumSetting("AutoExpireMethod",
+                emOldestFirst));
+    LoadExpireList(entries, expireList);
 
     strList << QString::number(expireList.size());
 
@@ -878,13 +1114,16 @@ void AutoExpire::GetAllExpiring(pginfolist_t &list)
     QMutexLocker lockit(&instance_lock);
     pginfolist_t expireList;
 
+    QList<ExpireEntry> entries;
+
     UpdateDontExpireSet();
 
-    FillDBOrdered(expireList, emShortLiveTVPrograms);
-    FillDBOrdered(expireList, emNormalLiveTVPrograms);
-    FillDBOrdered(expireList, emNormalDeletedPrograms);
-    FillDBOrdered(expireList, gCoreContext->GetNumSetting("AutoExpireMethod",
-                  emOldestFirst));
+    FillOrdered(entries, emShortLiveTVPrograms);
+    FillOrdered(entries, emNormalLiveTVPrograms);
+    FillOrdered(entries, emNormalDeletedPrograms);
+    FillOrdered(entries, gCoreContext->GetNumSetting("AutoExpireMethod",
+                emOldestFirst));
+    LoadExpireList(entries, expireList);
 
     pginfolist_t::iterator it = expireList.begin();
     for (; it != expireList.end(); ++it)
@@ -911,133 +1150,78 @@ void AutoExpire::ClearExpireList(pginfolist_t &expireList, bool deleteProg)
     }
 }
 
-/** \fn AutoExpire::FillDBOrdered(pginfolist_t&, int)
- *  \brief Creates a list of programs to delete using the database to
- *         order list.
+/** \fn AutoExpire::FillOrdered(QList<ExpireEntry>&, int)
+ *  \brief Appends the programs \p expMethod would expire, in the order it
+ *         would expire them, skipping those in use or already listed.
  */
-void AutoExpire::FillDBOrdered(pginfolist_t &expireList, int expMethod)
+void AutoExpire::FillOrdered(QList<ExpireEntry> &expireList, int expMethod)
 {
-    QString where;
-    QString orderby;
-    QString msg;
-    int maxAge;
+    QList<ExpireEntry> ordered;
+    QSet<uint> listed;
 
-    switch (expMethod)
-    {
-        default:
-        case emOldestFirst:
-            msg = "Adding programs expirable in Oldest First order";
-            where = "autoexpire > 0";
-            if (gCoreContext->GetBoolSetting("AutoExpireWatchedPriority", false))
-                orderby = "recorded.watched DESC, ";
-            orderby += "starttime ASC";
-            break;
-        case emLowestPriorityFirst:
-            msg = "Adding programs expirable in Lowest Priority First order";
-            where = "autoexpire > 0";
-            if (gCoreContext->GetBoolSetting("AutoExpireWatchedPriority", false))
-                orderby = "recorded.watched DESC, ";
-            orderby += "recorded.recpriority ASC, starttime ASC";
-            break;
-        case emWeightedTimePriority:
-            msg = "Adding programs expirable in Weighted Time Priority order";
-            where = "autoexpire > 0";
-            if (gCoreContext->GetBoolSetting("AutoExpireWatchedPriority", false))
-                orderby = "recorded.watched DESC, ";
-            orderby += QString("DATE_ADD(starttime, INTERVAL '%1' * "
-                                        "recorded.recpriority DAY) ASC")
-                      .arg(gCoreContext->GetNumSetting("AutoExpireDayPriority", 3));
-            break;
-        case emShortLiveTVPrograms:
-            msg = "Adding Short LiveTV programs in starttime order";
-            where = "recgroup = 'LiveTV' "
-                    "AND endtime < DATE_ADD(starttime, INTERVAL '30' SECOND) "
-                    "AND endtime <= DATE_ADD(NOW(), INTERVAL '-5' MINUTE) ";
-            orderby = "starttime ASC";
-            break;
-        case emNormalLiveTVPrograms:
-            msg = "Adding LiveTV programs in starttime order";
-            where = QString("recgroup = 'LiveTV' "
-                    "AND endtime <= DATE_ADD(NOW(), INTERVAL '-%1' DAY) ")
-                    .arg(gCoreContext->GetNumSetting("AutoExpireLiveTVMaxAge", 1));
-            orderby = "starttime ASC";
-            break;
-        case emOldDeletedPrograms:
-            if ((maxAge = gCoreContext->GetNumSetting("DeletedMaxAge", 0)) <= 0)
-                return;
-            msg = QString("Adding programs deleted more than %1 days ago")
-                          .arg(maxAge);
-            where = QString("recgroup = 'Deleted' "
-                    "AND lastmodified <= DATE_ADD(NOW(), INTERVAL '-%1' DAY) ")
-                    .arg(maxAge);
-            orderby = "starttime ASC";
-            break;
-        case emQuickDeletedPrograms:
-            if (gCoreContext->GetNumSetting("DeletedMaxAge", 0) != 0)
-                return;
-            msg = QString("Adding programs deleted more than 5 minutes ago");
-            where = QString("recgroup = 'Deleted' "
-                    "AND lastmodified <= DATE_ADD(NOW(), INTERVAL '-5' MINUTE) ");
-            orderby = "lastmodified ASC";
-            break;
-        case emNormalDeletedPrograms:
-            msg = "Adding deleted programs in FIFO order";
-            where = "recgroup = 'Deleted'";
-            orderby = "lastmodified ASC";
-            break;
-    }
+    expire_index.Refresh();
+    expire_index.GetOrdered(ordered, expMethod);
 
-    LOG(VB_FILE, LOG_INFO, LOC + "FillDBOrdered: " + msg);
-
-    MSqlQuery query(MSqlQuery::InitCon());
-    QString querystr = QString(
-        "SELECT recorded.chanid, starttime "
-        "FROM recorded "
-        "LEFT JOIN channel ON recorded.chanid = channel.chanid "
-        "WHERE %1 AND deletepending = 0 "
-        "ORDER BY autoexpire DESC, %2").arg(where).arg(orderby);
-
-    query.prepare(querystr);
-
-    if (!query.exec())
-        return;
+    QList<ExpireEntry>::const_iterator it = expireList.begin();
+    for (; it != expireList.end(); ++it)
+        listed.insert((*it).recordedid);
 
-    while (query.next())
+    int added = 0;
+    for (it = ordered.begin(); it != ordered.end(); ++it)
     {
-        uint chanid = query.value(0).toUInt();
-        QDateTime recstartts = MythDate::as_utc(query.value(1).toDateTime());
-
-        if (IsInDontExpireSet(chanid, recstartts))
+        if (IsInDontExpireSet((*it).chanid, (*it).starttime))
         {
             LOG(VB_FILE, LOG_INFO, LOC +
                 QString("    Skipping %1 at %2 because it is in Don't Expire "
                         "List")
-                    .arg(chanid).arg(recstartts.toString(Qt::ISODate)));
+                    .arg((*it).chanid)
+                    .arg((*it).starttime.toString(Qt::ISODate)));
         }
-        else if (IsInExpireList(expireList, chanid, recstartts))
+        else if (!listed.contains((*it).recordedid))
         {
-            LOG(VB_FILE, LOG_INFO, LOC +
-                QString("    Skipping %1 at %2 because it is already in Expire "
-                        "List")
-                    .arg(chanid).arg(recstartts.toString(Qt::ISODate)));
+            listed.insert((*it).recordedid);
+            expireList.push_back(*it);
+            added++;
+        }
+    }
+
+    LOG(VB_FILE, LOG_INFO, LOC + QString("FillOrdered: Added %1 programs "
+                                         "for expire method %2")
+            .arg(added).arg(expMethod));
+}
+
+/** \fn AutoExpire::FillOrdered(pginfolist_t&, int)
+ *  \brief Appends the programs \p expMethod would expire, loaded from the
+ *         database.
+ */
+void AutoExpire::FillOrdered(pginfolist_t &expireList, int expMethod)
+{
+    QList<ExpireEntry> entries;
+
+    FillOrdered(entries, expMethod);
+    LoadExpireList(entries, expireList);
+}
+
+/// Appends a ProgramInfo for each of \p entries to \p expireList.
+void AutoExpire::LoadExpireList(const QList<ExpireEntry> &entries,
+                                pginfolist_t &expireList)
+{
+    QList<ExpireEntry>::const_iterator it = entries.begin();
+    for (; it != entries.end(); ++it)
+    {
+        ProgramInfo *pginfo = new ProgramInfo((*it).recordedid);
+        if (pginfo->GetChanID())
+        {
+            expireList.push_back(pginfo);
         }
         else
         {
-            ProgramInfo *pginfo = new ProgramInfo(chanid, recstartts);
-            if (pginfo->GetChanID())
-            {
-                LOG(VB_FILE, LOG_INFO, LOC + QString("    Adding   %1 at %2")
-                        .arg(chanid).arg(recstartts.toString(Qt::ISODate)));
-                expireList.push_back(pginfo);
-            }
-            else
-            {
-                LOG(VB_FILE, LOG_INFO, LOC +
-                    QString("    Skipping %1 at %2 "
-                            "because it could not be loaded from the DB")
-                        .arg(chanid).arg(recstartts.toString(Qt::ISODate)));
-                delete pginfo;
-            }
+            LOG(VB_FILE, LOG_INFO, LOC +
+                QString("    Skipping %1 at %2 "
+                        "because it could not be loaded from the DB")
+                    .arg((*it).chanid)
+                    .arg((*it).starttime.toString(Qt::ISODate)));
+            delete pginfo;
         }
     }
 }
@@ -1133,20 +1317,270 @@ bool AutoExpire::IsInDontExpireSet(
     return (dont_expire_set.find(key) != dont_expire_set.end());
 }
 
-bool AutoExpire::IsInExpireList(
-    const pginfolist_t &expireList, uint chanid, const QDateTime &recstartts)
+void ExpireIndex::MarkChanged(uint recordedid)
+{
+    QMutexLocker locker(&m_lock);
+    m_changed.insert(recordedid);
+}
+
+void ExpireIndex::MarkDeleted(uint recordedid)
 {
-    pginfolist_t::const_iterator it;
+    QMutexLocker locker(&m_lock);
+    m_entries.remove(recordedid);
+    m_changed.remove(recordedid);
+}
 
-    for (it = expireList.begin(); it != expireList.end(); ++it)
+/** \fn ExpireIndex::Refresh(void)
+ *  \brief Reads the recordings that changed since the last call, or the
+ *         whole index if it is due to be reloaded.
+ */
+void ExpireIndex::Refresh(void)
+{
+    QList<uint> changed;
+
+    m_lock.lock();
+    bool reload = !m_loaded.isValid() ||
+        m_loaded.secsTo(MythDate::current()) >= kIndexReloadInterval;
+    if (!reload)
     {
-        if (((*it)->GetChanID()             == chanid) &&
-            ((*it)->GetRecordingStartTime() == recstartts))
+        changed = m_changed.toList();
+        m_changed.clear();
+    }
+    m_lock.unlock();
+
+    if (reload)
+        Load();
+    else if (!changed.empty())
+        Reload(changed);
+}
+
+static const char *kExpireEntryColumns =
+    "SELECT recordedid, chanid, starttime, endtime, lastmodified, "
+    "       recgroup, autoexpire, watched, recpriority, deletepending "
+    "FROM recorded ";
+
+ExpireEntry ExpireIndex::ReadEntry(const MSqlQuery &query)
+{
+    ExpireEntry entry;
+    entry.recordedid    = query.value(0).toUInt();
+    entry.chanid        = query.value(1).toUInt();
+    entry.starttime     = MythDate::as_utc(query.value(2).toDateTime());
+    entry.endtime       = MythDate::as_utc(query.value(3).toDateTime());
+    entry.lastmodified  = MythDate::as_utc(query.value(4).toDateTime());
+    entry.recgroup      = query.value(5).toString();
+    entry.autoexpire    = query.value(6).toInt();
+    entry.watched       = query.value(7).toBool();
+    entry.recpriority   = query.value(8).toInt();
+    entry.deletepending = query.value(9).toBool();
+    return entry;
+}
+
+/// Returns true if any expire method could pick \p entry.
+bool ExpireIndex::IsExpirable(const ExpireEntry &entry)
+{
+    return entry.autoexpire > 0 || entry.recgroup == "LiveTV" ||
+        entry.recgroup == "Deleted";
+}
+
+bool ExpireIndex::Load(void)
+{
+    m_lock.lock();
+    m_changed.clear();
+    m_lock.unlock();
+
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare(QString(kExpireEntryColumns) +
+                  "WHERE autoexpire > 0 OR recgroup IN ('LiveTV', 'Deleted')");
+
+    if (!query.exec())
+    {
+        MythDB::DBError("ExpireIndex::Load", query);
+        return false;
+    }
+
+    QHash<uint, ExpireEntry> entries;
+    if (query.size() > 0)
+        entries.reserve(query.size());
+    while (query.next())
+    {
+        ExpireEntry entry = ReadEntry(query);
+        entries.insert(entry.recordedid, entry);
+    }
+
+    LOG(VB_FILE, LOG_INFO, LOC +
+        QString("Loaded %1 expirable programs").arg(entries.size()));
+
+    QMutexLocker locker(&m_lock);
+    m_entries.swap(entries);
+    m_loaded = MythDate::current();
+    return true;
+}
+
+void ExpireIndex::Reload(const QList<uint> &recordedids)
+{
+    static const int kBatchSize = 500;
+
+    for (int i = 0; i < recordedids.size(); i += kBatchSize)
+    {
+        QList<uint> batch = recordedids.mid(i, kBatchSize);
+        QStringList ids;
+        foreach (uint recordedid, batch)
+            ids << QString::number(recordedid);
+
+        MSqlQuery query(MSqlQuery::InitCon());
+        query.prepare(QString(kExpireEntryColumns) +
+                      QString("WHERE recordedid IN (%1)").arg(ids.join(",")));
+
+        if (!query.exec())
+        {
+            MythDB::DBError("ExpireIndex::Reload", query);
+            QMutexLocker locker(&m_lock);
+            foreach (uint recordedid, batch)
+                m_changed.insert(recordedid);
+            continue;
+        }
+
+        QList<ExpireEntry> found;
+        while (query.next())
+            found.push_back(ReadEntry(query));
+
+        QMutexLocker locker(&m_lock);
+        foreach (uint recordedid, batch)
+            m_entries.remove(recordedid);
+        foreach (const ExpireEntry &entry, found)
+        {
+            if (IsExpirable(entry))
+                m_entries.insert(entry.recordedid, entry);
+        }
+    }
+
+    LOG(VB_FILE, LOG_DEBUG, LOC +
+        QString("Reread %1 changed programs").arg(recordedids.size()));
+}
+
+/** \fn ExpireIndex::GetOrdered(QList<ExpireEntry>&, int) const
+ *  \brief Returns the programs \p expMethod may expire, in the order it
+ *         expires them.
+ */
+void ExpireIndex::GetOrdered(QList<ExpireEntry> &list, int expMethod) const
+{
+    bool watchedFirst =
+        gCoreContext->GetBoolSetting("AutoExpireWatchedPriority", false);
+    int dayPriority =
+        gCoreContext->GetNumSetting("AutoExpireDayPriority", 3);
+    int liveTVMaxAge =
+        gCoreContext->GetNumSetting("AutoExpireLiveTVMaxAge", 1);
+    int deletedMaxAge = gCoreContext->GetNumSetting("DeletedMaxAge", 0);
+    QDateTime now = MythDate::current();
+
+    switch (expMethod)
+    {
+        case emOldestFirst:
+        case emLowestPriorityFirst:
+        case emWeightedTimePriority:
+        case emShortLiveTVPrograms:
+        case emNormalLiveTVPrograms:
+        case emNormalDeletedPrograms:
+            break;
+        case emOldDeletedPrograms:
+            if (deletedMaxAge <= 0)
+                return;
+            break;
+        case emQuickDeletedPrograms:
+            if (deletedMaxAge != 0)
+                return;
+            break;
+        default:
+            expMethod = emOldestFirst;
+            break;
+    }
+
+    list.clear();
+
+    m_lock.lock();
+    QHash<uint, ExpireEntry>::const_iterator it = m_entries.begin();
+    for (; it != m_entries.end(); ++it)
+    {
+        const ExpireEntry &e = *it;
+        if (e.deletepending)
+            continue;
+
+        bool match = false;
+        switch (expMethod)
         {
-            return true;
+            case emOldestFirst:
+            case emLowestPriorityFirst:
+            case emWeightedTimePriority:
+                match = e.autoexpire > 0;
+                break;
+            case emShortLiveTVPrograms:
+                match = e.recgroup == "LiveTV" &&
+                    e.endtime < e.starttime.addSecs(30) &&
+                    e.endtime <= now.addSecs(-5 * 60);
+                break;
+            case emNormalLiveTVPrograms:
+                match = e.recgroup == "LiveTV" &&
+                    e.endtime <= now.addDays(-liveTVMaxAge);
+                break;
+            case emOldDeletedPrograms:
+                match = e.recgroup == "Deleted" &&
+                    e.lastmodified <= now.addDays(-deletedMaxAge);
+                break;
+            case emQuickDeletedPrograms:
+                match = e.recgroup == "Deleted" &&
+                    e.lastmodified <= now.addSecs(-5 * 60);
+                break;
+            case emNormalDeletedPrograms:
+                match = e.recgroup == "Deleted";
+                break;
         }
+        if (match)
+            list.push_back(e);
     }
-    return false;
+    m_lock.unlock();
+
+    // The same order the database query used to return
+    std::stable_sort(list.begin(), list.end(),
+        [=](const ExpireEntry &a, const ExpireEntry &b)
+        {
+            if (a.autoexpire != b.autoexpire)
+                return a.autoexpire > b.autoexpire;
+
+            switch (expMethod)
+            {
+                case emOldestFirst:
+                case emLowestPriorityFirst:
+                case emWeightedTimePriority:
+                    if (watchedFirst && a.watched != b.watched)
+                        return a.watched;
+                    break;
+            }
+
+            switch (expMethod)
+            {
+                case emLowestPriorityFirst:
+                    if (a.recpriority != b.recpriority)
+                        return a.recpriority < b.recpriority;
+                    break;
+                case emWeightedTimePriority:
+                {
+                    QDateTime wa = a.starttime.addDays(dayPriority * a.recpriority);
+                    QDateTime wb = b.starttime.addDays(dayPriority * b.recpriority);
+                    if (wa != wb)
+                        return wa < wb;
+                    break;
+                }
+                case emQuickDeletedPrograms:
+                case emNormalDeletedPrograms:
+                    if (a.lastmodified != b.lastmodified)
+                        return a.lastmodified < b.lastmodified;
+                    break;
+            }
+
+            if (a.starttime != b.starttime)
+                return a.starttime < b.starttime;
+            return a.recordedid < b.recordedid;
+        });
 }
 
 /* vim: set expandtab tabstop=4 shiftwidth=4: */
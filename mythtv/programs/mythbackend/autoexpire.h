@@ -12,6 +12,8 @@ using namespace std;
 #include <QString>
 #include <QMutex>
 #include <QQueue>
+#include <QHash>
+#include <QList>
 #include <QSet>
 #include <QMap>
 
@@ -19,6 +21,7 @@ using namespace std;
 
 class ProgramInfo;
 class EncoderLink;
+class MSqlQuery;
 class FileSystemInfo;
 class MainServer;
 
@@ -48,6 +51,53 @@ class ExpireThread : public MThread
     QPointer<AutoExpire> m_parent;
 };
 
+/// The columns of a "recorded" row that decide if and when it expires
+class ExpireEntry
+{
+  public:
+    uint      recordedid    {0};
+    uint      chanid        {0};
+    QDateTime starttime;
+    QDateTime endtime;
+    QDateTime lastmodified;
+    QString   recgroup;
+    int       autoexpire    {0};
+    bool      watched       {false};
+    int       recpriority   {0};
+    bool      deletepending {false};
+};
+
+/** \class ExpireIndex
+ *  \brief In memory copy of the expirable recordings.
+ *
+ *  The index is read from the database once, and after that only the
+ *  recordings named by recording change events are read again. A full
+ *  reload is still done every few hours, to pick up changes made to the
+ *  database directly.
+ */
+class ExpireIndex
+{
+  public:
+    ExpireIndex() = default;
+
+    void MarkChanged(uint recordedid);
+    void MarkDeleted(uint recordedid);
+
+    void Refresh(void);
+    void GetOrdered(QList<ExpireEntry> &list, int expMethod) const;
+
+  private:
+    bool Load(void);
+    void Reload(const QList<uint> &recordedids);
+    static ExpireEntry ReadEntry(const MSqlQuery &query);
+    static bool IsExpirable(const ExpireEntry &entry);
+
+    mutable QMutex           m_lock;
+    QHash<uint, ExpireEntry> m_entries;  // protected by m_lock
+    QSet<uint>               m_changed;  // protected by m_lock
+    QDateTime                m_loaded;   // protected by m_lock
+};
+
 class UpdateEntry
 {
   public:
@@ -90,6 +140,7 @@ class AutoExpire : public QObject
 
   protected:
     void RunExpirer(void);
+    void customEvent(QEvent *event) override; // QObject
 
   private:
     void ExpireLiveTV(int type);
@@ -98,15 +149,20 @@ class AutoExpire : public QObject
     void ExpireRecordings(void);
     void ExpireEpisodesOverMax(void);
 
+    void FillExpireList(QList<ExpireEntry> &expireList);
     void FillExpireList(pginfolist_t &expireList);
-    void FillDBOrdered(pginfolist_t &expireList, int expMethod);
+    void FillOrdered(QList<ExpireEntry> &expireList, int expMethod);
+    void FillOrdered(pginfolist_t &expireList, int expMethod);
+    static void LoadExpireList(const QList<ExpireEntry> &entries,
+                               pginfolist_t &expireList);
     void SendDeleteMessages(pginfolist_t &deleteList);
     void Sleep(int sleepTime /*ms*/);
 
     void UpdateDontExpireSet(void);
     bool IsInDontExpireSet(uint chanid, const QDateTime &recstartts) const;
-    static bool IsInExpireList(const pginfolist_t &expireList,
-                               uint chanid, const QDateTime &recstartts);
+
+    bool ReconcileFilesystems(void);
+    void UpdateSpaceModel(void);
 
     // main expire info
     QSet<QString> dont_expire_set;
@@ -125,6 +181,15 @@ class AutoExpire : public QObject
     // update info
     QMutex              update_lock;
     QQueue<UpdateEntry> update_queue; // protected by update_lock
+
+    ExpireIndex         expire_index;
+
+    // free space model, the sizes of the recordings being written
+    QMap<uint, uint64_t> pending_sizes;   // protected by update_lock
+    QMap<uint, uint64_t> applied_sizes;   // protected by instance_lock
+    QMap<uint, int>      recording_fsids; // protected by instance_lock
+    QDateTime            last_reconcile;  // protected by instance_lock
+    bool                 reconcile_needed {true}; // protected by update_lock
 };
 
 #endif
@@ -8,6 +8,7 @@ QMap<int, EncoderLink *> tvList;
 AutoExpire  *expirer      = nullptr;
 JobQueue    *jobqueue     = nullptr;
 HouseKeeper *housekeeping = nullptr;
+RecordingCatalog *catalog = nullptr;
 MediaServer *g_pUPnp      = nullptr;
 BackendContext *gBackendContext = nullptr;
 QString      pidfile;
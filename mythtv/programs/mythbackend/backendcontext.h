@@ -11,6 +11,7 @@ class AutoExpire;
 class Scheduler;
 class JobQueue;
 class HouseKeeper;
+class RecordingCatalog;
 class MediaServer;
 class BackendContext;
 
@@ -18,6 +19,7 @@ extern QMap<int, EncoderLink *> tvList;
 extern AutoExpire  *expirer;
 extern JobQueue    *jobqueue;
 extern HouseKeeper *housekeeping;
+extern RecordingCatalog *catalog;
 extern MediaServer *g_pUPnp;
 extern BackendContext *gBackendContext;
 extern QString      pidfile;
@@ -10,6 +10,7 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
+#include <QSet>
 
 // MythTV headers
 #include "backendhousekeeper.h"
@@ -110,13 +111,22 @@ bool LogCleanerTask::DoRun(void)
 
 bool CleanupTask::DoRun(void)
 {
+    m_batch.Reset();
+
     JobQueue::CleanupOldJobsInQueue();
     CleanupOldRecordings();
     CleanupInUsePrograms();
     CleanupOrphanedLiveTV();
-    CleanupRecordedTables();
-    CleanupProgramListings();
-    return true;
+
+    // The large deletes go in batches, and stop early if the backend
+    // is shutting down
+    bool ok = CleanupRecordedTables();
+    ok = !m_batch.IsTerminated() && CleanupProgramListings() && ok;
+    ok = !m_batch.IsTerminated() && CleanupOrphanedPeople() && ok;
+
+    LOG(VB_GENERAL, LOG_INFO, QString("CleanupTask deleted %1 rows")
+        .arg(m_batch.GetTotalRows()));
+    return ok;
 }
 
 void CleanupTask::CleanupOldRecordings(void)
@@ -180,11 +190,9 @@ void CleanupTask::CleanupOrphanedLiveTV(void)
         MythDB::DBError("CleanupTask::CleanupOrphanedLiveTV", deleteQuery);
 }
 
-void CleanupTask::CleanupRecordedTables(void)
+bool CleanupTask::CleanupRecordedTables(void)
 {
     MSqlQuery query(MSqlQuery::InitCon());
-    MSqlQuery deleteQuery(MSqlQuery::InitCon());
-    int tableIndex = 0;
     // tables[tableIndex][0] is the table name
     // tables[tableIndex][1] is the name of the column on which the join is
     // performed
@@ -195,91 +203,78 @@ void CleanupTask::CleanupRecordedTables(void)
         { "recordedmarkup", "starttime" },
         { "recordedseek", "starttime" },
         { "", "" } }; // This blank entry must exist, do not remove.
-    QString table = tables[tableIndex][0];
-    QString column = tables[tableIndex][1];
-
-    // Because recordedseek can have millions of rows, we don't want to JOIN it
-    // with recorded.  Instead, pull out DISTINCT chanid and starttime into a
-    // temporary table (resulting in tens, hundreds, or--at most--a few
-    // thousand rows) for the JOIN
-    QString querystr;
-    querystr = "CREATE TEMPORARY TABLE IF NOT EXISTS temprecordedcleanup ( "
-                   "chanid int(10) unsigned NOT NULL default '0', "
-                   "starttime datetime NOT NULL default '0000-00-00 00:00:00' "
-                   ");";
-
-    if (!query.exec(querystr))
-    {
-        MythDB::DBError("CleanupTask::CleanupRecordedTables"
-                                "(creating temporary table)", query);
-        return;
-    }
+    bool ok = true;
 
-    while (!table.isEmpty())
+    for (int tableIndex = 0; !tables[tableIndex][0].isEmpty(); ++tableIndex)
     {
-        query.prepare(QString("TRUNCATE TABLE temprecordedcleanup;"));
-        if (!query.exec() || !query.isActive())
-        {
-            MythDB::DBError("CleanupTask::CleanupRecordedTables"
-                                  "(truncating temporary table)", query);
-            return;
-        }
-
-        query.prepare(QString("INSERT INTO temprecordedcleanup "
-                              "( chanid, starttime ) "
-                              "SELECT DISTINCT chanid, starttime "
-                              "FROM %1;")
-                              .arg(table));
-
-        if (!query.exec() || !query.isActive())
+        QString table = tables[tableIndex][0];
+        QString column = tables[tableIndex][1];
+
+        // Because recordedseek can have millions of rows, we don't want to
+        // JOIN it with recorded. Instead, pull out the DISTINCT chanid and
+        // starttime, which come straight from the start of its primary key,
+        // and compare them with recorded here. The table is read first, so
+        // a recording started in between, whose recorded row is written
+        // before its seek table, is never taken for an orphan.
+        query.prepare(QString("SELECT DISTINCT chanid, starttime "
+                              "FROM %1;").arg(table));
+        if (!query.exec())
         {
             MythDB::DBError("CleanupTask::CleanupRecordedTables"
                                     "(cleaning recorded tables)", query);
-            return;
+            ok = false;
+            continue;
         }
 
-        query.prepare(QString("SELECT DISTINCT p.chanid, p.starttime "
-                              "FROM temprecordedcleanup p "
-                              "LEFT JOIN recorded r "
-                              "ON p.chanid = r.chanid "
-                              "AND p.starttime = r.%1 "
-                              "WHERE r.chanid IS NULL;").arg(column));
-        if (!query.exec() || !query.isActive())
+        QList<QPair<QVariant, QVariant> > keys;
+        while (query.next())
+            keys.append(qMakePair(query.value(0), query.value(1)));
+
+        query.prepare(QString("SELECT chanid, %1 FROM recorded;")
+                              .arg(column));
+        if (!query.exec())
         {
             MythDB::DBError("CleanupTask::CleanupRecordedTables"
                                     "(cleaning recorded tables)", query);
-            return;
+            return false;
         }
 
-        deleteQuery.prepare(QString("DELETE FROM %1 "
-                                    "WHERE chanid = :CHANID "
-                                    "AND starttime = :STARTTIME;")
-                                    .arg(table));
+        QSet<QString> recorded;
         while (query.next())
+            recorded.insert(query.value(0).toString() + " " +
+                            query.value(1).toString());
+
+        m_batch.BeginStep(table);
+        MSqlBindings bindings;
+        for (int i = 0; i < keys.size(); ++i)
         {
-            deleteQuery.bindValue(":CHANID", query.value(0).toString());
-            deleteQuery.bindValue(":STARTTIME", query.value(1));
-            if (!deleteQuery.exec())
+            if (recorded.contains(keys[i].first.toString() + " " +
+                                  keys[i].second.toString()))
+                continue;
+
+            bindings[":CHANID"] = keys[i].first;
+            bindings[":STARTTIME"] = keys[i].second;
+            if (!m_batch.Delete(table,
+                                "chanid = :CHANID AND starttime = :STARTTIME",
+                                bindings))
             {
-                MythDB::DBError("CleanupTask::CleanupRecordedTables"
-                                "(cleaning recorded tables)", deleteQuery);
-                return;
+                ok = false;
+                break;
             }
         }
+        m_batch.EndStep();
 
-        tableIndex++;
-        table = tables[tableIndex][0];
-        column = tables[tableIndex][1];
+        if (m_batch.IsTerminated())
+            return false;
     }
 
-    if (!query.exec("DROP TABLE temprecordedcleanup;"))
-        MythDB::DBError("CleanupTask::CleanupRecordedTables"
-                                "(deleting temporary table)", query);
+    return ok;
 }
 
-void CleanupTask::CleanupProgramListings(void)
+bool CleanupTask::CleanupProgramListings(void)
 {
     MSqlQuery query(MSqlQuery::InitCon());
+    bool ok = true;
     QString querystr;
     // Keep as many days of listings data as we keep matching, non-recorded
     // oldrecorded entries to allow for easier post-mortem analysis
@@ -302,29 +297,24 @@ void CleanupTask::CleanupProgramListings(void)
     if (!query.exec())
         MythDB::DBError("HouseKeeper Cleaning Program Listings", query);
 
-    query.prepare("DELETE FROM program WHERE starttime <= "
-                  "DATE_SUB(CURRENT_DATE, INTERVAL :OFFSET DAY);");
-    query.bindValue(":OFFSET", offset);
-    if (!query.exec())
-        MythDB::DBError("HouseKeeper Cleaning Program Listings", query);
-
-    query.prepare("DELETE FROM programrating WHERE starttime <= "
-                  "DATE_SUB(CURRENT_DATE, INTERVAL :OFFSET DAY);");
-    query.bindValue(":OFFSET", offset);
-    if (!query.exec())
-        MythDB::DBError("HouseKeeper Cleaning Program Listings", query);
-
-    query.prepare("DELETE FROM programgenres WHERE starttime <= "
-                  "DATE_SUB(CURRENT_DATE, INTERVAL :OFFSET DAY);");
-    query.bindValue(":OFFSET", offset);
-    if (!query.exec())
-        MythDB::DBError("HouseKeeper Cleaning Program Listings", query);
-
-    query.prepare("DELETE FROM credits WHERE starttime <= "
-                  "DATE_SUB(CURRENT_DATE, INTERVAL :OFFSET DAY);");
-    query.bindValue(":OFFSET", offset);
-    if (!query.exec())
-        MythDB::DBError("HouseKeeper Cleaning Program Listings", query);
+    // These hold several rows for every program in the listings, so they
+    // are cleaned one channel at a time, along their (chanid, starttime)
+    // keys
+    MSqlBindings bindings;
+    bindings[":OFFSET"] = offset;
+    const char *listingTables[] =
+        { "program", "programrating", "programgenres", "credits" };
+    for (uint i = 0; i < sizeof(listingTables) / sizeof(listingTables[0]); ++i)
+    {
+        m_batch.BeginStep(listingTables[i]);
+        ok = m_batch.Delete(listingTables[i],
+                            "starttime <= "
+                            "DATE_SUB(CURRENT_DATE, INTERVAL :OFFSET DAY)",
+                            bindings, "chanid") && ok;
+        m_batch.EndStep();
+        if (m_batch.IsTerminated())
+            return false;
+    }
 
     query.prepare("DELETE FROM record WHERE (type = :SINGLE "
                   "OR type = :OVERRIDE OR type = :DONTRECORD) "
@@ -355,13 +345,38 @@ void CleanupTask::CleanupProgramListings(void)
     if (!query.exec())
         MythDB::DBError("HouseKeeper Cleaning Program Listings", query);
 
-    query.prepare("DELETE FROM oldrecorded WHERE "
-                  "recstatus <> :RECORDED AND duplicate = 0 AND "
-                  "endtime < DATE_SUB(CURRENT_DATE, INTERVAL :CLEAN DAY);");
-    query.bindValue(":RECORDED", RecStatus::Recorded);
-    query.bindValue(":CLEAN", offset);
-    if (!query.exec())
-        MythDB::DBError("HouseKeeper Cleaning Program Listings", query);
+    // oldrecorded is written as recordings start and end. Its primary key
+    // starts with (station, starttime), and a program that ended before
+    // the cut off also started before it.
+    bindings.clear();
+    bindings[":RECORDED"] = RecStatus::Recorded;
+    bindings[":CLEAN"] = offset;
+    m_batch.BeginStep("oldrecorded");
+    ok = m_batch.Delete("oldrecorded",
+                        "recstatus <> :RECORDED AND duplicate = 0 AND "
+                        "starttime < "
+                        "DATE_SUB(CURRENT_DATE, INTERVAL :CLEAN DAY) AND "
+                        "endtime < "
+                        "DATE_SUB(CURRENT_DATE, INTERVAL :CLEAN DAY)",
+                        bindings, "station") && ok;
+    m_batch.EndStep();
+
+    return ok;
+}
+
+bool CleanupTask::CleanupOrphanedPeople(void)
+{
+    // Remove the people no longer credited in the listings or a recording,
+    // a range of person ids at a time
+    m_batch.BeginStep("people");
+    bool ok = m_batch.DeleteRange("people", "person",
+        "DELETE people FROM people "
+        "LEFT JOIN credits ON credits.person = people.person "
+        "LEFT JOIN recordedcredits ON recordedcredits.person = people.person "
+        "WHERE people.person >= :LOW AND people.person < :HIGH "
+        "AND credits.person IS NULL AND recordedcredits.person IS NULL;");
+    m_batch.EndStep();
+    return ok;
 }
 
 bool ThemeUpdateTask::DoCheckRun(QDateTime now)
@@ -613,6 +628,7 @@ bool JobQueueRecoverTask::DoRun(void)
 MythFillDatabaseTask::MythFillDatabaseTask(void) :
     DailyHouseKeeperTask("MythFillDB"), m_msMFD(nullptr)
 {
+    SetExclusionGroup("Database");
     SetHourWindowFromDB();
 }
 
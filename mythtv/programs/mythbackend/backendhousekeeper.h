@@ -2,12 +2,14 @@
 #define BACKENDHOUSEKEEPER_H_
 
 #include "housekeeper.h"
+#include "batchdelete.h"
 #include "mythsystemlegacy.h"
 
 class LogCleanerTask : public DailyHouseKeeperTask
 {
   public:
-    LogCleanerTask(void) : DailyHouseKeeperTask("LogClean", kHKGlobal) {};
+    LogCleanerTask(void) : DailyHouseKeeperTask("LogClean", kHKGlobal)
+        { SetExclusionGroup("Database"); }
     bool DoRun(void) override; // HouseKeeperTask
 };
 
@@ -15,15 +17,24 @@ class LogCleanerTask : public DailyHouseKeeperTask
 class CleanupTask : public DailyHouseKeeperTask
 {
   public:
-    CleanupTask(void) : DailyHouseKeeperTask("DBCleanup", kHKGlobal) {};
+    CleanupTask(void) : DailyHouseKeeperTask("DBCleanup", kHKGlobal)
+    {
+        // clean up the listings mythfilldatabase has just replaced
+        AddDependency("MythFillDB");
+        SetExclusionGroup("Database");
+    }
     bool DoRun(void) override; // HouseKeeperTask
+    void Terminate(void) override { m_batch.Terminate(); } // HouseKeeperTask
 
   private:
     void CleanupOldRecordings(void);
     void CleanupInUsePrograms(void);
     void CleanupOrphanedLiveTV(void);
-    void CleanupRecordedTables(void);
-    void CleanupProgramListings(void);
+    bool CleanupRecordedTables(void);
+    bool CleanupProgramListings(void);
+    bool CleanupOrphanedPeople(void);
+
+    BatchDelete m_batch;
 };
 
 class RadioStreamUpdateTask : public DailyHouseKeeperTask
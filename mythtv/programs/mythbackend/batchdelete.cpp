@@ -0,0 +1,272 @@
+// C++ headers
+#include <chrono> // for milliseconds
+#include <thread> // for sleep_for
+
+// Qt headers
+#include <QStringList>
+#include <QVariant>
+
+// MythTV headers
+#include "batchdelete.h"
+#include "mythdb.h"
+#include "mythcorecontext.h"
+#include "mythlogging.h"
+
+#define LOC QString("BatchDelete: ")
+
+/// Rows, or keys of a range, in the first statement of a run
+static const int kDefaultBatch = 1000;
+static const int kMinBatch = 100;
+static const int kMaxBatch = 50000;
+/// Milliseconds a statement should take; the batch size follows this
+static const int kTargetTime = 200;
+/// Shortest pause between statements, in milliseconds
+static const int kMinPause = 20;
+/// Milliseconds between progress messages and resume point updates
+static const int kProgressInterval = 30000;
+
+BatchDelete::BatchDelete(void) :
+    m_batchSize(kDefaultBatch), m_terminated(false), m_resumeSaved(false),
+    m_stepRows(0), m_stepBatches(0), m_totalRows(0)
+{
+}
+
+/// Prepares for a new run of the cleanup.
+void BatchDelete::Reset(void)
+{
+    m_batchSize  = kDefaultBatch;
+    m_terminated = false;
+    m_totalRows  = 0;
+}
+
+void BatchDelete::BeginStep(const QString &step)
+{
+    m_step        = step;
+    m_resume      = GetResume();
+    m_resumeSaved = !m_resume.isEmpty();
+    m_stepRows    = 0;
+    m_stepBatches = 0;
+    m_stepTimer.start();
+    m_progressTimer.start();
+
+    if (m_resumeSaved)
+        LOG(VB_GENERAL, LOG_INFO, LOC + QString("Resuming '%1' at %2")
+            .arg(m_step).arg(m_resume));
+}
+
+void BatchDelete::EndStep(void)
+{
+    if (m_terminated)
+    {
+        SaveResume(m_resume);
+        LOG(VB_GENERAL, LOG_INFO, LOC +
+            QString("Stopped '%1' at %2 after deleting %3 rows")
+                .arg(m_step).arg(m_resume).arg(m_stepRows));
+        return;
+    }
+
+    if (m_resumeSaved)
+        SaveResume(QString());
+
+    LOG(VB_GENERAL, LOG_INFO, LOC +
+        QString("'%1' deleted %2 rows in %3 statements, %4 seconds")
+            .arg(m_step).arg(m_stepRows).arg(m_stepBatches)
+            .arg(m_stepTimer.elapsed() * 0.001, 0, 'f', 1));
+}
+
+/** \fn BatchDelete::Delete(const QString&, const QString&, const MSqlBindings&, const QString&)
+ *  \brief Deletes the rows of \p table that match \p where, at most one
+ *         batch per statement.
+ *
+ *  \param partition If set, the rows are deleted separately for each value
+ *                   of this column, which should lead an index that also
+ *                   covers the columns \p where tests. For example, with
+ *                   "chanid", "starttime < :TIME" is an index range scan
+ *                   for each channel rather than a scan of the table.
+ */
+bool BatchDelete::Delete(const QString &table, const QString &where,
+                         const MSqlBindings &bindings,
+                         const QString &partition)
+{
+    MSqlQuery query(MSqlQuery::InitCon());
+
+    if (partition.isEmpty())
+        return DeleteLimited(query, table, where, bindings);
+
+    QString sql = QString("SELECT DISTINCT %1 FROM %2").arg(partition)
+                                                        .arg(table);
+    if (!m_resume.isEmpty())
+        sql += QString(" WHERE %1 >= :RESUME").arg(partition);
+    sql += QString(" ORDER BY %1").arg(partition);
+
+    query.prepare(sql);
+    if (!m_resume.isEmpty())
+        query.bindValue(":RESUME", m_resume);
+    if (!query.exec())
+    {
+        MythDB::DBError("BatchDelete::Delete", query);
+        return false;
+    }
+
+    QVariantList values;
+    while (query.next())
+        values.append(query.value(0));
+
+    MSqlBindings partitionBindings = bindings;
+    QString partitionWhere = QString("%1 = :PARTITION AND (%2)")
+        .arg(partition).arg(where);
+
+    foreach (const QVariant &value, values)
+    {
+        m_resume = value.toString();
+        partitionBindings[":PARTITION"] = value;
+        if (!DeleteLimited(query, table, partitionWhere, partitionBindings))
+            return false;
+    }
+
+    m_resume.clear();
+    return true;
+}
+
+/** \fn BatchDelete::DeleteRange(const QString&, const QString&, const QString&, const MSqlBindings&)
+ *  \brief Runs a delete statement over consecutive ranges of an integer
+ *         primary key, from its lowest to its highest value.
+ *
+ *  \param statement The DELETE, limited to the rows of \p table whose
+ *                   \p key is at least :LOW and below :HIGH. It may join
+ *                   other tables, which a LIMIT could not.
+ */
+bool BatchDelete::DeleteRange(const QString &table, const QString &key,
+                              const QString &statement,
+                              const MSqlBindings &bindings)
+{
+    MSqlQuery query(MSqlQuery::InitCon());
+
+    query.prepare(QString("SELECT MIN(%1), MAX(%1) FROM %2").arg(key)
+                                                             .arg(table));
+    if (!query.exec())
+    {
+        MythDB::DBError("BatchDelete::DeleteRange", query);
+        return false;
+    }
+    if (!query.next() || query.value(0).isNull())
+        return true;
+
+    qint64 low  = query.value(0).toLongLong();
+    qint64 last = query.value(1).toLongLong();
+    if (!m_resume.isEmpty())
+        low = qMax(low, m_resume.toLongLong());
+
+    MSqlBindings rangeBindings = bindings;
+    while (low <= last)
+    {
+        if (m_terminated)
+            return false;
+
+        qint64 high = low + m_batchSize;
+        m_resume = QString::number(low);
+        rangeBindings[":LOW"]  = low;
+        rangeBindings[":HIGH"] = high;
+
+        int rows;
+        query.prepare(statement);
+        query.bindValues(rangeBindings);
+        if (!Exec(query, rows))
+            return false;
+        LogProgress();
+
+        low = high;
+    }
+
+    m_resume.clear();
+    return true;
+}
+
+bool BatchDelete::DeleteLimited(MSqlQuery &query, const QString &table,
+                                const QString &where,
+                                const MSqlBindings &bindings)
+{
+    int rows;
+    int batch;
+    do
+    {
+        if (m_terminated)
+            return false;
+
+        batch = m_batchSize;
+        query.prepare(QString("DELETE FROM %1 WHERE %2 LIMIT %3")
+                      .arg(table).arg(where).arg(batch));
+        query.bindValues(bindings);
+        if (!Exec(query, rows))
+            return false;
+        LogProgress();
+    } while (rows >= batch);
+
+    return true;
+}
+
+bool BatchDelete::Exec(MSqlQuery &query, int &rows)
+{
+    MythTimer timer(MythTimer::kStartRunning);
+    if (!query.exec())
+    {
+        MythDB::DBError(QString("BatchDelete '%1'").arg(m_step), query);
+        return false;
+    }
+
+    rows = query.numRowsAffected();
+    m_stepRows  += rows;
+    m_totalRows += rows;
+    m_stepBatches++;
+
+    Throttle(timer.elapsed());
+    return true;
+}
+
+// Sizes the next batch to take about kTargetTime, and leaves the table
+// alone for at least as long as the last statement held it
+void BatchDelete::Throttle(int elapsed)
+{
+    if (elapsed > 2 * kTargetTime)
+        m_batchSize = qMax(m_batchSize / 2, kMinBatch);
+    else if (elapsed < kTargetTime / 2)
+        m_batchSize = qMin(m_batchSize * 2, kMaxBatch);
+
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(qMax(elapsed, kMinPause)));
+}
+
+void BatchDelete::LogProgress(void)
+{
+    if (m_progressTimer.elapsed() < kProgressInterval)
+        return;
+    m_progressTimer.restart();
+
+    LOG(VB_GENERAL, LOG_INFO, LOC +
+        QString("'%1' has deleted %2 rows so far, at %3, %4 per batch")
+            .arg(m_step).arg(m_stepRows).arg(m_resume).arg(m_batchSize));
+    SaveResume(m_resume);
+}
+
+QString BatchDelete::GetResume(void) const
+{
+    QString value = gCoreContext->GetSetting("CleanupTaskResume");
+    QString prefix = m_step + '|';
+    if (!value.startsWith(prefix))
+        return QString();
+    return value.mid(prefix.length());
+}
+
+void BatchDelete::SaveResume(const QString &value)
+{
+    if (value.isEmpty())
+    {
+        gCoreContext->SaveSettingOnHost("CleanupTaskResume", "", "");
+        m_resumeSaved = false;
+        return;
+    }
+
+    gCoreContext->SaveSettingOnHost("CleanupTaskResume",
+                                    m_step + '|' + value, "");
+    m_resumeSaved = true;
+}
@@ -0,0 +1,73 @@
+#ifndef BATCHDELETE_H_
+#define BATCHDELETE_H_
+
+#include <atomic>
+
+#include <QString>
+
+#include "mythdbcon.h"
+#include "mythtimer.h"
+
+/** \class BatchDelete
+ *  \brief Deletes large numbers of rows a small batch at a time.
+ *
+ *   Most MythTV tables use table locks, so a single DELETE of a few million
+ *   rows holds up every recording and EIT insert into the table until it
+ *   completes. BatchDelete instead splits a delete into statements that each
+ *   touch a bounded number of rows, and pauses between them for as long as
+ *   the last one took, so the table is free at least half of the time.
+ *   The batch size adapts to keep each statement short.
+ *
+ *   A delete is split either by a LIMIT, within each value of the leading
+ *   key column of the table (the chanid for program data), or by ranges of
+ *   an integer primary key. The progress of the current step is saved in
+ *   the "CleanupTaskResume" setting, so a step that is interrupted, e.g. by
+ *   a backend shutdown, resumes where it stopped on the next run.
+ *
+ *   Work is grouped into named steps with BeginStep() and EndStep(), which
+ *   log the rows deleted, the number of statements and the time taken.
+ */
+class BatchDelete
+{
+  public:
+    BatchDelete(void);
+
+    void Reset(void);
+    void Terminate(void)            { m_terminated = true;  }
+    bool IsTerminated(void) const   { return m_terminated;  }
+
+    void BeginStep(const QString &step);
+    void EndStep(void);
+
+    bool Delete(const QString &table, const QString &where,
+                const MSqlBindings &bindings = MSqlBindings(),
+                const QString &partition = QString());
+    bool DeleteRange(const QString &table, const QString &key,
+                     const QString &statement,
+                     const MSqlBindings &bindings = MSqlBindings());
+
+    qint64 GetTotalRows(void) const { return m_totalRows;   }
+
+  private:
+    bool DeleteLimited(MSqlQuery &query, const QString &table,
+                       const QString &where, const MSqlBindings &bindings);
+    bool Exec(MSqlQuery &query, int &rows);
+    void Throttle(int elapsed);
+    void LogProgress(void);
+    QString GetResume(void) const;
+    void SaveResume(const QString &value);
+
+    int         m_batchSize;
+    std::atomic<bool> m_terminated;
+
+    QString     m_step;
+    QString     m_resume;       ///< partition or key the step is at
+    bool        m_resumeSaved;  ///< the step has a saved resume point
+    qint64      m_stepRows;
+    int         m_stepBatches;
+    MythTimer   m_stepTimer;
+    MythTimer   m_progressTimer;
+    qint64      m_totalRows;
+};
+
+#endif
@@ -41,6 +41,43 @@
 #include "upnp.h"
 #include "mythdate.h"
 #include "tv_rec.h"
+#include "housekeeper.h"
+#include "backendcontext.h"
+#include "mythevent.h"
+#include "mythtimer.h"
+#include "mthread.h"
+
+// Least time between two refreshes of a section that keeps changing
+static const int kSectionMinWait   = 1000;
+// Most time the refresher sleeps without looking at the sections
+static const int kSectionMaxWait   = 60000;
+// Costly sections are only kept up to date for this long after a request
+static const int kSectionIdleTime  = 10 * 60 * 1000;
+
+/////////////////////////////////////////////////////////////////////////////
+// Keeps the status sections up to date, so a request only has to put
+// together what is already there
+/////////////////////////////////////////////////////////////////////////////
+
+class HttpStatusRefresher : public MThread
+{
+  public:
+    explicit HttpStatusRefresher( HttpStatus &parent )
+        : MThread("HttpStatusRefresher"), m_parent(parent) {}
+
+    ~HttpStatusRefresher() { wait(); }
+
+  protected:
+    void run(void) override // MThread
+    {
+        RunProlog();
+        m_parent.RefreshSections();
+        RunEpilog();
+    }
+
+  private:
+    HttpStatus &m_parent;
+};
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -58,6 +95,96 @@ HttpStatus::HttpStatus( QMap<int, EncoderLink *> *tvList, Scheduler *sched,
     m_nPreRollSeconds = gCoreContext->GetNumSetting("RecordPreRoll", 0);
 
     m_pMainServer = nullptr;
+
+    // Seconds between refreshes, when nothing says a section changed.
+    // Storage asks the other backends for their free space and
+    // Miscellaneous runs a script, so they are only refreshed while the
+    // status is being requested.
+
+    AddSection( "Encoders"     , &HttpStatus::FillEncoders     ,  10 );
+    AddSection( "Scheduled"    , &HttpStatus::FillScheduled    ,  60 );
+    AddSection( "Frontends"    , &HttpStatus::FillFrontends    ,  60 );
+    AddSection( "Backends"     , &HttpStatus::FillBackends     ,  60 );
+    AddSection( "JobQueue"     , &HttpStatus::FillJobQueue     ,  30 );
+    AddSection( "Storage"      , &HttpStatus::FillStorage      ,  60, true );
+    AddSection( "Guide"        , &HttpStatus::FillGuide        , 300 );
+    AddSection( "HouseKeeping" , &HttpStatus::FillHouseKeeping ,  30 );
+    AddSection( "Miscellaneous", &HttpStatus::FillMiscellaneous,  60, true );
+
+    m_bRefresh   = true;
+    m_pRefresher = new HttpStatusRefresher(*this);
+    m_pRefresher->start();
+
+    gCoreContext->addListener(this);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+HttpStatus::~HttpStatus()
+{
+    gCoreContext->removeListener(this);
+
+    Stop();
+
+    delete m_pRefresher;
+    m_pRefresher = nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpStatus::Stop( void )
+{
+    {
+        QMutexLocker locker(&m_sectionLock);
+        m_bRefresh = false;
+        m_sectionWait.wakeAll();
+    }
+
+    if (m_pRefresher)
+        m_pRefresher->wait();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpStatus::SetMainServer( MainServer *mainServer )
+{
+    {
+        QMutexLocker locker(&m_sectionLock);
+        m_pMainServer = mainServer;
+    }
+
+    MarkStale("Storage");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Refresh the sections the backend says changed, rather than waiting for
+// their next turn
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpStatus::customEvent( QEvent *e )
+{
+    if (e->type() != MythEvent::MythEventMessage)
+        return;
+
+    MythEvent *me = static_cast<MythEvent *>(e);
+    QString message = me->Message();
+
+    if (message.startsWith("ENCODER_STATE") ||
+        message.startsWith("DONE_RECORDING"))
+        MarkStale("Encoders");
+    else if (message == "SCHEDULE_CHANGE")
+        MarkStale("Scheduled");
+    else if (message.startsWith("JOB_STATUS") ||
+             message.startsWith("JOB_PROGRESS"))
+        MarkStale("JobQueue");
+    else if (message.startsWith("RECORDING_LIST_CHANGE DELETE"))
+        MarkStale("Storage");
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -188,10 +315,205 @@ void HttpStatus::FillStatusXML( QDomDocument *pDoc )
     root.setAttribute("version" , MYTH_BINARY_VERSION           );
     root.setAttribute("protoVer", MYTH_PROTO_VERSION            );
 
-    // Add all encoders, if any
+    NoteRequest();
+
+    // Everything but the load average comes from the last background
+    // refresh, each section saying when that was.
+
+    AppendSection(pDoc, root, "Encoders" );
+    AppendSection(pDoc, root, "Scheduled");
+    AppendSection(pDoc, root, "Frontends");
+    AppendSection(pDoc, root, "Backends" );
+    AppendSection(pDoc, root, "JobQueue" );
+
+    QDomElement mInfo = pDoc->createElement("MachineInfo");
+    root.appendChild(mInfo);
+
+    AppendSection(pDoc, mInfo, "Storage");
+    mInfo.appendChild(FillLoad(pDoc));
+    AppendSection(pDoc, mInfo, "Guide"  );
+
+    AppendSection(pDoc, root, "HouseKeeping" );
+    AppendSection(pDoc, root, "Miscellaneous");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpStatus::AddSection( const QString &sName, HttpStatusBuilder pBuild,
+                             int nInterval, bool bOnDemand )
+{
+    HttpStatusSection section;
+
+    section.m_sName     = sName;
+    section.m_pBuild    = pBuild;
+    section.m_nInterval = nInterval;
+    section.m_bOnDemand = bOnDemand;
+    section.m_bStale    = true;
+
+    m_sections.append(section);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpStatus::MarkStale( const QString &sName )
+{
+    QMutexLocker locker(&m_sectionLock);
+
+    for (int i = 0; i < m_sections.size(); i++)
+    {
+        if (m_sections[i].m_sName == sName)
+            m_sections[i].m_bStale = true;
+    }
+
+    m_sectionWait.wakeAll();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Has the refresher go back to the on demand sections if nobody asked for
+// the status for a while. This request gets them as they were, the next
+// ones get them up to date.
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpStatus::NoteRequest( void )
+{
+    QMutexLocker locker(&m_sectionLock);
+
+    QDateTime now = MythDate::current();
+
+    if (!m_dtLastRequest.isValid() ||
+        m_dtLastRequest.msecsTo(now) >= kSectionIdleTime)
+    {
+        m_sectionWait.wakeAll();
+    }
+
+    m_dtLastRequest = now;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Runs in the refresher thread, rebuilding each section when it is due
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpStatus::RefreshSections( void )
+{
+    QMutexLocker locker(&m_sectionLock);
+
+    while (m_bRefresh)
+    {
+        QDateTime now  = MythDate::current();
+        int       wait = kSectionMaxWait;
+
+        // The on demand sections ask the other backends, or run scripts,
+        // so don't build them when nobody is going to look
+        bool bIdle = !m_dtLastRequest.isValid() ||
+                     m_dtLastRequest.msecsTo(now) >= kSectionIdleTime;
+
+        for (int i = 0; i < m_sections.size() && m_bRefresh; i++)
+        {
+            HttpStatusSection &section = m_sections[i];
+
+            if (bIdle && section.m_bOnDemand)
+                continue;
+
+            qint64 age = section.m_dtUpdated.isValid() ?
+                section.m_dtUpdated.msecsTo(now) : -1;
+
+            // Changes come in bursts, so rebuild at most every
+            // kSectionMinWait even when told something changed
+            bool due = (age < 0) || (age >= section.m_nInterval * 1000LL) ||
+                       (section.m_bStale && age >= kSectionMinWait);
+
+            if (!due)
+            {
+                qint64 left = section.m_bStale ?
+                    kSectionMinWait - age :
+                    section.m_nInterval * 1000LL - age;
+                wait = qMin(wait, (int)left);
+                continue;
+            }
+
+            QString           sName  = section.m_sName;
+            HttpStatusBuilder pBuild = section.m_pBuild;
+            section.m_bStale = false;
+
+            locker.unlock();
+
+            MythTimer t;
+            t.start();
+
+            QDomDocument doc;
+            QDomElement  element = (this->*pBuild)(&doc);
+            QString      sXML;
+
+            if (!element.isNull())
+            {
+                doc.appendChild(element);
+                sXML = doc.toString(-1);
+            }
+
+            LOG(VB_HTTP, LOG_DEBUG,
+                QString("HttpStatus: Refreshed %1 in %2 ms")
+                    .arg(sName).arg(t.elapsed()));
+
+            locker.relock();
+
+            // the list doesn't change once the refresher is running
+            m_sections[i].m_sXML      = sXML;
+            m_sections[i].m_dtUpdated = MythDate::current();
+            m_sectionWait.wakeAll();
+
+            // time has moved on, start over
+            wait = 0;
+            break;
+        }
+
+        if (m_bRefresh && wait > 0)
+            m_sectionWait.wait(locker.mutex(), wait);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Adds the named section, as of its last refresh, to parent
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpStatus::AppendSection( QDomDocument *pDoc, QDomElement &parent,
+                                const QString &sName )
+{
+    QMutexLocker locker(&m_sectionLock);
+
+    for (int i = 0; i < m_sections.size(); i++)
+    {
+        if (m_sections[i].m_sName != sName)
+            continue;
+
+        // A section that hasn't been built yet is left out, rather than
+        // holding up the request
+        if (m_sections[i].m_sXML.isEmpty())
+            return;
+
+        QDomDocument doc;
+        if (!doc.setContent(m_sections[i].m_sXML))
+            return;
+
+        QDomElement element =
+            pDoc->importNode(doc.documentElement(), true).toElement();
+        element.setAttribute("updated",
+                             m_sections[i].m_dtUpdated.toString(Qt::ISODate));
+        parent.appendChild(element);
+        return;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
 
+QDomElement HttpStatus::FillEncoders( QDomDocument *pDoc )
+{
     QDomElement encoders = pDoc->createElement("Encoders");
-    root.appendChild(encoders);
 
     int  numencoders = 0;
     bool isLocal     = true;
@@ -255,10 +577,16 @@ void HttpStatus::FillStatusXML( QDomDocument *pDoc )
 
     encoders.setAttribute("count", numencoders);
 
-    // Add upcoming shows
+    return encoders;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
 
+QDomElement HttpStatus::FillScheduled( QDomDocument *pDoc )
+{
     QDomElement scheduled = pDoc->createElement("Scheduled");
-    root.appendChild(scheduled);
 
     RecList recordingList;
 
@@ -289,10 +617,16 @@ void HttpStatus::FillStatusXML( QDomDocument *pDoc )
 
     scheduled.setAttribute("count", iNumRecordings);
 
-    // Add known frontends
+    return scheduled;
+}
 
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+QDomElement HttpStatus::FillFrontends( QDomDocument *pDoc )
+{
     QDomElement frontends = pDoc->createElement("Frontends");
-    root.appendChild(frontends);
 
     SSDPCacheEntries *fes = SSDP::Find(
         "urn:schemas-mythtv-org:service:MythFrontend:1");
@@ -315,10 +649,16 @@ void HttpStatus::FillStatusXML( QDomDocument *pDoc )
         }
     }
 
-    // Other backends
+    return frontends;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
 
+QDomElement HttpStatus::FillBackends( QDomDocument *pDoc )
+{
     QDomElement backends = pDoc->createElement("Backends");
-    root.appendChild(backends);
 
     int numbes = 0;
     if (!gCoreContext->IsMasterBackend())
@@ -367,10 +707,16 @@ void HttpStatus::FillStatusXML( QDomDocument *pDoc )
 
     backends.setAttribute("count", numbes);
 
-    // Add Job Queue Entries
+    return backends;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
 
+QDomElement HttpStatus::FillJobQueue( QDomDocument *pDoc )
+{
     QDomElement jobqueue = pDoc->createElement("JobQueue");
-    root.appendChild(jobqueue);
 
     QMap<int, JobQueueEntry> jobs;
     QMap<int, JobQueueEntry>::Iterator it;
@@ -418,19 +764,16 @@ void HttpStatus::FillStatusXML( QDomDocument *pDoc )
 
     jobqueue.setAttribute( "count", jobs.size() );
 
-    // Add Machine information
-
-    QDomElement mInfo   = pDoc->createElement("MachineInfo");
-    QDomElement storage = pDoc->createElement("Storage"    );
-    QDomElement load    = pDoc->createElement("Load"       );
-    QDomElement guide   = pDoc->createElement("Guide"      );
+    return jobqueue;
+}
 
-    root.appendChild (mInfo  );
-    mInfo.appendChild(storage);
-    mInfo.appendChild(load   );
-    mInfo.appendChild(guide  );
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
 
-    // drive space   ---------------------
+QDomElement HttpStatus::FillStorage( QDomDocument *pDoc )
+{
+    QDomElement storage = pDoc->createElement("Storage");
 
     QStringList strlist;
     QString dirs;
@@ -440,8 +783,15 @@ void HttpStatus::FillStatusXML( QDomDocument *pDoc )
     QString fsID;
     QString ids;
 
-    if (m_pMainServer)
-        m_pMainServer->BackendQueryDiskSpace(strlist, true, m_bIsMaster);
+    MainServer *mainServer;
+    {
+        QMutexLocker locker(&m_sectionLock);
+        mainServer = m_pMainServer;
+    }
+
+    // The other backends are asked in parallel, each with a time limit
+    if (mainServer)
+        mainServer->BackendQueryDiskSpace(strlist, true, m_bIsMaster);
 
     QDomElement total;
 
@@ -512,7 +862,16 @@ void HttpStatus::FillStatusXML( QDomDocument *pDoc )
             storage.appendChild(fsXML[fs_index]);
     }
 
-    // load average ---------------------
+    return storage;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+QDomElement HttpStatus::FillLoad( QDomDocument *pDoc )
+{
+    QDomElement load = pDoc->createElement("Load");
 
 #ifdef Q_OS_ANDROID
     load.setAttribute("avg1", 0);
@@ -529,7 +888,16 @@ void HttpStatus::FillStatusXML( QDomDocument *pDoc )
     }
 #endif
 
-    // Guide Data ---------------------
+    return load;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+QDomElement HttpStatus::FillGuide( QDomDocument *pDoc )
+{
+    QDomElement guide = pDoc->createElement("Guide");
 
     QDateTime GuideDataThrough;
 
@@ -557,65 +925,123 @@ void HttpStatus::FillStatusXML( QDomDocument *pDoc )
     {
         guide.setAttribute("guideThru",
             GuideDataThrough.toString(Qt::ISODate));
-        guide.setAttribute("guideDays", qdtNow.daysTo(GuideDataThrough));
+        guide.setAttribute("guideDays",
+            MythDate::current().daysTo(GuideDataThrough));
     }
 
     QDomText dataDirectMessage =
         pDoc->createTextNode(gCoreContext->GetSetting("DataDirectMessage"));
     guide.appendChild(dataDirectMessage);
 
-    // Add Miscellaneous information
+    return guide;
+}
 
-    QString info_script = gCoreContext->GetSetting("MiscStatusScript");
-    if ((!info_script.isEmpty()) && (info_script != "none"))
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+QDomElement HttpStatus::FillHouseKeeping( QDomDocument *pDoc )
+{
+    if (!housekeeping)
+        return QDomElement();
+
+    QDomElement tasks = pDoc->createElement("HouseKeeping");
+
+    QList<HouseKeeperTaskStatus> list = housekeeping->GetTaskStatus();
+    foreach (const HouseKeeperTaskStatus &status, list)
     {
-        QDomElement misc = pDoc->createElement("Miscellaneous");
-        root.appendChild(misc);
+        QDomElement task = pDoc->createElement("Task");
+        tasks.appendChild(task);
+
+        task.setAttribute("tag"    , status.tag);
+        task.setAttribute("running", status.running);
+        task.setAttribute("queued" , status.queued);
+        task.setAttribute("lastRun",
+                          status.lastRun.toString(Qt::ISODate));
+        task.setAttribute("lastSuccess",
+                          status.lastSuccess.toString(Qt::ISODate));
+        if (status.started.isValid())
+            task.setAttribute("started",
+                              status.started.toString(Qt::ISODate));
+
+        // Durations of the completed runs, in milliseconds
+        if (status.runTimes.isEmpty())
+            continue;
 
-        uint flags = kMSRunShell | kMSStdOut;
-        MythSystemLegacy ms(info_script, flags);
-        ms.Run(10);
-        if (ms.Wait() != GENERIC_EXIT_OK)
+        long long total = 0;
+        int longest = 0;
+        foreach (int ms, status.runTimes)
         {
-            LOG(VB_GENERAL, LOG_ERR,
-                QString("Error running miscellaneous "
-                        "status information script: %1").arg(info_script));
-            return;
+            total  += ms;
+            longest = qMax(longest, ms);
         }
+        task.setAttribute("runs"       , status.runTimes.size());
+        task.setAttribute("lastTime"   , status.runTimes.last());
+        task.setAttribute("averageTime",
+                          (int)(total / status.runTimes.size()));
+        task.setAttribute("longestTime", longest);
+    }
 
-        QByteArray input = ms.ReadAll();
+    return tasks;
+}
 
-        QStringList output = QString(input).split('\n',
-                                                  QString::SkipEmptyParts);
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
 
-        for (auto iter = output.begin(); iter != output.end(); ++iter)
-        {
-            QDomElement info = pDoc->createElement("Information");
+QDomElement HttpStatus::FillMiscellaneous( QDomDocument *pDoc )
+{
+    QString info_script = gCoreContext->GetSetting("MiscStatusScript");
+    if ((info_script.isEmpty()) || (info_script == "none"))
+        return QDomElement();
 
-            QStringList list = (*iter).split("[]:[]");
-            unsigned int size = list.size();
-            unsigned int hasAttributes = 0;
+    QDomElement misc = pDoc->createElement("Miscellaneous");
 
-            if ((size > 0) && (!list[0].isEmpty()))
-            {
-                info.setAttribute("display", list[0]);
-                hasAttributes++;
-            }
-            if ((size > 1) && (!list[1].isEmpty()))
-            {
-                info.setAttribute("name", list[1]);
-                hasAttributes++;
-            }
-            if ((size > 2) && (!list[2].isEmpty()))
-            {
-                info.setAttribute("value", list[2]);
-                hasAttributes++;
-            }
+    uint flags = kMSRunShell | kMSStdOut;
+    MythSystemLegacy ms(info_script, flags);
+    ms.Run(10);
+    if (ms.Wait() != GENERIC_EXIT_OK)
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            QString("Error running miscellaneous "
+                    "status information script: %1").arg(info_script));
+        return misc;
+    }
+
+    QByteArray input = ms.ReadAll();
+
+    QStringList output = QString(input).split('\n',
+                                              QString::SkipEmptyParts);
+
+    for (auto iter = output.begin(); iter != output.end(); ++iter)
+    {
+        QDomElement info = pDoc->createElement("Information");
+
+        QStringList list = (*iter).split("[]:[]");
+        unsigned int size = list.size();
+        unsigned int hasAttributes = 0;
 
-            if (hasAttributes > 0)
-                misc.appendChild(info);
+        if ((size > 0) && (!list[0].isEmpty()))
+        {
+            info.setAttribute("display", list[0]);
+            hasAttributes++;
+        }
+        if ((size > 1) && (!list[1].isEmpty()))
+        {
+            info.setAttribute("name", list[1]);
+            hasAttributes++;
+        }
+        if ((size > 2) && (!list[2].isEmpty()))
+        {
+            info.setAttribute("value", list[2]);
+            hasAttributes++;
         }
+
+        if (hasAttributes > 0)
+            misc.appendChild(info);
     }
+
+    return misc;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -690,6 +1116,13 @@ void HttpStatus::PrintStatus( QTextStream &os, QDomDocument *pDoc )
     if (!node.isNull())
         PrintMachineInfo( os, node.toElement());
 
+    // Housekeeping tasks ----------------------
+
+    node = docElem.namedItem( "HouseKeeping" );
+
+    if (!node.isNull())
+        PrintHouseKeeping( os, node.toElement());
+
     // Miscellaneous information ---------------
 
     node = docElem.namedItem( "Miscellaneous" );
@@ -1447,6 +1880,66 @@ int HttpStatus::PrintMachineInfo( QTextStream &os, QDomElement info )
     return( 1 );
 }
 
+int HttpStatus::PrintHouseKeeping( QTextStream &os, QDomElement tasks )
+{
+    if (tasks.isNull())
+        return( 0 );
+
+    QDomNodeList nodes = tasks.elementsByTagName("Task");
+    uint count = nodes.count();
+    if (count == 0)
+        return( 0 );
+
+    os << "<div class=\"content\">\r\n"
+       << "    <h2 class=\"status\">Housekeeping</h2>\r\n"
+       << "    <ul>\r\n";
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        QDomElement e = nodes.item(i).toElement();
+        if (e.isNull())
+            continue;
+
+        os << "      <li>" << e.attribute("tag") << ": ";
+
+        if (e.attribute("running", "0").toInt())
+        {
+            QDateTime started = MythDate::fromString(e.attribute("started"));
+            os << "running since "
+               << MythDate::toString(started, MythDate::kDateTimeShort);
+        }
+        else if (e.attribute("queued", "0").toInt())
+            os << "waiting to run";
+        else
+        {
+            QDateTime lastRun = MythDate::fromString(e.attribute("lastRun"));
+            if (lastRun.isValid() && lastRun.toMSecsSinceEpoch() > 0)
+                os << "last run "
+                   << MythDate::toString(lastRun, MythDate::kDateTimeShort);
+            else
+                os << "not run yet";
+        }
+
+        int runs = e.attribute("runs", "0").toInt();
+        if (runs > 0)
+        {
+            os << QString(", took %1 s (average %2 s, longest %3 s "
+                          "over %4 run(s))")
+                .arg(e.attribute("lastTime").toInt() * 0.001, 0, 'f', 1)
+                .arg(e.attribute("averageTime").toInt() * 0.001, 0, 'f', 1)
+                .arg(e.attribute("longestTime").toInt() * 0.001, 0, 'f', 1)
+                .arg(runs);
+        }
+
+        os << "</li>\r\n";
+    }
+
+    os << "    </ul>\r\n"
+       << "</div>\r\n";
+
+    return( count );
+}
+
 int HttpStatus::PrintMiscellaneousInfo( QTextStream &os, QDomElement info )
 {
     if (info.isNull())
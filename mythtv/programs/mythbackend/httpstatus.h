@@ -12,7 +12,10 @@
 #define HTTPSTATUS_H_
 
 #include <QDomDocument>
+#include <QWaitCondition>
+#include <QDateTime>
 #include <QMutex>
+#include <QList>
 #include <QMap>
 
 #include "httpserver.h"
@@ -38,9 +41,33 @@ class Scheduler;
 class AutoExpire;
 class EncoderLink;
 class MainServer;
+class HttpStatus;
+class HttpStatusRefresher;
+
+typedef QDomElement (HttpStatus::*HttpStatusBuilder)( QDomDocument *pDoc );
+
+/////////////////////////////////////////////////////////////////////////////
+// One part of the status page. It is rebuilt in the background every
+// m_nInterval seconds, or sooner when an event says it changed, and kept
+// as text since a QDomDocument can't be shared between threads. An on
+// demand section is only rebuilt while the status is being requested.
+/////////////////////////////////////////////////////////////////////////////
+
+struct HttpStatusSection
+{
+    QString             m_sName;
+    HttpStatusBuilder   m_pBuild;
+    int                 m_nInterval;
+    bool                m_bOnDemand;
+    QString             m_sXML;
+    QDateTime           m_dtUpdated;
+    bool                m_bStale;
+};
 
 class HttpStatus : public HttpServerExtension
 {
+    friend class HttpStatusRefresher;
+
     private:
 
         Scheduler                   *m_pSched;
@@ -51,6 +78,13 @@ class HttpStatus : public HttpServerExtension
         int                          m_nPreRollSeconds;
         QMutex                       m_settingLock;
 
+        QList<HttpStatusSection>     m_sections;
+        QMutex                       m_sectionLock;
+        QWaitCondition               m_sectionWait;
+        bool                         m_bRefresh;
+        QDateTime                    m_dtLastRequest;
+        HttpStatusRefresher         *m_pRefresher;
+
     private:
 
         HttpStatusMethod GetMethod( const QString &sURI );
@@ -59,7 +93,29 @@ class HttpStatus : public HttpServerExtension
         void    GetStatusHTML     ( HTTPRequest *pRequest );
 
         void    FillStatusXML     ( QDomDocument *pDoc);
-    
+
+        void    AddSection        ( const QString &sName,
+                                    HttpStatusBuilder pBuild,
+                                    int nInterval,
+                                    bool bOnDemand = false );
+        void    MarkStale         ( const QString &sName );
+        void    NoteRequest       ( void );
+        void    RefreshSections   ( void );
+        void    AppendSection     ( QDomDocument *pDoc,
+                                    QDomElement  &parent,
+                                    const QString &sName );
+
+        QDomElement FillEncoders     ( QDomDocument *pDoc );
+        QDomElement FillScheduled    ( QDomDocument *pDoc );
+        QDomElement FillFrontends    ( QDomDocument *pDoc );
+        QDomElement FillBackends     ( QDomDocument *pDoc );
+        QDomElement FillJobQueue     ( QDomDocument *pDoc );
+        QDomElement FillStorage      ( QDomDocument *pDoc );
+        QDomElement FillLoad         ( QDomDocument *pDoc );
+        QDomElement FillGuide        ( QDomDocument *pDoc );
+        QDomElement FillHouseKeeping ( QDomDocument *pDoc );
+        QDomElement FillMiscellaneous( QDomDocument *pDoc );
+
         void    PrintStatus       ( QTextStream &os, QDomDocument *pDoc );
         int     PrintEncoderStatus( QTextStream &os, QDomElement encoders );
         int     PrintScheduled    ( QTextStream &os, QDomElement scheduled );
@@ -67,6 +123,7 @@ class HttpStatus : public HttpServerExtension
         int     PrintBackends     ( QTextStream &os, QDomElement backends );
         int     PrintJobQueue     ( QTextStream &os, QDomElement jobs );
         int     PrintMachineInfo  ( QTextStream &os, QDomElement info );
+        int     PrintHouseKeeping ( QTextStream &os, QDomElement tasks );
         int     PrintMiscellaneousInfo ( QTextStream &os, QDomElement info );
 
         void    FillProgramInfo   ( QDomDocument *pDoc,
@@ -83,14 +140,20 @@ class HttpStatus : public HttpServerExtension
     public:
                  HttpStatus( QMap<int, EncoderLink *> *tvList, Scheduler *sched,
                              AutoExpire *expirer, bool bIsMaster );
-        virtual ~HttpStatus() = default;
+        virtual ~HttpStatus();
 
-        void     SetMainServer(MainServer *mainServer)
-                    { m_pMainServer = mainServer; }
+        // Stops the background refresh, before what it reads goes away
+        void     Stop( void );
+
+        void     SetMainServer( MainServer *mainServer );
 
         QStringList GetBasePaths() override; // HttpServerExtension
         
         bool     ProcessRequest( HTTPRequest *pRequest ) override; // HttpServerExtension
+
+    protected:
+
+        void     customEvent( QEvent *e ) override; // QObject
 };
 
 #endif
@@ -35,6 +35,7 @@
 #include "encoderlink.h"
 #include "remoteutil.h"
 #include "backendhousekeeper.h"
+#include "recordingcatalog.h"
 
 #include "mythcontext.h"
 #include "mythversion.h"
@@ -65,6 +66,7 @@
 #define LOC_ERR  QString("MythBackend, Error: ")
 
 static MainServer *mainServer = nullptr;
+static HttpStatus *httpStatus = nullptr;
 
 bool setupTVs(bool ismaster, bool &error)
 {
@@ -234,6 +236,11 @@ void cleanup(void)
     if (gCoreContext)
         gCoreContext->SetExiting();
 
+    // The status page is refreshed in the background from what is
+    // torn down below, the extension itself goes with g_pUPnp
+    if (httpStatus)
+        httpStatus->Stop();
+
     delete housekeeping;
     housekeeping = nullptr;
 
@@ -249,8 +256,12 @@ void cleanup(void)
     delete jobqueue;
     jobqueue = nullptr;
 
+    delete catalog;
+    catalog = nullptr;
+
     delete g_pUPnp;
     g_pUPnp = nullptr;
+    httpStatus = nullptr;
 
     if (SSDP::Instance())
     {
@@ -611,6 +622,8 @@ int run_backend(MythBackendCommandLineParser &cmdline)
 
     print_warnings(cmdline);
 
+    catalog = new RecordingCatalog();
+
     bool fatal_error = false;
     bool runsched = setupTVs(ismaster, fatal_error);
     if (fatal_error)
@@ -690,7 +703,6 @@ int run_backend(MythBackendCommandLineParser &cmdline)
     // Setup status server
     // ----------------------------------------------------------------------
 
-    HttpStatus *httpStatus = nullptr;
     HttpServer *pHS = g_pUPnp->GetHttpServer();
 
     if (pHS)
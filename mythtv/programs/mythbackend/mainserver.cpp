@@ -84,6 +84,7 @@ using namespace std;
 
 // mythbackend headers
 #include "backendcontext.h"
+#include "recordingcatalog.h"
 
 /** Milliseconds to wait for an existing thread from
  *  process request thread pool.
@@ -238,6 +239,37 @@ class FreeSpaceUpdater : public QRunnable
 const int FreeSpaceUpdater::kRequeryTimeout = 15000;
 const int FreeSpaceUpdater::kExitTimeout = 61000;
 
+/// How long BackendQueryDiskSpace() waits for the other backends to answer
+const int kRemoteFreeSpaceTimeout = 2000;
+
+class RemoteFreeSpaceQuery : public QRunnable
+{
+  public:
+    RemoteFreeSpaceQuery(MainServer &parent, PlaybackSock *pbs) :
+        m_parent(parent), m_pbs(pbs), m_hostname(pbs->getHostname())
+    {
+    }
+
+    void run(void) override // QRunnable
+    {
+        QStringList list;
+        m_pbs->GetDiskSpace(list);
+        m_pbs->DecrRef();
+        m_pbs = nullptr;
+
+        QMutexLocker locker(&m_parent.remoteFreeSpaceLock);
+        if (!list.isEmpty())
+            m_parent.remoteFreeSpace[m_hostname] = list;
+        m_parent.remoteFreeSpacePending.remove(m_hostname);
+        m_parent.remoteFreeSpaceWait.wakeAll();
+    }
+
+  private:
+    MainServer   &m_parent;
+    PlaybackSock *m_pbs;
+    QString       m_hostname;
+};
+
 MainServer::MainServer(bool master, int port,
                        QMap<int, EncoderLink *> *_tvList,
                        Scheduler *sched, AutoExpire *_expirer) :
@@ -413,6 +445,12 @@ void MainServer::Stop()
         }
     }
 
+    {
+        QMutexLocker locker(&remoteFreeSpaceLock);
+        while (!remoteFreeSpacePending.isEmpty())
+            remoteFreeSpaceWait.wait(locker.mutex());
+    }
+
     // Close all open sockets
     QWriteLocker locker(&sockListLock);
 
@@ -2141,30 +2179,28 @@ void MainServer::HandleQueryRecordings(QString type, PlaybackSock *pbs)
     MythSocket *pbssock = pbs->getSocket();
     QString playbackhost = pbs->getHostname();
 
-    QMap<QString,ProgramInfo*> recMap;
-    if (m_sched)
-        recMap = m_sched->GetRecording();
-
-    QMap<QString,uint32_t> inUseMap = ProgramInfo::QueryInUseMap();
-    QMap<QString,bool> isJobRunning =
-        ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
+    RecordingSnapshotPtr snapshot = catalog->GetSnapshot();
+    RecordingList destination;
 
-    int sort = 0;
-    // Allow "Play" and "Delete" for backwards compatibility with protocol
-    // version 56 and below.
-    if ((type == "Ascending") || (type == "Play"))
-        sort = 1;
-    else if ((type == "Descending") || (type == "Delete"))
-        sort = -1;
-
-    ProgramList destination;
-    LoadFromRecorded(
-        destination, (type == "Recording"),
-        inUseMap, isJobRunning, recMap, sort);
+    if (type == "Recording")
+    {
+        QDateTime now = MythDate::current();
+        RecordingList started = snapshot->GetByStartTime(QDateTime(), now);
+        foreach (const RecordingPtr &recording, started)
+        {
+            if (recording->GetRecordingEndTime() >= now)
+                destination.push_back(recording);
+        }
+    }
+    else
+    {
+        // Allow "Play" and "Delete" for backwards compatibility with
+        // protocol version 56 and below.
+        destination = snapshot->GetAll(
+            (type == "Descending") || (type == "Delete"));
+    }
 
-    QMap<QString,ProgramInfo*>::iterator mit = recMap.begin();
-    for (; mit != recMap.end(); mit = recMap.erase(mit))
-        delete *mit;
+    RecordingOverlay overlay(m_sched);
 
     QStringList outputlist(QString::number(destination.size()));
     QMap<QString, QString> backendPortMap;
@@ -2172,10 +2208,9 @@ void MainServer::HandleQueryRecordings(QString type, PlaybackSock *pbs)
     int port = gCoreContext->GetBackendServerPort();
     QString host = gCoreContext->GetHostName();
 
-    ProgramList::iterator it = destination.begin();
-    for (it = destination.begin(); it != destination.end(); ++it)
+    foreach (const RecordingPtr &recording, destination)
     {
-        ProgramInfo *proginfo = *it;
+        ProgramInfo *proginfo = overlay.Copy(*recording);
         PlaybackSock *slave = nullptr;
 
         if (proginfo->GetHostname() != gCoreContext->GetHostName())
@@ -2255,6 +2290,7 @@ void MainServer::HandleQueryRecordings(QString type, PlaybackSock *pbs)
             slave->DecrRef();
 
         proginfo->ToStringList(outputlist);
+        delete proginfo;
     }
 
     SendResponse(pbssock, outputlist);
@@ -2467,6 +2503,7 @@ void MainServer::DoDeleteThread(DeleteStruct *ds)
     QStringList nameFilters;
     nameFilters.push_back(fInfo.fileName() + "*.png");
     nameFilters.push_back(fInfo.fileName() + "*.jpg");
+    nameFilters.push_back(fInfo.fileName() + ".strip.vtt");
     nameFilters.push_back(fInfo.fileName() + ".tmp");
     nameFilters.push_back(fInfo.fileName() + ".old");
     nameFilters.push_back(fInfo.fileName() + ".map");
@@ -5248,10 +5285,45 @@ void MainServer::BackendQueryDiskSpace(QStringList &strlist, bool consolidated,
 
         sockListLock.unlock();
 
+        // Ask all the other backends at once, and don't let one that is
+        // slow to answer hold up the rest. A backend that doesn't answer
+        // in time, or that is still busy with an earlier query, is counted
+        // with what it last answered.
+        QStringList hosts;
+        QMutexLocker locker(&remoteFreeSpaceLock);
         for (list<PlaybackSock *>::iterator p = localPlaybackList.begin() ;
-             p != localPlaybackList.end() ; ++p) {
-            (*p)->GetDiskSpace(strlist);
-            (*p)->DecrRef();
+             p != localPlaybackList.end() ; ++p)
+        {
+            QString host = (*p)->getHostname();
+            hosts << host;
+            if (remoteFreeSpacePending.contains(host))
+            {
+                (*p)->DecrRef();
+                continue;
+            }
+            remoteFreeSpacePending.insert(host);
+            MThreadPool::globalInstance()->startReserved(
+                new RemoteFreeSpaceQuery(*this, *p), "RemoteFreeSpace");
+        }
+
+        MythTimer t;
+        t.start();
+        foreach (const QString &host, hosts)
+        {
+            while (remoteFreeSpacePending.contains(host))
+            {
+                int left = kRemoteFreeSpaceTimeout - t.elapsed();
+                if (left <= 0 ||
+                    !remoteFreeSpaceWait.wait(locker.mutex(), left))
+                    break;
+            }
+            if (remoteFreeSpacePending.contains(host))
+            {
+                LOG(VB_GENERAL, LOG_WARNING, LOC +
+                    QString("Timed out querying free space on %1, "
+                            "using the last known values").arg(host));
+            }
+            strlist += remoteFreeSpace.value(host);
         }
     }
 
@@ -5432,6 +5504,26 @@ void MainServer::GetFilesystemInfos(QList<FileSystemInfo> &fsInfos,
     fsInfosCache = fsInfos;
 }
 
+/** \fn MainServer::AdjustFilesystemUsage(const QMap<int, int64_t>&)
+ *  \brief Adds \p usedKB, keyed by filesystem ID, to the used space of
+ *         the cached filesystems, for space written since they were read.
+ */
+void MainServer::AdjustFilesystemUsage(const QMap<int, int64_t> &usedKB)
+{
+    QMutexLocker locker(&fsInfosCacheLock);
+    QList<FileSystemInfo>::iterator it = fsInfosCache.begin();
+    for (; it != fsInfosCache.end(); ++it)
+    {
+        QMap<int, int64_t>::const_iterator used =
+            usedKB.find(it->getFSysID());
+        if (used == usedKB.end() || it->getUsedSpace() < 0)
+            continue;
+
+        it->setUsedSpace(min(it->getUsedSpace() + *used,
+                             it->getTotalSpace()));
+    }
+}
+
 void MainServer::HandleMoveFile(PlaybackSock *pbs, const QString &storagegroup,
                                 const QString &src, const QString &dst)
 {
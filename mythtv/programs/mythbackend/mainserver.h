@@ -114,6 +114,7 @@ class MainServer : public QObject, public MythSocketCBs
     friend class DeleteThread;
     friend class TruncateThread;
     friend class FreeSpaceUpdater;
+    friend class RemoteFreeSpaceQuery;
     friend class RenameThread;
   public:
     MainServer(bool master, int port,
@@ -145,6 +146,7 @@ class MainServer : public QObject, public MythSocketCBs
                                bool allHosts);
     void GetFilesystemInfos(QList<FileSystemInfo> &fsInfos,
                             bool useCache=true);
+    void AdjustFilesystemUsage(const QMap<int, int64_t> &usedKB);
 
     int GetExitCode() const { return m_exitCode; }
 
@@ -324,6 +326,12 @@ class MainServer : public QObject, public MythSocketCBs
     QWaitCondition masterFreeSpaceListWait;
     QStringList masterFreeSpaceList;
 
+    // Last free space answer of each of the other backends, by hostname
+    QMutex remoteFreeSpaceLock;
+    QWaitCondition remoteFreeSpaceWait;
+    QMap<QString, QStringList> remoteFreeSpace;
+    QSet<QString> remoteFreeSpacePending;
+
     QTimer *masterServerReconnect; // audited ref #5318
     PlaybackSock *masterServer;
 
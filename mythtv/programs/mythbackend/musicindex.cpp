@@ -0,0 +1,385 @@
+// C++ headers
+#include <algorithm>
+
+// Qt headers
+#include <QVariant>
+#include <QSet>
+
+// MythTV headers
+#include "musicindex.h"
+#include "mythcorecontext.h"
+#include "mythtimer.h"
+#include "mythlogging.h"
+#include "mythevent.h"
+#include "mythdate.h"
+#include "mythdb.h"
+
+#define LOC QString("MusicIndex: ")
+
+/// Seconds before the index is rebuilt, if no scan announced a change
+static const int kMaxAge = 15 * 60;
+
+template <typename T>
+static bool name_less(const T &a, const T &b)
+{
+    int cmp = a.m_name.compare(b.m_name, Qt::CaseInsensitive);
+    if (cmp != 0)
+        return cmp < 0;
+    return a.m_id < b.m_id;
+}
+
+static bool track_less(const MusicIndexTrack &a, const MusicIndexTrack &b)
+{
+    if (a.m_artist != b.m_artist)
+        return a.m_artist < b.m_artist;
+    if (a.m_album != b.m_album)
+        return a.m_album < b.m_album;
+    if (a.m_trackNum != b.m_trackNum)
+        return a.m_trackNum < b.m_trackNum;
+    return a.m_id < b.m_id;
+}
+
+/// Sorts \p list by name, and returns the index each id ended up at.
+template <typename T>
+static QHash<int, int> sort_by_name(QVector<T> &list)
+{
+    std::sort(list.begin(), list.end(), name_less<T>);
+
+    QHash<int, int> byId;
+    byId.reserve(list.size());
+    for (int i = 0; i < list.size(); i++)
+        byId.insert(list[i].m_id, i);
+    return byId;
+}
+
+static QVector<int> all_of(int size)
+{
+    QVector<int> all(size);
+    for (int i = 0; i < size; i++)
+        all[i] = i;
+    return all;
+}
+
+/// Returns the tracks of \p album by \p artist in \p genre. Any of them
+/// may be -1, to not filter by it.
+QVector<int> MusicSnapshot::GetTracks(int album, int artist, int genre) const
+{
+    QVector<int> tracks = m_allTracks;
+    if (album >= 0)
+        tracks = m_albums[album].m_tracks;
+    else if (artist >= 0)
+        tracks = m_artists[artist].m_tracks;
+    else if (genre >= 0)
+        tracks = m_genres[genre].m_tracks;
+
+    bool filter = (album >= 0 && (artist >= 0 || genre >= 0)) ||
+                  (artist >= 0 && genre >= 0);
+    if (!filter)
+        return tracks;
+
+    QVector<int> filtered;
+    foreach (int track, tracks)
+    {
+        const MusicIndexTrack &t = m_tracks[track];
+        if ((artist < 0 || t.m_artist == artist) &&
+            (genre < 0 || t.m_genre == genre))
+            filtered.append(track);
+    }
+    return filtered;
+}
+
+/// Returns the albums with tracks by \p artist in \p genre. Either may be
+/// -1, to not filter by it.
+QVector<int> MusicSnapshot::GetAlbums(int artist, int genre) const
+{
+    if (artist >= 0 && genre >= 0)
+        return m_genreArtistAlbums.value(qMakePair(genre, artist));
+    if (artist >= 0)
+        return m_artists[artist].m_albums;
+    if (genre < 0)
+        return m_allAlbums;
+
+    // Not a container the ContentDirectory has, so not indexed
+    QVector<int> albums;
+    foreach (int track, m_genres[genre].m_tracks)
+        albums.append(m_tracks[track].m_album);
+    std::sort(albums.begin(), albums.end());
+    albums.erase(std::unique(albums.begin(), albums.end()), albums.end());
+    return albums;
+}
+
+/// Returns the artists with tracks in \p genre, or all of them if it is -1.
+QVector<int> MusicSnapshot::GetArtists(int genre) const
+{
+    if (genre >= 0)
+        return m_genres[genre].m_artists;
+    return m_allArtists;
+}
+
+/// Fills in the children of every container, from the sorted tracks.
+void MusicSnapshot::Build(void)
+{
+    m_allTracks  = all_of(m_tracks.size());
+    m_allAlbums  = all_of(m_albums.size());
+    m_allArtists = all_of(m_artists.size());
+    m_allGenres  = all_of(m_genres.size());
+
+    m_trackById.reserve(m_tracks.size());
+
+    // Tracks are in artist, album order, so each album is added to the
+    // lists it belongs to once, in order, when it is first seen
+    for (int i = 0; i < m_tracks.size(); i++)
+    {
+        const MusicIndexTrack &track = m_tracks[i];
+        m_trackById.insert(track.m_id, i);
+
+        MusicIndexAlbum &album = m_albums[track.m_album];
+        album.m_tracks.append(i);
+        if (album.m_genre < 0)
+            album.m_genre = track.m_genre;
+        if (album.m_artSongId == 0 && track.m_hasArt)
+            album.m_artSongId = track.m_id;
+
+        MusicIndexArtist &artist = m_artists[track.m_artist];
+        artist.m_tracks.append(i);
+        if (artist.m_albums.isEmpty() || artist.m_albums.last() != track.m_album)
+            artist.m_albums.append(track.m_album);
+
+        if (track.m_genre < 0)
+            continue;
+
+        MusicIndexGenre &genre = m_genres[track.m_genre];
+        genre.m_tracks.append(i);
+        if (genre.m_artists.isEmpty() ||
+            genre.m_artists.last() != track.m_artist)
+            genre.m_artists.append(track.m_artist);
+
+        QVector<int> &albums =
+            m_genreArtistAlbums[qMakePair(track.m_genre, track.m_artist)];
+        if (albums.isEmpty() || albums.last() != track.m_album)
+            albums.append(track.m_album);
+    }
+}
+
+MusicIndex::MusicIndex(void)
+{
+    gCoreContext->addListener(this);
+}
+
+MusicIndex::~MusicIndex()
+{
+    gCoreContext->removeListener(this);
+}
+
+/** \fn MusicIndex::GetSnapshot(void)
+ *  \brief Returns the current version of the index, building it first if
+ *         there is none or it is out of date.
+ *
+ *   Only the first call waits for the index to be built. Once there is
+ *   one, calls made while it is rebuilt return the previous version.
+ */
+MusicSnapshotPtr MusicIndex::GetSnapshot(void)
+{
+    m_lock.lock();
+    MusicSnapshotPtr snapshot = m_snapshot;
+    bool current = snapshot && !m_stale &&
+                   m_loaded.secsTo(MythDate::current()) < kMaxAge;
+    m_lock.unlock();
+
+    if (current)
+        return snapshot;
+
+    if (!snapshot)
+        m_loadLock.lock();
+    else if (!m_loadLock.tryLock())
+        return snapshot;
+
+    m_lock.lock();
+    if (m_snapshot != snapshot)
+    {
+        // Built while this call was waiting for it
+        snapshot = m_snapshot;
+        m_lock.unlock();
+        m_loadLock.unlock();
+        return snapshot;
+    }
+    // Changes announced from here on need another build
+    m_stale = false;
+    m_lock.unlock();
+
+    MusicSnapshot *loaded = Load();
+
+    m_lock.lock();
+    if (loaded)
+        m_snapshot = MusicSnapshotPtr(loaded);
+    else if (!m_snapshot)
+        m_snapshot = MusicSnapshotPtr(new MusicSnapshot());
+    // Also after a failure, so the database isn't asked on every request
+    m_loaded = MythDate::current();
+    snapshot = m_snapshot;
+    m_lock.unlock();
+
+    m_loadLock.unlock();
+    return snapshot;
+}
+
+void MusicIndex::customEvent(QEvent *event)
+{
+    if (event->type() != MythEvent::MythEventMessage)
+        return;
+
+    MythEvent *me = static_cast<MythEvent *>(event);
+
+    if (me->Message().startsWith("MUSIC_SCANNER_FINISHED"))
+    {
+        QMutexLocker locker(&m_lock);
+        m_stale = true;
+    }
+}
+
+/// Reads the music tables into a new snapshot, or returns nullptr if they
+/// could not be read.
+MusicSnapshot *MusicIndex::Load(void)
+{
+    MythTimer timer(MythTimer::kStartRunning);
+    MSqlQuery query(MSqlQuery::InitCon());
+
+    QHash<int, QString> artistNames;
+    if (!query.exec("SELECT artist_id, artist_name FROM music_artists"))
+    {
+        MythDB::DBError(LOC + "Load artists", query);
+        return nullptr;
+    }
+    while (query.next())
+        artistNames.insert(query.value(0).toInt(), query.value(1).toString());
+
+    QHash<int, QString> genreNames;
+    if (!query.exec("SELECT genre_id, genre FROM music_genres"))
+    {
+        MythDB::DBError(LOC + "Load genres", query);
+        return nullptr;
+    }
+    while (query.next())
+        genreNames.insert(query.value(0).toInt(), query.value(1).toString());
+
+    QHash<int, MusicIndexAlbum> albumInfo;
+    if (!query.exec("SELECT album_id, album_name, artist_id, year "
+                    "FROM music_albums"))
+    {
+        MythDB::DBError(LOC + "Load albums", query);
+        return nullptr;
+    }
+    while (query.next())
+    {
+        MusicIndexAlbum album;
+        album.m_id         = query.value(0).toInt();
+        album.m_name       = query.value(1).toString();
+        album.m_artistName = artistNames.value(query.value(2).toInt());
+        album.m_year       = query.value(3).toInt();
+        albumInfo.insert(album.m_id, album);
+    }
+
+    QSet<int> withArt;
+    if (!query.exec("SELECT DISTINCT song_id FROM music_albumart "
+                    "WHERE song_id > 0"))
+    {
+        MythDB::DBError(LOC + "Load album art", query);
+        return nullptr;
+    }
+    while (query.next())
+        withArt.insert(query.value(0).toInt());
+
+    if (!query.exec("SELECT song_id, artist_id, album_id, genre_id, name, "
+                    "description, filename, year, track, length, size, "
+                    "numplays, lastplay "
+                    "FROM music_songs"))
+    {
+        MythDB::DBError(LOC + "Load songs", query);
+        return nullptr;
+    }
+
+    MusicSnapshot *snapshot = new MusicSnapshot();
+    snapshot->m_tracks.reserve(query.size());
+
+    // Only the artists, albums and genres that have tracks are listed.
+    // Until they are sorted, the tracks refer to them by id.
+    QSet<int> artists;
+    QSet<int> albums;
+    QSet<int> genres;
+
+    while (query.next())
+    {
+        MusicIndexTrack track;
+        track.m_id          = query.value(0).toInt();
+        track.m_artist      = query.value(1).toInt();
+        track.m_album       = query.value(2).toInt();
+        track.m_genre       = query.value(3).toInt();
+        track.m_title       = query.value(4).toString();
+        track.m_description = query.value(5).toString();
+        track.m_filename    = query.value(6).toString();
+        track.m_year        = query.value(7).toInt();
+        track.m_trackNum    = query.value(8).toInt();
+        track.m_length      = query.value(9).toUInt();
+        track.m_fileSize    = query.value(10).toULongLong();
+        track.m_playCount   = query.value(11).toInt();
+        track.m_lastPlay    = query.value(12).toDateTime();
+        track.m_hasArt      = withArt.contains(track.m_id);
+
+        if (!artists.contains(track.m_artist))
+        {
+            MusicIndexArtist artist;
+            artist.m_id   = track.m_artist;
+            artist.m_name = artistNames.value(track.m_artist);
+            artists.insert(artist.m_id);
+            snapshot->m_artists.append(artist);
+        }
+
+        if (!albums.contains(track.m_album))
+        {
+            MusicIndexAlbum album = albumInfo.value(track.m_album);
+            album.m_id = track.m_album;
+            albums.insert(album.m_id);
+            snapshot->m_albums.append(album);
+        }
+
+        if (!genreNames.contains(track.m_genre))
+            track.m_genre = -1;
+        else if (!genres.contains(track.m_genre))
+        {
+            MusicIndexGenre genre;
+            genre.m_id   = track.m_genre;
+            genre.m_name = genreNames.value(track.m_genre);
+            genres.insert(genre.m_id);
+            snapshot->m_genres.append(genre);
+        }
+
+        snapshot->m_tracks.append(track);
+    }
+
+    snapshot->m_artistById = sort_by_name(snapshot->m_artists);
+    snapshot->m_albumById  = sort_by_name(snapshot->m_albums);
+    snapshot->m_genreById  = sort_by_name(snapshot->m_genres);
+
+    for (int i = 0; i < snapshot->m_tracks.size(); i++)
+    {
+        MusicIndexTrack &track = snapshot->m_tracks[i];
+        track.m_artist = snapshot->m_artistById.value(track.m_artist);
+        track.m_album  = snapshot->m_albumById.value(track.m_album);
+        if (track.m_genre >= 0)
+            track.m_genre = snapshot->m_genreById.value(track.m_genre);
+    }
+
+    std::sort(snapshot->m_tracks.begin(), snapshot->m_tracks.end(),
+              track_less);
+
+    snapshot->Build();
+
+    LOG(VB_UPNP, LOG_INFO, LOC + QString("Indexed %1 tracks, %2 albums, "
+                                         "%3 artists in %4 ms")
+        .arg(snapshot->m_tracks.size()).arg(snapshot->m_albums.size())
+        .arg(snapshot->m_artists.size()).arg(timer.elapsed()));
+
+    return snapshot;
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
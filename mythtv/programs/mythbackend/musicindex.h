@@ -0,0 +1,157 @@
+#ifndef MUSICINDEX_H_
+#define MUSICINDEX_H_
+
+// C++ headers
+#include <cstdint>
+
+// Qt headers
+#include <QSharedPointer>
+#include <QDateTime>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QHash>
+#include <QPair>
+
+class MusicIndexTrack
+{
+  public:
+    int       m_id        {0};
+    int       m_artist    {-1};     ///< index into MusicSnapshot::Artists()
+    int       m_album     {-1};     ///< index into MusicSnapshot::Albums()
+    int       m_genre     {-1};     ///< index into MusicSnapshot::Genres()
+    QString   m_title;
+    QString   m_description;
+    QString   m_filename;
+    int       m_year      {0};
+    int       m_trackNum  {0};
+    uint32_t  m_length    {0};      ///< milliseconds
+    uint64_t  m_fileSize  {0};
+    int       m_playCount {0};
+    QDateTime m_lastPlay;
+    bool      m_hasArt    {false};
+};
+
+class MusicIndexAlbum
+{
+  public:
+    int          m_id        {0};
+    QString      m_name;
+    QString      m_artistName;
+    int          m_year      {0};
+    int          m_genre     {-1};
+    int          m_artSongId {0};   ///< a track with album art, or 0
+    QVector<int> m_tracks;
+};
+
+class MusicIndexArtist
+{
+  public:
+    int          m_id {0};
+    QString      m_name;
+    QVector<int> m_albums;
+    QVector<int> m_tracks;
+};
+
+class MusicIndexGenre
+{
+  public:
+    int          m_id {0};
+    QString      m_name;
+    QVector<int> m_artists;
+    QVector<int> m_albums;
+    QVector<int> m_tracks;
+};
+
+/** \class MusicSnapshot
+ *  \brief The music library, arranged the way the UPnP ContentDirectory
+ *         presents it.
+ *
+ *   Artists, albums and genres are sorted by name, tracks by artist,
+ *   album and track number, and each container holds the indexes of its
+ *   children in that order. Any container's children, and so any page of
+ *   them, are found without looking at anything else in the library.
+ *
+ *   A snapshot never changes once it is published, so it may be read
+ *   from any thread without locking for as long as it is held.
+ */
+class MusicSnapshot
+{
+    friend class MusicIndex;
+
+  public:
+    const QVector<MusicIndexTrack>  &Tracks(void) const  { return m_tracks;  }
+    const QVector<MusicIndexAlbum>  &Albums(void) const  { return m_albums;  }
+    const QVector<MusicIndexArtist> &Artists(void) const { return m_artists; }
+    const QVector<MusicIndexGenre>  &Genres(void) const  { return m_genres;  }
+
+    int FindTrack(int id) const  { return m_trackById.value(id, -1);  }
+    int FindAlbum(int id) const  { return m_albumById.value(id, -1);  }
+    int FindArtist(int id) const { return m_artistById.value(id, -1); }
+    int FindGenre(int id) const  { return m_genreById.value(id, -1);  }
+
+    QVector<int> GetTracks(int album, int artist, int genre) const;
+    QVector<int> GetAlbums(int artist, int genre) const;
+    QVector<int> GetArtists(int genre) const;
+    QVector<int> GetGenres(void) const { return m_allGenres; }
+
+  private:
+    void Build(void);
+
+    QVector<MusicIndexTrack>  m_tracks;
+    QVector<MusicIndexAlbum>  m_albums;
+    QVector<MusicIndexArtist> m_artists;
+    QVector<MusicIndexGenre>  m_genres;
+
+    QVector<int>              m_allTracks;
+    QVector<int>              m_allAlbums;
+    QVector<int>              m_allArtists;
+    QVector<int>              m_allGenres;
+
+    QHash<int, int>           m_trackById;
+    QHash<int, int>           m_albumById;
+    QHash<int, int>           m_artistById;
+    QHash<int, int>           m_genreById;
+
+    /// albums by (genre, artist)
+    QHash<QPair<int, int>, QVector<int> > m_genreArtistAlbums;
+};
+
+typedef QSharedPointer<const MusicSnapshot> MusicSnapshotPtr;
+
+/** \class MusicIndex
+ *  \brief Keeps a MusicSnapshot of the music tables up to date.
+ *
+ *   The index is built from the database when it is first used, and again
+ *   after a music scan finishes. Changes made elsewhere, such as tags
+ *   edited in a frontend, are picked up by rebuilding it every few
+ *   minutes. While it is being rebuilt, requests use the previous version.
+ */
+class MusicIndex : public QObject
+{
+    Q_OBJECT
+
+  public:
+    MusicIndex(void);
+   ~MusicIndex();
+
+    MusicSnapshotPtr GetSnapshot(void);
+
+  protected:
+    void customEvent(QEvent *event) override; // QObject
+
+  private:
+    static MusicSnapshot *Load(void);
+
+    QMutex               m_loadLock;   ///< serializes database reads
+
+    mutable QMutex       m_lock;
+    MusicSnapshotPtr     m_snapshot;   // protected by m_lock
+    bool                 m_stale {true}; // protected by m_lock
+    QDateTime            m_loaded;     // protected by m_lock
+};
+
+#endif
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,486 @@
+// C++ headers
+#include <algorithm>
+
+// Qt headers
+#include <QStringList>
+#include <QVariant>
+#include <QPair>
+
+// MythTV headers
+#include "recordingcatalog.h"
+#include "mythcorecontext.h"
+#include "mythscheduler.h"
+#include "mythtimer.h"
+#include "mythlogging.h"
+#include "mythevent.h"
+#include "mythdate.h"
+#include "mythdb.h"
+#include "jobqueue.h"
+
+#define LOC QString("RecordingCatalog: ")
+
+/// Seconds between full reloads of the catalog
+static const int kReloadInterval = 6 * 60 * 60;
+/// Recordings looked up per query when reading changed recordings
+static const int kBatchSize = 500;
+
+static bool start_time_less(const RecordingPtr &a, const RecordingPtr &b)
+{
+    if (a->GetRecordingStartTime() != b->GetRecordingStartTime())
+        return a->GetRecordingStartTime() < b->GetRecordingStartTime();
+    return a->GetRecordingID() < b->GetRecordingID();
+}
+
+/// Returns \p recording, owned by a RecordingPtr, with the defaults
+/// LoadFromRecorded() fills in.
+static RecordingPtr make_recording(ProgramInfo *recording)
+{
+    if (recording->GetHostname().isEmpty())
+        recording->SetHostname(gCoreContext->GetHostName());
+    return RecordingPtr(recording);
+}
+
+RecordingList RecordingSnapshot::GetAll(bool descending) const
+{
+    RecordingList list = m_byStartTime.values();
+    if (descending)
+        std::reverse(list.begin(), list.end());
+    return list;
+}
+
+/// Returns the recordings that started from \p from through \p to.
+/// Either may be invalid, for no limit.
+RecordingList RecordingSnapshot::GetByStartTime(const QDateTime &from,
+                                                const QDateTime &to) const
+{
+    QMultiMap<QDateTime, RecordingPtr>::const_iterator it =
+        from.isValid() ? m_byStartTime.lowerBound(from)
+                       : m_byStartTime.constBegin();
+    QMultiMap<QDateTime, RecordingPtr>::const_iterator end =
+        to.isValid() ? m_byStartTime.upperBound(to)
+                     : m_byStartTime.constEnd();
+
+    RecordingList list;
+    for (; it != end; ++it)
+        list.push_back(*it);
+    return list;
+}
+
+/// Returns the recordings titled \p title, ignoring case.
+RecordingList RecordingSnapshot::GetByTitle(const QString &title) const
+{
+    return Ordered(m_byTitle.values(title.toLower()));
+}
+
+RecordingList RecordingSnapshot::GetByRecGroup(const QString &recgroup) const
+{
+    return Ordered(m_byRecGroup.values(recgroup));
+}
+
+RecordingList RecordingSnapshot::GetByStorageGroup(
+    const QString &storagegroup) const
+{
+    return Ordered(m_byStorageGroup.values(storagegroup));
+}
+
+RecordingList RecordingSnapshot::Ordered(const RecordingList &list)
+{
+    RecordingList ordered = list;
+    std::sort(ordered.begin(), ordered.end(), start_time_less);
+    return ordered;
+}
+
+void RecordingSnapshot::Insert(const RecordingPtr &recording)
+{
+    m_byId.insert(recording->GetRecordingID(), recording);
+    m_byStartTime.insert(recording->GetRecordingStartTime(), recording);
+    m_byTitle.insert(recording->GetTitle().toLower(), recording);
+    m_byRecGroup.insert(recording->GetRecordingGroup(), recording);
+    m_byStorageGroup.insert(recording->GetStorageGroup(), recording);
+}
+
+void RecordingSnapshot::Remove(uint recordedid)
+{
+    RecordingPtr recording = m_byId.take(recordedid);
+    if (!recording)
+        return;
+
+    m_byStartTime.remove(recording->GetRecordingStartTime(), recording);
+    m_byTitle.remove(recording->GetTitle().toLower(), recording);
+    m_byRecGroup.remove(recording->GetRecordingGroup(), recording);
+    m_byStorageGroup.remove(recording->GetStorageGroup(), recording);
+}
+
+enum SortField
+{
+    kSortStartTime, kSortTitle, kSortSubtitle, kSortSeason, kSortEpisode,
+    kSortCategory, kSortWatched, kSortStars, kSortOriginalAirDate,
+    kSortRecGroup, kSortStorageGroup, kSortChanNum, kSortCallsign,
+    kSortChannelName,
+};
+
+struct SortKey
+{
+    SortField field;
+    bool      ascending;
+};
+
+template <typename T>
+static int compare_values(const T &a, const T &b)
+{
+    return (a < b) ? -1 : ((b < a) ? 1 : 0);
+}
+
+static int compare_strings(const QString &a, const QString &b)
+{
+    return QString::compare(a, b, Qt::CaseInsensitive);
+}
+
+static int compare_field(SortField field, const ProgramInfo &a,
+                         const ProgramInfo &b)
+{
+    switch (field)
+    {
+        case kSortStartTime:
+            return compare_values(a.GetRecordingStartTime(),
+                                  b.GetRecordingStartTime());
+        case kSortTitle:
+            return compare_strings(a.GetTitle(), b.GetTitle());
+        case kSortSubtitle:
+            return compare_strings(a.GetSubtitle(), b.GetSubtitle());
+        case kSortSeason:
+            return compare_values(a.GetSeason(), b.GetSeason());
+        case kSortEpisode:
+            return compare_values(a.GetEpisode(), b.GetEpisode());
+        case kSortCategory:
+            return compare_strings(a.GetCategory(), b.GetCategory());
+        case kSortWatched:
+            return compare_values(a.IsWatched(), b.IsWatched());
+        case kSortStars:
+            return compare_values(a.GetStars(), b.GetStars());
+        case kSortOriginalAirDate:
+            return compare_values(a.GetOriginalAirDate(),
+                                  b.GetOriginalAirDate());
+        case kSortRecGroup:
+            return compare_strings(a.GetRecordingGroup(),
+                                   b.GetRecordingGroup());
+        case kSortStorageGroup:
+            return compare_strings(a.GetStorageGroup(), b.GetStorageGroup());
+        case kSortChanNum:
+            return compare_strings(a.GetChanNum(), b.GetChanNum());
+        case kSortCallsign:
+            return compare_strings(a.GetChannelSchedulingID(),
+                                   b.GetChannelSchedulingID());
+        case kSortChannelName:
+            return compare_strings(a.GetChannelName(), b.GetChannelName());
+    }
+    return 0;
+}
+
+/** \fn RecordingSnapshot::Sort(RecordingList&, const QString&, bool)
+ *  \brief Sorts \p list by the comma separated fields of \p sortBy, each
+ *         optionally followed by "asc" or "desc", as LoadFromRecorded()
+ *         does. Without any fields the list is sorted by start time.
+ *
+ *   Recordings that compare equal keep their order, so a list that is
+ *   already in start time order stays so within each sort key.
+ */
+void RecordingSnapshot::Sort(RecordingList &list, const QString &sortBy,
+                             bool descending)
+{
+    static QMap<QString, SortField> s_fields;
+    if (s_fields.isEmpty())
+    {
+        QMap<QString, SortField> fields;
+        fields["starttime"]       = kSortStartTime;
+        fields["title"]           = kSortTitle;
+        fields["subtitle"]        = kSortSubtitle;
+        fields["season"]          = kSortSeason;
+        fields["episode"]         = kSortEpisode;
+        fields["category"]        = kSortCategory;
+        fields["watched"]         = kSortWatched;
+        fields["stars"]           = kSortStars;
+        fields["originalairdate"] = kSortOriginalAirDate;
+        fields["recgroup"]        = kSortRecGroup;
+        fields["storagegroup"]    = kSortStorageGroup;
+        fields["channum"]         = kSortChanNum;
+        fields["callsign"]        = kSortCallsign;
+        fields["name"]            = kSortChannelName;
+        fields["channelname"]     = kSortChannelName;
+        s_fields = fields;
+    }
+
+    QList<SortKey> keys;
+    QStringList fields = sortBy.split(",", QString::SkipEmptyParts);
+    foreach (const QString &sortField, fields)
+    {
+        SortKey key { kSortStartTime, true };
+        QString field = sortField.simplified().toLower();
+
+        if (field.endsWith("desc"))
+        {
+            key.ascending = false;
+            field.chop(4);
+        }
+        else if (field.endsWith("asc"))
+        {
+            field.chop(3);
+        }
+        field = field.simplified();
+
+        if (!s_fields.contains(field))
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC +
+                QString("Unknown sort field '%1' - ignoring").arg(sortField));
+            continue;
+        }
+        key.field = s_fields[field];
+        keys.push_back(key);
+    }
+
+    if (keys.isEmpty())
+    {
+        SortKey key { kSortStartTime, !descending };
+        keys.push_back(key);
+    }
+
+    std::stable_sort(list.begin(), list.end(),
+        [&keys](const RecordingPtr &a, const RecordingPtr &b)
+        {
+            foreach (const SortKey &key, keys)
+            {
+                int result = compare_field(key.field, *a, *b);
+                if (result != 0)
+                    return key.ascending ? (result < 0) : (result > 0);
+            }
+            return false;
+        });
+}
+
+RecordingOverlay::RecordingOverlay(MythScheduler *scheduler) :
+    m_inUseMap(ProgramInfo::QueryInUseMap()),
+    m_isJobRunning(ProgramInfo::QueryJobsRunning(JOB_COMMFLAG)),
+    m_recordingAfter(MythDate::current().addSecs(
+                         -gCoreContext->GetNumSetting("RecordOverTime")))
+{
+    if (scheduler)
+        m_recMap = scheduler->GetRecording();
+}
+
+RecordingOverlay::~RecordingOverlay()
+{
+    QMap<QString, ProgramInfo*>::iterator it = m_recMap.begin();
+    for (; it != m_recMap.end(); it = m_recMap.erase(it))
+        delete *it;
+}
+
+/// Returns a new copy of \p recording, with its recording status and flags
+/// set as LoadFromRecorded() would.
+ProgramInfo *RecordingOverlay::Copy(const ProgramInfo &recording) const
+{
+    ProgramInfo *copy = new ProgramInfo(recording);
+    QString key = recording.MakeUniqueKey();
+
+    if (recording.GetRecordingEndTime() > m_recordingAfter &&
+        m_recMap.contains(key))
+    {
+        copy->SetRecordingStatus(RecStatus::Recording);
+    }
+
+    uint32_t flags = recording.GetProgramFlags() | m_inUseMap.value(key);
+    if ((flags & FL_COMMPROCESSING) && !m_isJobRunning.contains(key))
+        flags &= ~FL_COMMPROCESSING;
+    flags &= ~FL_EDITING;
+    if (flags & (FL_REALLYEDITING | FL_COMMPROCESSING))
+        flags |= FL_EDITING;
+    copy->SetProgramFlags(flags);
+
+    return copy;
+}
+
+RecordingCatalog::RecordingCatalog(void) :
+    m_snapshot(new RecordingSnapshot())
+{
+    gCoreContext->addListener(this);
+}
+
+RecordingCatalog::~RecordingCatalog()
+{
+    gCoreContext->removeListener(this);
+}
+
+/** \fn RecordingCatalog::GetSnapshot(void)
+ *  \brief Returns the current version of the catalog, after applying the
+ *         changes announced since the last call.
+ */
+RecordingSnapshotPtr RecordingCatalog::GetSnapshot(void)
+{
+    Refresh();
+
+    QMutexLocker locker(&m_lock);
+    return m_snapshot;
+}
+
+void RecordingCatalog::customEvent(QEvent *event)
+{
+    if (event->type() != MythEvent::MythEventMessage)
+        return;
+
+    MythEvent *me = static_cast<MythEvent *>(event);
+    QString message = me->Message();
+    QStringList tokens = message.split(" ", QString::SkipEmptyParts);
+
+    // This runs in the event thread, so only note what changed here and
+    // leave the database work to the next GetSnapshot().
+    if (message.startsWith("RECORDING_LIST_CHANGE") && tokens.size() == 3)
+    {
+        uint recordedid = tokens[2].toUInt();
+        QMutexLocker locker(&m_lock);
+        if (tokens[1] == "DELETE")
+        {
+            m_changed.remove(recordedid);
+            m_sizes.remove(recordedid);
+            m_deleted.insert(recordedid);
+        }
+        else
+        {
+            m_changed.insert(recordedid);
+        }
+    }
+    else if (message.startsWith("MASTER_UPDATE_REC_INFO") &&
+             tokens.size() >= 2)
+    {
+        QMutexLocker locker(&m_lock);
+        m_changed.insert(tokens[1].toUInt());
+    }
+    else if (message.startsWith("UPDATE_FILE_SIZE") && tokens.size() == 3)
+    {
+        QMutexLocker locker(&m_lock);
+        m_sizes[tokens[1].toUInt()] = tokens[2].toULongLong();
+    }
+}
+
+void RecordingCatalog::Refresh(void)
+{
+    QMutexLocker refreshLocker(&m_refreshLock);
+
+    m_lock.lock();
+    bool reload = !m_loaded.isValid() ||
+        m_loaded.secsTo(MythDate::current()) >= kReloadInterval;
+    if (reload)
+        m_changed.clear();
+    m_lock.unlock();
+
+    if (reload && !Load())
+        return;
+
+    // Deletes noted while loading are applied too, in case the load
+    // still found the recording.
+    m_lock.lock();
+    QList<uint> changed = m_changed.toList();
+    QList<uint> deleted = m_deleted.toList();
+    QHash<uint, uint64_t> sizes;
+    sizes.swap(m_sizes);
+    m_changed.clear();
+    m_deleted.clear();
+    RecordingSnapshotPtr current = m_snapshot;
+    m_lock.unlock();
+
+    if (changed.empty() && deleted.empty() && sizes.empty())
+        return;
+
+    RecordingSnapshot *snapshot = new RecordingSnapshot(*current);
+    foreach (uint recordedid, deleted)
+        snapshot->Remove(recordedid);
+    Reload(snapshot, changed);
+
+    QHash<uint, uint64_t>::const_iterator it = sizes.constBegin();
+    for (; it != sizes.constEnd(); ++it)
+    {
+        RecordingPtr recording = snapshot->Find(it.key());
+        if (!recording || recording->GetFilesize() == *it)
+            continue;
+        ProgramInfo *copy = new ProgramInfo(*recording);
+        copy->SetFilesize(*it);
+        snapshot->Remove(it.key());
+        snapshot->Insert(RecordingPtr(copy));
+    }
+
+    Publish(snapshot);
+}
+
+bool RecordingCatalog::Load(void)
+{
+    // This clears the commercial flagging state of recordings whose
+    // flagging job is no longer running, as every listing used to.
+    QMap<QString, uint32_t> inUseMap;
+    QMap<QString, ProgramInfo*> recMap;
+    QMap<QString, bool> isJobRunning =
+        ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
+
+    MythTimer timer(MythTimer::kStartRunning);
+    ProgramList recordings;
+    if (!LoadFromRecorded(recordings, false, inUseMap, isJobRunning, recMap))
+        return false;
+
+    RecordingSnapshot *snapshot = new RecordingSnapshot();
+    snapshot->m_byId.reserve(recordings.size());
+    recordings.setAutoDelete(false);
+    for (uint i = 0; i < recordings.size(); i++)
+        snapshot->Insert(make_recording(recordings[i]));
+
+    LOG(VB_FILE, LOG_INFO, LOC + QString("Loaded %1 recordings in %2 ms")
+        .arg(snapshot->Size()).arg(timer.elapsed()));
+
+    Publish(snapshot);
+
+    QMutexLocker locker(&m_lock);
+    m_loaded = MythDate::current();
+    return true;
+}
+
+/// Reads \p recordedids into \p snapshot again, removing those that are
+/// no longer in the database. Recordings that could not be read are left
+/// as they were and read again next time.
+void RecordingCatalog::Reload(RecordingSnapshot *snapshot,
+                              const QList<uint> &recordedids)
+{
+    QMap<QString, uint32_t> inUseMap;
+    QMap<QString, ProgramInfo*> recMap;
+    QMap<QString, bool> isJobRunning =
+        ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
+
+    for (int i = 0; i < recordedids.size(); i += kBatchSize)
+    {
+        QList<uint> batch = recordedids.mid(i, kBatchSize);
+
+        ProgramList recordings;
+        if (!LoadFromRecorded(recordings, batch, inUseMap, isJobRunning,
+                              recMap))
+        {
+            QMutexLocker locker(&m_lock);
+            foreach (uint recordedid, batch)
+                m_changed.insert(recordedid);
+            continue;
+        }
+
+        foreach (uint recordedid, batch)
+            snapshot->Remove(recordedid);
+
+        recordings.setAutoDelete(false);
+        for (uint j = 0; j < recordings.size(); j++)
+            snapshot->Insert(make_recording(recordings[j]));
+    }
+
+    LOG(VB_FILE, LOG_DEBUG, LOC +
+        QString("Reread %1 changed recordings").arg(recordedids.size()));
+}
+
+void RecordingCatalog::Publish(RecordingSnapshot *snapshot)
+{
+    QMutexLocker locker(&m_lock);
+    snapshot->m_version = m_snapshot->m_version + 1;
+    m_snapshot = RecordingSnapshotPtr(snapshot);
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,138 @@
+#ifndef RECORDINGCATALOG_H_
+#define RECORDINGCATALOG_H_
+
+// Qt headers
+#include <QSharedPointer>
+#include <QMultiHash>
+#include <QMultiMap>
+#include <QDateTime>
+#include <QObject>
+#include <QMutex>
+#include <QHash>
+#include <QList>
+#include <QSet>
+
+// MythTV headers
+#include "programinfo.h"
+
+class MythScheduler;
+
+typedef QSharedPointer<const ProgramInfo> RecordingPtr;
+typedef QList<RecordingPtr> RecordingList;
+
+/** \class RecordingSnapshot
+ *  \brief One version of the recordings catalog.
+ *
+ *   A snapshot never changes once it is published, so it may be read
+ *   from any thread without locking for as long as it is held. The
+ *   recordings in it are shared with later versions that did not change
+ *   them. Lists are returned in order of recording start time.
+ */
+class RecordingSnapshot
+{
+    friend class RecordingCatalog;
+
+  public:
+    uint Version(void) const { return m_version;     }
+    int  Size(void) const    { return m_byId.size(); }
+
+    RecordingPtr  Find(uint recordedid) const
+        { return m_byId.value(recordedid); }
+    RecordingList GetAll(bool descending = false) const;
+    RecordingList GetByStartTime(const QDateTime &from,
+                                 const QDateTime &to) const;
+    RecordingList GetByTitle(const QString &title) const;
+    RecordingList GetByRecGroup(const QString &recgroup) const;
+    RecordingList GetByStorageGroup(const QString &storagegroup) const;
+
+    static void Sort(RecordingList &list, const QString &sortBy,
+                     bool descending);
+
+  private:
+    void Insert(const RecordingPtr &recording);
+    void Remove(uint recordedid);
+    static RecordingList Ordered(const RecordingList &list);
+
+    uint                               m_version {0};
+    QHash<uint, RecordingPtr>          m_byId;
+    QMultiMap<QDateTime, RecordingPtr> m_byStartTime;
+    QMultiHash<QString, RecordingPtr>  m_byTitle;  ///< lower case title
+    QMultiHash<QString, RecordingPtr>  m_byRecGroup;
+    QMultiHash<QString, RecordingPtr>  m_byStorageGroup;
+};
+
+typedef QSharedPointer<const RecordingSnapshot> RecordingSnapshotPtr;
+
+/** \class RecordingOverlay
+ *  \brief The state of the recordings that changes too often to be kept
+ *         in the catalog: which are being recorded, which are in use and
+ *         which are being flagged.
+ *
+ *   It is read once per request, and applied to the copies of the
+ *   recordings that the request hands out.
+ */
+class RecordingOverlay
+{
+  public:
+    explicit RecordingOverlay(MythScheduler *scheduler);
+   ~RecordingOverlay();
+
+    ProgramInfo *Copy(const ProgramInfo &recording) const;
+
+  private:
+    Q_DISABLE_COPY(RecordingOverlay)
+
+    QMap<QString, ProgramInfo*> m_recMap;
+    QMap<QString, uint32_t>     m_inUseMap;
+    QMap<QString, bool>         m_isJobRunning;
+    QDateTime                   m_recordingAfter;
+};
+
+/** \class RecordingCatalog
+ *  \brief In memory copy of the recorded table, used by the recording
+ *         lists of the Dvr service and of QUERY_RECORDINGS.
+ *
+ *   The UPnP TV tree (UPnpCDSTv) does not use it, and still queries the
+ *   recorded table itself, nor does AutoExpire, which keeps its own index.
+ *
+ *   The catalog is read from the database when it is first used. After
+ *   that only the recordings named by recording change events are read
+ *   again, when the next snapshot is taken; file size updates are applied
+ *   without reading the database at all. A full reload is still done
+ *   every few hours, to pick up changes made to the database directly.
+ *
+ *   Each change publishes a new RecordingSnapshot with a higher version,
+ *   so callers can tell whether anything changed since they last looked.
+ */
+class RecordingCatalog : public QObject
+{
+    Q_OBJECT
+
+  public:
+    RecordingCatalog(void);
+   ~RecordingCatalog();
+
+    RecordingSnapshotPtr GetSnapshot(void);
+
+  protected:
+    void customEvent(QEvent *event) override; // QObject
+
+  private:
+    void Refresh(void);
+    bool Load(void);
+    void Reload(RecordingSnapshot *snapshot, const QList<uint> &recordedids);
+    void Publish(RecordingSnapshot *snapshot);
+
+    QMutex                  m_refreshLock;   ///< serializes database reads
+
+    mutable QMutex          m_lock;
+    RecordingSnapshotPtr    m_snapshot;  // protected by m_lock
+    QSet<uint>              m_changed;   // protected by m_lock
+    QSet<uint>              m_deleted;   // protected by m_lock
+    QHash<uint, uint64_t>   m_sizes;     // protected by m_lock
+    QDateTime               m_loaded;    // protected by m_lock
+};
+
+#endif
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
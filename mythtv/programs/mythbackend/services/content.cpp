@@ -873,7 +873,8 @@ DTC::LiveStreamInfo *Content::AddLiveStream( const QString   &sStorageGroup,
                                              int              nHeight,
                                              int              nBitrate,
                                              int              nAudioBitrate,
-                                             int              nSampleRate )
+                                             int              nSampleRate,
+                                             int              nRenditions )
 {
     QString sGroup = sStorageGroup;
 
@@ -919,7 +920,8 @@ DTC::LiveStreamInfo *Content::AddLiveStream( const QString   &sStorageGroup,
 
     HTTPLiveStream *hls = new
         HTTPLiveStream(sFullFileName, nWidth, nHeight, nBitrate, nAudioBitrate,
-                       nMaxSegments, 0, 0, nSampleRate);
+                       nMaxSegments, 0, 0, nSampleRate,
+                       qMax(nRenditions, 1));
 
     if (!hls)
     {
@@ -1003,7 +1005,8 @@ DTC::LiveStreamInfo *Content::AddRecordingLiveStream(
     int              nHeight,
     int              nBitrate,
     int              nAudioBitrate,
-    int              nSampleRate )
+    int              nSampleRate,
+    int              nRenditions )
 {
     if ((nRecordedId <= 0) &&
         (nChanId <= 0 || !recstarttsRaw.isValid()))
@@ -1056,11 +1059,62 @@ DTC::LiveStreamInfo *Content::AddRecordingLiveStream(
         return nullptr;
     }
 
+    // ----------------------------------------------------------------------
+    // A recording players can already play is cut into segments as it is,
+    // rather than transcoded
+    // ----------------------------------------------------------------------
+
+    QSize recSize;
+
+    if (HTTPLiveStream::CanRemux( pginfo, nWidth, nHeight, &recSize ))
+    {
+        HTTPLiveStream *hls = new
+            HTTPLiveStream(sFileName, recSize.width(), recSize.height(), 0, 0,
+                           nMaxSegments, 0, 0, 0, 1, true);
+
+        DTC::LiveStreamInfo *lsInfo = hls->StartStream();
+
+        delete hls;
+
+        return lsInfo;
+    }
+
     QFileInfo fInfo( sFileName );
 
     return AddLiveStream( pginfo.GetStorageGroup(), fInfo.fileName(),
                           pginfo.GetHostname(), nMaxSegments, nWidth,
-                          nHeight, nBitrate, nAudioBitrate, nSampleRate );
+                          nHeight, nBitrate, nAudioBitrate, nSampleRate,
+                          nRenditions );
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+QFileInfo Content::GetLiveStreamSegment( int nId, int nSegment )
+{
+    if (nSegment <= 0 || nSegment > 65535)
+        throw QString( "Segment is invalid" );
+
+    HTTPLiveStream *hls = new HTTPLiveStream(nId);
+
+    if (!hls->IsRemux())
+    {
+        LOG( VB_UPNP, LOG_ERR,
+             QString("GetLiveStreamSegment - stream id %1 is not remuxed")
+                     .arg( nId ));
+        delete hls;
+        return QFileInfo();
+    }
+
+    QString sFileName = hls->GetRemuxSegment( nSegment );
+
+    delete hls;
+
+    if (sFileName.isEmpty())
+        return QFileInfo();
+
+    return QFileInfo( sFileName );
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1073,7 +1127,8 @@ DTC::LiveStreamInfo *Content::AddVideoLiveStream( int nId,
                                                   int nHeight,
                                                   int nBitrate,
                                                   int nAudioBitrate,
-                                                  int nSampleRate )
+                                                  int nSampleRate,
+                                                  int nRenditions )
 {
     if (nId < 0)
         throw QString( "Id is invalid" );
@@ -1117,5 +1172,6 @@ DTC::LiveStreamInfo *Content::AddVideoLiveStream( int nId,
 
     return AddLiveStream( "Videos", metadata->GetFilename(),
                           metadata->GetHost(), nMaxSegments, nWidth,
-                          nHeight, nBitrate, nAudioBitrate, nSampleRate );
+                          nHeight, nBitrate, nAudioBitrate, nSampleRate,
+                          nRenditions );
 }
@@ -100,7 +100,8 @@ class Content : public ContentServices
                                                           int              Height,
                                                           int              Bitrate,
                                                           int              AudioBitrate,
-                                                          int              SampleRate ) override; // ContentServices
+                                                          int              SampleRate,
+                                                          int              Renditions ) override; // ContentServices
 
         DTC::LiveStreamInfo     *AddRecordingLiveStream ( int              RecordedId,
                                                           int              ChanId,
@@ -110,7 +111,8 @@ class Content : public ContentServices
                                                           int              Height,
                                                           int              Bitrate,
                                                           int              AudioBitrate,
-                                                          int              SampleRate ) override; // ContentServices
+                                                          int              SampleRate,
+                                                          int              Renditions ) override; // ContentServices
 
         DTC::LiveStreamInfo     *AddVideoLiveStream     ( int              Id,
                                                           int              MaxSegments,
@@ -118,13 +120,17 @@ class Content : public ContentServices
                                                           int              Height,
                                                           int              Bitrate,
                                                           int              AudioBitrate,
-                                                          int              SampleRate ) override; // ContentServices
+                                                          int              SampleRate,
+                                                          int              Renditions ) override; // ContentServices
 
         DTC::LiveStreamInfo     *GetLiveStream            ( int Id ) override; // ContentServices
         DTC::LiveStreamInfoList *GetLiveStreamList        ( const QString &FileName ) override; // ContentServices
 
         DTC::LiveStreamInfo     *StopLiveStream         ( int Id ) override; // ContentServices
         bool                     RemoveLiveStream       ( int Id ) override; // ContentServices
+
+        QFileInfo                GetLiveStreamSegment   ( int Id,
+                                                          int Segment ) override; // ContentServices
 };
 
 // --------------------------------------------------------------------------
@@ -192,12 +198,13 @@ class ScriptableContent : public QObject
                                  int              Height,
                                  int              Bitrate,
                                  int              AudioBitrate,
-                                 int              SampleRate )
+                                 int              SampleRate,
+                                 int              Renditions )
         {
             SCRIPT_CATCH_EXCEPTION( nullptr,
                 return m_obj.AddLiveStream(StorageGroup, FileName, HostName,
                                        MaxSegments, Width, Height, Bitrate,
-                                       AudioBitrate, SampleRate);
+                                       AudioBitrate, SampleRate, Renditions);
             )
         }
 
@@ -207,13 +214,15 @@ class ScriptableContent : public QObject
                                          int              Height,
                                          int              Bitrate,
                                          int              AudioBitrate,
-                                         int              SampleRate )
+                                         int              SampleRate,
+                                         int              Renditions )
         {
             SCRIPT_CATCH_EXCEPTION( nullptr,
                 return m_obj.AddRecordingLiveStream(RecordedId, 0, QDateTime(),
                                                 MaxSegments,
                                                 Width, Height, Bitrate,
-                                                AudioBitrate, SampleRate);
+                                                AudioBitrate, SampleRate,
+                                                Renditions);
             )
         }
 
@@ -223,11 +232,13 @@ class ScriptableContent : public QObject
                                      int              Height,
                                      int              Bitrate,
                                      int              AudioBitrate,
-                                     int              SampleRate )
+                                     int              SampleRate,
+                                     int              Renditions )
         {
             SCRIPT_CATCH_EXCEPTION( nullptr,
                 return m_obj.AddVideoLiveStream(Id, MaxSegments, Width, Height,
-                                            Bitrate, AudioBitrate, SampleRate);
+                                            Bitrate, AudioBitrate, SampleRate,
+                                            Renditions);
             )
         }
 
@@ -49,12 +49,14 @@
 #include "storagegroup.h"
 #include "playgroup.h"
 #include "recordingprofile.h"
+#include "recordingcatalog.h"
 
 #include "scheduler.h"
 #include "tv_rec.h"
 
 extern QMap<int, EncoderLink *> tvList;
 extern AutoExpire  *expirer;
+extern RecordingCatalog *catalog;
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -70,26 +72,19 @@ DTC::ProgramList* Dvr::GetRecordedList( bool           bDescending,
                                         const QString &sSort
                                       )
 {
-    QMap< QString, ProgramInfo* > recMap;
+    RecordingSnapshotPtr snapshot = catalog->GetSnapshot();
+    RecordingList progList;
 
-    if (gCoreContext->GetScheduler())
-        recMap = gCoreContext->GetScheduler()->GetRecording();
-
-    QMap< QString, uint32_t > inUseMap    = ProgramInfo::QueryInUseMap();
-    QMap< QString, bool >     isJobRunning= ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
-
-    ProgramList progList;
-
-    int desc = 1;
-    if (bDescending)
-        desc = -1;
-
-    LoadFromRecorded( progList, false, inUseMap, isJobRunning, recMap, desc, sSort );
+    if (!sRecGroup.isEmpty())
+        progList = snapshot->GetByRecGroup(sRecGroup);
+    else if (!sStorageGroup.isEmpty())
+        progList = snapshot->GetByStorageGroup(sStorageGroup);
+    else
+        progList = snapshot->GetAll();
 
-    QMap< QString, ProgramInfo* >::iterator mit = recMap.begin();
+    RecordingSnapshot::Sort(progList, sSort, bDescending);
 
-    for (; mit != recMap.end(); mit = recMap.erase(mit))
-        delete *mit;
+    RecordingOverlay overlay(gCoreContext->GetScheduler());
 
     // ----------------------------------------------------------------------
     // Build Response
@@ -105,9 +100,9 @@ DTC::ProgramList* Dvr::GetRecordedList( bool           bDescending,
 
     QRegExp rTitleRegEx        = QRegExp(sTitleRegEx, Qt::CaseInsensitive);
 
-    for( unsigned int n = 0; n < progList.size(); n++)
+    for( int n = 0; n < progList.size(); n++)
     {
-        ProgramInfo *pInfo = progList[ n ];
+        const ProgramInfo *pInfo = progList[ n ].data();
 
         if (pInfo->IsDeletePending() ||
             (!sTitleRegEx.isEmpty() && !pInfo->GetTitle().contains(rTitleRegEx)) ||
@@ -128,7 +123,9 @@ DTC::ProgramList* Dvr::GetRecordedList( bool           bDescending,
 
         DTC::Program *pProgram = pPrograms->AddNewProgram();
 
-        FillProgramInfo( pProgram, pInfo, true );
+        ProgramInfo *pCopy = overlay.Copy( *pInfo );
+        FillProgramInfo( pProgram, pCopy, true );
+        delete pCopy;
     }
 
     // ----------------------------------------------------------------------
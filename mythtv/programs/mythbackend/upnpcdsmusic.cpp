@@ -20,6 +20,11 @@
 #include "mythcorecontext.h"
 #include "upnphelpers.h"
 
+// Classes of the containers that can be searched for, besides tracks
+static const char *kAlbumClass  = "object.container.album.musicAlbum";
+static const char *kArtistClass = "object.container.person.musicArtist";
+static const char *kGenreClass  = "object.container.genre.musicGenre";
+
 /**
  * \brief Music Extension for UPnP ContentDirectory Service
  *
@@ -89,14 +94,7 @@ void UPnpCDSMusic::CreateRoot()
     CDSObject* pContainer;
     QString containerId = m_sExtensionId + "/%1";
 
-    // HACK: I'm not entirely happy with this solution, but it's at least
-    // tidier than passing through half a dozen extra args to Load[Foo]
-    // or having yet more methods just to load the counts
-    UPnpCDSRequest *pRequest = new UPnpCDSRequest();
-    pRequest->m_nRequestedCount = 0; // We don't want to load any results, we just want the TotalCount
-    UPnpCDSExtensionResults *pResult = new UPnpCDSExtensionResults();
-    IDTokenMap tokens;
-    // END HACK
+    MusicSnapshotPtr index = m_index.GetSnapshot();
 
     // -----------------------------------------------------------------------
     // All Tracks
@@ -105,11 +103,8 @@ void UPnpCDSMusic::CreateRoot()
                                               QObject::tr("All Tracks"),
                                               m_sExtensionId, // Parent Id
                                               nullptr );
-    // HACK
-    LoadTracks(pRequest, pResult, tokens);
-    pContainer->SetChildCount(pResult->m_nTotalMatches);
+    pContainer->SetChildCount(index->Tracks().size());
     pContainer->SetChildContainerCount(0);
-    // END HACK
     m_pRoot->AddChild(pContainer);
 
     // -----------------------------------------------------------------------
@@ -119,11 +114,8 @@ void UPnpCDSMusic::CreateRoot()
                                               QObject::tr("Artist"),
                                               m_sExtensionId, // Parent Id
                                               nullptr );
-    // HACK
-    LoadArtists(pRequest, pResult, tokens);
-    pContainer->SetChildCount(pResult->m_nTotalMatches);
-    pContainer->SetChildContainerCount(pResult->m_nTotalMatches);
-    // END HACK
+    pContainer->SetChildCount(index->Artists().size());
+    pContainer->SetChildContainerCount(index->Artists().size());
     m_pRoot->AddChild(pContainer);
 
     // -----------------------------------------------------------------------
@@ -133,11 +125,8 @@ void UPnpCDSMusic::CreateRoot()
                                               QObject::tr("Album"),
                                               m_sExtensionId, // Parent Id
                                               nullptr );
-    // HACK
-    LoadAlbums(pRequest, pResult, tokens);
-    pContainer->SetChildCount(pResult->m_nTotalMatches);
-    pContainer->SetChildContainerCount(pResult->m_nTotalMatches);
-    // END HACK
+    pContainer->SetChildCount(index->Albums().size());
+    pContainer->SetChildContainerCount(index->Albums().size());
     m_pRoot->AddChild(pContainer);
 
     // -----------------------------------------------------------------------
@@ -147,11 +136,8 @@ void UPnpCDSMusic::CreateRoot()
                                               QObject::tr("Genre"),
                                               m_sExtensionId, // Parent Id
                                               nullptr );
-    // HACK
-    LoadGenres(pRequest, pResult, tokens);
-    pContainer->SetChildCount(pResult->m_nTotalMatches);
-    pContainer->SetChildContainerCount(pResult->m_nTotalMatches);
-    // END HACK
+    pContainer->SetChildCount(index->Genres().size());
+    pContainer->SetChildContainerCount(index->Genres().size());
     m_pRoot->AddChild(pContainer);
 
     // -----------------------------------------------------------------------
@@ -161,19 +147,9 @@ void UPnpCDSMusic::CreateRoot()
 //                                                   QObject::tr("Directory"),
 //                                                   m_sExtensionId, // Parent Id
 //                                                   nullptr );
-//     // HACK
-//     LoadDirectories(pRequest, pResult, tokens);
-//     pContainer->SetChildCount(pResult->m_nTotalMatches);
-//     pContainer->SetChildContainerCount(pResult->m_nTotalMatches);
-//     // END HACK
 //     m_pRoot->AddChild(pContainer);
 
     // -----------------------------------------------------------------------
-
-    // HACK
-    delete pRequest;
-    delete pResult;
-    // END HACK
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -248,12 +224,97 @@ bool UPnpCDSMusic::IsSearchRequestForUs( UPnpCDSRequest *pRequest )
 //         (!pRequest->m_sContainerID.isEmpty()))
 //         pRequest->m_sObjectId = pRequest->m_sContainerID;
 
+    // Searches of another extension's containers aren't ours
+
+    QString sContainerId = SearchContainerId( pRequest );
+
+    if (sContainerId != "0" && !sContainerId.startsWith( m_sExtensionId ))
+        return false;
+
+    // Albums, artists and genres can be searched for as well as tracks
+
+    if (QString( kAlbumClass  ).startsWith( pRequest->m_sSearchClass ) ||
+        QString( kArtistClass ).startsWith( pRequest->m_sSearchClass ) ||
+        QString( kGenreClass  ).startsWith( pRequest->m_sSearchClass ))
+        return true;
+
     LOG(VB_UPNP, LOG_INFO,
         "UPnpCDSMusic::IsSearchRequestForUs.. Don't know, calling base class.");
 
     return UPnpCDSExtension::IsSearchRequestForUs( pRequest );
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// Searches are answered from the index, the same way browsing is. The
+// search class picks the container that lists objects of that class, and
+// the search container, e.g. Music/Genre=32, limits them to those below
+// it. Other search criteria are ignored, as they always have been.
+/////////////////////////////////////////////////////////////////////////////
+
+UPnpCDSExtensionResults *UPnpCDSMusic::Search( UPnpCDSRequest *pRequest )
+{
+    if (!IsSearchRequestForUs( pRequest ))
+        return nullptr;
+
+    IDTokenMap tokens = TokenizeIDString( SearchContainerId( pRequest ));
+
+    // The objects found get the IDs they have in the top level containers
+
+    UPnpCDSRequest request = *pRequest;
+    QString        sSearchClass = pRequest->m_sSearchClass;
+
+    if (request.m_nRequestedCount == 0)
+        request.m_nRequestedCount = UINT16_MAX;
+
+    UPnpCDSExtensionResults *pResults = new UPnpCDSExtensionResults();
+    bool                     bFound   = false;
+
+    if (m_sClass.startsWith( sSearchClass ))
+    {
+        request.m_sObjectId = m_sExtensionId + "/Track";
+        request.m_sParentId = request.m_sObjectId;
+        bFound = LoadTracks( &request, pResults, tokens );
+    }
+    else if (QString( kAlbumClass ).startsWith( sSearchClass ))
+    {
+        request.m_sObjectId = m_sExtensionId + "/Album";
+        request.m_sParentId = request.m_sObjectId;
+        bFound = LoadAlbums( &request, pResults, tokens );
+    }
+    else if (QString( kArtistClass ).startsWith( sSearchClass ))
+    {
+        request.m_sObjectId = m_sExtensionId + "/Artist";
+        request.m_sParentId = request.m_sObjectId;
+        bFound = LoadArtists( &request, pResults, tokens );
+    }
+    else
+    {
+        request.m_sObjectId = m_sExtensionId + "/Genre";
+        request.m_sParentId = request.m_sObjectId;
+        bFound = LoadGenres( &request, pResults, tokens );
+    }
+
+    if (!bFound)
+        pResults->m_eErrorCode = UPnPResult_CDS_NoSuchObject;
+
+    return pResults;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+QString UPnpCDSMusic::SearchContainerId( const UPnpCDSRequest *pRequest )
+{
+    if (!pRequest->m_sContainerID.isEmpty())
+        return pRequest->m_sContainerID;
+
+    if (!pRequest->m_sObjectId.isEmpty())
+        return pRequest->m_sObjectId;
+
+    return "0";
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //
 /////////////////////////////////////////////////////////////////////////////
@@ -465,84 +526,48 @@ bool UPnpCDSMusic::LoadAlbums(const UPnpCDSRequest *pRequest,
 {
     QString sRequestId = pRequest->m_sObjectId;
 
-    uint16_t nCount = pRequest->m_nRequestedCount;
-    uint16_t nOffset = pRequest->m_nStartingIndex;
-
-    // We must use a dedicated connection to get an acccurate value from
-    // FOUND_ROWS()
-    MSqlQuery query(MSqlQuery::InitCon(MSqlQuery::kDedicatedConnection));
-
-    QString sql = "SELECT SQL_CALC_FOUND_ROWS "
-                  "a.album_id, a.album_name, t.artist_name, a.year, "
-                  "a.compilation, s.song_id, g.genre, "
-                  "COUNT(a.album_id), w.albumart_id "
-                  "FROM music_albums a "
-                  "LEFT JOIN music_artists t ON a.artist_id=t.artist_id "
-                  "LEFT JOIN music_songs s ON a.album_id=s.album_id "
-                  "LEFT JOIN music_genres g ON s.genre_id=g.genre_id "
-                  "LEFT JOIN music_albumart w ON s.song_id=w.song_id "
-                  "%1 " // WHERE clauses
-                  "GROUP BY a.album_id "
-                  "ORDER BY a.album_name "
-                  "LIMIT :OFFSET,:COUNT";
-
-    QStringList clauses;
-    QString whereString = BuildWhereClause(clauses, tokens);
+    MusicSnapshotPtr index = m_index.GetSnapshot();
+    MusicTokens      found;
 
-    query.prepare(sql.arg(whereString));
-
-    BindValues(query, tokens);
+    if (!FindTokens(*index, tokens, found))
+        return false;
 
-    query.bindValue(":OFFSET", nOffset);
-    query.bindValue(":COUNT", nCount);
+    QVector<int> albums;
+    if (found.m_nAlbum >= 0)
+        albums.append(found.m_nAlbum);
+    else
+        albums = index->GetAlbums(found.m_nArtist, found.m_nGenre);
 
-    if (!query.exec())
-        return false;
+    int nEnd = PageEnd(pRequest, albums.size());
 
-    while (query.next())
+    for (int i = pRequest->m_nStartingIndex; i < nEnd; i++)
     {
-        int nAlbumID = query.value(0).toInt();
-        QString sAlbumName = query.value(1).toString();
-        QString sArtist = query.value(2).toString();
-        QString sYear = query.value(3).toString();
-        bool bCompilation = query.value(4).toBool();
-        int nSongId = query.value(5).toInt(); // TODO: Allow artwork lookups by album ID
-        QString sGenre = query.value(6).toString();
-        int nTrackCount = query.value(7).toInt();
-        int nAlbumArtID = query.value(8).toInt();
-
-        CDSObject* pContainer = CDSObject::CreateMusicAlbum( CreateIDString(sRequestId, "Album", nAlbumID),
-                                                             sAlbumName,
+        const MusicIndexAlbum &album = index->Albums()[albums[i]];
+        int nTrackCount = index->GetTracks(albums[i], found.m_nArtist,
+                                           found.m_nGenre).size();
+
+        CDSObject* pContainer = CDSObject::CreateMusicAlbum( CreateIDString(sRequestId, "Album", album.m_id),
+                                                             album.m_name,
                                                              pRequest->m_sParentId,
                                                              nullptr );
-        pContainer->SetPropValue("artist", sArtist);
-        pContainer->SetPropValue("date", sYear);
-        pContainer->SetPropValue("genre", sGenre);
+        pContainer->SetPropValue("artist", album.m_artistName);
+        pContainer->SetPropValue("date", QString::number(album.m_year));
+        if (album.m_genre >= 0)
+            pContainer->SetPropValue("genre",
+                                     index->Genres()[album.m_genre].m_name);
         pContainer->SetChildCount(nTrackCount);
         pContainer->SetChildContainerCount(0);
-        if (bCompilation)
-        {
-            // Do nothing for now
-        }
 
         // Artwork
 
-        if (nAlbumArtID > 0)
-            PopulateArtworkURIS(pContainer, nSongId);
+        if (album.m_artSongId > 0)
+            PopulateArtworkURIS(pContainer, album.m_artSongId);
 
         pResults->Add(pContainer);
         pContainer->DecrRef();
     }
 
-    // Just in case FOUND_ROWS() should fail, ensure m_nTotalMatches contains
-    // at least the size of this result set
-    if (query.size() > 0)
-        pResults->m_nTotalMatches = query.size();
-
-    // Fetch the total number of matches ignoring any LIMITs
-    query.prepare("SELECT FOUND_ROWS()");
-    if (query.exec() && query.next())
-            pResults->m_nTotalMatches = query.value(0).toUInt();
+    pResults->m_nTotalMatches = qMin(albums.size(), int(UINT16_MAX));
 
     return true;
 }
@@ -557,56 +582,29 @@ bool UPnpCDSMusic::LoadArtists(const UPnpCDSRequest *pRequest,
 {
     QString sRequestId = pRequest->m_sObjectId;
 
-    uint16_t nCount = pRequest->m_nRequestedCount;
-    uint16_t nOffset = pRequest->m_nStartingIndex;
-
-    // We must use a dedicated connection to get an accurate value from
-    // FOUND_ROWS()
-    MSqlQuery query(MSqlQuery::InitCon(MSqlQuery::kDedicatedConnection));
-
-    QString sql = "SELECT SQL_CALC_FOUND_ROWS "
-                  "t.artist_id, t.artist_name, CONCAT_WS(',', g.genre), "
-                  "COUNT(DISTINCT a.album_id) "
-                  "FROM music_artists t "
-                  "LEFT JOIN music_albums a ON a.artist_id = t.artist_id "
-                  "JOIN music_songs s ON t.artist_id = s.artist_id "
-                  "LEFT JOIN music_genres g ON s.genre_id = g.genre_id "
-                  "%1 " // WHERE clauses
-                  "GROUP BY t.artist_id "
-                  "ORDER BY t.artist_name "
-                  "LIMIT :OFFSET,:COUNT";
-
+    MusicSnapshotPtr index = m_index.GetSnapshot();
+    MusicTokens      found;
 
-    QStringList clauses;
-    QString whereString = BuildWhereClause(clauses, tokens);
-
-    query.prepare(sql.arg(whereString));
-
-    BindValues(query, tokens);
+    if (!FindTokens(*index, tokens, found))
+        return false;
 
-    query.bindValue(":OFFSET", nOffset);
-    query.bindValue(":COUNT", nCount);
+    QVector<int> artists;
+    if (found.m_nArtist >= 0)
+        artists.append(found.m_nArtist);
+    else
+        artists = index->GetArtists(found.m_nGenre);
 
-    if (!query.exec())
-        return false;
+    int nEnd = PageEnd(pRequest, artists.size());
 
-    while (query.next())
+    for (int i = pRequest->m_nStartingIndex; i < nEnd; i++)
     {
-        int nArtistId = query.value(0).toInt();
-        QString sArtistName = query.value(1).toString();
-        QStringList sGenres = query.value(2).toString().split(',');
-        int nAlbumCount = query.value(3).toInt();
+        const MusicIndexArtist &artist = index->Artists()[artists[i]];
+        int nAlbumCount = index->GetAlbums(artists[i], found.m_nGenre).size();
 
-        CDSObject* pContainer = CDSObject::CreateMusicArtist( CreateIDString(sRequestId, "Artist", nArtistId),
-                                                              sArtistName,
+        CDSObject* pContainer = CDSObject::CreateMusicArtist( CreateIDString(sRequestId, "Artist", artist.m_id),
+                                                              artist.m_name,
                                                               pRequest->m_sParentId,
                                                               nullptr );
-// TODO: Add SetPropValues option for multi-value properties
-//         QStringList::Iterator it;
-//         for (it = sGenres.begin(); it != sGenres.end(); ++it)
-//         {
-//             pContainer->SetPropValues("genre", sGenres);
-//         }
         pContainer->SetChildCount(nAlbumCount);
         pContainer->SetChildContainerCount(nAlbumCount);
 
@@ -617,15 +615,7 @@ bool UPnpCDSMusic::LoadArtists(const UPnpCDSRequest *pRequest,
         pContainer->DecrRef();
     }
 
-    // Just in case FOUND_ROWS() should fail, ensure m_nTotalMatches contains
-    // at least the size of this result set
-    if (query.size() > 0)
-        pResults->m_nTotalMatches = query.size();
-
-    // Fetch the total number of matches ignoring any LIMITs
-    query.prepare("SELECT FOUND_ROWS()");
-    if (query.exec() && query.next())
-            pResults->m_nTotalMatches = query.value(0).toUInt();
+    pResults->m_nTotalMatches = qMin(artists.size(), int(UINT16_MAX));
 
     return true;
 }
@@ -640,64 +630,38 @@ bool UPnpCDSMusic::LoadGenres(const UPnpCDSRequest *pRequest,
 {
     QString sRequestId = pRequest->m_sObjectId;
 
-    uint16_t nCount = pRequest->m_nRequestedCount;
-    uint16_t nOffset = pRequest->m_nStartingIndex;
+    MusicSnapshotPtr index = m_index.GetSnapshot();
+    MusicTokens      found;
 
-    // We must use a dedicated connection to get an acccurate value from
-    // FOUND_ROWS()
-    MSqlQuery query(MSqlQuery::InitCon(MSqlQuery::kDedicatedConnection));
-
-    QString sql = "SELECT SQL_CALC_FOUND_ROWS g.genre_id, g.genre, "
-                  "COUNT( DISTINCT t.artist_id ) "
-                  "FROM music_genres g "
-                  "LEFT JOIN music_songs s ON g.genre_id = s.genre_id "
-                  "LEFT JOIN music_artists t ON t.artist_id = s.artist_id "
-                  "%1 " // WHERE clauses
-                  "GROUP BY g.genre_id "
-                  "ORDER BY g.genre "
-                  "LIMIT :OFFSET,:COUNT";
-
-    QStringList clauses;
-    QString whereString = BuildWhereClause(clauses, tokens);
-
-    query.prepare(sql.arg(whereString));
-
-    BindValues(query, tokens);
+    if (!FindTokens(*index, tokens, found))
+        return false;
 
-    query.bindValue(":OFFSET", nOffset);
-    query.bindValue(":COUNT", nCount);
+    QVector<int> genres;
+    if (found.m_nGenre >= 0)
+        genres.append(found.m_nGenre);
+    else
+        genres = index->GetGenres();
 
-    if (!query.exec())
-        return false;
+    int nEnd = PageEnd(pRequest, genres.size());
 
-    while (query.next())
+    for (int i = pRequest->m_nStartingIndex; i < nEnd; i++)
     {
-        int nGenreId = query.value(0).toInt();
-        QString sGenreName = query.value(1).toString();
-        int nArtistCount = query.value(2).toInt();
+        const MusicIndexGenre &genre = index->Genres()[genres[i]];
 
-        CDSObject* pContainer = CDSObject::CreateMusicGenre( CreateIDString(sRequestId, "Genre", nGenreId),
-                                                             sGenreName,
+        CDSObject* pContainer = CDSObject::CreateMusicGenre( CreateIDString(sRequestId, "Genre", genre.m_id),
+                                                             genre.m_name,
                                                              pRequest->m_sParentId,
                                                              nullptr );
-        pContainer->SetPropValue("description", sGenreName);
+        pContainer->SetPropValue("description", genre.m_name);
 
-        pContainer->SetChildCount(nArtistCount);
-        pContainer->SetChildContainerCount(nArtistCount);
+        pContainer->SetChildCount(genre.m_artists.size());
+        pContainer->SetChildContainerCount(genre.m_artists.size());
 
         pResults->Add(pContainer);
         pContainer->DecrRef();
     }
 
-    // Just in case FOUND_ROWS() should fail, ensure m_nTotalMatches contains
-    // at least the size of this result set
-    if (query.size() > 0)
-        pResults->m_nTotalMatches = query.size();
-
-    // Fetch the total number of matches ignoring any LIMITs
-    query.prepare("SELECT FOUND_ROWS()");
-    if (query.exec() && query.next())
-            pResults->m_nTotalMatches = query.value(0).toUInt();
+    pResults->m_nTotalMatches = qMin(genres.size(), int(UINT16_MAX));
 
     return true;
 }
@@ -712,58 +676,42 @@ bool UPnpCDSMusic::LoadTracks(const UPnpCDSRequest *pRequest,
 {
     QString sRequestId = pRequest->m_sObjectId;
 
-    uint16_t nCount = pRequest->m_nRequestedCount;
-    uint16_t nOffset = pRequest->m_nStartingIndex;
-
-    // We must use a dedicated connection to get an acccurate value from
-    // FOUND_ROWS()
-    MSqlQuery query(MSqlQuery::InitCon(MSqlQuery::kDedicatedConnection));
-
-    QString sql = "SELECT SQL_CALC_FOUND_ROWS s.song_id, t.artist_name, "
-                  "a.album_name, s.name, "
-                  "g.genre, s.year, s.track, "
-                  "s.description, s.filename, s.length, s.size, "
-                  "s.numplays, s.lastplay, w.albumart_id "
-                  "FROM music_songs s "
-                  "LEFT JOIN music_artists t ON t.artist_id = s.artist_id "
-                  "LEFT JOIN music_albums a ON a.album_id = s.album_id "
-                  "LEFT JOIN music_genres g ON  g.genre_id = s.genre_id "
-                  "LEFT JOIN music_albumart w ON s.song_id = w.song_id "
-                  "%1 " // WHERE clauses
-                  "GROUP BY s.song_id "
-                  "ORDER BY t.artist_name, a.album_name, s.track "
-                  "LIMIT :OFFSET,:COUNT";
-
-    QStringList clauses;
-    QString whereString = BuildWhereClause(clauses, tokens);
+    MusicSnapshotPtr index = m_index.GetSnapshot();
+    MusicTokens      found;
 
-    query.prepare(sql.arg(whereString));
+    if (!FindTokens(*index, tokens, found))
+        return false;
 
-    BindValues(query, tokens);
+    QVector<int> tracks;
+    if (found.m_nTrack >= 0)
+        tracks.append(found.m_nTrack);
+    else
+        tracks = index->GetTracks(found.m_nAlbum, found.m_nArtist,
+                                  found.m_nGenre);
 
-    query.bindValue(":OFFSET", nOffset);
-    query.bindValue(":COUNT", nCount);
+    int nEnd = PageEnd(pRequest, tracks.size());
 
-    if (!query.exec())
-        return false;
-
-    while (query.next())
+    for (int i = pRequest->m_nStartingIndex; i < nEnd; i++)
     {
-        int            nId          = query.value( 0).toInt();
-        QString        sArtist      = query.value( 1).toString();
-        QString        sAlbum       = query.value( 2).toString();
-        QString        sTitle       = query.value( 3).toString();
-        QString        sGenre       = query.value( 4).toString();
-        int            nYear        = query.value( 5).toInt();
-        int            nTrackNum    = query.value( 6).toInt();
-        QString        sDescription = query.value( 7).toString();
-        QString        sFileName    = query.value( 8).toString();
-        uint32_t       nLengthMS    = query.value( 9).toUInt();
-        uint64_t       nFileSize    = query.value(10).toULongLong();
-
-        int            nPlaybackCount = query.value(11).toInt();
-        QDateTime      lastPlayedTime = query.value(12).toDateTime();
-        int            nAlbumArtID    = query.value(13).toInt();
+        const MusicIndexTrack &track = index->Tracks()[tracks[i]];
+
+        int            nId          = track.m_id;
+        QString        sArtist      = index->Artists()[track.m_artist].m_name;
+        QString        sAlbum       = index->Albums()[track.m_album].m_name;
+        QString        sTitle       = track.m_title;
+        QString        sGenre;
+        int            nYear        = track.m_year;
+        int            nTrackNum    = track.m_trackNum;
+        QString        sDescription = track.m_description;
+        QString        sFileName    = track.m_filename;
+        uint32_t       nLengthMS    = track.m_length;
+        uint64_t       nFileSize    = track.m_fileSize;
+
+        int            nPlaybackCount = track.m_playCount;
+        QDateTime      lastPlayedTime = track.m_lastPlay;
+
+        if (track.m_genre >= 0)
+            sGenre = index->Genres()[track.m_genre].m_name;
 
         CDSObject* pItem = CDSObject::CreateMusicTrack( CreateIDString(sRequestId, "Track", nId),
                                                         sTitle,
@@ -797,7 +745,7 @@ bool UPnpCDSMusic::LoadTracks(const UPnpCDSRequest *pRequest,
         pItem->SetPropValue( "lastPlaybackTime"     , UPnPDateTime::DateTimeFormat(lastPlayedTime));
 
         // Artwork
-        if (nAlbumArtID > 0)
+        if (track.m_hasArt)
             PopulateArtworkURIS(pItem, nId);
 
         // ----------------------------------------------------------------------
@@ -827,73 +775,45 @@ bool UPnpCDSMusic::LoadTracks(const UPnpCDSRequest *pRequest,
         pItem->DecrRef();
     }
 
-    // Just in case FOUND_ROWS() should fail, ensure m_nTotalMatches contains
-    // at least the size of this result set
-    if (query.size() > 0)
-        pResults->m_nTotalMatches = query.size();
-
-    // Fetch the total number of matches ignoring any LIMITs
-    query.prepare("SELECT FOUND_ROWS()");
-    if (query.exec() && query.next())
-            pResults->m_nTotalMatches = query.value(0).toUInt();
+    pResults->m_nTotalMatches = qMin(tracks.size(), int(UINT16_MAX));
 
     return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
-//
+// Looks up the track, album, artist and genre IDs in the object ID in the
+// index. Returns false if any of them isn't there.
 /////////////////////////////////////////////////////////////////////////////
 
-QString UPnpCDSMusic::BuildWhereClause( QStringList clauses,
-                                     IDTokenMap tokens)
+bool UPnpCDSMusic::FindTokens( const MusicSnapshot &index,
+                               const IDTokenMap &tokens,
+                               MusicTokens &found )
 {
-    if (tokens["track"].toInt() > 0)
-        clauses.append("s.song_id=:TRACK_ID");
-    if (tokens["album"].toInt() > 0)
-        clauses.append("s.album_id=:ALBUM_ID");
-    if (tokens["artist"].toInt() > 0)
-        clauses.append("s.artist_id=:ARTIST_ID");
-    if (tokens["genre"].toInt() > 0)
-        clauses.append("s.genre_id=:GENRE_ID");
-    if (tokens["year"].toInt() > 0)
-        clauses.append("s.year=:YEAR");
-    if (tokens["directory"].toInt() > 0)
-        clauses.append("s.directory_id=:DIRECTORY_ID");
-
-//     if (tokens["album"].toInt() > 0)
-//         clauses.append("a.album_id=:ALBUM_ID");
-//     if (tokens["artist"].toInt() > 0)
-//         clauses.append("a.artist_id=:ARTIST_ID");
-
-    QString whereString;
-    if (!clauses.isEmpty())
-    {
-        whereString = " WHERE ";
-        whereString.append(clauses.join(" AND "));
-    }
+    int nTrackId  = tokens.value("track").toInt();
+    int nAlbumId  = tokens.value("album").toInt();
+    int nArtistId = tokens.value("artist").toInt();
+    int nGenreId  = tokens.value("genre").toInt();
+
+    if (nTrackId > 0 && (found.m_nTrack = index.FindTrack(nTrackId)) < 0)
+        return false;
+    if (nAlbumId > 0 && (found.m_nAlbum = index.FindAlbum(nAlbumId)) < 0)
+        return false;
+    if (nArtistId > 0 && (found.m_nArtist = index.FindArtist(nArtistId)) < 0)
+        return false;
+    if (nGenreId > 0 && (found.m_nGenre = index.FindGenre(nGenreId)) < 0)
+        return false;
 
-    return whereString;
+    return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
-//
+// Returns the end of the page of children the request asks for.
 /////////////////////////////////////////////////////////////////////////////
 
-void UPnpCDSMusic::BindValues( MSqlQuery &query,
-                            IDTokenMap tokens)
+int UPnpCDSMusic::PageEnd( const UPnpCDSRequest *pRequest, int nTotal )
 {
-    if (tokens["track"].toInt() > 0)
-        query.bindValue(":TRACK_ID", tokens["track"]);
-    if (tokens["album"].toInt() > 0)
-        query.bindValue(":ALBUM_ID", tokens["album"]);
-    if (tokens["artist"].toInt() > 0)
-        query.bindValue(":ARTIST_ID", tokens["artist"]);
-    if (tokens["genre"].toInt() > 0)
-        query.bindValue(":GENRE_ID", tokens["genre"]);
-    if (tokens["year"].toInt() > 0)
-        query.bindValue(":YEAR", tokens["year"]);
-    if (tokens["directory"].toInt() > 0)
-        query.bindValue(":DIRECTORY_ID", tokens["directory"]);
+    return qMin(nTotal, int(pRequest->m_nStartingIndex) +
+                        int(pRequest->m_nRequestedCount));
 }
 
 // vim:ts=4:sw=4:ai:et:si:sts=4
@@ -14,11 +14,11 @@
 #include <QString>
 
 #include "upnpcds.h"
+#include "musicindex.h"
 
 //////////////////////////////////////////////////////////////////////////////
 //
 //////////////////////////////////////////////////////////////////////////////
-class MSqlQuery;
 class UPnpCDSMusic : public UPnpCDSExtension
 {
     public:
@@ -26,6 +26,8 @@ class UPnpCDSMusic : public UPnpCDSExtension
         UPnpCDSMusic();
         virtual ~UPnpCDSMusic() = default;
 
+        UPnpCDSExtensionResults *Search( UPnpCDSRequest *pRequest ) override; // UPnpCDSExtension
+
     protected:
 
         bool IsBrowseRequestForUs( UPnpCDSRequest *pRequest ) override; // UPnpCDSExtension
@@ -44,7 +46,17 @@ class UPnpCDSMusic : public UPnpCDSExtension
 
     private:
 
+        class MusicTokens
+        {
+            public:
+                int m_nTrack  {-1};
+                int m_nAlbum  {-1};
+                int m_nArtist {-1};
+                int m_nGenre  {-1};
+        };
+
         QUrl             m_URIBase;
+        MusicIndex       m_index;
 
         void             PopulateArtworkURIS( CDSObject *pItem,
                                               int songID );
@@ -63,10 +75,12 @@ class UPnpCDSMusic : public UPnpCDSExtension
                                     IDTokenMap tokens);
 
         // Common code helpers
-        QString BuildWhereClause( QStringList clauses,
-                                  IDTokenMap tokens );
-        void    BindValues ( MSqlQuery &query,
-                             IDTokenMap tokens );
+        static bool    FindTokens ( const MusicSnapshot &index,
+                                    const IDTokenMap &tokens,
+                                    MusicTokens &found );
+        static int     PageEnd    ( const UPnpCDSRequest *pRequest,
+                                    int nTotal );
+        static QString SearchContainerId( const UPnpCDSRequest *pRequest );
 };
 
 #endif
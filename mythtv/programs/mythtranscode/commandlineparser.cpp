@@ -109,6 +109,10 @@ void MythTranscodeCommandLineParser::LoadArguments(void)
         ->SetChildOf("hls");
     add("--maxsegments", "maxsegments", 0, "Max HTTP Live Stream segments", "")
         ->SetChildOf("hls");
+    add("--renditions", "renditions", 1,
+            "Number of HTTP Live Stream renditions (bitrate ladder rungs) "
+            "to encode from a single decode", "")
+        ->SetChildOf("hls");
     add("--noaudioonly", "noaudioonly", 0, "Disable Audio-Only HLS Stream", "")
         ->SetChildOf("hls");
     add("--hlsstreamid", "hlsstreamid", -1, "Stream ID to process", "")
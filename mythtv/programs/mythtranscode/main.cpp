@@ -578,6 +578,8 @@ int main(int argc, char *argv[])
             transcode->SetHLSStreamID(cmdline.toInt("hlsstreamid"));
         if (cmdline.toBool("maxsegments"))
             transcode->SetHLSMaxSegments(cmdline.toInt("maxsegments"));
+        if (cmdline.toBool("renditions"))
+            transcode->SetHLSRenditions(cmdline.toInt("renditions"));
         if (cmdline.toBool("noaudioonly"))
             transcode->DisableAudioOnlyHLS();
     }
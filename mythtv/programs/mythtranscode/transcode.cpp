@@ -48,6 +48,78 @@ using namespace std;
 
 #define LOC QString("Transcode: ")
 
+/** \class HLSRendition
+ *  \brief One of the lower renditions of an HTTP Live Stream ladder.
+ *
+ *  Each rendition has its own scaler and encoder, and is scaled from the
+ *  same decoded frame as the main stream, so the recording is decoded only
+ *  once however many renditions there are. All of them are given every
+ *  frame and the same key frame distance, so their segments line up and
+ *  players can switch between them at any segment.
+ */
+class HLSRendition
+{
+  public:
+    HLSRendition(uint16_t rendition, int width, int height)
+      : m_rendition(rendition), m_writer(new AVFormatWriter())
+    {
+        memset(&m_frame, 0, sizeof(m_frame));
+
+        size_t size = buffersize(FMT_YV12, width, height);
+        unsigned char *buf = (unsigned char *)av_malloc(size);
+        if (buf)
+            init(&m_frame, FMT_YV12, buf, width, height, size);
+    }
+
+   ~HLSRendition()
+    {
+        delete m_writer;
+        sws_freeContext(m_scontext);
+        av_freep(&m_frame.buf);
+    }
+
+    /// Scales a decoded frame to this rendition's size and encodes it with
+    /// the timecode the main stream was given
+    int WriteVideoFrame(VideoFrame *decoded, long long timecode)
+    {
+        AVFrame imageIn, imageOut;
+        AVPictureFill(&imageIn, decoded);
+        AVPictureFill(&imageOut, &m_frame);
+
+        int bottomBand = (decoded->height == 1088) ? 8 : 0;
+        m_scontext = sws_getCachedContext(m_scontext,
+                         decoded->width, decoded->height,
+                         FrameTypeToPixelFormat(decoded->codec),
+                         m_frame.width, m_frame.height,
+                         FrameTypeToPixelFormat(m_frame.codec),
+                         SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+
+        sws_scale(m_scontext, imageIn.data, imageIn.linesize, 0,
+                  decoded->height - bottomBand,
+                  imageOut.data, imageOut.linesize);
+
+        m_frame.timecode    = timecode;
+        m_frame.frameNumber = decoded->frameNumber;
+
+        return m_writer->WriteVideoFrame(&m_frame);
+    }
+
+    uint16_t            m_rendition;
+    AVFormatWriter     *m_writer;
+    VideoFrame          m_frame;
+    struct SwsContext  *m_scontext {nullptr};
+
+  private:
+    Q_DISABLE_COPY(HLSRendition)
+};
+
+/// The renditions of a transcode, deleted with it whichever way it ends
+class HLSRenditionList : public QList<HLSRendition*>
+{
+  public:
+   ~HLSRenditionList() { qDeleteAll(*this); }
+};
+
 Transcode::Transcode(ProgramInfo *pginfo) :
     m_proginfo(pginfo),
     m_recProfile(new RecordingProfile("Transcoders")),
@@ -64,7 +136,7 @@ Transcode::Transcode(ProgramInfo *pginfo) :
     avfMode(false),
     hlsMode(false),                 hlsStreamID(-1),
     hlsDisableAudioOnly(false),
-    hlsMaxSegments(0),
+    hlsMaxSegments(0),              hlsRenditions(1),
     cmdContainer("mpegts"),         cmdAudioCodec("aac"),
     cmdVideoCodec("libx264"),
     cmdWidth(480),                  cmdHeight(0),
@@ -226,6 +298,7 @@ int Transcode::TranscodeFile(const QString &inputname,
     Cutter *cutter = nullptr;
     AVFormatWriter *avfw = nullptr;
     AVFormatWriter *avfw2 = nullptr;
+    HLSRenditionList renditions;
     HTTPLiveStream *hls = nullptr;
     int hlsSegmentSize = 0;
     int hlsSegmentFrames = 0;
@@ -475,7 +548,7 @@ int Transcode::TranscodeFile(const QString &inputname,
                 hls = new HTTPLiveStream(inputname, newWidth, newHeight,
                                          cmdBitrate,
                                          cmdAudioBitrate, hlsMaxSegments,
-                                         0, 0);
+                                         0, 0, -1, hlsRenditions);
 
                 hlsStreamID = hls->GetStreamID();
                 if (!hls || hlsStreamID == -1)
@@ -554,6 +627,47 @@ int Transcode::TranscodeFile(const QString &inputname,
             avfw->SetFilename(hls->GetCurrentFilename());
             if (avfw2)
                 avfw2->SetFilename(hls->GetCurrentFilename(true));
+
+            for (uint16_t r = 1; r < hls->GetRenditions(); ++r)
+            {
+                QSize size = hls->GetRenditionSize(r);
+                HLSRendition *rendition =
+                    new HLSRendition(r, size.width(), size.height());
+                renditions.append(rendition);
+
+                if (!rendition->m_frame.buf)
+                {
+                    // OOM
+                    SetPlayerContext(nullptr);
+                    delete hls;
+                    delete avfw;
+                    if (avfw2)
+                        delete avfw2;
+                    return REENCODE_ERROR;
+                }
+
+                AVFormatWriter *writer = rendition->m_writer;
+                writer->SetContainer("mpegts");
+                writer->SetVideoCodec("libx264");
+                writer->SetAudioCodec("aac");
+                writer->SetVideoBitrate(hls->GetRenditionBitrate(r));
+                writer->SetWidth(size.width());
+                writer->SetHeight(size.height());
+                writer->SetAspect(video_aspect);
+                writer->SetAudioBitrate(cmdAudioBitrate);
+                writer->SetAudioChannels(arb->m_channels);
+                writer->SetAudioFrameRate(arb->m_eff_audiorate);
+                writer->SetAudioFormat(FORMAT_S16);
+                writer->SetFramerate(halfFramerate ? video_frame_rate / 2 :
+                                                     video_frame_rate);
+                writer->SetKeyFrameDist(30);
+                writer->SetFilename(hls->GetCurrentFilename(false, false, r));
+
+                LOG(VB_GENERAL, LOG_NOTICE,
+                    QString("HLS: Rendition %1 is %2x%3 at %4 kbps")
+                        .arg(r).arg(size.width()).arg(size.height())
+                        .arg(hls->GetRenditionBitrate(r) / 1000));
+            }
         }
         else
         {
@@ -580,6 +694,13 @@ int Transcode::TranscodeFile(const QString &inputname,
         if (avfw2)
             avfw2->SetThreadCount(1);
 
+        foreach (HLSRendition *rendition, renditions)
+        {
+            rendition->m_writer->SetThreadCount(threads);
+            rendition->m_writer->SetEncodingPreset(preset);
+            rendition->m_writer->SetEncodingTune(tune);
+        }
+
         if (!avfw->Init())
         {
             LOG(VB_GENERAL, LOG_ERR, "avfw->Init() failed");
@@ -626,6 +747,23 @@ int Transcode::TranscodeFile(const QString &inputname,
             return REENCODE_ERROR;
         }
 
+        foreach (HLSRendition *rendition, renditions)
+        {
+            if (!rendition->m_writer->Init() ||
+                !rendition->m_writer->OpenFile())
+            {
+                LOG(VB_GENERAL, LOG_ERR,
+                    QString("Unable to open HLS rendition %1")
+                        .arg(rendition->m_rendition));
+                SetPlayerContext(nullptr);
+                delete hls;
+                delete avfw;
+                if (avfw2)
+                    delete avfw2;
+                return REENCODE_ERROR;
+            }
+        }
+
         arb->m_audioFrameSize = avfw->GetAudioFrameSize() * arb->m_channels * 2;
 
         GetPlayer()->SetVideoFilters(
@@ -1437,6 +1575,21 @@ int Transcode::TranscodeFile(const QString &inputname,
                             avfw2->WriteAudioFrame(buf, audioFrame, tc);
                         }
 
+                        foreach (HLSRendition *rendition, renditions)
+                        {
+                            AVFormatWriter *writer = rendition->m_writer;
+
+                            if ((writer->GetTimecodeOffset() == -1) &&
+                                (avfw->GetTimecodeOffset() != -1))
+                            {
+                                writer->SetTimecodeOffset(
+                                    avfw->GetTimecodeOffset());
+                            }
+
+                            tc = ab->m_time - timecodeOffset;
+                            writer->WriteAudioFrame(buf, audioFrame, tc);
+                        }
+
                         ++audioFrame;
                     }
                 }
@@ -1492,10 +1645,20 @@ int Transcode::TranscodeFile(const QString &inputname,
                 {
                     skippedLastFrame = false;
 
+                    // Every rendition starts its next segment at the same
+                    // frame, so they line up
+                    bool renditionsAtKeyFrame = true;
+                    foreach (HLSRendition *rendition, renditions)
+                    {
+                        if (!rendition->m_writer->NextFrameIsKeyFrame())
+                            renditionsAtKeyFrame = false;
+                    }
+
                     if ((hls) &&
                         (avfw->GetFramesWritten()) &&
                         (hlsSegmentFrames > hlsSegmentSize) &&
-                        (avfw->NextFrameIsKeyFrame()))
+                        (avfw->NextFrameIsKeyFrame()) &&
+                        (renditionsAtKeyFrame))
                     {
                         hls->AddSegment();
                         avfw->ReOpen(hls->GetCurrentFilename());
@@ -1503,16 +1666,29 @@ int Transcode::TranscodeFile(const QString &inputname,
                         if (avfw2)
                             avfw2->ReOpen(hls->GetCurrentFilename(true));
 
+                        foreach (HLSRendition *rendition, renditions)
+                        {
+                            rendition->m_writer->ReOpen(
+                                hls->GetCurrentFilename(false, false,
+                                                        rendition->m_rendition));
+                        }
+
                         hlsSegmentFrames = 0;
                     }
 
-                    if (avfw->WriteVideoFrame(rescale ? &frame : lastDecode) > 0)
+                    VideoFrame *encode = rescale ? &frame : lastDecode;
+                    long long encodeTimecode = encode->timecode;
+
+                    if (avfw->WriteVideoFrame(encode) > 0)
                     {
                         lastWrittenTime = frame.timecode + timecodeOffset;
                         if (hls)
                             ++hlsSegmentFrames;
                     }
 
+                    foreach (HLSRendition *rendition, renditions)
+                        rendition->WriteVideoFrame(lastDecode, encodeTimecode);
+
                 }
             }
 #if CONFIG_LIBMP3LAME
@@ -1627,6 +1803,9 @@ int Transcode::TranscodeFile(const QString &inputname,
         if (avfw2)
             avfw2->CloseFile();
 
+        foreach (HLSRendition *rendition, renditions)
+            rendition->m_writer->CloseFile();
+
         if (!avfMode && m_proginfo)
         {
             m_proginfo->ClearPositionMap(MARK_KEYFRAME);
@@ -29,6 +29,7 @@ class Transcode : public QObject
     void SetHLSMode(void) { hlsMode = true; }
     void SetHLSStreamID(int streamid) { hlsStreamID = streamid; }
     void SetHLSMaxSegments(int segments) { hlsMaxSegments = segments; }
+    void SetHLSRenditions(int renditions) { hlsRenditions = renditions; }
     void SetCMDContainer(QString container) { cmdContainer = container; }
     void SetCMDAudioCodec(QString codec) { cmdAudioCodec = codec; }
     void SetCMDVideoCodec(QString codec) { cmdVideoCodec = codec; }
@@ -64,6 +65,7 @@ class Transcode : public QObject
     int                     hlsStreamID;
     bool                    hlsDisableAudioOnly;
     int                     hlsMaxSegments;
+    int                     hlsRenditions;
     QString                 cmdContainer;
     QString                 cmdAudioCodec;
     QString                 cmdVideoCodec;
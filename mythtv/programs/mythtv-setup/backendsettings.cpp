@@ -353,6 +353,19 @@ static HostTextEditSetting *MiscStatusScript()
     return he;
 }
 
+static GlobalSpinBoxSetting *PreviewStripThumbnails()
+{
+    GlobalSpinBoxSetting *bs = new GlobalSpinBoxSetting(
+        "PreviewStripThumbnails", 0, 100, 5);
+    bs->setLabel(QObject::tr("Thumbnails per recording"));
+    bs->setHelpText(QObject::tr("When a recording has finished, its backend "
+                    "saves this many thumbnails spread over the recording "
+                    "next to it, for frontends and the web interface to "
+                    "show while seeking. Set to 0 to disable."));
+    bs->setValue(40);
+    return bs;
+}
+
 static GlobalSpinBoxSetting *EITTransportTimeout()
 {
     GlobalSpinBoxSetting *gc = new GlobalSpinBoxSetting("EITTransportTimeout", 1, 15, 1);
@@ -579,12 +592,59 @@ static HostSpinBoxSetting *JobQueueCheckFrequency()
 {
     HostSpinBoxSetting *gc = new HostSpinBoxSetting("JobQueueCheckFrequency", 5, 300, 5);
     gc->setLabel(QObject::tr("Job Queue check frequency (secs)"));
-    gc->setHelpText(QObject::tr("When looking for new jobs to process, the "
-                    "Job Queue will wait this many seconds between checks."));
+    gc->setHelpText(QObject::tr("The Job Queue looks for new jobs as soon "
+                    "as they are queued or a recording finishes. It also "
+                    "checks this often, so that jobs held back while the "
+                    "system was busy are started."));
     gc->setValue(60);
     return gc;
 };
 
+static HostSpinBoxSetting *JobQueueMaxTranscode()
+{
+    HostSpinBoxSetting *gc = new HostSpinBoxSetting("JobQueueMaxTranscode", 0, 10, 1);
+    gc->setLabel(QObject::tr("Maximum simultaneous transcode jobs"));
+    gc->setHelpText(QObject::tr("Limits how many transcode jobs may run at "
+                    "once on this backend. 0 leaves it to the overall "
+                    "limit and the CPU usage setting."));
+    gc->setValue(0);
+    return gc;
+};
+
+static HostSpinBoxSetting *JobQueueMaxCommFlag()
+{
+    HostSpinBoxSetting *gc = new HostSpinBoxSetting("JobQueueMaxCommFlag", 0, 10, 1);
+    gc->setLabel(QObject::tr("Maximum simultaneous commercial detection jobs"));
+    gc->setHelpText(QObject::tr("Limits how many commercial detection jobs "
+                    "may run at once on this backend. 0 leaves it to the "
+                    "overall limit and the CPU usage setting."));
+    gc->setValue(0);
+    return gc;
+};
+
+static HostSpinBoxSetting *JobQueueAgingMinutes()
+{
+    HostSpinBoxSetting *gc = new HostSpinBoxSetting("JobQueueAgingMinutes", 1, 240, 5);
+    gc->setLabel(QObject::tr("Job priority aging (mins)"));
+    gc->setHelpText(QObject::tr("Queued jobs gain priority the longer they "
+                    "wait, one level per this many minutes, so that large "
+                    "jobs are not held back forever by smaller ones."));
+    gc->setValue(30);
+    return gc;
+};
+
+static HostCheckBoxSetting *JobQueueStealJobs()
+{
+    HostCheckBoxSetting *gc = new HostCheckBoxSetting("JobQueueStealJobs");
+    gc->setLabel(QObject::tr("Take over jobs from busy backends"));
+    gc->setValue(true);
+    gc->setHelpText(QObject::tr("If enabled, this backend will run jobs "
+                    "queued for another backend while that backend has no "
+                    "free job slots. Backends that store the recording "
+                    "locally are given the first chance."));
+    return gc;
+};
+
 static HostComboBoxSetting *JobQueueCPU()
 {
     HostComboBoxSetting *gc = new HostComboBoxSetting("JobQueueCPU");
@@ -595,7 +655,9 @@ static HostComboBoxSetting *JobQueueCPU()
     gc->setHelpText(QObject::tr("This setting controls approximately how "
                     "much CPU jobs in the queue may consume. "
                     "On 'High', all available CPU time may be used, "
-                    "which could cause problems on slower systems." ));
+                    "which could cause problems on slower systems. "
+                    "Jobs are only started while the system load leaves "
+                    "room for them." ));
     return gc;
 };
 
@@ -626,7 +688,8 @@ static GlobalCheckBoxSetting *JobsRunOnRecordHost()
     gc->setValue(false);
     gc->setHelpText(QObject::tr("If enabled, jobs in the queue will be required "
                                 "to run on the backend that made the "
-                                "original recording."));
+                                "original recording, unless that backend is "
+                                "busy and another one may take them over."));
     return gc;
 };
 
@@ -936,6 +999,7 @@ BackendSettings::BackendSettings() :
     fm->addChild(TruncateDeletes());
     fm->addChild(HDRingbufferSize());
     fm->addChild(StorageScheduler());
+    fm->addChild(PreviewStripThumbnails());
     group2->addChild(fm);
     GroupSetting* upnp = new GroupSetting();
     upnp->setLabel(QObject::tr("UPnP Server Settings"));
@@ -993,6 +1057,10 @@ BackendSettings::BackendSettings() :
     group5->setLabel(QObject::tr("Job Queue (Backend-Specific)"));
     group5->addChild(JobQueueMaxSimultaneousJobs());
     group5->addChild(JobQueueCheckFrequency());
+    group5->addChild(JobQueueMaxTranscode());
+    group5->addChild(JobQueueMaxCommFlag());
+    group5->addChild(JobQueueAgingMinutes());
+    group5->addChild(JobQueueStealJobs());
     group5->addChild(JobQueueWindowStart());
     group5->addChild(JobQueueWindowEnd());
     group5->addChild(JobQueueCPU());